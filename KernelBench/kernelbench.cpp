@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <vkdl/graphics/image_kernels.h>
+
+using namespace vkdl;
+
+struct BenchOptions
+{
+	uint32_t width      = 4096;
+	uint32_t height     = 4096;
+	int      iterations = 10;
+};
+
+static void print_usage()
+{
+	std::printf(
+		"usage: KernelBench [options]\n"
+		"  --size <w> <h>      image size in pixels (default 4096 4096)\n"
+		"  --iterations <n>    runs per kernel, the fastest one is reported (default 10)\n");
+}
+
+// Best of `iterations` runs in milliseconds, `reset` restores the input between runs
+static double best_time(int iterations, const std::function<void()>& reset, const std::function<void()>& kernel)
+{
+	double best = 1e30;
+
+	for (int i = 0; i < iterations; i++) {
+		reset();
+
+		const auto start = std::chrono::steady_clock::now();
+		kernel();
+		const auto end   = std::chrono::steady_clock::now();
+
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--size") && i + 2 < argc) {
+			options.width  = static_cast<uint32_t>(std::atoi(argv[++i]));
+			options.height = static_cast<uint32_t>(std::atoi(argv[++i]));
+		} else if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			options.iterations = std::max(std::atoi(argv[++i]), 1);
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if (options.width == 0 || options.height == 0) {
+		print_usage();
+		return 1;
+	}
+
+	const size_t pixel_count = static_cast<size_t>(options.width) * options.height;
+
+	// Deterministic noise, so every run and every SIMD level sees the same input
+	std::vector<uint8_t> source(pixel_count * 4);
+	uint32_t state = 0x12345678u;
+	for (auto& byte : source) {
+		state = state * 1664525u + 1013904223u;
+		byte  = static_cast<uint8_t>(state >> 24);
+	}
+
+	std::vector<uint8_t> pixels(source.size());
+	std::vector<uint8_t> output(source.size());
+	std::vector<uint8_t> scalar_output(source.size());
+
+	const auto reset = [&]() { std::memcpy(pixels.data(), source.data(), source.size()); };
+
+	struct Kernel
+	{
+		const char*           name;
+		std::function<void()> run;
+		const uint8_t*        result;
+		size_t                result_size;
+	};
+
+	const uint32_t w = options.width;
+	const uint32_t h = options.height;
+
+	const size_t rgba_size = pixel_count * 4;
+	const size_t half_size = static_cast<size_t>(std::max(w / 2, 1u)) * std::max(h / 2, 1u) * 4;
+
+	const Kernel kernels[] = {
+		{ "convert rgba8 -> bgra8", [&]() { ImageKernels::convert(pixels.data(), PixelLayout::RGBA8, output.data(), PixelLayout::BGRA8, pixel_count); }, output.data(), rgba_size },
+		{ "convert rgba8 -> gray8", [&]() { ImageKernels::convert(pixels.data(), PixelLayout::RGBA8, output.data(), PixelLayout::Gray8, pixel_count); }, output.data(), pixel_count },
+		{ "premultiply alpha",      [&]() { ImageKernels::premultiplyAlpha(pixels.data(), pixel_count); }, pixels.data(), rgba_size },
+		{ "unpremultiply alpha",    [&]() { ImageKernels::unpremultiplyAlpha(pixels.data(), pixel_count); }, pixels.data(), rgba_size },
+		{ "replace color",          [&]() { ImageKernels::replaceColor(reinterpret_cast<uint32_t*>(pixels.data()), pixel_count, 0xff000000u, 0u); }, pixels.data(), rgba_size },
+		{ "flip horizontal",        [&]() { ImageKernels::flipHorizontal(pixels.data(), w, h, 4); }, pixels.data(), rgba_size },
+		{ "flip vertical",          [&]() { ImageKernels::flipVertical(pixels.data(), w, h, 4); }, pixels.data(), rgba_size },
+		{ "rotate 90",              [&]() { ImageKernels::rotate(pixels.data(), output.data(), w, h, 4, ImageRotation::Rotate90); }, output.data(), rgba_size },
+		{ "resize bilinear 1/2",    [&]() { ImageKernels::resize(pixels.data(), w, h, output.data(), std::max(w / 2, 1u), std::max(h / 2, 1u), 4, ResizeFilter::Bilinear); }, output.data(), half_size },
+		{ "resize lanczos3 1/2",    [&]() { ImageKernels::resize(pixels.data(), w, h, output.data(), std::max(w / 2, 1u), std::max(h / 2, 1u), 4, ResizeFilter::Lanczos3); }, output.data(), half_size },
+	};
+
+	const char* simd = ImageKernels::simdLevel();
+
+	std::printf("%u x %u RGBA8, best of %d runs, SIMD level %s\n\n", w, h, options.iterations, simd);
+	std::printf("%-24s %12s %12s %9s %s\n", "kernel", "scalar ms", "simd ms", "speedup", "");
+
+	bool all_match = true;
+
+	for (const auto& kernel : kernels) {
+		ImageKernels::setSimdEnabled(false);
+		const double scalar_ms = best_time(options.iterations, reset, kernel.run);
+		std::memcpy(scalar_output.data(), kernel.result, kernel.result_size);
+
+		ImageKernels::setSimdEnabled(true);
+		const double simd_ms = best_time(options.iterations, reset, kernel.run);
+
+		// Results must match the scalar paths bit for bit
+		const bool match = std::memcmp(scalar_output.data(), kernel.result, kernel.result_size) == 0;
+		all_match = all_match && match;
+
+		std::printf("%-24s %12.3f %12.3f %8.2fx %s\n", kernel.name, scalar_ms, simd_ms, scalar_ms / simd_ms, match ? "" : "MISMATCH");
+	}
+
+	return all_match ? 0 : 1;
+}
\ No newline at end of file
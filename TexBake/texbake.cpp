@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstring>
+#include <vkdl/graphics/image.h>
+#include <vkdl/graphics/texture_container.h>
+
+using namespace vkdl;
+
+static void print_usage()
+{
+	std::printf(
+		"usage: TexBake [options] <input image> <output.ktx2>\n"
+		"  --rgba8     store uncompressed RGBA8\n"
+		"  --bc1       BC1, opaque images (4 bits per texel)\n"
+		"  --bc3       BC3 with alpha (8 bits per texel, default)\n"
+		"  --srgb      mark the texture as sRGB encoded\n"
+		"  --no-mips   store mip level 0 only\n");
+}
+
+int main(int argc, char** argv)
+{
+	TextureBakeOptions options;
+
+	const char* input  = nullptr;
+	const char* output = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--rgba8"))        options.format = TextureBakeFormat::RGBA8;
+		else if (!std::strcmp(argv[i], "--bc1"))     options.format = TextureBakeFormat::BC1;
+		else if (!std::strcmp(argv[i], "--bc3"))     options.format = TextureBakeFormat::BC3;
+		else if (!std::strcmp(argv[i], "--srgb"))    options.srgb = true;
+		else if (!std::strcmp(argv[i], "--no-mips")) options.generate_mips = false;
+		else if (!input)                             input = argv[i];
+		else if (!output)                            output = argv[i];
+		else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if (!input || !output) {
+		print_usage();
+		return 1;
+	}
+
+	ColorImage image;
+
+	if (!image.loadFromFile(input)) {
+		std::fprintf(stderr, "failed to load %s\n", input);
+		return 1;
+	}
+
+	if (!TextureContainer::bake(image, output, options)) {
+		std::fprintf(stderr, "failed to write %s\n", output);
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
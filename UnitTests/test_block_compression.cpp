@@ -0,0 +1,121 @@
+#include "unit_test.h"
+
+#include "../VKDL/src/block_compression.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace bc = vkdl::priv;
+
+// Colors along one line through RGB space, which BC1 endpoints can follow
+static std::vector<uint8_t> gradient_image(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			const uint32_t t = (x + y) * 255 / std::max(width + height - 2, 1u);
+
+			uint8_t* pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+			pixel[0] = static_cast<uint8_t>(t);
+			pixel[1] = static_cast<uint8_t>(255 - t);
+			pixel[2] = static_cast<uint8_t>(64 + t / 2);
+			pixel[3] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1u));
+		}
+	}
+
+	return rgba;
+}
+
+// Largest per channel difference over the first `channels` channels
+static int max_error(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, size_t channels)
+{
+	int error = 0;
+
+	for (size_t i = 0; i < a.size(); i += 4)
+		for (size_t c = 0; c < channels; c++)
+			error = std::max(error, std::abs(int(a[i + c]) - int(b[i + c])));
+
+	return error;
+}
+
+static std::vector<uint8_t> round_trip(vk::Format format, const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> blocks(bc::compressedSizeInBytes(format, width, height));
+
+	if (format == vk::Format::eBc1RgbUnormBlock)
+		bc::encodeBC1(rgba.data(), width, height, blocks.data());
+	else
+		bc::encodeBC3(rgba.data(), width, height, blocks.data());
+
+	std::vector<uint8_t> decoded(rgba.size());
+	bc::decodeBlocks(format, blocks.data(), width, height, decoded.data());
+
+	return decoded;
+}
+
+static void test_sizes()
+{
+	UNIT_CHECK(bc::blockSizeInBytes(vk::Format::eBc1RgbUnormBlock) == 8);
+	UNIT_CHECK(bc::blockSizeInBytes(vk::Format::eBc3UnormBlock) == 16);
+	UNIT_CHECK(bc::blockSizeInBytes(vk::Format::eR8G8B8A8Unorm) == 0);
+
+	// Partial blocks on the edges still take a whole block
+	UNIT_CHECK(bc::compressedSizeInBytes(vk::Format::eBc1RgbUnormBlock, 4, 4) == 8);
+	UNIT_CHECK(bc::compressedSizeInBytes(vk::Format::eBc1RgbUnormBlock, 5, 1) == 16);
+	UNIT_CHECK(bc::compressedSizeInBytes(vk::Format::eBc3UnormBlock, 13, 7) == 4 * 2 * 16);
+}
+
+static void test_solid_blocks()
+{
+	// 565 endpoints keep at most the top 5 or 6 bits
+	const uint8_t colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 200, 30, 90, 255 }, { 17, 140, 250, 0 } };
+
+	for (const auto& color : colors) {
+		std::vector<uint8_t> rgba(8 * 8 * 4);
+		for (size_t i = 0; i < rgba.size(); i += 4)
+			std::copy(color, color + 4, &rgba[i]);
+
+		UNIT_CHECK(max_error(rgba, round_trip(vk::Format::eBc1RgbUnormBlock, rgba, 8, 8), 3) <= 4);
+
+		const auto bc3 = round_trip(vk::Format::eBc3UnormBlock, rgba, 8, 8);
+		UNIT_CHECK(max_error(rgba, bc3, 3) <= 4);
+		UNIT_CHECK(max_error(rgba, bc3, 4) <= 4 && bc3[3] == color[3]);
+	}
+}
+
+// Odd sizes exercise the partial blocks on the right and bottom edges
+static void test_gradients()
+{
+	for (const auto& size : { std::make_pair(16u, 16u), std::make_pair(13u, 7u), std::make_pair(1u, 1u), std::make_pair(2u, 9u) }) {
+		const auto rgba = gradient_image(size.first, size.second);
+
+		const auto bc1 = round_trip(vk::Format::eBc1RgbUnormBlock, rgba, size.first, size.second);
+		UNIT_CHECK(max_error(rgba, bc1, 3) <= 20);
+
+		// BC1 ignores alpha and decodes it opaque
+		bool opaque = true;
+		for (size_t i = 3; i < bc1.size(); i += 4)
+			opaque = opaque && bc1[i] == 255;
+		UNIT_CHECK(opaque);
+
+		const auto bc3 = round_trip(vk::Format::eBc3UnormBlock, rgba, size.first, size.second);
+		UNIT_CHECK(max_error(rgba, bc3, 3) <= 20);
+
+		// Alpha has 8 interpolated steps per block, on its own endpoints
+		int alpha_error = 0;
+		for (size_t i = 3; i < rgba.size(); i += 4)
+			alpha_error = std::max(alpha_error, std::abs(int(rgba[i]) - int(bc3[i])));
+		UNIT_CHECK(alpha_error <= 6);
+	}
+}
+
+int main()
+{
+	test_sizes();
+	test_solid_blocks();
+	test_gradients();
+
+	return UNIT_RESULT();
+}
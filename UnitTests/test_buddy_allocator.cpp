@@ -0,0 +1,118 @@
+#include "unit_test.h"
+
+#include "../VKDL/src/buddy_allocator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using vkdl::priv::BuddyAllocator;
+
+static void test_orders()
+{
+	BuddyAllocator buddy(4096, 256);
+
+	UNIT_CHECK(buddy.maxOrder() == 4);
+	UNIT_CHECK(buddy.orderFor(1) == 0);
+	UNIT_CHECK(buddy.orderFor(256) == 0);
+	UNIT_CHECK(buddy.orderFor(257) == 1);
+	UNIT_CHECK(buddy.orderFor(4096) == 4);
+	UNIT_CHECK(buddy.rangeSize(3) == 2048);
+}
+
+static void test_split_and_merge()
+{
+	BuddyAllocator buddy(4096, 256);
+
+	uint64_t a, b, c;
+	UNIT_CHECK(buddy.allocate(0, a));
+	UNIT_CHECK(buddy.allocate(0, b));
+	UNIT_CHECK(buddy.allocate(2, c));
+
+	// Splitting hands out the lower half first, ranges are aligned to their size
+	UNIT_CHECK(a == 0);
+	UNIT_CHECK(b == 256);
+	UNIT_CHECK(c == 1024);
+
+	// Left are 512 bytes after b and the upper half
+	uint64_t d, e;
+	UNIT_CHECK(!buddy.allocate(4, d));
+	UNIT_CHECK(buddy.allocate(3, d));
+	UNIT_CHECK(d == 2048);
+	UNIT_CHECK(!buddy.allocate(2, e));
+	UNIT_CHECK(buddy.allocate(1, e));
+	UNIT_CHECK(e == 512);
+	UNIT_CHECK(!buddy.allocate(0, e));
+
+	buddy.free(512, 1);
+	buddy.free(2048, 3);
+	buddy.free(a, 0);
+	buddy.free(c, 2);
+	buddy.free(b, 0);
+
+	// Everything merged back into the whole range
+	uint64_t whole;
+	UNIT_CHECK(buddy.allocate(4, whole));
+	UNIT_CHECK(whole == 0);
+}
+
+static void test_random_workload()
+{
+	const uint64_t size = 1 << 20;
+
+	BuddyAllocator buddy(size, 256);
+	std::vector<bool> used(size / 256, false);
+
+	struct Range
+	{
+		uint64_t offset;
+		uint32_t order;
+	};
+
+	std::vector<Range> live;
+	std::mt19937       rng(7);
+
+	for (int i = 0; i < 20000; i++) {
+		if (!live.empty() && (rng() % 3 == 0 || live.size() > 500)) {
+			const size_t index = rng() % live.size();
+			const auto   range = live[index];
+
+			for (uint64_t unit = range.offset / 256; unit < (range.offset + buddy.rangeSize(range.order)) / 256; unit++)
+				used[unit] = false;
+
+			buddy.free(range.offset, range.order);
+			live.erase(live.begin() + index);
+		} else {
+			const uint32_t order = rng() % 6;
+
+			uint64_t offset;
+			if (!buddy.allocate(order, offset)) continue;
+
+			UNIT_CHECK(offset % buddy.rangeSize(order) == 0);
+			UNIT_CHECK(offset + buddy.rangeSize(order) <= size);
+
+			// No two live ranges overlap
+			for (uint64_t unit = offset / 256; unit < (offset + buddy.rangeSize(order)) / 256; unit++) {
+				UNIT_CHECK(!used[unit]);
+				used[unit] = true;
+			}
+
+			live.push_back({ offset, order });
+		}
+	}
+
+	for (const auto& range : live)
+		buddy.free(range.offset, range.order);
+
+	uint64_t whole;
+	UNIT_CHECK(buddy.allocate(buddy.maxOrder(), whole));
+}
+
+int main()
+{
+	test_orders();
+	test_split_and_merge();
+	test_random_workload();
+
+	return UNIT_RESULT();
+}
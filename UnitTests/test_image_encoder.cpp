@@ -0,0 +1,177 @@
+#include "unit_test.h"
+
+#include <vkdl/graphics/image_encoder.h>
+
+#include "../thirdparty/stb/stb_image.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+
+// Noise in the top half for the literal paths, flat runs and a gradient below
+// for matches, runs and the QOI index and diff ops
+static vkdl::ColorImage test_image(uint32_t width, uint32_t height)
+{
+	vkdl::ColorImage image(width, height);
+	std::mt19937     rng(3);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			auto& pixel = image.at(x, y);
+
+			if (y < height / 2) {
+				const uint32_t value = rng();
+				pixel = vkdl::Color(uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24));
+			} else if (x < width / 2) {
+				pixel = vkdl::Color(uint8_t(40), uint8_t(80), uint8_t(120), uint8_t(255));
+			} else {
+				pixel = vkdl::Color(uint8_t(x), uint8_t(x + 1), uint8_t(y), uint8_t(x % 7 == 0 ? 128 : 255));
+			}
+		}
+	}
+
+	return image;
+}
+
+static bool same_pixels(const vkdl::ColorImage& image, const uint8_t* rgba)
+{
+	return std::memcmp(image.data(), rgba, static_cast<size_t>(image.width()) * image.height() * 4) == 0;
+}
+
+// Reference decoder following the QOI specification
+static std::vector<uint8_t> decode_qoi(const std::vector<uint8_t>& data, uint32_t& width, uint32_t& height)
+{
+	const auto read_u32 = [&](size_t at) {
+		return (uint32_t(data[at]) << 24) | (uint32_t(data[at + 1]) << 16) | (uint32_t(data[at + 2]) << 8) | data[at + 3];
+	};
+
+	if (data.size() < 22 || std::memcmp(data.data(), "qoif", 4) != 0) return {};
+
+	width  = read_u32(4);
+	height = read_u32(8);
+
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+	uint8_t index[64][4] = {};
+	uint8_t px[4]        = { 0, 0, 0, 255 };
+	size_t  pos          = 14;
+	int     run          = 0;
+
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		if (run > 0) {
+			run--;
+		} else if (pos < data.size() - 8) {
+			const uint8_t op = data[pos++];
+
+			if (op == 0xfe) {
+				std::memcpy(px, &data[pos], 3);
+				pos += 3;
+			} else if (op == 0xff) {
+				std::memcpy(px, &data[pos], 4);
+				pos += 4;
+			} else if ((op & 0xc0) == 0x00) {
+				std::memcpy(px, index[op], 4);
+			} else if ((op & 0xc0) == 0x40) {
+				px[0] += ((op >> 4) & 3) - 2;
+				px[1] += ((op >> 2) & 3) - 2;
+				px[2] += (op & 3) - 2;
+			} else if ((op & 0xc0) == 0x80) {
+				const int dg = (op & 0x3f) - 32;
+				const int b2 = data[pos++];
+				px[0] += dg - 8 + ((b2 >> 4) & 0x0f);
+				px[1] += dg;
+				px[2] += dg - 8 + (b2 & 0x0f);
+			} else {
+				run = op & 0x3f;
+			}
+
+			std::memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+		}
+
+		std::memcpy(&pixels[i], px, 4);
+	}
+
+	// End marker, seven zero bytes and a one
+	if (data.size() - pos != 8 || std::memcmp(&data[pos], "\0\0\0\0\0\0\0\1", 8) != 0) return {};
+
+	return pixels;
+}
+
+static void test_png_round_trip()
+{
+	const auto image = test_image(257, 131);
+
+	for (int level : { 0, 1, 3, 9 }) {
+		for (uint32_t strip_rows : { 0u, 1u, 16u }) {
+			vkdl::PNGEncoder encoder(level);
+			encoder.setStripRows(strip_rows);
+
+			const auto png = encoder.encode(image);
+
+			int width, height, channels;
+			uint8_t* decoded = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width, &height, &channels, 4);
+
+			UNIT_CHECK(decoded != nullptr);
+			if (!decoded) continue;
+
+			UNIT_CHECK(width == 257 && height == 131 && channels == 4);
+			UNIT_CHECK(same_pixels(image, decoded));
+
+			stbi_image_free(decoded);
+		}
+	}
+}
+
+static void test_png_compresses()
+{
+	const vkdl::ColorImage flat(vkdl::Color(uint8_t(1), uint8_t(2), uint8_t(3), uint8_t(4)), 512, 512);
+
+	const auto stored     = vkdl::PNGEncoder(0).encode(flat);
+	const auto compressed = vkdl::PNGEncoder(6).encode(flat);
+
+	UNIT_CHECK(stored.size() > 512 * 512 * 4);
+	UNIT_CHECK(compressed.size() * 50 < stored.size());
+}
+
+static void test_qoi_round_trip()
+{
+	const auto image = test_image(199, 77);
+	const auto qoi   = vkdl::QOIEncoder().encode(image);
+
+	uint32_t width = 0, height = 0;
+	const auto decoded = decode_qoi(qoi, width, height);
+
+	UNIT_CHECK(width == 199 && height == 77);
+	UNIT_CHECK(!decoded.empty() && same_pixels(image, decoded.data()));
+
+	// Flat images collapse into runs
+	const vkdl::ColorImage flat(vkdl::Color(uint8_t(9), uint8_t(9), uint8_t(9), uint8_t(255)), 256, 256);
+	UNIT_CHECK(vkdl::QOIEncoder().encode(flat).size() < 2048);
+}
+
+static void test_ppm_header()
+{
+	const auto ppm = vkdl::PPMEncoder().encode(test_image(5, 3));
+	const std::string header = "P6\n5 3\n255\n";
+
+	UNIT_CHECK(ppm.size() == header.size() + 5 * 3 * 3);
+	UNIT_CHECK(std::memcmp(ppm.data(), header.data(), header.size()) == 0);
+}
+
+static void test_from_extension()
+{
+	UNIT_CHECK(dynamic_cast<const vkdl::PNGEncoder*>(vkdl::ImageEncoder::fromExtension("shot.PNG")) != nullptr);
+	UNIT_CHECK(dynamic_cast<const vkdl::QOIEncoder*>(vkdl::ImageEncoder::fromExtension("shot.qoi")) != nullptr);
+	UNIT_CHECK(vkdl::ImageEncoder::fromExtension("shot.bmp") == nullptr);
+}
+
+int main()
+{
+	test_png_round_trip();
+	test_png_compresses();
+	test_qoi_round_trip();
+	test_ppm_header();
+	test_from_extension();
+
+	return UNIT_RESULT();
+}
@@ -0,0 +1,149 @@
+#include "unit_test.h"
+
+#include <vkdl/graphics/image_kernels.h>
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+using vkdl::ImageKernels;
+using vkdl::PixelLayout;
+
+static std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<uint8_t> bytes(size);
+	for (auto& byte : bytes)
+		byte = static_cast<uint8_t>(rng());
+	return bytes;
+}
+
+// Runs `kernel` on the SIMD paths and on the scalar ones, the results must be identical
+static bool matches_scalar(size_t size, const std::function<void(std::vector<uint8_t>&)>& kernel)
+{
+	std::vector<uint8_t> simd   = random_bytes(size, 1);
+	std::vector<uint8_t> scalar = simd;
+
+	ImageKernels::setSimdEnabled(true);
+	kernel(simd);
+
+	ImageKernels::setSimdEnabled(false);
+	kernel(scalar);
+
+	ImageKernels::setSimdEnabled(true);
+
+	return simd == scalar;
+}
+
+static void test_known_values()
+{
+	const uint8_t rgba[8] = { 10, 20, 30, 255, 200, 100, 50, 128 };
+
+	uint8_t bgra[8];
+	ImageKernels::convert(rgba, PixelLayout::RGBA8, bgra, PixelLayout::BGRA8, 2);
+	UNIT_CHECK(bgra[0] == 30 && bgra[1] == 20 && bgra[2] == 10 && bgra[3] == 255);
+
+	uint8_t rgb[6];
+	ImageKernels::convert(rgba, PixelLayout::RGBA8, rgb, PixelLayout::RGB8, 2);
+	UNIT_CHECK(std::memcmp(rgb, "\x0a\x14\x1e\xc8\x64\x32", 6) == 0);
+
+	uint8_t premultiplied[8];
+	std::memcpy(premultiplied, rgba, sizeof(rgba));
+	ImageKernels::premultiplyAlpha(premultiplied, 2);
+	UNIT_CHECK(premultiplied[0] == 10 && premultiplied[3] == 255);
+	UNIT_CHECK(premultiplied[4] == 100 && premultiplied[5] == 50 && premultiplied[6] == 25 && premultiplied[7] == 128);
+
+	// 2x3 image turned clockwise becomes 3x2
+	const uint8_t src[6] = { 1, 2, 3, 4, 5, 6 };
+	uint8_t       dst[6];
+	ImageKernels::rotate(src, dst, 3, 2, 1, vkdl::ImageRotation::Rotate90);
+	UNIT_CHECK(std::memcmp(dst, "\x04\x01\x05\x02\x06\x03", 6) == 0);
+
+	uint8_t flipped[6];
+	std::memcpy(flipped, src, sizeof(src));
+	ImageKernels::flipHorizontal(flipped, 3, 2, 1);
+	UNIT_CHECK(std::memcmp(flipped, "\x03\x02\x01\x06\x05\x04", 6) == 0);
+
+	uint32_t colors[3] = { 0xff0000ff, 0x12345678, 0xff0000ff };
+	ImageKernels::replaceColor(colors, 3, 0xff0000ff, 0);
+	UNIT_CHECK(colors[0] == 0 && colors[1] == 0x12345678 && colors[2] == 0);
+}
+
+// Sizes above the parallel threshold, with odd widths for the SIMD tails
+static void test_simd_matches_scalar()
+{
+	const uint32_t width  = 1021;
+	const uint32_t height = 517;
+	const size_t   pixels = static_cast<size_t>(width) * height;
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		std::vector<uint8_t> dst(pixels * 4);
+		ImageKernels::convert(data.data(), PixelLayout::RGBA8, dst.data(), PixelLayout::BGRA8, pixels);
+		data = dst;
+	}));
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		std::vector<uint8_t> dst(pixels * 3);
+		ImageKernels::convert(data.data(), PixelLayout::RGBA8, dst.data(), PixelLayout::RGB8, pixels);
+		data = dst;
+	}));
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		ImageKernels::premultiplyAlpha(data.data(), pixels);
+	}));
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		ImageKernels::unpremultiplyAlpha(data.data(), pixels);
+	}));
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		ImageKernels::flipHorizontal(data.data(), width, height, 4);
+	}));
+
+	UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+		std::vector<uint8_t> dst(pixels * 4);
+		ImageKernels::rotate(data.data(), dst.data(), width, height, 4, vkdl::ImageRotation::Rotate270);
+		data = dst;
+	}));
+
+	for (auto filter : { vkdl::ResizeFilter::Box, vkdl::ResizeFilter::Bilinear, vkdl::ResizeFilter::Lanczos3 }) {
+		UNIT_CHECK(matches_scalar(pixels * 4, [&](std::vector<uint8_t>& data) {
+			std::vector<uint8_t> dst(static_cast<size_t>(611) * 389 * 4);
+			ImageKernels::resize(data.data(), width, height, dst.data(), 611, 389, 4, filter);
+			data = dst;
+		}));
+	}
+}
+
+// Rotating four times and flipping twice gives the image back
+static void test_round_trips()
+{
+	const uint32_t width  = 333;
+	const uint32_t height = 1001;
+
+	const auto original = random_bytes(static_cast<size_t>(width) * height * 4, 2);
+
+	auto image = original;
+	std::vector<uint8_t> rotated(image.size());
+	for (int i = 0; i < 4; i++) {
+		const bool odd = (i % 2) != 0;
+		ImageKernels::rotate(image.data(), rotated.data(), odd ? height : width, odd ? width : height, 4, vkdl::ImageRotation::Rotate90);
+		std::swap(image, rotated);
+	}
+	UNIT_CHECK(image == original);
+
+	ImageKernels::flipVertical(image.data(), width, height, 4);
+	UNIT_CHECK(image != original);
+	ImageKernels::flipVertical(image.data(), width, height, 4);
+	UNIT_CHECK(image == original);
+}
+
+int main()
+{
+	test_known_values();
+	test_simd_matches_scalar();
+	test_round_trips();
+
+	return UNIT_RESULT();
+}
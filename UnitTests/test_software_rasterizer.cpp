@@ -0,0 +1,127 @@
+#include "unit_test.h"
+
+#include <vkdl/graphics/software_rasterizer.h>
+#include <vkdl/graphics/drawlist_2d.h>
+
+// Untextured geometry only, which the rasterizer draws without a Context
+
+static bool pixel_is(const vkdl::ColorImage& image, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b)
+{
+	const auto& pixel = image.at(x, y);
+	return pixel.r == r && pixel.g == g && pixel.b == b;
+}
+
+// Pixel centers inside the rectangle are covered, the ones on its edges are not
+static void test_coverage()
+{
+	vkdl::DrawList2D drawlist;
+	drawlist.addFilledRect(vkdl::vec2(2, 3), vkdl::vec2(5, 4), vkdl::Colors::Red);
+
+	vkdl::SoftwareRasterizer rasterizer;
+	const auto image = rasterizer.render(drawlist, vkdl::uvec2(16, 16));
+
+	size_t red = 0;
+	for (uint32_t y = 0; y < 16; y++) {
+		for (uint32_t x = 0; x < 16; x++) {
+			const bool inside = x >= 2 && x < 7 && y >= 3 && y < 7;
+			UNIT_CHECK(inside ? pixel_is(image, x, y, 255, 0, 0) : pixel_is(image, x, y, 0, 0, 0));
+			red += inside;
+		}
+	}
+
+	UNIT_CHECK(red == 20);
+}
+
+// The diagonal shared by the two triangles of a quad is owned by one of them, so a
+// translucent quad blends every pixel exactly once
+static void test_shared_edges()
+{
+	vkdl::DrawList2D drawlist;
+	drawlist.addFilledRect(vkdl::vec2(0, 0), vkdl::vec2(32, 32), vkdl::Color(uint8_t(255), uint8_t(255), uint8_t(255), uint8_t(128)));
+	drawlist.addFilledTriangle(vkdl::vec2(40, 0), vkdl::vec2(72, 0), vkdl::vec2(40, 32), vkdl::Color(uint8_t(255), uint8_t(255), uint8_t(255), uint8_t(128)));
+	drawlist.addFilledTriangle(vkdl::vec2(72, 0), vkdl::vec2(72, 32), vkdl::vec2(40, 32), vkdl::Color(uint8_t(255), uint8_t(255), uint8_t(255), uint8_t(128)));
+
+	vkdl::SoftwareRasterizer rasterizer;
+	const auto image = rasterizer.render(drawlist, vkdl::uvec2(80, 32));
+
+	const auto expected = image.at(0, 0);
+	UNIT_CHECK(expected.r > 100 && expected.r < 160);
+
+	for (uint32_t y = 0; y < 32; y++) {
+		for (uint32_t x = 0; x < 72; x++) {
+			if (x >= 32 && x < 40) continue;
+			UNIT_CHECK(pixel_is(image, x, y, expected.r, expected.g, expected.b));
+		}
+	}
+}
+
+// Later geometry blends over earlier geometry, also across tile boundaries
+static void test_submission_order()
+{
+	const uint32_t size = vkdl::SoftwareRasterizer::tile_size * 3 + 7;
+
+	vkdl::DrawList2D drawlist;
+	drawlist.addFilledRect(vkdl::vec2(0, 0), vkdl::vec2(float(size), float(size)), vkdl::Colors::Red);
+	drawlist.addFilledRect(vkdl::vec2(10, 10), vkdl::vec2(float(size - 20), float(size - 20)), vkdl::Colors::Lime);
+	drawlist.addFilledRect(vkdl::vec2(20, 20), vkdl::vec2(float(size - 40), float(size - 40)), vkdl::Color(uint8_t(0), uint8_t(0), uint8_t(255), uint8_t(0)));
+
+	vkdl::SoftwareRasterizer rasterizer;
+	const auto image = rasterizer.render(drawlist, vkdl::uvec2(size, size));
+
+	UNIT_CHECK(pixel_is(image, 5, 5, 255, 0, 0));
+	UNIT_CHECK(pixel_is(image, size - 5, size - 5, 255, 0, 0));
+
+	// The fully transparent rectangle leaves the green one visible
+	for (uint32_t i = 10; i < size - 10; i++) {
+		UNIT_CHECK(pixel_is(image, i, size / 2, 0, 255, 0));
+		UNIT_CHECK(pixel_is(image, size / 2, i, 0, 255, 0));
+	}
+}
+
+static void test_clip_rect()
+{
+	vkdl::DrawList2D drawlist;
+	drawlist.pushClipRect(4, 4, 8, 8);
+	drawlist.addFilledRect(vkdl::vec2(0, 0), vkdl::vec2(16, 16), vkdl::Colors::White);
+	drawlist.popClipRect();
+
+	vkdl::SoftwareRasterizer rasterizer;
+	const auto image = rasterizer.render(drawlist, vkdl::uvec2(16, 16));
+
+	UNIT_CHECK(pixel_is(image, 3, 8, 0, 0, 0));
+	UNIT_CHECK(pixel_is(image, 4, 4, 255, 255, 255));
+	UNIT_CHECK(pixel_is(image, 11, 11, 255, 255, 255));
+	UNIT_CHECK(pixel_is(image, 12, 8, 0, 0, 0));
+}
+
+// A render is deterministic no matter how tiles are spread over the threads
+static void test_repeatable()
+{
+	vkdl::DrawList2D drawlist;
+	for (int i = 0; i < 200; i++) {
+		const float x = float((i * 37) % 300);
+		const float y = float((i * 53) % 200);
+		drawlist.addFilledTriangle(vkdl::vec2(x, y), vkdl::vec2(x + 60, y + 10), vkdl::vec2(x + 20, y + 45),
+			vkdl::Color(uint8_t(i * 7), uint8_t(i * 13), uint8_t(i * 29), uint8_t(96 + i % 128)));
+	}
+
+	vkdl::SoftwareRasterizer rasterizer;
+	const auto first  = rasterizer.render(drawlist, vkdl::uvec2(320, 240));
+	const auto second = rasterizer.render(drawlist, vkdl::uvec2(320, 240));
+
+	UNIT_CHECK(vkdl::SoftwareRasterizer::compare(first, second, 0) == 0);
+
+	const vkdl::ColorImage black(vkdl::Colors::Black, 320, 240);
+	UNIT_CHECK(vkdl::SoftwareRasterizer::compare(first, black) > 0);
+}
+
+int main()
+{
+	test_coverage();
+	test_shared_edges();
+	test_submission_order();
+	test_clip_rect();
+	test_repeatable();
+
+	return UNIT_RESULT();
+}
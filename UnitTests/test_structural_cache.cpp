@@ -0,0 +1,104 @@
+#include "unit_test.h"
+
+#include "../VKDL/src/structural_cache.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using vkdl::priv::StructuralCache;
+
+struct TestKey
+{
+	std::string name;
+	int         value;
+
+	size_t hash() const
+	{
+		size_t seed = 0;
+		vkdl::priv::hashCombine(seed, name);
+		vkdl::priv::hashCombine(seed, value);
+		return seed;
+	}
+
+	bool operator==(const TestKey& rhs) const
+	{
+		return name == rhs.name && value == rhs.value;
+	}
+};
+
+// Every key lands in the same bucket, so lookups have to compare keys
+struct CollidingKey
+{
+	int value;
+
+	size_t hash() const { return 0; }
+	bool operator==(const CollidingKey& rhs) const { return value == rhs.value; }
+};
+
+static void test_shares_equal_keys()
+{
+	StructuralCache<TestKey, int> cache;
+	int created = 0;
+
+	const auto create = [&]() { created++; return std::make_shared<int>(created); };
+
+	auto a = cache.getOrCreate({ "blend", 1 }, create);
+	auto b = cache.getOrCreate({ "blend", 1 }, create);
+	auto c = cache.getOrCreate({ "blend", 2 }, create);
+
+	UNIT_CHECK(a == b);
+	UNIT_CHECK(a != c);
+	UNIT_CHECK(created == 2);
+}
+
+// Only weak references are kept, an object dies with its last user
+static void test_weak_entries()
+{
+	StructuralCache<CollidingKey, int> cache;
+
+	std::weak_ptr<int> weak;
+	{
+		auto object = cache.getOrCreate({ 1 }, []() { return std::make_shared<int>(1); });
+		weak = object;
+	}
+	UNIT_CHECK(weak.expired());
+
+	auto kept    = cache.getOrCreate({ 2 }, []() { return std::make_shared<int>(2); });
+	auto renewed = cache.getOrCreate({ 1 }, []() { return std::make_shared<int>(3); });
+
+	UNIT_CHECK(*renewed == 3);
+	UNIT_CHECK(*cache.getOrCreate({ 2 }, []() { return std::make_shared<int>(4); }) == 2);
+}
+
+// Threads racing for one key all get the object inserted first
+static void test_concurrent_lookups()
+{
+	StructuralCache<TestKey, int> cache;
+	std::atomic<int>              created(0);
+
+	std::vector<std::shared_ptr<int>> results(8);
+	std::vector<std::thread>          threads;
+
+	for (size_t i = 0; i < results.size(); i++) {
+		threads.emplace_back([&, i]() {
+			results[i] = cache.getOrCreate({ "race", 0 }, [&]() { return std::make_shared<int>(++created); });
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	for (const auto& result : results)
+		UNIT_CHECK(result == results.front());
+}
+
+int main()
+{
+	test_shares_equal_keys();
+	test_weak_entries();
+	test_concurrent_lookups();
+
+	return UNIT_RESULT();
+}
@@ -0,0 +1,185 @@
+#include "unit_test.h"
+
+#include <vkdl/graphics/texture_container.h>
+#include <vkdl/util/file_io.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Only parsing is tested, createTexture needs a Context
+
+static vkdl::ColorImage test_image(uint32_t width, uint32_t height)
+{
+	vkdl::ColorImage image(width, height);
+
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++)
+			image.at(x, y) = vkdl::Color(uint8_t(x * 19), uint8_t(y * 31), uint8_t(x ^ y), uint8_t(255 - x));
+
+	return image;
+}
+
+static void put_u32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+{
+	std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+static std::vector<uint8_t> dds_header(uint32_t width, uint32_t height, uint32_t mip_count, uint32_t fourcc)
+{
+	std::vector<uint8_t> data(128, 0);
+
+	put_u32(data, 0, 0x20534444);                           // "DDS "
+	put_u32(data, 4, 124);
+	put_u32(data, 8, 0x1007 | (mip_count > 1 ? 0x20000 : 0)); // caps, height, width, pixel format, mip count
+	put_u32(data, 12, height);
+	put_u32(data, 16, width);
+	put_u32(data, 28, mip_count);
+	put_u32(data, 76, 32);
+	put_u32(data, 80, 0x4);                                  // DDPF_FOURCC
+	put_u32(data, 84, fourcc);
+
+	return data;
+}
+
+static bool write_bytes(const char* path, const std::vector<uint8_t>& data)
+{
+	return vkdl::writeFile(path, data.data(), data.size());
+}
+
+static void test_ktx2_rgba8()
+{
+	const auto image = test_image(13, 7);
+
+	vkdl::TextureBakeOptions options;
+	options.format = vkdl::TextureBakeFormat::RGBA8;
+
+	UNIT_CHECK(vkdl::TextureContainer::bake(image, "unit_rgba8.ktx2", options));
+
+	vkdl::TextureContainer container;
+	UNIT_CHECK(container.loadFromFile("unit_rgba8.ktx2"));
+	UNIT_CHECK(container.format() == vk::Format::eR8G8B8A8Unorm);
+	UNIT_CHECK(container.extent().x == 13 && container.extent().y == 7);
+	UNIT_CHECK(!container.isCompressed());
+	UNIT_CHECK(!container.generatesMips());
+
+	// 13x7, 6x3, 3x1, 1x1
+	UNIT_CHECK(container.mipLevels() == 4);
+
+	if (container.mipLevels() == 4) {
+		const auto& base = container.getLevel(0);
+		UNIT_CHECK(base.size == 13 * 7 * 4);
+		UNIT_CHECK(std::memcmp(base.data, image.data(), base.size) == 0);
+
+		const auto& last = container.getLevel(3);
+		UNIT_CHECK(last.width == 1 && last.height == 1 && last.size == 4);
+	}
+
+	container.close();
+	std::remove("unit_rgba8.ktx2");
+}
+
+static void test_ktx2_bc()
+{
+	const auto image = test_image(64, 32);
+
+	vkdl::TextureBakeOptions options;
+	options.format = vkdl::TextureBakeFormat::BC3;
+	options.srgb   = true;
+
+	UNIT_CHECK(vkdl::TextureContainer::bake(image, "unit_bc3.ktx2", options));
+
+	vkdl::TextureContainer container;
+	UNIT_CHECK(container.loadFromFile("unit_bc3.ktx2"));
+	UNIT_CHECK(container.format() == vk::Format::eBc3SrgbBlock);
+	UNIT_CHECK(container.isCompressed());
+	UNIT_CHECK(container.mipLevels() == 7);
+
+	// Levels below one block still take a whole block
+	for (uint32_t level = 0; level < container.mipLevels(); level++) {
+		const auto& info = container.getLevel(level);
+		UNIT_CHECK(info.size == ((info.width + 3) / 4) * ((info.height + 3) / 4) * 16);
+	}
+
+	container.close();
+	std::remove("unit_bc3.ktx2");
+}
+
+static void test_dds()
+{
+	// DXT5 8x8 with two levels, 4 + 1 blocks
+	auto data = dds_header(8, 8, 2, 0x35545844);
+	data.resize(128 + 5 * 16, 0xab);
+
+	UNIT_CHECK(write_bytes("unit_dxt5.dds", data));
+
+	vkdl::TextureContainer container;
+	UNIT_CHECK(container.loadFromFile("unit_dxt5.dds"));
+	UNIT_CHECK(container.format() == vk::Format::eBc3UnormBlock);
+	UNIT_CHECK(container.mipLevels() == 2);
+
+	if (container.mipLevels() == 2) {
+		UNIT_CHECK(container.getLevel(0).size == 64);
+		UNIT_CHECK(container.getLevel(1).size == 16);
+		UNIT_CHECK(container.getLevel(1).data == container.getLevel(0).data + 64);
+	}
+
+	container.close();
+
+	// A level cut short rejects the file
+	data.resize(data.size() - 1);
+	UNIT_CHECK(write_bytes("unit_dxt5.dds", data));
+	UNIT_CHECK(!container.loadFromFile("unit_dxt5.dds"));
+	UNIT_CHECK(container.empty());
+
+	std::remove("unit_dxt5.dds");
+}
+
+static void test_dds_dx10()
+{
+	auto data = dds_header(4, 2, 1, 0x30315844);              // "DX10"
+	data.resize(128 + 20, 0);
+	put_u32(data, 128, 28);                                  // DXGI_FORMAT_R8G8B8A8_UNORM
+	put_u32(data, 132, 3);                                   // Texture 2D
+	put_u32(data, 140, 1);
+	data.resize(data.size() + 4 * 2 * 4, 0x7f);
+
+	UNIT_CHECK(write_bytes("unit_dx10.dds", data));
+
+	vkdl::TextureContainer container;
+	UNIT_CHECK(container.loadFromFile("unit_dx10.dds"));
+	UNIT_CHECK(container.format() == vk::Format::eR8G8B8A8Unorm);
+	UNIT_CHECK(container.mipLevels() == 1 && container.getLevel(0).size == 32);
+
+	container.close();
+
+	// Cube maps are not read
+	put_u32(data, 112, 0x200);
+	UNIT_CHECK(write_bytes("unit_dx10.dds", data));
+	UNIT_CHECK(!container.loadFromFile("unit_dx10.dds"));
+
+	std::remove("unit_dx10.dds");
+}
+
+static void test_rejects_garbage()
+{
+	std::vector<uint8_t> data(256, 0x5a);
+	UNIT_CHECK(write_bytes("unit_garbage.ktx2", data));
+
+	vkdl::TextureContainer container;
+	UNIT_CHECK(!container.loadFromFile("unit_garbage.ktx2"));
+	UNIT_CHECK(!container.loadFromFile("unit_missing.ktx2"));
+
+	std::remove("unit_garbage.ktx2");
+}
+
+int main()
+{
+	test_ktx2_rgba8();
+	test_ktx2_bc();
+	test_dds();
+	test_dds_dx10();
+	test_rejects_garbage();
+
+	return UNIT_RESULT();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdio>
+
+// The unit tests are plain executables run by ctest, they cover the CPU side code
+// and need no Vulkan device. A failed check is reported and the test carries on,
+// main returns UNIT_RESULT().
+static int unit_test_failures = 0;
+
+#define UNIT_CHECK(expression) \
+	do { \
+		if (!(expression)) { \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expression); \
+			unit_test_failures++; \
+		} \
+	} while (0)
+
+#define UNIT_RESULT() (unit_test_failures == 0 ? 0 : 1)
@@ -14,6 +14,7 @@ public:
 	DescriptorSetLayoutBuilder& setShaderStage(vk::ShaderStageFlagBits stage);
 	DescriptorSetLayoutBuilder& addSampler(vk::Sampler sampler);
 	DescriptorSetLayoutBuilder& pushCurrentBinding();
+	DescriptorSetLayoutBuilder& setFlags(vk::DescriptorSetLayoutCreateFlags flags);
 
 	std::shared_ptr<DescriptorSetLayout> build();
 
@@ -21,6 +22,7 @@ private:
 	std::vector<vk::DescriptorSetLayoutBinding> bindings;
 	std::vector<vk::Sampler>                    samplers;
 	vk::DescriptorSetLayoutBinding              curr_binding;
+	vk::DescriptorSetLayoutCreateFlags          flags;
 };
 
 VKDL_END
\ No newline at end of file
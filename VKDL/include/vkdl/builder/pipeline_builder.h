@@ -5,7 +5,15 @@
 #include "../core/renderpass.h"
 
 VKDL_BEGIN
+VKDL_PRIV_BEGIN
 
+struct PipelineKey;
+
+VKDL_PRIV_END
+
+// build() and buildAsync() hand out the pipeline already built from structurally
+// equal state (same shader modules, fixed function state, layout and render pass)
+// for as long as that pipeline is alive.
 class PipelineBuilder
 {
 public:
@@ -59,7 +67,18 @@ public:
 
 	std::shared_ptr<Pipeline> build();
 
+	// Compiles on a background thread. The returned pipeline has its layout right away
+	// and waits for the compile the first time its handle is used, see Pipeline::isReady.
+	// Shader stage specialization info must outlive the compile.
+	std::shared_ptr<Pipeline> buildAsync() const;
+
 private:
+	vk::Pipeline createPipeline() const;
+
+	// False when some state is only known by pointer (specialization info, extension
+	// structs), such pipelines are never shared
+	bool makeKey(VKDL_PRIV_NAMESPACE_NAME::PipelineKey& key) const;
+
 	std::vector<vk::PipelineShaderStageCreateInfo>     ss_info;
 	std::vector<vk::VertexInputBindingDescription>     vib_desc;
 	std::vector<vk::VertexInputAttributeDescription>   via_desc;
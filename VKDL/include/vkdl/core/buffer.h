@@ -3,6 +3,8 @@
 #include "include_vulkan.h"
 #include "context.h"
 #include "exception.h"
+#include "memory_allocator.h"
+#include "upload_service.h"
 
 VKDL_BEGIN
 VKDL_PRIV_BEGIN
@@ -18,8 +20,9 @@ constexpr bool is_iterator_v<T, std::void_t<iter_cat_t<T>>> = true;
 
 VKDL_PRIV_END
 
+// Memory comes from the context's MemoryAllocator, defragment() may move it
 template <class T>
-class Buffer
+class Buffer : public MemoryOwner
 {
 public:
 	static VKDL_NODISCARD VKDL_INLINE Buffer<T> createVertexBuffer(size_t size)
@@ -43,8 +46,7 @@ public:
 public:
 	VKDL_INLINE Buffer() VKDL_NOEXCEPT :
 		buffer(nullptr),
-		memory(nullptr),
-		mapped_ptr(nullptr),
+		allocation(),
 		allocated_size(0),
 		item_size(0),
 		usage(),
@@ -54,8 +56,7 @@ public:
 	
 	VKDL_INLINE Buffer(vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memory_props, vk::SharingMode sharing_mode = vk::SharingMode::eExclusive) VKDL_NOEXCEPT :
 		buffer(nullptr),
-		memory(nullptr),
-		mapped_ptr(nullptr),
+		allocation(),
 		allocated_size(0),
 		item_size(0),
 		usage(usage | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc),
@@ -85,14 +86,15 @@ public:
 	
 	VKDL_INLINE Buffer(Buffer&& rhs) VKDL_NOEXCEPT :
 		buffer(std::exchange(rhs.buffer, nullptr)),
-		memory(std::exchange(rhs.memory, nullptr)),
-		mapped_ptr(std::exchange(rhs.mapped_ptr, nullptr)),
+		allocation(std::exchange(rhs.allocation, {})),
 		allocated_size(std::exchange(rhs.allocated_size, 0)),
 		item_size(std::exchange(rhs.item_size, 0)),
 		usage(std::exchange(rhs.usage, {})),
 		memory_props(std::exchange(rhs.memory_props, {})),
 		sharing_mode(std::exchange(rhs.sharing_mode, vk::SharingMode::eExclusive))
-	{}
+	{
+		adoptAllocation();
+	}
 	
 	VKDL_INLINE ~Buffer()
 	{
@@ -120,14 +122,15 @@ public:
 		clear();
 
 		buffer         = std::exchange(rhs.buffer, nullptr);
-		memory         = std::exchange(rhs.memory, nullptr);
-		mapped_ptr     = std::exchange(rhs.mapped_ptr, nullptr);
+		allocation     = std::exchange(rhs.allocation, {});
 		allocated_size = std::exchange(rhs.allocated_size, 0);
 		item_size      = std::exchange(rhs.item_size, 0);
 		usage          = std::exchange(rhs.usage, {});
 		memory_props   = std::exchange(rhs.memory_props, {});
 		sharing_mode   = std::exchange(rhs.sharing_mode, vk::SharingMode::eExclusive);
 
+		adoptAllocation();
+
 		return *this;
 	}
 
@@ -136,29 +139,30 @@ public:
 		return buffer;
 	}
 
+	// Copies through the upload service, works for device local buffers and from any thread.
+	// The ready future signals that the data reached the buffer.
+	VKDL_INLINE std::shared_future<void> uploadAsync(const T* data, size_t count, size_t offset = 0)
+	{
+		VKDL_CHECK(offset + count <= item_size);
+
+		return Context::get().upload_service->uploadBuffer(buffer, offset * sizeof(T), data, count * sizeof(T));
+	}
+
+	// Host visible memory stays mapped, map() only offsets into it and unmap() only flushes
 	VKDL_NODISCARD VKDL_INLINE T* map(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE)
 	{
-		if (mapped_ptr) 
-			return mapped_ptr;
-		
-		return mapped_ptr = static_cast<T*>(Context::get().device.mapMemory(memory, offset, size));
+		VKDL_CHECK_MSG(allocation.mapped, "buffer memory is not host visible");
+		return reinterpret_cast<T*>(allocation.mapped + offset);
 	}
 
 	VKDL_INLINE void unmap(bool flush = false)
 	{
 		if (flush) this->flush();
-		Context::get().device.unmapMemory(memory);
-		mapped_ptr = nullptr;
 	}
 
 	VKDL_INLINE void flush(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE)
 	{
-		vk::MappedMemoryRange range = {};
-		range.memory = memory;
-		range.offset = offset;
-		range.size   = size;
-
-		VK_CHECK(Context::get().device.flushMappedMemoryRanges(1, &range));
+		Context::get().memory_allocator->flush(allocation, offset, size);
 	}
 
 	VKDL_INLINE void resize(size_t new_size, bool retain = true)
@@ -184,37 +188,28 @@ public:
 		auto req        = device.getBufferMemoryRequirements(new_buffer);
 
 		if (allocated_size < req.size) {
-			vk::MemoryAllocateInfo image_info = {};
-			image_info.allocationSize  = req.size;
-			image_info.memoryTypeIndex = ctx.findMemoryType(req.memoryTypeBits, memory_props);
-
-			auto new_memory = device.allocateMemory(image_info);
-			device.bindBufferMemory(new_buffer, new_memory, 0);
+			auto new_allocation = ctx.memory_allocator->allocate(req, memory_props, MemoryAllocator::categoryOf(usage), true, this);
+			device.bindBufferMemory(new_buffer, new_allocation.memory, new_allocation.offset);
 
-			if (memory != nullptr) {
-				if (retain)
-					copyBuffer(new_buffer, buffer, (vk::DeviceSize)size_in_bytes());
-				device.free(std::exchange(memory, new_memory));
-			} else {
-				memory = new_memory;
-			}
+			if (!allocation.empty() && retain)
+				copyBuffer(new_buffer, buffer, (vk::DeviceSize)std::min(size_in_bytes(), sizeof(T) * new_size));
 
+			retireBuffer(std::exchange(buffer, new_buffer), std::exchange(allocation, new_allocation));
 			allocated_size = req.size;
-			mapped_ptr     = nullptr;
 		} else {
-			device.bindBufferMemory(new_buffer, memory, 0);
+			device.bindBufferMemory(new_buffer, allocation.memory, allocation.offset);
+			retireBuffer(std::exchange(buffer, new_buffer), {});
 		}
 
-		device.destroy(std::exchange(buffer, new_buffer));
 		item_size  = new_size;
 	}
 
 	VKDL_INLINE void clear()
 	{
-		auto device = Context::get().device;
-		device.destroy(std::exchange(buffer, nullptr));
-		device.free(std::exchange(memory, nullptr));
-		mapped_ptr     = nullptr;
+		// Buffers that never allocated can live and die without a Context
+		if (!buffer) return;
+
+		retireBuffer(std::exchange(buffer, nullptr), std::exchange(allocation, {}));
 		allocated_size = 0;
 		item_size      = 0;
 	}
@@ -247,16 +242,67 @@ public:
 	VKDL_INLINE void swap(Buffer<T>& rhs) VKDL_NOEXCEPT
 	{
 		std::swap(buffer, rhs.buffer);
-		std::swap(memory, rhs.memory);
-		std::swap(mapped_ptr, rhs.mapped_ptr);
+		std::swap(allocation, rhs.allocation);
 		std::swap(allocated_size, rhs.allocated_size);
 		std::swap(item_size, rhs.item_size);
 		std::swap(usage, rhs.usage);
 		std::swap(memory_props, rhs.memory_props);
 		std::swap(sharing_mode, rhs.sharing_mode);
+
+		adoptAllocation();
+		rhs.adoptAllocation();
+	}
+
+	// Called by MemoryAllocator::defragment, the buffer is recreated in `to`
+	VKDL_INLINE bool relocate(const MemoryAllocation& from, const MemoryAllocation& to) override
+	{
+		if (!buffer || allocation.memory != from.memory || allocation.offset != from.offset)
+			return false;
+
+		auto& ctx    = Context::get();
+		auto  device = ctx.device;
+
+		vk::BufferCreateInfo buffer_info = {};
+		buffer_info.size        = sizeof(T) * item_size;
+		buffer_info.usage       = usage;
+		buffer_info.sharingMode = sharing_mode;
+
+		auto new_buffer = device.createBuffer(buffer_info);
+		device.bindBufferMemory(new_buffer, to.memory, to.offset);
+
+		copyBuffer(new_buffer, buffer, (vk::DeviceSize)size_in_bytes());
+
+		// Frames in flight may still read the old buffer
+		ctx.retire([device, old_buffer = buffer]() { device.destroy(old_buffer); });
+
+		buffer     = new_buffer;
+		allocation = to;
+
+		return true;
 	}
 
 private:
+	// Frames in flight may still read the buffer, it and its memory are released once they completed
+	VKDL_INLINE static void retireBuffer(vk::Buffer old_buffer, MemoryAllocation old_allocation)
+	{
+		auto& ctx = Context::get();
+
+		// Without an owner the range is never moved by defragment() meanwhile
+		ctx.memory_allocator->setOwner(old_allocation, nullptr);
+
+		ctx.retire([device = ctx.device, old_buffer, old_allocation]() mutable {
+			device.destroy(old_buffer);
+			Context::get().memory_allocator->free(old_allocation);
+		});
+	}
+
+	// The allocator hands `this` to defragment(), which changes when the buffer moves
+	VKDL_INLINE void adoptAllocation()
+	{
+		if (allocation.block)
+			Context::get().memory_allocator->setOwner(allocation, this);
+	}
+
 	VKDL_INLINE void copyBuffer(vk::Buffer dst_buffer, vk::Buffer src_buffer, vk::DeviceSize size)
 	{
 		auto& ctx = Context::get();
@@ -273,8 +319,7 @@ private:
 
 protected:
 	vk::Buffer              buffer;
-	vk::DeviceMemory        memory;
-	T*                      mapped_ptr;
+	MemoryAllocation        allocation;
 	vk::DeviceSize          allocated_size;
 	size_t                  item_size;
 	vk::BufferUsageFlags    usage;
@@ -1,7 +1,10 @@
 #include "config.h"
+#include "pipeline.h"
+#include "renderpass.h"
 #include "../util/uuid.h"
 
 #define VKDL_BUILTIN_RENDERPASS0_UUID "1ADB22D2-D170-425F-A56A-8A94A96770DF"
+#define VKDL_BUILTIN_RENDERPASS1_UUID "68EC035A-CE05-4C2C-A4CC-3705D2FCF241"
 
 #define VKDL_BUILTIN_PIPELINE0_UUID "DAA72873-ABD8-44D8-A247-ED6A5CC40558"
 #define VKDL_BUILTIN_PIPELINE1_UUID "3FDD44FE-B5F0-454C-9AFB-2B4A0DDA7B6B"
@@ -9,7 +12,9 @@
 
 VKDL_BEGIN
 
-void registerBuiltinRenderpass(UUID uuid);
-void registerBuiltinPipeline(UUID uuid);
+// Both return the handle of the builtin object, registering it on first use. A
+// builtin pipeline registers the render pass it is built against as well
+RenderPassHandle registerBuiltinRenderpass(UUID uuid);
+PipelineHandle registerBuiltinPipeline(UUID uuid);
 
 VKDL_END
\ No newline at end of file
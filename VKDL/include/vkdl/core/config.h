@@ -4,6 +4,9 @@
 #  define VKDL_PLATFORM_WINDOWS
 #endif
 
+// Define project wide to compile the CPU zones and counters of core/cpu_profiler.h
+// #define VKDL_ENABLE_PROFILING
+
 #if defined( __cpp_constexpr )
 #  define VKDL_CONSTEXPR constexpr
 #  if 201304 <= __cpp_constexpr
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "renderpass.h"
 #include "pipeline.h"
 #include "../util/uuid.h"
@@ -8,6 +16,35 @@
 VKDL_BEGIN
 
 class Context;
+class UploadService;
+class MemoryAllocator;
+class DescriptorAllocator;
+class SamplerCache;
+class ReadbackQueue;
+class GpuProfiler;
+
+// Compute and Transfer resolve to dedicated queue families when the device
+// exposes them (async compute, DMA engine), and to the graphics queue otherwise.
+enum class QueueType
+{
+	Graphics,
+	Compute,
+	Transfer
+};
+
+// Milliseconds spent bringing the context up, see Context::getStartupTimings
+struct StartupTimings
+{
+	double   instance_ms         = 0.0;
+	double   device_ms           = 0.0;
+	double   pipeline_cache_ms   = 0.0; // Reading and validating the cache file
+	double   pipeline_build_ms   = 0.0; // Sum over every pipeline built so far
+	uint32_t pipeline_count      = 0;
+	double   pipeline_wait_ms    = 0.0; // Time draws spent blocked on pipelines still compiling
+	uint32_t pipeline_wait_count = 0;
+	size_t   pipeline_cache_size = 0;   // Bytes handed to the driver, 0 when nothing was reused
+	bool     pipeline_cache_hit  = false;
+};
 
 class ContextCreator
 {
@@ -23,6 +60,23 @@ public:
 	ContextCreator& setPhysicalDeviceType(vk::PhysicalDeviceType type);
 	ContextCreator& enableDebug(uint32_t level = 5);
 
+	// Leaves out the surface and swapchain extensions, so the context runs on devices
+	// and drivers without a display (lavapipe, GPU-less servers). Only offscreen
+	// targets such as RenderTexture can render. Always on where VKDL has no window.
+	ContextCreator& setHeadless(bool value);
+
+	// Times every frame and render() call on the GPU, see GpuProfiler. Also enables
+	// VK_EXT_debug_utils labels when the instance supports them.
+	ContextCreator& enableGpuProfiler(uint32_t max_scopes_per_frame = 256);
+
+	// Pipelines are compiled through a cache loaded from `path`, and written back
+	// when the context is destroyed. A cache from another device or driver is ignored.
+	ContextCreator& setPipelineCachePath(const std::string& path);
+
+	// Starts compiling the builtin pipelines in the background while the context is
+	// created, instead of on first use by DrawList2D or TextureView. On by default.
+	ContextCreator& setPrecompileBuiltins(bool value);
+
 	VKDL_NODISCARD std::unique_ptr<Context> create();
 
 private:
@@ -32,6 +86,11 @@ private:
 	std::vector<const char*> device_extensions;
 	vk::PhysicalDeviceType   physical_device_type;
 	uint32_t                 debug_level;
+	std::string              pipeline_cache_path;
+	bool                     precompile_builtins;
+	bool                     headless;
+	uint32_t                 gpu_profiler_scopes; // 0 when the profiler is off
+	bool                     debug_utils;
 };
 
 class Context
@@ -46,25 +105,69 @@ class Context
 	Context(const ContextCreator& creator);
 
 public:
+	static VKDL_CONSTEXPR uint32_t invalid_handle = ~0u;
+
 	static VKDL_INLINE Context& get() { return *context_inst; }
 
 	~Context();
 
+	// Any thread can record single time commands, each one allocates from a command
+	// pool of its own. End the command buffer on the thread that began it
 	vk::CommandBuffer beginSingleTimeCommmand();
 	void endSingleTimeCommmand(vk::CommandBuffer cmd_buffer);
 
+	// Submissions and presents are serialized per queue, so any thread can use them
+	void submit(QueueType type, uint32_t submit_count, const vk::SubmitInfo* submits, vk::Fence fence = nullptr);
+	vk::Result present(uint32_t queue_family_idx, const vk::PresentInfoKHR& present_info);
+	void waitIdle(QueueType type);
+
+	// Keeps `object` alive until the GPU finished every frame submitted so far, for
+	// resources replaced while frames in flight may still use them
+	void retire(std::shared_ptr<void> object);
+
+	// Same, for raw handles: `release` runs once those frames completed
+	void retire(std::function<void()> release);
+
+	// Counts a frame and releases the retired objects whose frames completed.
+	// PlatformWindow and RenderTexture call it once their frame is submitted
+	void endFrame();
+
+	VKDL_NODISCARD vk::Queue getQueue(QueueType type) const;
+	VKDL_NODISCARD uint32_t getQueueFamilyIndex(QueueType type) const;
+	VKDL_NODISCARD bool hasDedicatedQueue(QueueType type) const;
+
+	// Records vkCmdPushDescriptorSetKHR, only valid when push_descriptor_supported
+	void pushDescriptorSet(vk::CommandBuffer cmd, vk::PipelineBindPoint bind_point, vk::PipelineLayout layout, uint32_t set, uint32_t write_count, const vk::WriteDescriptorSet* writes);
+
 	void transitionImageLayout(vk::CommandBuffer cmd_buffer, vk::Image image, vk::Format format, vk::ImageLayout old_layout, vk::ImageLayout new_layout);
 
 	vk::SampleCountFlagBits getMaxUsableSampleCount() const;
 	vk::DeviceSize alignMemorySize(vk::DeviceSize size) const;
 	uint32_t findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags props) const;
 
+	// UUIDs are only looked up at registration, draws go through the handles, which
+	// index dense arrays and stay valid for the lifetime of the context. Registration
+	// and lookups are safe from any thread
 	bool hasPipeline(const UUID& pipeline_uuid) const;
-	void registerPipeline(const UUID& pipeline_uuid, std::shared_ptr<Pipeline>& pipeline);
+	PipelineHandle registerPipeline(const UUID& pipeline_uuid, std::shared_ptr<Pipeline>& pipeline);
+	VKDL_NODISCARD PipelineHandle findPipeline(const UUID& pipeline_uuid) const;
 	Pipeline& getPipeline(const UUID& uuid);
+	Pipeline& getPipeline(PipelineHandle handle);
+
 	bool hasRenderPass(const UUID& renderpass_uuid) const;
-	void registerRenderPass(const UUID& renderpass_uuid, std::shared_ptr<RenderPass>& renderpass);
+	RenderPassHandle registerRenderPass(const UUID& renderpass_uuid, std::shared_ptr<RenderPass>& renderpass);
+	VKDL_NODISCARD RenderPassHandle findRenderPass(const UUID& renderpass_uuid) const;
 	RenderPass& getRenderpass(const UUID& uuid);
+	RenderPass& getRenderpass(RenderPassHandle handle);
+
+	// Writes the pipeline cache to the path given to the creator, returns false
+	// when there is no path or the file could not be written
+	bool savePipelineCache();
+
+	void recordPipelineBuild(double milliseconds);
+	void recordPipelineWait(double milliseconds);
+	VKDL_NODISCARD StartupTimings getStartupTimings() const;
+	VKDL_NODISCARD std::string startupReport() const;
 	
 	vk::Instance instance;
 
@@ -73,26 +176,69 @@ public:
 	vk::PhysicalDeviceMemoryProperties physical_device_memory_props;
 
 	vk::Device             device;
-	std::vector<vk::Queue> queues;
+	std::vector<vk::Queue> queues; // One per queue family, indexed by family
 	uint32_t               graphics_queue_family_idx;
-	vk::DescriptorPool     descriptor_pool;
-	vk::CommandPool        command_pool;
+	uint32_t               compute_queue_family_idx;
+	uint32_t               transfer_queue_family_idx;
 	vk::PipelineCache      pipeline_cache;
 
-	std::map<UUID, std::shared_ptr<Pipeline>>   pipelines;
-	std::map<UUID, std::shared_ptr<RenderPass>> render_passes;
+	// VK_KHR_push_descriptor is enabled whenever the device exposes it
+	bool                   push_descriptor_supported;
+
+	// Created without surface extensions, see ContextCreator::setHeadless
+	bool                   headless;
+
+	// Incremented by endFrame every time a window presents or a RenderTexture displays, used to age cached resources
+	std::atomic<uint64_t>  frame_count;
+
+	std::vector<std::shared_ptr<Pipeline>>   pipelines;     // Indexed by PipelineHandle
+	std::vector<std::shared_ptr<RenderPass>> render_passes; // Indexed by RenderPassHandle
+
+	std::unique_ptr<MemoryAllocator>     memory_allocator;
+	std::unique_ptr<DescriptorAllocator> descriptor_allocator;
+	std::unique_ptr<SamplerCache>        sampler_cache;
+	std::unique_ptr<UploadService>       upload_service;
+	std::unique_ptr<ReadbackQueue>       readback_queue;
+	std::unique_ptr<GpuProfiler>         gpu_profiler; // Null unless enabled
 
 	vk::DebugReportCallbackEXT debug_callback;
 
 private:
+	struct RetiredBatch
+	{
+		vk::Fence                          fence;
+		std::vector<std::shared_ptr<void>> objects;
+	};
+
 	void setDebugCallback(uint32_t debug_level);
 	void selectPhysicalDevice(vk::PhysicalDeviceType preffered_type);
-	void createDevice(const std::vector<const char*>& device_extensions);
-	void createDescriptorPool();
-	void createCommandPool();
+	void createDevice(std::vector<const char*> device_extensions);
+	void createPipelineCache();
+
+	vk::CommandPool threadCommandPool();
+
+	std::mutex& queueMutex(uint32_t queue_family_idx);
 
 private:
 	static Context* context_inst;
+
+	std::vector<std::unique_ptr<std::mutex>> queue_mutexes;
+
+	// Created on first use by each thread, until the context is destroyed
+	std::unordered_map<std::thread::id, vk::CommandPool> command_pools;
+	std::mutex                               command_pool_mutex;
+
+	std::vector<std::shared_ptr<void>>       retired; // Not covered by a fence yet
+	std::vector<RetiredBatch>                retired_batches;
+	std::mutex                               retire_mutex;
+
+	std::map<UUID, PipelineHandle>           pipeline_handles;
+	std::map<UUID, RenderPassHandle>         render_pass_handles;
+	mutable std::mutex                       registry_mutex; // Both maps and both arrays
+
+	std::string                              pipeline_cache_path;
+	StartupTimings                           timings;
+	mutable std::mutex                       timings_mutex;
 };
 
 VKDL_END
\ No newline at end of file
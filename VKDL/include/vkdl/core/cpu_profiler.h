@@ -0,0 +1,104 @@
+#pragma once
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Zones and counters only exist when VKDL_ENABLE_PROFILING is defined, otherwise
+// every VKDL_PROFILE_* macro expands to nothing. Zone names must be string literals.
+#define VKDL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VKDL_PROFILE_CONCAT(a, b) VKDL_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef VKDL_ENABLE_PROFILING
+#  define VKDL_PROFILE_ZONE(name) const VKDL_NAMESPACE_NAME::CpuProfileZone VKDL_PROFILE_CONCAT(vkdl_profile_zone_, __LINE__)(name)
+#  define VKDL_PROFILE_COUNT(counter, value) VKDL_NAMESPACE_NAME::CpuProfiler::count(VKDL_NAMESPACE_NAME::CpuCounter::counter, static_cast<uint64_t>(value))
+#  define VKDL_PROFILE_FRAME() VKDL_NAMESPACE_NAME::CpuProfiler::endFrame()
+#else
+#  define VKDL_PROFILE_ZONE(name) ((void)0)
+#  define VKDL_PROFILE_COUNT(counter, value) ((void)0)
+#  define VKDL_PROFILE_FRAME() ((void)0)
+#endif
+
+VKDL_BEGIN
+
+enum class CpuCounter : uint32_t
+{
+	DrawCalls,
+	Vertices,
+	Indices,
+	SkippedBinds, // RenderStates::bind calls that found a state already bound
+	UploadBytes,
+	GlyphMisses,
+
+	Count
+};
+
+struct CpuFrameCounters
+{
+	uint64_t frame  = 0;
+	uint64_t end_ns = 0; // CpuProfiler::now() when the frame ended
+	uint64_t values[static_cast<size_t>(CpuCounter::Count)] = {};
+
+	uint64_t operator[](CpuCounter counter) const;
+};
+
+// CPU side instrumentation. Every thread records its zones into its own ring of the
+// last ring_capacity zones, so recording only takes that thread's uncontended lock.
+// Counters are summed atomically and rolled over by endFrame(), which Context::endFrame
+// calls when PlatformWindow or RenderTexture submit a frame.
+//
+// exportChromeTrace() writes the zones and counters as trace_event JSON, which loads
+// in chrome://tracing and Perfetto. The ring of a thread that exited is released by the
+// first export after it, so short lived threads do not accumulate.
+class CpuProfiler
+{
+public:
+	static VKDL_CONSTEXPR size_t ring_capacity = 16384;
+	static VKDL_CONSTEXPR size_t frame_history = 1024;
+
+	// Nanoseconds since the profiler started
+	VKDL_NODISCARD static uint64_t now();
+
+	static void recordZone(const char* name, uint64_t begin_ns, uint64_t end_ns);
+	static void count(CpuCounter counter, uint64_t value);
+	static void endFrame();
+
+	// Names the calling thread in exported traces
+	static void setThreadName(const char* name);
+
+	// Counters of the last ended frame
+	VKDL_NODISCARD static CpuFrameCounters lastFrame();
+	VKDL_NODISCARD static const char* counterName(CpuCounter counter);
+
+	VKDL_NODISCARD static std::string exportChromeTrace();
+	VKDL_NODISCARD static bool saveChromeTrace(const char* path);
+
+	// Drops the recorded zones and frames
+	static void clear();
+};
+
+class CpuProfileZone
+{
+	VKDL_NOCOPY(CpuProfileZone);
+	VKDL_NOCOPYASS(CpuProfileZone);
+
+public:
+	VKDL_INLINE explicit CpuProfileZone(const char* name) :
+		name(name),
+		begin(CpuProfiler::now())
+	{
+	}
+
+	VKDL_INLINE ~CpuProfileZone()
+	{
+		CpuProfiler::recordZone(name, begin, CpuProfiler::now());
+	}
+
+private:
+	const char* name;
+	uint64_t    begin;
+};
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "include_vulkan.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+VKDL_BEGIN
+
+struct DescriptorAllocatorStats
+{
+	size_t pool_count     = 0;
+	size_t pool_set_count = 0; // Capacity of all pools
+	size_t live_set_count = 0;
+	size_t free_set_count = 0; // Freed sets waiting for reuse
+	size_t recycled_count = 0; // Allocations served from the free lists
+};
+
+// Allocates descriptor sets from a chain of pools. When a pool runs out another one,
+// twice as large up to `max_sets_per_pool`, is added to the chain. Freed sets are
+// kept on a free list per layout and handed out again to the next allocation with
+// the same layout, so pools are never fragmented and never need eFreeDescriptorSet.
+// Thread safe.
+class DescriptorAllocator
+{
+	VKDL_NOCOPY(DescriptorAllocator);
+	VKDL_NOCOPYASS(DescriptorAllocator);
+
+public:
+	// Descriptors reserved per set for each type
+	using PoolRatio = std::pair<vk::DescriptorType, float>;
+
+	static VKDL_CONSTEXPR uint32_t default_sets_per_pool = 64;
+	static VKDL_CONSTEXPR uint32_t max_sets_per_pool     = 4096;
+
+	DescriptorAllocator(uint32_t sets_per_pool = default_sets_per_pool);
+	DescriptorAllocator(const std::vector<PoolRatio>& ratios, uint32_t sets_per_pool = default_sets_per_pool);
+	~DescriptorAllocator();
+
+	VKDL_NODISCARD vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+	// The set must not be in use by pending command buffers. It is rewritten before reuse.
+	void free(vk::DescriptorSetLayout layout, vk::DescriptorSet desc_set);
+
+	// Drops the free list of a layout about to be destroyed, so its sets are never
+	// handed to a new layout that gets the same handle
+	void forget(vk::DescriptorSetLayout layout);
+
+	VKDL_NODISCARD DescriptorAllocatorStats getStats() const;
+
+private:
+	using FreeLists = std::map<vk::DescriptorSetLayout, std::vector<vk::DescriptorSet>>;
+
+	vk::DescriptorPool createPool(uint32_t max_sets) const;
+
+	std::vector<PoolRatio>          ratios;
+	uint32_t                        next_pool_size;
+	mutable std::mutex              mutex;
+	std::vector<vk::DescriptorPool> pools;
+	FreeLists                       free_sets;
+	DescriptorAllocatorStats        stats;
+};
+
+VKDL_END
\ No newline at end of file
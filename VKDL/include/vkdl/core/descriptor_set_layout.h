@@ -10,7 +10,7 @@ class DescriptorSetLayout : public std::enable_shared_from_this<DescriptorSetLay
 
 	VKDL_NOCOPY(DescriptorSetLayout);
 
-	DescriptorSetLayout(vk::DescriptorSetLayout layout);
+	DescriptorSetLayout(vk::DescriptorSetLayout layout, vk::DescriptorSetLayoutCreateFlags flags = {});
 
 public:
 	~DescriptorSetLayout();
@@ -18,8 +18,12 @@ public:
 	vk::DescriptorSetLayout getDescriptorSetLayout() const;
 	operator vk::DescriptorSetLayout() const;
 
+	// Sets of push descriptor layouts are never allocated, see Context::pushDescriptorSet
+	bool isPushDescriptor() const;
+
 private:
-	vk::DescriptorSetLayout layout;
+	vk::DescriptorSetLayout            layout;
+	vk::DescriptorSetLayoutCreateFlags flags;
 };
 
 VKDL_END
\ No newline at end of file
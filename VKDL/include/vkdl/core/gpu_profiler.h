@@ -0,0 +1,98 @@
+#pragma once
+
+#include "include_vulkan.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+VKDL_BEGIN
+
+class Drawable;
+class RenderOptions;
+
+struct GpuProfileStats
+{
+	std::string label;
+	double      last_ms = 0.0; // Summed over the scopes of the last resolved frame
+	double      avg_ms  = 0.0; // Over the last GpuProfiler::history_size frames
+	double      min_ms  = 0.0;
+	double      max_ms  = 0.0;
+	uint32_t    calls   = 0;   // Scopes with this label in the last resolved frame
+	uint64_t    frames  = 0;   // Frames resolved with this label
+};
+
+// Timestamp queries of one frame in flight of a render target. Targets keep one per
+// frame, so each query pool is reused only after the fence of its frame signaled.
+struct GpuQueryFrame
+{
+	vk::QueryPool            pool     = nullptr;
+	uint32_t                 used     = 0;     // Queries written since the last reset
+	std::vector<std::string> labels;           // Scope i spans queries 2i and 2i + 1
+	std::vector<uint32_t>    open;             // Scopes begun and not ended yet
+	bool                     recorded = false; // Holds results not read back yet
+};
+
+// Opt-in GPU timing, see ContextCreator::enableGpuProfiler. PlatformWindow and
+// RenderTexture bracket every frame and every render() call with timestamps, labeled
+// with RenderOptions::label or the type of the drawable. A frame's results are read
+// when that frame comes around again and its fence has signaled, nothing waits on the
+// GPU. Scope times are summed per label and frame.
+//
+// When VK_EXT_debug_utils is available, every scope is also recorded as a command
+// buffer label for capture tools.
+class GpuProfiler
+{
+	VKDL_NOCOPY(GpuProfiler);
+	VKDL_NOCOPYASS(GpuProfiler);
+
+	struct History
+	{
+		std::vector<double> samples; // Ring of the last history_size frames
+		uint32_t            next   = 0;
+		uint64_t            frames = 0;
+		double              last   = 0.0;
+		uint32_t            calls  = 0;
+	};
+
+public:
+	static VKDL_CONSTEXPR uint32_t history_size = 120;
+
+	GpuProfiler(uint32_t max_scopes_per_frame, bool debug_labels);
+	~GpuProfiler();
+
+	void createFrame(GpuQueryFrame& frame) const;
+	void destroyFrame(GpuQueryFrame& frame) const;
+
+	// Reads back the previous results of `frame`, whose fence must have signaled, then
+	// resets its queries and opens the frame scope. Must be recorded outside a render pass.
+	void beginFrame(vk::CommandBuffer cmd, GpuQueryFrame& frame, const char* label);
+	void endFrame(vk::CommandBuffer cmd, GpuQueryFrame& frame);
+
+	// Scopes past max_scopes_per_frame still get debug labels, but no timestamps
+	void beginScope(vk::CommandBuffer cmd, GpuQueryFrame& frame, const char* label);
+	void endScope(vk::CommandBuffer cmd, GpuQueryFrame& frame);
+
+	VKDL_NODISCARD std::vector<GpuProfileStats> getStats() const;
+	VKDL_NODISCARD std::string report() const;
+	void resetStats();
+
+	VKDL_NODISCARD uint64_t droppedScopes() const;
+
+	static const char* drawableLabel(const Drawable& drawable, const RenderOptions& options);
+
+private:
+	void resolve(GpuQueryFrame& frame);
+
+	uint32_t                       max_queries;
+	bool                           debug_labels;
+	double                         timestamp_period; // Nanoseconds per tick
+	uint64_t                       timestamp_mask;
+
+	std::map<std::string, History> histories;
+	uint64_t                       dropped;
+	mutable std::mutex             mutex;
+};
+
+VKDL_END
\ No newline at end of file
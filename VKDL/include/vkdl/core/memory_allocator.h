@@ -0,0 +1,143 @@
+#pragma once
+
+#include "include_vulkan.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+struct MemoryBlock;
+
+VKDL_PRIV_END
+
+enum class MemoryCategory
+{
+	Texture,
+	VertexBuffer,
+	IndexBuffer,
+	UniformBuffer,
+	StagingBuffer,
+	Other,
+	Count
+};
+
+// A range of device memory. Host visible memory stays mapped for its whole
+// lifetime, `mapped` points at `offset`.
+struct MemoryAllocation
+{
+	vk::DeviceMemory                        memory      = nullptr;
+	vk::DeviceSize                          offset      = 0;
+	vk::DeviceSize                          size        = 0;
+	uint8_t*                                mapped      = nullptr;
+	uint32_t                                memory_type = 0;
+	MemoryCategory                          category    = MemoryCategory::Other;
+	VKDL_PRIV_NAMESPACE_NAME::MemoryBlock*  block       = nullptr; // nullptr for dedicated allocations
+
+	VKDL_NODISCARD bool empty() const { return !memory; }
+};
+
+// Resources that defragment() may move. Buffer and Texture register themselves when
+// they allocate and follow their own C++ moves with MemoryAllocator::setOwner.
+class MemoryOwner
+{
+public:
+	// Rebinds the resource to `to` and copies its contents, or returns false to stay
+	// in place. Handles replaced here must be released through Context::retire.
+	virtual bool relocate(const MemoryAllocation& from, const MemoryAllocation& to) = 0;
+
+protected:
+	~MemoryOwner() = default;
+};
+
+struct MemoryCategoryStats
+{
+	size_t         allocation_count = 0;
+	vk::DeviceSize bytes            = 0;
+};
+
+struct MemoryStats
+{
+	std::array<MemoryCategoryStats, static_cast<size_t>(MemoryCategory::Count)> categories = {};
+
+	size_t         block_count      = 0;
+	vk::DeviceSize block_bytes      = 0; // Reserved by blocks
+	vk::DeviceSize block_used_bytes = 0; // Handed out of blocks, after rounding
+	size_t         dedicated_count  = 0;
+	vk::DeviceSize dedicated_bytes  = 0;
+
+	VKDL_NODISCARD size_t deviceAllocationCount() const { return block_count + dedicated_count; }
+};
+
+// Suballocates device memory so thousands of buffers and textures share a handful
+// of vkAllocateMemory calls. Each memory type has one pool for buffers and one for
+// images, which keeps linear and optimal resources apart (bufferImageGranularity).
+// Pools are made of power of two blocks split with a buddy allocator; anything
+// larger than half a block gets a dedicated allocation. Thread safe.
+class MemoryAllocator
+{
+	VKDL_NOCOPY(MemoryAllocator);
+	VKDL_NOCOPYASS(MemoryAllocator);
+
+public:
+	static VKDL_CONSTEXPR vk::DeviceSize default_block_size = 64ull << 20;
+	static VKDL_CONSTEXPR vk::DeviceSize min_allocation     = 256;
+
+	MemoryAllocator(vk::DeviceSize block_size = default_block_size);
+	~MemoryAllocator();
+
+	// Allocations without an owner pin their block, defragment() leaves it alone
+	VKDL_NODISCARD MemoryAllocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags props, MemoryCategory category, bool linear, MemoryOwner* owner = nullptr);
+
+	// Allocate and bind
+	VKDL_NODISCARD MemoryAllocation allocate(vk::Buffer buffer, vk::MemoryPropertyFlags props, MemoryCategory category, MemoryOwner* owner = nullptr);
+	VKDL_NODISCARD MemoryAllocation allocate(vk::Image image, vk::MemoryPropertyFlags props, MemoryCategory category, bool linear = false, MemoryOwner* owner = nullptr);
+
+	void free(MemoryAllocation& allocation);
+
+	// For owners that moved in memory, no-op for dedicated allocations
+	void setOwner(const MemoryAllocation& allocation, MemoryOwner* owner);
+
+	// No-ops for host coherent memory
+	void flush(const MemoryAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) const;
+	void invalidate(const MemoryAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) const;
+
+	// Moves allocations out of blocks used below `max_occupancy` into fuller ones through
+	// MemoryOwner::relocate. Pending uploads are waited for first, and the old ranges are
+	// freed once the frames in flight completed, which releases the emptied blocks.
+	// Call it between frames, command buffers recorded earlier keep the old handles.
+	// Returns the number of allocations moved.
+	size_t defragment(float max_occupancy = 0.25f);
+
+	// Releases empty blocks that were kept around for reuse
+	void trim();
+
+	VKDL_NODISCARD MemoryStats getStats() const;
+
+	VKDL_NODISCARD static MemoryCategory categoryOf(vk::BufferUsageFlags usage);
+	VKDL_NODISCARD static const char* categoryName(MemoryCategory category);
+
+private:
+	using PoolKey = std::pair<uint32_t, bool>; // Memory type, linear
+
+	using Pool = std::vector<std::unique_ptr<VKDL_PRIV_NAMESPACE_NAME::MemoryBlock>>;
+
+	bool allocateFromPool(Pool& pool, vk::DeviceSize size, vk::DeviceSize alignment, MemoryCategory category, MemoryOwner* owner, MemoryAllocation& allocation);
+	void releaseBlock(Pool& pool, VKDL_PRIV_NAMESPACE_NAME::MemoryBlock* block);
+	void flushOrInvalidate(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size, bool flush) const;
+
+	uint8_t* mapIfHostVisible(vk::DeviceMemory memory, uint32_t memory_type) const;
+	vk::DeviceSize blockSizeFor(uint32_t memory_type) const;
+	void addStats(const MemoryAllocation& allocation, int64_t sign);
+
+	vk::DeviceSize          block_size;
+	mutable std::mutex      mutex;
+	std::map<PoolKey, Pool> pools;
+	MemoryStats             stats;
+};
+
+VKDL_END
\ No newline at end of file
@@ -2,29 +2,42 @@
 
 #include "pipeline_layout.h"
 #include "shader_module.h"
+#include "renderpass.h"
+
+#include <future>
 
 VKDL_BEGIN
 
+// Index of a pipeline registered with the Context
+using PipelineHandle = uint32_t;
+
 class Pipeline : public std::enable_shared_from_this<Pipeline>
 {
 	friend class PipelineBuilder;
 
 	VKDL_NOCOPY(Pipeline);
 
-	Pipeline(vk::Pipeline pipeline, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules);
+	Pipeline(vk::Pipeline pipeline, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules, std::shared_ptr<RenderPass>& renderpass);
+	Pipeline(std::shared_future<vk::Pipeline> pending, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules, std::shared_ptr<RenderPass>& renderpass);
 
 public:
 	~Pipeline();
 	
 	PipelineLayout& getPipelineLayout() const;
 
-	vk::Pipeline get();
+	// False while a pipeline from PipelineBuilder::buildAsync is still compiling.
+	// The layout is usable right away, the handle accessors wait for the compile.
+	VKDL_NODISCARD bool isReady() const;
+
+	vk::Pipeline get() const;
 	operator vk::Pipeline() const;
 
 private:
 	vk::Pipeline                               pipeline;
+	std::shared_future<vk::Pipeline>           pending;
 	std::shared_ptr<PipelineLayout>            layout;
 	std::vector<std::shared_ptr<ShaderModule>> modules;
+	std::shared_ptr<RenderPass>                renderpass;
 };
 
 VKDL_END
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "include_vulkan.h"
+#include "../graphics/image.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+VKDL_BEGIN
+
+class Texture;
+
+// Copies rendered images back to the host without stalling the renderer. Copies
+// are recorded into a frame's command buffer after its render pass, into one of a
+// small ring of host cached buffers, and delivered as ColorImage once the fence of
+// that frame signals. PlatformWindow records the queued requests in display() and
+// delivers finished ones at the start of the next frame on the rendering thread.
+// Source textures must stay alive until their request was recorded.
+class ReadbackQueue
+{
+	VKDL_NOCOPY(ReadbackQueue);
+	VKDL_NOCOPYASS(ReadbackQueue);
+
+public:
+	using Callback = std::function<void(ColorImage&&)>;
+
+private:
+	struct Slot
+	{
+		vk::Buffer       buffer;
+		vk::DeviceMemory memory;
+		uint8_t*         mapped;
+		vk::DeviceSize   size;
+		bool             coherent;
+
+		vk::Fence        fence;     // Set once the recording command buffer was submitted
+		bool             busy;
+		vk::Format       format;
+		uvec2            extent;
+		Callback         callback;
+	};
+
+	struct Request
+	{
+		const Texture* texture;
+		Callback       callback;
+	};
+
+public:
+	static VKDL_CONSTEXPR uint32_t default_slot_count = 3;
+
+	ReadbackQueue(uint32_t slot_count = default_slot_count);
+	~ReadbackQueue();
+
+	// RGBA8 and BGRA8, in unorm or srgb
+	VKDL_NODISCARD static bool supportsFormat(vk::Format format);
+
+	// Queues a copy of mip level 0 for the next recorded frame. The texture must have
+	// been written to and created with transfer source usage.
+	std::future<ColorImage> readback(const Texture& texture);
+	void readback(const Texture& texture, Callback callback);
+
+	// Records a copy of `image` into `cmd`, outside of any render pass. The image is
+	// in `layout` before and after the copy.
+	void record(vk::CommandBuffer cmd, vk::Image image, vk::Format format, const uvec2& extent, vk::ImageLayout layout, Callback callback);
+
+	// Records the queued texture requests
+	void record(vk::CommandBuffer cmd);
+
+	// Every copy recorded since the last call completes with `fence`
+	void submitted(vk::Fence fence);
+
+	// Delivers the copies whose fence signaled. Call before resetting a frame fence.
+	void collect();
+
+	VKDL_NODISCARD size_t pendingCount() const;
+
+private:
+	Slot& acquireSlot(vk::DeviceSize size);
+	void createSlotBuffer(Slot& slot, vk::DeviceSize size) const;
+	void destroySlotBuffer(Slot& slot) const;
+
+	mutable std::mutex   mutex;
+	std::deque<Slot>     slots;
+	std::vector<Request> requests;
+	uint32_t             next_slot;
+};
+
+VKDL_END
\ No newline at end of file
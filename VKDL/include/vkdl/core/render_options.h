@@ -16,6 +16,7 @@ public:
 	std::optional<vk::Viewport> viewport;
 	std::optional<vk::Rect2D>   scissor;
 	bool                        lazyRendering;
+	const char*                 label; // Names the render() call in GPU profiles and debug labels
 };
 
 VKDL_END
\ No newline at end of file
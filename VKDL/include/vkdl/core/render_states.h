@@ -2,6 +2,8 @@
 
 #include <optional>
 #include "include_vulkan.h"
+#include "pipeline.h"
+#include "renderpass.h"
 #include "../util/uuid.h"
 
 VKDL_BEGIN
@@ -46,6 +48,10 @@ struct Updatable
 class RenderStates
 {
 public:
+	void updateRenderPass(RenderPassHandle handle);
+	void updatePipeline(PipelineHandle handle);
+
+	// Look the handle up by UUID on every call, draw loops should keep the handle
 	void updateRenderPassUUID(const UUID& uuid);
 	void updatePipelineUUID(const UUID& uuid);
 	void updateViewport(const vk::Viewport& viewport);
@@ -55,11 +61,18 @@ public:
 
 	void bind(RenderTarget& target, const RenderOptions& options);
 
+	// Ends the frame's render pass. When nothing was drawn an empty pass is recorded
+	// first, so the target is still cleared and left in its final layout.
+	void endRenderPass(RenderTarget& target);
+
 private:
-	Updatable<UUID>              renderpass_uuid;
-	Updatable<UUID>              pipeline_uuid;
+	void beginRenderPass(RenderTarget& target);
+
+	Updatable<RenderPass*>       renderpass;
+	Updatable<Pipeline*>         pipeline;
 	Updatable<vk::Viewport>      viewport;
 	Updatable<vk::Rect2D>        scissor;
+	bool                         renderpass_begun = false;
 };
 
 VKDL_END
\ No newline at end of file
@@ -8,7 +8,7 @@ VKDL_BEGIN
 class Drawable;
 class RenderOptions;
 
-class RenderTarget abstract
+class RenderTarget
 {
 	friend class Drawable;
 
@@ -19,6 +19,10 @@ public:
 
 	virtual vk::CommandBuffer getCommandBuffer() = 0;
 	virtual vk::Framebuffer getFrameBuffer() = 0;
+
+	// The pass the framebuffers were created with, begun in place of the pass a
+	// drawable selects. Builtin pipelines are compatible with every builtin pass.
+	virtual vk::RenderPass getRenderPass() = 0;
 	virtual uvec2 getFrameBufferSize() const = 0;
 	virtual vk::ClearColorValue getClearColorValue() const = 0;
 };
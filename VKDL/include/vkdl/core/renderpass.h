@@ -4,6 +4,9 @@
 
 VKDL_BEGIN
 
+// Index of a render pass registered with the Context
+using RenderPassHandle = uint32_t;
+
 class RenderPass : public std::enable_shared_from_this<RenderPass>
 {
 	friend class RenderPassBuilder;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "include_vulkan.h"
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstddef>
+
+VKDL_BEGIN
+
+struct SamplerInfoHash
+{
+	size_t operator()(const vk::SamplerCreateInfo& info) const;
+};
+
+// Shares one vk::Sampler between every user of an identical SamplerCreateInfo.
+// Samplers are reference counted, the last release retires them (see Context::retire).
+// Create infos with a pNext chain are never shared. Thread safe.
+class SamplerCache
+{
+	VKDL_NOCOPY(SamplerCache);
+	VKDL_NOCOPYASS(SamplerCache);
+
+	struct Entry
+	{
+		vk::SamplerCreateInfo info;
+		uint32_t              ref_count;
+		bool                  shared;
+	};
+
+public:
+	SamplerCache();
+	~SamplerCache();
+
+	VKDL_NODISCARD vk::Sampler acquire(const vk::SamplerCreateInfo& info);
+	void release(vk::Sampler sampler);
+
+	VKDL_NODISCARD size_t samplerCount() const;
+
+private:
+	mutable std::mutex                                                      mutex;
+	std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, SamplerInfoHash> lookup;
+	std::map<vk::Sampler, Entry>                                            entries;
+};
+
+VKDL_END
\ No newline at end of file
@@ -1,13 +1,18 @@
 #pragma once
 
+#include <deque>
 #include <map>
+#include <mutex>
+#include <vector>
 #include "include_vulkan.h"
 
 VKDL_BEGIN
 
+// Loading the same SPIR-V again returns the module already alive, so pipelines built
+// from separate loads share their handle and hit the pipeline cache.
 class ShaderModule : public std::enable_shared_from_this<ShaderModule>
 {
-	ShaderModule(vk::ShaderModule module);
+	ShaderModule(vk::ShaderModule module, const uint32_t* code, size_t size_in_byte);
 
 	VKDL_NOCOPY(ShaderModule);
 
@@ -16,13 +21,18 @@ public:
 	
 	~ShaderModule();
 
+	// Returns the stage made earlier when it has the same entry point
 	vk::PipelineShaderStageCreateInfo makeShaderStageCreateInfo(vk::ShaderStageFlagBits stage, const char* name = "main");
 
 	vk::PipelineShaderStageCreateInfo operator[](vk::ShaderStageFlagBits stage) const;
 
+	VKDL_NODISCARD bool matches(const uint32_t* code, size_t size_in_byte) const;
+
 private:
 	std::map<vk::ShaderStageFlagBits, vk::PipelineShaderStageCreateInfo> stages;
-	std::vector<std::string>                                             names;
+	std::deque<std::string>                                              names; // Stable for pName
+	std::vector<uint32_t>                                                code;
+	mutable std::mutex                                                   mutex;
 	vk::ShaderModule                                                     module;
 };
 
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "include_vulkan.h"
+#include "../math/vector_type.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+VKDL_BEGIN
+
+class Texture;
+
+// Streams texture and buffer uploads without stalling the renderer. Uploads are
+// accepted from any thread and copied into a persistently mapped staging ring;
+// flush() records them into one batch and submits it, which PlatformWindow does
+// at the start of every frame. Uploads into textures without contents go through
+// a dedicated transfer queue family when the device has one, with queue family
+// ownership handed over to the graphics queue; everything else is copied on the
+// graphics queue ahead of the frame. The returned futures become ready once the
+// GPU finished the copy. Destination textures must stay alive until then.
+// Mips of textures created with setGenerateMips are blitted in the same batch,
+// or filtered on the CPU from the staged pixels when the format cannot be blitted.
+// flush() and wait() may be called from any thread, they are serialized.
+class UploadService
+{
+	VKDL_NOCOPY(UploadService);
+	VKDL_NOCOPYASS(UploadService);
+
+public:
+	// Persistently mapped, host coherent staging buffer
+	struct Staging
+	{
+		vk::Buffer       buffer;
+		vk::DeviceMemory memory;
+		uint8_t*         mapped;
+		vk::DeviceSize   size;
+	};
+
+private:
+	struct Job
+	{
+		Texture*                            texture;
+		vk::Buffer                          dst_buffer;
+		vk::DeviceSize                      dst_offset;
+		ivec2                               offset;
+		uvec2                               size;
+		vk::Buffer                          src_buffer;
+		vk::DeviceSize                      src_offset;
+		vk::DeviceSize                      src_size;
+		std::shared_ptr<std::promise<void>> promise;
+		std::function<void()>               on_complete;
+	};
+
+	// Level 0 rectangle whose mips are built on the CPU once the copy finished,
+	// for formats that cannot be blitted. `pixels` points into the staging memory.
+	struct CpuMips
+	{
+		Texture*       texture;
+		ivec2          offset;
+		uvec2          size;
+		const uint8_t* pixels;
+	};
+
+	struct Batch
+	{
+		vk::CommandBuffer                                transfer_cmd;
+		vk::CommandBuffer                                graphics_cmd;
+		vk::Semaphore                                    semaphore;
+		vk::Fence                                        fence;
+		vk::DeviceSize                                   ring_consumed;
+		std::vector<Staging>                             dedicated;
+		std::vector<CpuMips>                             cpu_mips;
+		std::vector<std::shared_ptr<std::promise<void>>> promises;
+		std::vector<std::function<void()>>               callbacks;
+	};
+
+public:
+	static VKDL_CONSTEXPR vk::DeviceSize default_ring_size = 64ull << 20;
+
+	UploadService(vk::DeviceSize ring_size = default_ring_size);
+	~UploadService();
+
+	// A texture that generates mips but cannot blit gets them filtered on the CPU, which
+	// needs level 0 on the GPU: they are built when flush() finds the copy completed, in
+	// practice by the next flush. Until then level 0 is sampled with the previous mips,
+	// the future becomes ready only once they are built.
+	std::shared_future<void> uploadTexture(Texture& texture, const void* pixels, const ivec2& offset, const uvec2& size);
+	std::shared_future<void> uploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size_in_bytes);
+
+	// For producers that write the pixels themselves (decoders), skipping the copy into the ring.
+	// Both are thread safe. uploadTexture takes ownership of `staging` and calls `on_complete`
+	// from flush() once the copy finished, before the future becomes ready.
+	VKDL_NODISCARD Staging allocateStaging(vk::DeviceSize size) const;
+	void releaseStaging(Staging& staging) const;
+	std::shared_future<void> uploadTexture(Texture& texture, Staging&& staging, const ivec2& offset, const uvec2& size, std::function<void()> on_complete = {});
+
+	void flush();
+	void wait();
+
+	VKDL_NODISCARD bool hasDedicatedTransferQueue() const;
+	VKDL_NODISCARD size_t pendingCount() const;
+
+private:
+	std::shared_future<void> enqueue(Job& job, const void* data);
+	bool allocateRing(vk::DeviceSize size, vk::DeviceSize& offset);
+	void collect(bool wait_all);
+
+	Staging createStaging(vk::DeviceSize size) const;
+	void destroyStaging(Staging& staging) const;
+
+	void recordTextureJobs(Batch& batch, Texture& texture, const std::vector<const Job*>& jobs, bool use_transfer_queue);
+	void recordBufferJobs(Batch& batch, const std::vector<const Job*>& jobs);
+
+	uint32_t        graphics_family;
+	uint32_t        transfer_family;
+	vk::CommandPool graphics_pool;
+	vk::CommandPool transfer_pool;
+
+	Staging         ring;
+	vk::DeviceSize  ring_head;
+	vk::DeviceSize  ring_used;
+	vk::DeviceSize  pending_consumed;
+
+	mutable std::mutex   mutex;
+	std::vector<Job>     pending;
+	std::vector<Staging> pending_dedicated;
+
+	// Guards the command pools and the batches in flight, held while recording
+	// and collecting but never while the callbacks run
+	std::mutex           submit_mutex;
+	std::deque<Batch>    in_flight;
+};
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "texture.h"
+#include "../math/rect.h"
+
+#include <deque>
+#include <vector>
+
+VKDL_BEGIN
+
+// An image packed into an atlas page. The rect is in texels, which is what
+// DrawList2D expects for texture coordinates.
+struct AtlasRegion
+{
+	const Texture* texture = nullptr;
+	irect          rect    = {};
+
+	VKDL_NODISCARD bool empty() const { return texture == nullptr; }
+
+	VKDL_NODISCARD vec2 uv0() const { return vec2(rect.position); }
+	VKDL_NODISCARD vec2 uv1() const { return vec2(rect.position + rect.size); }
+};
+
+// Packs small images (icons, sprites, UI pieces) into shared page textures so
+// drawing many of them binds one texture. Images go in at load time as a batch,
+// which packs tallest first and uploads each page once, or one at a time.
+//
+// Every image is surrounded by `extrude` copies of its border texels, so linear
+// filtering at its edges never picks up a neighbour, and `padding` transparent
+// texels. Images too large for a page get a page of their own. Pages live as long
+// as the builder and never move, regions stay valid until clear().
+class AtlasBuilder
+{
+	VKDL_NOCOPY(AtlasBuilder);
+	VKDL_NOCOPYASS(AtlasBuilder);
+
+	struct Shelf
+	{
+		uint32_t top;
+		uint32_t height;
+		uint32_t width;
+	};
+
+	struct Page
+	{
+		Texture            texture;
+		ColorImage         pixels; // CPU copy, so a batch uploads each page in one transfer
+		std::vector<Shelf> shelves;
+		uint32_t           next_shelf   = 0;
+		uint32_t           dirty_top    = 0;
+		uint32_t           dirty_bottom = 0;
+		bool               uploaded     = false;
+		bool               dedicated    = false;
+	};
+
+public:
+	static VKDL_CONSTEXPR uint32_t default_page_size = 1024;
+
+	AtlasBuilder(uint32_t page_size = default_page_size, uint32_t padding = 1, uint32_t extrude = 1);
+
+	VKDL_NODISCARD AtlasRegion add(const ColorImage& image);
+	VKDL_NODISCARD std::vector<AtlasRegion> add(const std::vector<const ColorImage*>& images);
+
+	VKDL_NODISCARD size_t pageCount() const;
+	VKDL_NODISCARD const Texture& getPage(size_t index) const;
+
+	// Destroys every page, the GPU must be done with them
+	void clear();
+
+private:
+	AtlasRegion place(const ColorImage& image, Page*& page);
+	Page& createPage(uint32_t width, uint32_t height, bool dedicated);
+	void upload(Page& page);
+
+	static bool packShelf(Page& page, uvec2 size, uvec2& position);
+
+	uint32_t         page_size;
+	uint32_t         padding;
+	uint32_t         extrude;
+	std::deque<Page> pages;
+};
+
+VKDL_END
\ No newline at end of file
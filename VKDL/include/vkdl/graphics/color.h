@@ -151,12 +151,16 @@ enum class Colors : uint32_t {
 struct Color {
 	VKDL_INLINE Color() VKDL_NOEXCEPT = default;
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 26495)
+#endif
 	VKDL_INLINE Color(Colors color) VKDL_NOEXCEPT {
 		*reinterpret_cast<Colors*>(this) = color;
 	}
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 	VKDL_INLINE explicit Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) VKDL_NOEXCEPT :
 		r(r),
@@ -2,14 +2,20 @@
 
 #include "../core/buffer.h"
 #include "../core/drawable.h"
+#include "../core/pipeline.h"
+#include "../core/renderpass.h"
 #include "../math/transform_2d.h"
 #include "vertex.h"
 
+#include <memory>
+
 VKDL_BEGIN
 
 class Texture;
 class Font;
+class GlyphAtlas;
 struct Glyph;
+struct AtlasRegion;
 
 struct TextStyle
 {
@@ -60,6 +66,7 @@ public:
 
 	void addImage(const Texture& texture, const vec2& pos, const vec2& size, const vec2& uv0, const vec2& uv1, const Color& col = Colors::White);
 	void addImage(const vec2& pos, const vec2& size, const vec2& uv0, const vec2& uv1, const Color& col = Colors::White);
+	void addImage(const AtlasRegion& region, const vec2& pos, const vec2& size, const Color& col = Colors::White);
 	void addImageQuad(const vec2& p0, const vec2& p1, const vec2& p2, const vec2& p3, const vec2& uv0, const vec2& uv1, const vec2& uv2, const vec2& uv3, const Color& col = Colors::White);
 
 	void addText(const vec2& pos, const std::string& text, const TextStyle& style);
@@ -79,10 +86,16 @@ public:
 
 	void clear();
 
+	// Recorded geometry, indices refer to `getVertices()` as a whole
+	VKDL_NODISCARD const std::vector<DrawCommand2D>& getCommands() const;
+	VKDL_NODISCARD const std::vector<Vertex2D>& getVertices() const;
+	VKDL_NODISCARD const std::vector<uint32_t>& getIndices() const;
+
 private:
 	void draw(RenderTarget& target, RenderStates& states, const RenderOptions& options) const override;
 
 	void newCommand();
+	void useGlyphTexture(const GlyphAtlas& atlas);
 	uint32_t reservePrimitives(uint32_t vert_size, uint32_t idx_size);
 
 private:
@@ -93,10 +106,18 @@ private:
 	std::vector<const Texture*> texture_stack;
 	std::vector<vk::Rect2D>     clip_rect_stack;
 	std::vector<Transform2D>    transform_stack;
+
+	// Glyph atlas textures the commands point at, kept after the atlas moved on (see GlyphAtlas)
+	std::vector<std::shared_ptr<const Texture>> glyph_textures;
 	
 	mutable Buffer<Vertex2D>   vertex_buffer;
 	mutable Buffer<uint32_t>   index_buffer;
 	mutable bool               update_buffer;
+
+	// Looked up on the first draw, recording needs no Context
+	mutable RenderPassHandle   render_pass;
+	mutable PipelineHandle     textured_pipeline;
+	mutable PipelineHandle     color_pipeline;
 };
 
 VKDL_END
\ No newline at end of file
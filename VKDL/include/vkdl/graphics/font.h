@@ -2,9 +2,11 @@
 
 #include "texture.h"
 #include "glyph.h"
+#include "glyph_atlas.h"
 
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -23,42 +25,25 @@ class Font
 {
 	struct FontHandles;
 
-	using GlyphTable = std::unordered_map<std::uint64_t, Glyph>;
-
-	struct Row
-	{
-		Row(uint32_t rowTop, uint32_t rowHeight) :
-			width(0),
-			top(rowTop),
-			height(rowHeight)
-		{
-		}
-
-		uint32_t width;
-		uint32_t top;
-		uint32_t height;
-	};
-
-	struct Page
-	{
-		explicit Page(bool smooth);
-
-		GlyphTable       glyphs;
-		Texture          texture;
-		uint32_t         next_row;
-		std::vector<Row> rows;
-	};
-
-	using PageTable = std::unordered_map<uint32_t, Page>;
+	using PageTable    = std::unordered_map<uint32_t, std::shared_ptr<GlyphAtlas>>;
+	using KerningTable = std::unordered_map<uint64_t, float>;
 
 public:
 	Font();
 	Font(const char* path);
 	Font(const void* data, size_t size_in_bytes);
 
+	// Fonts opened from the same file or the same data share one memory-mapped,
+	// parsed face. Each Font still rasterizes into its own glyph pages.
 	VKDL_NODISCARD bool loadFromFile(const char* path);
 	VKDL_NODISCARD bool loadFromMemory(const void* data, size_t size_in_bytes);
 
+	// Loads a precomputed AngelCode BMFont descriptor (text or binary) and its page
+	// images, without FreeType. Bitmap fonts have a fixed size: the character size
+	// given to the queries below is ignored, as are the bold and outline styles.
+	VKDL_NODISCARD bool loadFromBMFont(const char* path);
+	VKDL_NODISCARD bool isBitmapFont() const;
+
 	VKDL_NODISCARD const Glyph& getGlyph(std::uint32_t code_point, uint32_t character_size, bool bold, float outline_thickness = 0) const;
 	VKDL_NODISCARD bool hasGlyph(std::uint32_t code_point) const;
 
@@ -69,6 +54,28 @@ public:
 
 	VKDL_NODISCARD const Texture& getTexture(uint32_t character_size) const;
 
+	void setGlyphAtlas(std::shared_ptr<GlyphAtlas> atlas);
+	VKDL_NODISCARD const std::shared_ptr<GlyphAtlas>& getGlyphAtlas() const;
+
+	// The atlas holding the glyphs of `character_size`, the shared one when set
+	VKDL_NODISCARD std::shared_ptr<GlyphAtlas> getGlyphAtlas(uint32_t character_size) const;
+
+	// Limits the texture memory of the per-size pages. Pages not used this frame are
+	// dropped first, least recently used first, the remaining ones are trimmed to share
+	// the budget. A DrawList2D keeps the textures of dropped pages it was recorded with.
+	// A shared atlas is bounded with GlyphAtlas::setMemoryBudget instead.
+	void setMemoryBudget(size_t size_in_bytes);
+	VKDL_NODISCARD size_t getMemoryBudget() const;
+
+	VKDL_NODISCARD GlyphAtlasStats getStats() const;
+
+	// Writes the rasterized pages to a cache file keyed by the font content, so the
+	// next process can restore them with loadCache() instead of rasterizing again.
+	// loadCache() returns false when the file is missing, stale or from another font.
+	// Fonts using a shared atlas are not cached.
+	VKDL_NODISCARD bool saveCache(const char* path) const;
+	VKDL_NODISCARD bool loadCache(const char* path);
+
 	// void setSmooth(bool smooth);
 	// VKDL_NODISCARD bool isSmooth() const;
 
@@ -77,16 +84,29 @@ public:
 private:
 	void cleanup();
 
-	Page& loadPage(uint32_t character_size) const;
+	// Holds the face shared with other Fonts, empty for bitmap fonts
+	std::unique_lock<std::recursive_mutex> lockFace() const;
+
+	const std::shared_ptr<GlyphAtlas>& loadPage(uint32_t character_size) const;
+	void enforceMemoryBudget() const;
+	uint32_t getGlyphIndex(std::uint32_t code_point) const;
 	Glyph loadGlyph(std::uint32_t code_point, uint32_t character_size, bool bold, float outline_thickness) const;
-	irect findGlyphRect(Page& page, uvec2 size) const;
 
 	VKDL_NODISCARD bool setCurrentSize(uint32_t character_size) const;
 
 	std::shared_ptr<FontHandles>      font_handles;
+	uint64_t                          face_id;
+	uint64_t                          content_hash;
 	bool                              is_smooth;
 	FontInfo                          info;
 	mutable PageTable                 pages;
+	std::shared_ptr<GlyphAtlas>       shared_atlas;
+	size_t                            memory_budget;
+	mutable uint64_t                  current_frame;
+	mutable uint64_t                  page_evictions;
+	uint32_t                          bitmap_size;
+	float                             bitmap_line_height;
+	KerningTable                      bitmap_kernings;
 	mutable std::vector<std::uint8_t> pixel_buffer;
 };
 
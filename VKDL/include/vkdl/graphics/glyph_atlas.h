@@ -0,0 +1,155 @@
+#pragma once
+
+#include "texture.h"
+#include "glyph.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+
+struct GlyphKey
+{
+	uint64_t face_id;
+	uint32_t glyph_index;
+	uint32_t character_size;
+	bool     bold;
+	float    outline_thickness;
+
+	bool operator==(const GlyphKey& rhs) const;
+	bool operator!=(const GlyphKey& rhs) const;
+};
+
+struct GlyphKeyHash
+{
+	size_t operator()(const GlyphKey& key) const;
+};
+
+struct GlyphAtlasStats
+{
+	uint64_t hits           = 0;
+	uint64_t misses         = 0;
+	uint64_t evictions      = 0;
+	uint64_t page_evictions = 0;
+	uint64_t compactions    = 0;
+	size_t   glyph_count    = 0;
+	size_t   used_texels    = 0;
+	size_t   total_texels   = 0;
+	size_t   memory_usage   = 0;
+
+	float hitRate() const;
+	float occupancy() const;
+
+	GlyphAtlasStats& operator+=(const GlyphAtlasStats& rhs);
+};
+
+// Row packed glyph texture. A Font keeps one atlas per character size by default,
+// or shares a single atlas with other fonts (see Font::setGlyphAtlas) so text drawn
+// with mixed fonts, sizes and styles binds one texture and stays in one draw command.
+//
+// Every lookup stamps the glyph with Context::frame_count. When a memory budget is
+// set, the first access of a new frame evicts the least recently used glyphs and
+// repacks the survivors into the smallest texture that holds them. Allocating a glyph
+// grows the texture with every glyph in place, once the maximum size is reached it
+// evicts the least recently used glyphs right away. There is no minimum age, glyphs
+// recorded this frame may be evicted as well.
+//
+// Moving glyphs (eviction, trim() and clear()) puts the atlas on a new Texture object
+// and bumps getGeneration(). Draw lists hold the previous one through shareTexture()
+// and keep drawing with the coordinates they were recorded with; growing keeps the
+// object, texel coordinates stay valid. Textures are retired (see Context::retire)
+// once their last owner lets go, frames in flight keep sampling them.
+class GlyphAtlas
+{
+	VKDL_NOCOPY(GlyphAtlas);
+	VKDL_NOCOPYASS(GlyphAtlas);
+
+	struct Entry
+	{
+		Glyph    glyph;
+		irect    rect;
+		uint64_t last_used;
+		bool     pinned;
+	};
+
+	using GlyphTable = std::unordered_map<GlyphKey, Entry, GlyphKeyHash>;
+
+	struct Row
+	{
+		Row(uint32_t row_top, uint32_t row_height) :
+			width(0),
+			top(row_top),
+			height(row_height)
+		{
+		}
+
+		uint32_t width;
+		uint32_t top;
+		uint32_t height;
+	};
+
+public:
+	static VKDL_CONSTEXPR int32_t  padding          = 2;
+	static VKDL_CONSTEXPR uint32_t texture_min_size = 128;
+	static VKDL_CONSTEXPR uint32_t texture_max_size = 8192;
+
+	GlyphAtlas(uint32_t width = texture_min_size, uint32_t height = texture_min_size);
+
+	// Restores an atlas written by serialize(), giving its glyphs the face id of the
+	// loading font. On return `data` points at the page pixels (memoryUsage() bytes),
+	// which the caller uploads with upload() so several pages share one transfer.
+	GlyphAtlas(const uint8_t*& data, const uint8_t* end, uint64_t face_id);
+
+	VKDL_NODISCARD const Glyph* findGlyph(const GlyphKey& key);
+	// Pinned glyphs are never evicted, for glyphs that cannot be rasterized again
+	const Glyph& insertGlyph(const GlyphKey& key, const Glyph& glyph, bool pinned = false);
+
+	VKDL_NODISCARD irect allocate(uvec2 size);
+	void update(const void* pixels, const ivec2& offset, const uvec2& size);
+	void upload(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize buffer_offset);
+
+	void serialize(std::vector<uint8_t>& output) const;
+
+	void setMemoryBudget(size_t size_in_bytes);
+	VKDL_NODISCARD size_t getMemoryBudget() const;
+	VKDL_NODISCARD size_t memoryUsage() const;
+
+	void trim();
+	void trim(size_t size_in_bytes);
+
+	VKDL_NODISCARD const Texture& getTexture() const;
+	// Keeps the current texture alive after the atlas moved on to another one
+	VKDL_NODISCARD std::shared_ptr<const Texture> shareTexture() const;
+	VKDL_NODISCARD size_t glyphCount() const;
+	VKDL_NODISCARD uint64_t lastUsedFrame() const;
+	VKDL_NODISCARD uint64_t getGeneration() const;
+	VKDL_NODISCARD GlyphAtlasStats getStats() const;
+
+	void clear();
+
+private:
+	void syncFrame();
+	bool compact(size_t size_in_bytes);
+	void replaceTexture(Texture&& new_texture, bool keep_glyphs);
+	Texture createTexture(uint32_t width, uint32_t height, bool initialize = true) const;
+
+	static bool packRect(std::vector<Row>& rows, uint32_t& next_row, uvec2 extent, uvec2 size, irect& rect);
+
+	GlyphTable               glyphs;
+	std::shared_ptr<Texture> texture;
+	uint32_t                 next_row;
+	std::vector<Row>         rows;
+
+	size_t                   memory_budget;
+	uint64_t                 current_frame;
+	uint64_t                 last_used;
+	size_t                   used_texels;
+	uint64_t                 generation;
+	GlyphAtlasStats          stats;
+};
+
+VKDL_END
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include "../core/include_vulkan.h"
 #include "color.h"
+#include "image_kernels.h"
+
+#include <future>
 
 VKDL_BEGIN
 
@@ -41,6 +44,14 @@ public:
 
 	bool empty() const;
 
+	// Run on ImageKernels with sizeof(DataType) byte pixels, vectorized and split across threads
+	void flipHorizontal();
+	void flipVertical();
+	Image rotate(ImageRotation rotation) const;
+
+	// Each byte of a pixel is filtered as one channel, so DataType must be made of 1 to 4 bytes
+	Image resize(const uvec2& size, ResizeFilter filter = ResizeFilter::Bilinear) const;
+
 protected:
 	DataType*  pixels;
 	vk::Format img_format;
@@ -57,13 +68,24 @@ public:
 	ColorImage(uint32_t width, uint32_t height);
 	ColorImage(Color value, uint32_t width, uint32_t height);
 	ColorImage(Color* pixels, uint32_t width, uint32_t height);
+	ColorImage(const void* pixels, PixelLayout layout, uint32_t width, uint32_t height);
 	ColorImage(const char* path);
 
 	bool loadFromFile(const char* path);
+	// PNG, QOI or PPM by extension, PNG for anything else
 	bool saveToFile(const char* path);
+	VKDL_NODISCARD std::future<bool> saveToFileAsync(const char* path) const;
 
 	ColorImage blit(const uvec2& offset, const uvec2& size) const;
 	ColorImage createMask(Color color_from, Color color_to = Colors::Transparent) const;
+
+	// Pixel operations run on ImageKernels, vectorized and split across threads
+	void convertTo(void* dst, PixelLayout layout) const;
+	void premultiplyAlpha();
+	void unpremultiplyAlpha();
+
+	ColorImage rotate(ImageRotation rotation) const;
+	ColorImage resize(const uvec2& size, ResizeFilter filter = ResizeFilter::Bilinear) const;
 };
 
 template<class DataType>
@@ -234,4 +256,42 @@ bool Image<DataType>::empty() const
 	return pixels == nullptr;
 }
 
+template<class DataType>
+void Image<DataType>::flipHorizontal()
+{
+	ImageKernels::flipHorizontal(pixels, img_w, img_h, sizeof(DataType));
+}
+
+template<class DataType>
+void Image<DataType>::flipVertical()
+{
+	ImageKernels::flipVertical(pixels, img_w, img_h, sizeof(DataType));
+}
+
+template<class DataType>
+Image<DataType> Image<DataType>::rotate(ImageRotation rotation) const
+{
+	const bool transposed = rotation != ImageRotation::Rotate180;
+
+	Image image(transposed ? img_h : img_w, transposed ? img_w : img_h, img_format);
+	ImageKernels::rotate(pixels, image.data(), img_w, img_h, sizeof(DataType), rotation);
+
+	return image;
+}
+
+template<class DataType>
+Image<DataType> Image<DataType>::resize(const uvec2& size, ResizeFilter filter) const
+{
+	static_assert(alignof(DataType) == 1 && sizeof(DataType) <= 4, "Image::resize needs pixels of 1 to 4 byte channels");
+
+	Image image(size.x, size.y, img_format);
+
+	ImageKernels::resize(
+		reinterpret_cast<const uint8_t*>(pixels), img_w, img_h,
+		reinterpret_cast<uint8_t*>(image.data()), size.x, size.y,
+		sizeof(DataType), filter);
+
+	return image;
+}
+
 VKDL_END
\ No newline at end of file
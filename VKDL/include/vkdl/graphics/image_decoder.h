@@ -0,0 +1,70 @@
+#pragma once
+
+#include "texture.h"
+#include "../util/thread_pool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+VKDL_BEGIN
+
+// Decodes PNG and JPEG files on ThreadPool::shared() straight into mapped staging memory and
+// uploads them through the context's UploadService, so every image is copied once on
+// the CPU. The future becomes ready after the upload completed, which needs a window
+// rendering frames (or UploadService::flush) on the render thread. At most
+// `max_in_flight` images are decoded or waiting for their upload at a time, which
+// also bounds the staging memory; further loads queue up.
+//
+// Workers create the textures themselves. That goes through the locked memory,
+// descriptor and sampler allocators, and any single time command they record uses
+// the worker's own command pool (see Context::beginSingleTimeCommmand).
+class ImageDecoder
+{
+	VKDL_NOCOPY(ImageDecoder);
+	VKDL_NOCOPYASS(ImageDecoder);
+
+	struct Request
+	{
+		std::string                            path;
+		TextureCreator                         creator;
+		std::shared_ptr<std::promise<Texture>> promise;
+	};
+
+	struct State
+	{
+		std::mutex              mutex;
+		std::condition_variable decoded;
+		std::deque<Request>     queued;
+		size_t                  in_flight     = 0;
+		size_t                  max_in_flight = 0;
+		size_t                  decoding      = 0; // Decodes running on the pool
+		bool                    closed        = false;
+	};
+
+public:
+	static VKDL_CONSTEXPR size_t default_max_in_flight = 8;
+
+	ImageDecoder(size_t max_in_flight = default_max_in_flight);
+	~ImageDecoder();
+
+	// `creator` supplies the sampler, descriptor set layout and mip generation,
+	// the format is RGBA8 and the extent comes from the file
+	VKDL_NODISCARD std::future<Texture> loadTexture(const char* path, TextureCreator creator);
+
+	void setMaxInFlight(size_t count);
+	VKDL_NODISCARD size_t getMaxInFlight() const;
+	VKDL_NODISCARD size_t queuedCount() const;
+
+private:
+	static void dispatch(const std::shared_ptr<State>& state);
+	static void decode(const std::shared_ptr<State>& state, Request& request);
+	static void release(const std::shared_ptr<State>& state);
+
+	std::shared_ptr<State> state;
+};
+
+VKDL_END
\ No newline at end of file
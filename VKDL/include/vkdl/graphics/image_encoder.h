@@ -0,0 +1,71 @@
+#pragma once
+
+#include "image.h"
+
+#include <future>
+#include <string>
+#include <vector>
+
+VKDL_BEGIN
+
+// Turns RGBA8 images into a file format. Encoders are stateless between calls,
+// so one instance can serve several threads at once.
+class ImageEncoder
+{
+public:
+	virtual ~ImageEncoder() = default;
+
+	VKDL_NODISCARD virtual std::vector<uint8_t> encode(const ColorImage& image) const = 0;
+
+	bool saveToFile(const ColorImage& image, const char* path) const;
+
+	// Encodes and writes on a background thread. The image is taken by value so a
+	// capture loop can hand over its frame and continue, the encoder must outlive
+	// the returned future.
+	VKDL_NODISCARD std::future<bool> saveToFileAsync(ColorImage image, std::string path) const;
+
+	// PNG, QOI or PPM encoder with default settings picked by file extension,
+	// nullptr for anything else
+	VKDL_NODISCARD static const ImageEncoder* fromExtension(const char* path);
+};
+
+// Deflate is run on horizontal strips in parallel. Each strip is its own IDAT
+// chunk, flushed to a byte boundary so the strips concatenate into one zlib
+// stream. Matches never reach across strips, which costs a little ratio.
+class PNGEncoder : public ImageEncoder
+{
+public:
+	// 0 stores the filtered rows uncompressed, 1 is the fastest and 9 searches
+	// longest for matches
+	PNGEncoder(int compression_level = 3);
+
+	VKDL_NODISCARD std::vector<uint8_t> encode(const ColorImage& image) const override;
+
+	void setCompressionLevel(int level);
+	VKDL_NODISCARD int getCompressionLevel() const;
+
+	// Rows per strip, 0 sizes strips from the image and the thread count
+	void setStripRows(uint32_t rows);
+	VKDL_NODISCARD uint32_t getStripRows() const;
+
+private:
+	int      compression_level;
+	uint32_t strip_rows;
+};
+
+// Quite OK Image format, single pass and several times faster than PNG at a
+// similar size for screenshots
+class QOIEncoder : public ImageEncoder
+{
+public:
+	VKDL_NODISCARD std::vector<uint8_t> encode(const ColorImage& image) const override;
+};
+
+// Binary PPM (P6), the raw RGB pixels behind a text header. Alpha is dropped.
+class PPMEncoder : public ImageEncoder
+{
+public:
+	VKDL_NODISCARD std::vector<uint8_t> encode(const ColorImage& image) const override;
+};
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../core/config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+
+enum class PixelLayout
+{
+	RGBA8,
+	BGRA8,
+	RGB8,
+	Gray8
+};
+
+enum class ResizeFilter
+{
+	Box,
+	Bilinear,
+	Lanczos3
+};
+
+// Clockwise
+enum class ImageRotation
+{
+	Rotate90,
+	Rotate180,
+	Rotate270
+};
+
+// CPU image kernels on tightly packed pixels. The hot loops use AVX2, SSSE3/SSE2 or NEON,
+// picked once at runtime, and images above a few hundred KB are split into row bands
+// processed on a shared thread pool. Results match the scalar paths bit for bit.
+class ImageKernels
+{
+public:
+	// "avx2", "ssse3", "sse2", "neon" or "scalar"
+	VKDL_NODISCARD static const char* simdLevel();
+
+	// Forces the scalar paths, for comparing against them
+	static void setSimdEnabled(bool enabled);
+
+	static void convert(const void* src, PixelLayout src_layout, void* dst, PixelLayout dst_layout, size_t pixel_count);
+
+	// RGBA8 or BGRA8, rounding to the nearest value
+	static void premultiplyAlpha(uint8_t* pixels, size_t pixel_count);
+	static void unpremultiplyAlpha(uint8_t* pixels, size_t pixel_count);
+
+	static void replaceColor(uint32_t* pixels, size_t pixel_count, uint32_t from, uint32_t to);
+
+	static void flipHorizontal(void* pixels, uint32_t width, uint32_t height, size_t pixel_size);
+	static void flipVertical(void* pixels, uint32_t width, uint32_t height, size_t pixel_size);
+
+	// `dst` is height x width for quarter turns
+	static void rotate(const void* src, void* dst, uint32_t width, uint32_t height, size_t pixel_size, ImageRotation rotation);
+
+	// Separable resampling of 1 to 4 channel images. Alpha should be premultiplied
+	// so transparent texels do not bleed their color into the result.
+	static void resize(
+		const uint8_t* src, uint32_t src_width, uint32_t src_height,
+		uint8_t*       dst, uint32_t dst_width, uint32_t dst_height,
+		size_t channels, ResizeFilter filter);
+};
+
+VKDL_END
\ No newline at end of file
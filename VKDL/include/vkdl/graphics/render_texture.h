@@ -0,0 +1,101 @@
+#pragma once
+
+#include "image.h"
+#include "../core/render_target.h"
+#include "../core/render_states.h"
+#include "../core/memory_allocator.h"
+#include "../core/readback_queue.h"
+#include "../core/gpu_profiler.h"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+VKDL_BEGIN
+
+// Offscreen render target, the way to render on a headless Context. Every frame in
+// flight owns its image, framebuffer, command buffer and fence, so the next frame is
+// recorded while the GPU still renders the previous ones. The image is RGBA8 and left
+// in transfer source layout, its pixels come back through capture().
+//
+// display() submits this target alone. display(targets, count) submits the frames of
+// many targets with a single vkQueueSubmit, which is how batches of small jobs
+// (thumbnails, reports) should be rendered.
+class RenderTexture : protected RenderTarget
+{
+	VKDL_NOCOPY(RenderTexture);
+	VKDL_NOMOVE(RenderTexture);
+	VKDL_NOCOPYASS(RenderTexture);
+	VKDL_NOMOVEASS(RenderTexture);
+
+	struct Frame
+	{
+		vk::Image                  image;
+		vk::ImageView              image_view;
+		MemoryAllocation           allocation;
+		vk::Framebuffer            frame_buffer;
+		vk::CommandBuffer          cmd_buffer;
+		std::shared_ptr<vk::Fence> fence; // Of the last submission, shared by the targets of a batch
+
+		RenderStates  states;
+		GpuQueryFrame queries;
+	};
+
+public:
+	static VKDL_CONSTEXPR uint32_t default_frames_in_flight = 2;
+
+	RenderTexture();
+	RenderTexture(uint32_t width, uint32_t height, uint32_t frames_in_flight = default_frames_in_flight);
+	~RenderTexture();
+
+	void create(uint32_t width, uint32_t height, uint32_t frames_in_flight = default_frames_in_flight);
+	void destroy();
+
+	void render(const Drawable& drawable, const RenderOptions& options = {}) override;
+	void display() override;
+
+	// Sets the color the next frame is cleared to
+	void clear(const Color& color = Colors::Black) override;
+
+	static void display(RenderTexture* const* targets, size_t count);
+
+	// Copies the frame being rendered once it is displayed, without waiting for the GPU.
+	// The pixels arrive as RGBA once the frame finished, when this target starts a later
+	// frame or in wait().
+	std::future<ColorImage> capture();
+	void capture(std::function<void(ColorImage&&)> callback);
+
+	// Blocks until every displayed frame finished, and delivers their captures
+	void wait();
+
+	VKDL_NODISCARD uvec2 getSize() const;
+	VKDL_NODISCARD uint32_t getFramesInFlight() const;
+	VKDL_NODISCARD Color getClearColor() const;
+	VKDL_NODISCARD bool is_null() const;
+
+private:
+	vk::CommandBuffer getCommandBuffer() override;
+	vk::Framebuffer getFrameBuffer() override;
+	vk::RenderPass getRenderPass() override;
+	uvec2 getFrameBufferSize() const override;
+	vk::ClearColorValue getClearColorValue() const override;
+
+	void beginFrame();
+	vk::CommandBuffer endFrame();
+	void createFrame(Frame& frame, vk::CommandBuffer cmd_buffer);
+	void destroyFrame(Frame& frame);
+
+private:
+	std::vector<Frame>                   frames;
+	std::vector<ReadbackQueue::Callback> captures; // Recorded with the next displayed frame
+
+	vk::CommandPool     cmd_pool;
+	RenderPassHandle    render_pass;
+	uvec2               size;
+	vk::ClearColorValue clear_color;
+	uint32_t            frame_idx;
+	bool                render_begin;
+};
+
+VKDL_END
\ No newline at end of file
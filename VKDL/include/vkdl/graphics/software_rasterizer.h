@@ -0,0 +1,57 @@
+#pragma once
+
+#include "image.h"
+#include "vertex.h"
+
+#include <unordered_map>
+#include <vector>
+
+VKDL_BEGIN
+
+class Texture;
+class DrawList2D;
+
+// Turns DrawList2D content into pixels on the CPU, for golden image tests and for
+// machines without a Vulkan driver. Without a Context only untextured geometry and
+// textures given to setTextureImage() can be drawn: text needs a Font, whose glyphs
+// live in the Vulkan texture of a GlyphAtlas, and other textures are read back.
+//
+// It follows the builtin pipelines: triangles
+// cover the pixel centers inside them with a top-left fill rule on positions snapped
+// to 1/256 pixel, colors are interpolated per vertex, textures are sampled from mip
+// level 0 with the filter and address mode of their sampler, and the result is alpha
+// blended (src alpha / one minus src alpha, alpha with one / one minus src alpha).
+//
+// Triangles are binned into tiles of tile_size pixels, which are rasterized in
+// parallel. Each tile draws its triangles in submission order, so overlapping
+// geometry blends the same way as on the GPU.
+class SoftwareRasterizer
+{
+	VKDL_NOCOPY(SoftwareRasterizer);
+	VKDL_NOCOPYASS(SoftwareRasterizer);
+
+public:
+	static VKDL_CONSTEXPR uint32_t tile_size = 64;
+
+	SoftwareRasterizer();
+
+	// CPU copy of `texture`, used for the commands that draw with it. A texture without
+	// one is read back on first use, which needs a Context.
+	void setTextureImage(const Texture& texture, ColorImage image);
+	void clearTextureImages();
+
+	// Draws over the current content of `target`
+	void render(ColorImage& target, const DrawList2D& drawlist);
+	VKDL_NODISCARD ColorImage render(const DrawList2D& drawlist, const uvec2& size, const Color& clear_color = Colors::Black);
+
+	// Compares two images channel by channel, returns the number of pixels where any
+	// channel differs by more than `tolerance`
+	static size_t compare(const ColorImage& lhs, const ColorImage& rhs, uint8_t tolerance = 2);
+
+private:
+	const ColorImage& textureImage(const Texture& texture);
+
+	std::unordered_map<const Texture*, ColorImage> texture_images;
+};
+
+VKDL_END
\ No newline at end of file
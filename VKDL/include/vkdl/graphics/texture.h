@@ -5,6 +5,8 @@
 #include "../core/descriptor_set.h"
 #include "../core/buffer.h"
 
+#include <future>
+
 VKDL_BEGIN
 
 struct TextureInfo
@@ -13,11 +15,15 @@ struct TextureInfo
 	vk::SamplerCreateInfo   sampler_info;
 	vk::DescriptorSetLayout desc_set_layout;
 	vk::MemoryPropertyFlags memory_props;
+	bool                    generate_mips;
+	bool                    push_descriptor; // desc_set_layout is a push descriptor layout
 };
 
-class Texture : public std::enable_shared_from_this<Texture>
+class Texture : public std::enable_shared_from_this<Texture>, public MemoryOwner
 {
 	friend class TextureCreator;
+	friend class UploadService;
+	friend class ReadbackQueue;
 
 	VKDL_NOCOPY(Texture);
 	VKDL_NOCOPYASS(Texture);
@@ -31,10 +37,31 @@ public:
 
 	Texture& operator=(Texture&& rhs);
 
+	// Null for textures created with a push descriptor layout, use bind() to cover both
 	const vk::DescriptorSet& getDescriptorSet() const;
 
+	// Binds the texture to binding 0 of `set`, pushing it when the layout allows
+	void bind(vk::CommandBuffer cmd, vk::PipelineLayout pipeline_layout, uint32_t set = 0) const;
+
+	// Updating mip level 0 of a texture created with setGenerateMips rebuilds the other levels
 	void update(void* pixels);
-	void update(void* pixels, const ivec2& offset, const uvec2& size);
+	void update(void* pixels, const ivec2& offset, const uvec2& size, uint32_t mip_level = 0);
+	void update(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize buffer_offset, const ivec2& offset, const uvec2& size, uint32_t mip_level = 0);
+	void update(vk::CommandBuffer cmd, vk::Buffer buffer, const vk::BufferImageCopy* regions, uint32_t region_count);
+
+	// Downsamples mip level 0 into the rest of the chain with vkCmdBlitImage. Formats that
+	// cannot be blitted with linear filtering are box filtered on the CPU instead, which
+	// needs 8 bit channels. The command buffer overload only records blits.
+	void generateMips();
+	void generateMips(vk::CommandBuffer cmd);
+
+	// Queued on the context's UploadService, see upload_service.h
+	std::shared_future<void> updateAsync(const void* pixels);
+	std::shared_future<void> updateAsync(const void* pixels, const ivec2& offset, const uvec2& size);
+	void copy(const Texture& src, const vk::ImageCopy* regions, uint32_t region_count);
+
+	void readback(void* pixels) const;
+	void readback(void* pixels, const ivec2& offset, const uvec2& size) const;
 
 	void resize(uint32_t width, uint32_t height);
 
@@ -45,6 +72,8 @@ public:
 	vk::Format format() const;
 
 	uvec2 extent() const;
+	uvec2 extent(uint32_t mip_level) const;
+	uint32_t mipLevels() const;
 	size_t size_in_bytes() const;
 	size_t capacity() const;
 
@@ -53,20 +82,36 @@ public:
 
 	void swap(Texture& rhs);
 
+	// Called by MemoryAllocator::defragment, the image is recreated in `to`
+	bool relocate(const MemoryAllocation& from, const MemoryAllocation& to) override;
+
 private:
-	vk::DeviceMemory allocateMemory(vk::Image image, vk::DeviceSize& size) const;
+	bool supportsBlitMips() const;
+	bool canGenerateMips() const;
+
+	// Rebuilds the mips over a rectangle of level 0 from `pixels`, tightly packed.
+	// The filter also reads the texels bordering the rectangle on each level, one row
+	// and column per side or two where an odd edge folds, which are read back together
+	// with level 0 when there are no pixels. Nothing outside that border is transferred.
+	void generateMipsOnCPU(const ivec2& offset, const uvec2& size, const void* pixels = nullptr);
+
+	MemoryAllocation allocateMemory(vk::Image image, vk::DeviceSize& size);
+	void adoptAllocation();
+	void retireImage();
 	vk::DescriptorSet createDescriptorSet(vk::Sampler sampler, vk::ImageView image_view) const;
+	vk::DescriptorImageInfo descriptorImageInfo() const;
 
 private:
-	TextureInfo       info;
-
-	vk::Image         image;
-	vk::ImageView     image_view;
-	vk::DeviceMemory  memory;
-	vk::Sampler       sampler;
-	vk::DescriptorSet desc_set;
-	vk::DeviceSize    allocated_size;
-	Buffer<uint8_t>   staging_buffer;
+	TextureInfo             info;
+
+	vk::Image               image;
+	vk::ImageView           image_view;
+	MemoryAllocation        allocation;
+	vk::Sampler             sampler;
+	vk::DescriptorSet       desc_set;
+	mutable vk::ImageLayout layout;
+	vk::DeviceSize          allocated_size;
+	Buffer<uint8_t>         staging_buffer;
 };
 
 class TextureCreator
@@ -78,6 +123,7 @@ public:
 	TextureCreator& setImageExtent(uint32_t width, uint32_t height);
 	TextureCreator& setImageExtent(vk::Extent2D extent);
 	TextureCreator& setImageMipLevels(uint32_t mip_levels);
+	TextureCreator& setGenerateMips(bool value);
 	TextureCreator& setImageSamples(vk::SampleCountFlagBits samples);
 	TextureCreator& setImageTiling(vk::ImageTiling tiling);
 	TextureCreator& setImageUsage(vk::ImageUsageFlags usage);
@@ -96,7 +142,9 @@ public:
 	TextureCreator& setSamplerBorderColor(vk::BorderColor color);
 	TextureCreator& setSamplerUnnormalizedCoordinates(bool value);
 
-	TextureCreator& setDescriptorSetLayout(vk::DescriptorSetLayout layout);
+	// `flags` are the ones the raw layout was created with, they tell push descriptor layouts apart
+	TextureCreator& setDescriptorSetLayout(vk::DescriptorSetLayout layout, vk::DescriptorSetLayoutCreateFlags flags = {});
+	TextureCreator& setDescriptorSetLayout(const DescriptorSetLayout& layout);
 
 	Texture create() const;
 
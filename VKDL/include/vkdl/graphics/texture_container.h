@@ -0,0 +1,76 @@
+#pragma once
+
+#include "texture.h"
+#include "image.h"
+#include "../util/mapped_file.h"
+
+#include <vector>
+
+VKDL_BEGIN
+
+enum class TextureBakeFormat
+{
+	RGBA8,
+	BC1,
+	BC3
+};
+
+struct TextureBakeOptions
+{
+	TextureBakeFormat format        = TextureBakeFormat::BC3;
+	bool              generate_mips = true;
+	bool              srgb          = false;
+};
+
+// GPU ready texture file (KTX2 or DDS) with its mip levels already built. The file
+// is memory mapped and the level bytes are copied straight into a staging buffer,
+// without decoding. BCn data the device cannot sample is decoded to RGBA8 on the
+// CPU (BC1 to BC5 only). Only single layer 2D textures without supercompression
+// are read, in BCn or plain 8 bit, half and float formats; KTX2 files without
+// levels get their mip chain generated by createTexture.
+class TextureContainer
+{
+	VKDL_NOCOPY(TextureContainer);
+	VKDL_NOCOPYASS(TextureContainer);
+
+public:
+	struct Level
+	{
+		const uint8_t* data;
+		size_t         size;
+		uint32_t       width;
+		uint32_t       height;
+	};
+
+	TextureContainer();
+	TextureContainer(const char* path);
+
+	VKDL_NODISCARD bool loadFromFile(const char* path);
+	void close();
+
+	// `creator` supplies the sampler and descriptor set layout, format, extent
+	// and mip levels are taken from the file
+	VKDL_NODISCARD Texture createTexture(TextureCreator creator) const;
+
+	VKDL_NODISCARD vk::Format format() const;
+	VKDL_NODISCARD uvec2 extent() const;
+	VKDL_NODISCARD uint32_t mipLevels() const; // Levels stored in the file
+	VKDL_NODISCARD bool generatesMips() const;
+	VKDL_NODISCARD const Level& getLevel(uint32_t mip_level) const;
+	VKDL_NODISCARD bool isCompressed() const;
+	VKDL_NODISCARD bool empty() const;
+
+	// Writes `image` as KTX2, optionally block compressed and with a box filtered mip chain
+	static bool bake(const ColorImage& image, const char* path, const TextureBakeOptions& options = {});
+
+private:
+	bool parseKTX2();
+	bool parseDDS();
+
+	MappedFile         file;
+	vk::Format         fmt;
+	std::vector<Level> levels;
+	bool               generate_mips;
+};
+
+VKDL_END
\ No newline at end of file
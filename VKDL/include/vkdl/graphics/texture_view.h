@@ -25,6 +25,9 @@ public:
 
 private:
 	void draw(RenderTarget& target, RenderStates& states, const RenderOptions& options) const override;
+
+	RenderPassHandle render_pass;
+	PipelineHandle   pipeline;
 };
 
 VKDL_END
\ No newline at end of file
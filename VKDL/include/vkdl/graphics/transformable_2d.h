@@ -5,15 +5,17 @@
 
 VKDL_BEGIN
 
-class Transformable2D abstract
+class Transformable2D
 {
 	PROPERTY_INIT(Transformable2D);
 
-public:
+protected:
+	// Base class only, constructible through the drawables deriving from it
 	VKDL_INLINE Transformable2D();
 	Transformable2D(const Transformable2D&) = default;
 	Transformable2D(Transformable2D&&) VKDL_NOEXCEPT = default;
 
+public:
 	Transformable2D& operator=(const Transformable2D&) = default;
 	Transformable2D& operator=(Transformable2D&&) VKDL_NOEXCEPT = default;
 
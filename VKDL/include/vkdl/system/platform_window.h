@@ -1,8 +1,11 @@
 #pragma once
 
+#include <functional>
+#include <future>
 #include <string>
 #include "../core/render_target.h"
 #include "../core/render_options.h"
+#include "../graphics/image.h"
 #include "../system/window_event.h"
 #include "../math/vector_type.h"
 #include "../util/property.hpp"
@@ -70,9 +73,15 @@ public:
 	void display() override;
 	void clear(const Color& color = Colors::Black) override;
 
+	// Copies the frame being rendered once it is displayed, without waiting for the GPU.
+	// The pixels arrive as RGBA at the start of a later frame, see ReadbackQueue.
+	std::future<ColorImage> capture();
+	void capture(std::function<void(ColorImage&&)> callback);
+
 private:
 	vk::CommandBuffer getCommandBuffer() override;
 	vk::Framebuffer getFrameBuffer() override;
+	vk::RenderPass getRenderPass() override;
 	uvec2 getFrameBufferSize() const override;
 	vk::ClearColorValue getClearColorValue() const override;
 
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 #include <cstring> // memcmp
@@ -214,7 +216,8 @@ struct _Simplify_func<_UNKNOWN_INHERITANCE_PTR_SIZE> {
 #endif // MS/Intel hacks
 
 template<class Ret, class...Args>
-struct _Stateful_wrapper abstract {
+struct _Stateful_wrapper {
+	virtual ~_Stateful_wrapper() = default;
 	virtual Ret call(Args... args)   = 0;
 	virtual _generic_class_t* copy() = 0;
 };
@@ -274,7 +277,10 @@ struct _Closure_ptr<Ret(Args...)> {
 	}
 
 	DEL_INLINE void copy_from(const _Closure_ptr& rhs) {
-		if (is_dynamic_stateful())
+		if (this == &rhs) return;
+		clear();
+
+		if (rhs.is_dynamic_stateful())
 			inst = reinterpret_cast<_Stateful_wrapper<Ret, Args...>*>(rhs.inst)->copy();
 		else inst = rhs.inst;
 
@@ -282,13 +288,16 @@ struct _Closure_ptr<Ret(Args...)> {
 	}
 
 	DEL_INLINE void move_from(_Closure_ptr&& rhs) {
+		if (this == &rhs) return;
+		clear();
+
 		inst = std::exchange(rhs.inst, nullptr);
 		fptr = std::exchange(rhs.fptr, nullptr);
 	}
 
 	DEL_INLINE void clear() {
 		if (is_dynamic_stateful())
-			delete inst;
+			delete reinterpret_cast<_Stateful_wrapper<Ret, Args...>*>(inst);
 		inst = nullptr;
 		fptr = nullptr;
 	}
@@ -353,7 +362,8 @@ private:
 			Stateful obj;
 		} wrapper(std::forward<Stateful>(obj));
 
-		inst = *(_generic_class_ptr_t*)&wrapper;
+		inst = nullptr;
+		std::memcpy(&inst, &wrapper, sizeof(_Wrapper));
 		fptr = reinterpret_cast<_generic_memfunc_ptr_t>(&_Wrapper::call);
 	}
 
@@ -371,12 +381,6 @@ template <typename T> class Delegate;
 
 template<class Ret, class...Args>
 class Delegate<Ret(Args...)> {
-	template<class Ret, class...Args>
-	struct _Stateful_wrapper abstract {
-		virtual Ret call(Args... args) = 0;
-		virtual _generic_class_t* copy() = 0;
-	};
-
 public:
 	using type     = Delegate;
 	using return_t = Ret;
@@ -399,7 +403,7 @@ public:
 		closure.bind_method(static_cast<const Class*>(obj), to_bind);
 	}
 
-	template <class Lambda, class...Args, std::enable_if_t<!std::is_same_v<Lambda, Delegate<Ret(Args...)>>, int> = 0>
+	template <class Lambda, std::enable_if_t<!std::is_same_v<std::decay_t<Lambda>, Delegate<Ret(Args...)>>, int> = 0>
 	DEL_INLINE Delegate(Lambda&& lambda) {
 		bind(std::forward<Lambda>(lambda));
 	}
@@ -422,7 +426,7 @@ public:
 	}
 
 	DEL_INLINE Delegate& operator=(Delegate&& rhs) noexcept {
-		closure.move_from(rhs.closure);
+		closure.move_from(std::move(rhs.closure));
 		return *this;
 	}
 
@@ -431,7 +435,7 @@ public:
 		return *this;
 	}
 
-	template <class Lambda, class...Args, std::enable_if_t<!std::is_same_v<Lambda, Delegate<Ret(Args...)>>, int> = 0>
+	template <class Lambda, std::enable_if_t<!std::is_same_v<std::decay_t<Lambda>, Delegate<Ret(Args...)>>, int> = 0>
 	DEL_INLINE Delegate& operator=(Lambda&& lambda) {
 		bind(std::forward<Lambda>(lambda));
 		return *this;
@@ -451,7 +455,7 @@ public:
 		closure.bind_method(static_cast<const Class*>(pthis), function_to_bind);
 	}
 
-	template <class Lambda, class...Args, std::enable_if_t<!std::is_same_v<Lambda, Delegate<Ret(Args...)>>, int> = 0>
+	template <class Lambda, std::enable_if_t<!std::is_same_v<std::decay_t<Lambda>, Delegate<Ret(Args...)>>, int> = 0>
 	DEL_INLINE void bind(Lambda&& lambda) {
 		if constexpr (std::is_convertible_v<Lambda, Ret(*)(Args...)>)
 			closure.bind_static((Ret(*)(Args...))lambda);
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include "delegate.hpp"
@@ -82,7 +83,7 @@ private:
 };
 
 // delete lines below if don't needed
-class EventSender abstract {};
+class EventSender {};
 
 struct EventArgs {};
 
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../core/config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+
+// 64 bit FNV-1a, used to validate the on-disk caches. Not a cryptographic hash.
+VKDL_NODISCARD uint64_t hashFNV1a(const void* data, size_t size_in_bytes);
+
+// Writes `data` next to `path` and renames it over the destination, so a process
+// killed while writing never leaves a truncated file behind. Returns false and
+// keeps the previous file on failure.
+bool writeFile(const char* path, const void* data, size_t size_in_bytes);
+
+VKDL_END
\ No newline at end of file
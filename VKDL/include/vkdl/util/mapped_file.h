@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../core/config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+
+// Read-only memory mapping of a whole file. The mapping stays valid until
+// the object is closed or destroyed.
+class MappedFile
+{
+	VKDL_NOCOPY(MappedFile);
+	VKDL_NOCOPYASS(MappedFile);
+
+public:
+	MappedFile();
+	MappedFile(const char* path);
+	MappedFile(MappedFile&& rhs) VKDL_NOEXCEPT;
+	~MappedFile();
+
+	MappedFile& operator=(MappedFile&& rhs) VKDL_NOEXCEPT;
+
+	VKDL_NODISCARD bool open(const char* path);
+	void close();
+
+	VKDL_NODISCARD const uint8_t* data() const;
+	VKDL_NODISCARD size_t size() const;
+	VKDL_NODISCARD bool is_open() const;
+
+private:
+	void*          file_handle;
+	void*          mapping_handle;
+	const uint8_t* ptr;
+	size_t         length;
+};
+
+VKDL_END
\ No newline at end of file
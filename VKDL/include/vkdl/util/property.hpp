@@ -28,9 +28,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <type_traits>
-#include <stddef.h>
-#include <stdint.h>
 
 template <class T>
 class __non_copyable_but {
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../core/config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+VKDL_BEGIN
+
+// Fixed set of worker threads draining one FIFO task queue. Destruction runs
+// the tasks already queued, then joins the workers.
+//
+// The library's own CPU work (image kernels, encoders, the software rasterizer,
+// decoders, pipeline compiles) shares shared(), so the machine is not oversubscribed
+// by one pool per module. Tasks that wait on tasks they submitted go through wait(),
+// which runs queued tasks meanwhile instead of blocking a worker.
+class ThreadPool
+{
+	VKDL_NOCOPY(ThreadPool);
+	VKDL_NOCOPYASS(ThreadPool);
+
+public:
+	// 0 uses one thread per hardware thread
+	ThreadPool(size_t thread_count = 0);
+	~ThreadPool();
+
+	template <class Func>
+	auto submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+	{
+		using result_type = std::invoke_result_t<std::decay_t<Func>>;
+
+		auto task   = std::make_shared<std::packaged_task<result_type()>>(std::forward<Func>(func));
+		auto future = task->get_future();
+
+		push([task]() { (*task)(); });
+
+		return future;
+	}
+
+	// Blocks until `future` is ready, running queued tasks on the calling thread
+	// while the one it waits for has not been picked up yet
+	template <class T>
+	T wait(std::future<T>& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			if (!runPending()) {
+				future.wait();
+				break;
+			}
+		}
+
+		return future.get();
+	}
+
+	VKDL_NODISCARD size_t threadCount() const;
+
+	// One thread per hardware thread, created on first use
+	VKDL_NODISCARD static ThreadPool& shared();
+
+private:
+	void push(std::function<void()> task);
+	bool runPending();
+	void run();
+
+	std::vector<std::thread>          workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex                        mutex;
+	std::condition_variable           condition;
+	bool                              stopping;
+};
+
+VKDL_END
\ No newline at end of file
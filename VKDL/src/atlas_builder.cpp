@@ -0,0 +1,215 @@
+#include "../include/vkdl/graphics/atlas_builder.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/builtin_objects.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+// Copies `image` into `dst` at `offset`, repeating its border texels `extrude` times on every side
+static void write_extruded(VKDL_NAMESPACE_NAME::ColorImage& dst, const VKDL_NAMESPACE_NAME::ColorImage& image, uint32_t offset_x, uint32_t offset_y, uint32_t extrude)
+{
+	using VKDL_NAMESPACE_NAME::Color;
+
+	const uint32_t width  = image.width();
+	const uint32_t height = image.height();
+
+	for (uint32_t y = 0; y < height + extrude * 2; ++y) {
+		const uint32_t src_y = std::min(y >= extrude ? y - extrude : 0, height - 1);
+
+		const Color* src_row = image.data() + static_cast<size_t>(src_y) * width;
+		Color*       dst_row = &dst.at(offset_x, offset_y + y);
+
+		std::fill_n(dst_row, extrude, src_row[0]);
+		std::memcpy(dst_row + extrude, src_row, sizeof(Color) * width);
+		std::fill_n(dst_row + extrude + width, extrude, src_row[width - 1]);
+	}
+}
+
+VKDL_BEGIN
+
+AtlasBuilder::AtlasBuilder(uint32_t page_size, uint32_t padding, uint32_t extrude) :
+	page_size(page_size),
+	padding(padding),
+	extrude(extrude),
+	pages()
+{
+	VKDL_CHECK_MSG(page_size > 0, "Atlas page size must not be zero");
+}
+
+VKDL_NODISCARD AtlasRegion AtlasBuilder::add(const ColorImage& image)
+{
+	Page* page   = nullptr;
+	auto  region = place(image, page);
+
+	if (!page->uploaded) {
+		upload(*page);
+		return region;
+	}
+
+	// Only the new slot goes to the GPU, read back out of the page copy
+	const uvec2 slot_pos  = uvec2(region.rect.position) - uvec2(extrude);
+	const uvec2 slot_size = uvec2(region.rect.size) + uvec2(extrude * 2);
+
+	page->texture.update(page->pixels.blit(slot_pos, slot_size).data(), ivec2(slot_pos), slot_size);
+	page->dirty_top    = 0;
+	page->dirty_bottom = 0;
+
+	return region;
+}
+
+VKDL_NODISCARD std::vector<AtlasRegion> AtlasBuilder::add(const std::vector<const ColorImage*>& images)
+{
+	std::vector<size_t> order(images.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	// Tallest first fills shelves with images of similar height
+	std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return images[lhs]->height() > images[rhs]->height();
+	});
+
+	std::vector<AtlasRegion> regions(images.size());
+	std::vector<Page*>       touched;
+
+	for (size_t idx : order) {
+		Page* page = nullptr;
+		regions[idx] = place(*images[idx], page);
+
+		if (std::find(touched.begin(), touched.end(), page) == touched.end())
+			touched.push_back(page);
+	}
+
+	for (auto* page : touched)
+		upload(*page);
+
+	return regions;
+}
+
+VKDL_NODISCARD size_t AtlasBuilder::pageCount() const
+{
+	return pages.size();
+}
+
+VKDL_NODISCARD const Texture& AtlasBuilder::getPage(size_t index) const
+{
+	return pages.at(index).texture;
+}
+
+void AtlasBuilder::clear()
+{
+	pages.clear();
+}
+
+AtlasRegion AtlasBuilder::place(const ColorImage& image, Page*& page)
+{
+	VKDL_CHECK_MSG(!image.empty(), "Cannot add an empty image to an atlas");
+
+	const uvec2 slot = uvec2(image.width(), image.height()) + uvec2(extrude * 2 + padding);
+
+	uvec2 position;
+	page = nullptr;
+
+	if (slot.x <= page_size && slot.y <= page_size) {
+		for (auto& candidate : pages) {
+			if (!candidate.dedicated && packShelf(candidate, slot, position)) {
+				page = &candidate;
+				break;
+			}
+		}
+
+		if (!page) {
+			page = &createPage(page_size, page_size, false);
+			VKDL_CHECK(packShelf(*page, slot, position));
+		}
+	} else {
+		page     = &createPage(slot.x, slot.y, true);
+		position = uvec2(0, 0);
+	}
+
+	write_extruded(page->pixels, image, position.x, position.y, extrude);
+
+	if (page->dirty_top == page->dirty_bottom) {
+		page->dirty_top    = position.y;
+		page->dirty_bottom = position.y + slot.y;
+	} else {
+		page->dirty_top    = std::min(page->dirty_top, position.y);
+		page->dirty_bottom = std::max(page->dirty_bottom, position.y + slot.y);
+	}
+
+	AtlasRegion region;
+	region.texture = &page->texture;
+	region.rect    = irect(ivec2(position + uvec2(extrude)), ivec2(image.width(), image.height()));
+	return region;
+}
+
+AtlasBuilder::Page& AtlasBuilder::createPage(uint32_t width, uint32_t height, bool dedicated)
+{
+	auto& ctx             = Context::get();
+	auto& desc_set_layout = ctx.getPipeline(registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE0_UUID)).getPipelineLayout().getDescriptorSetLayout(0);
+
+	auto& page = pages.emplace_back();
+
+	page.texture = TextureCreator()
+		.setImageFormat(vk::Format::eR8G8B8A8Unorm)
+		.setImageUsage(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst)
+		.setImageExtent(width, height)
+		.setDescriptorSetLayout(desc_set_layout)
+		.create();
+
+	page.pixels    = ColorImage(Colors::Transparent, width, height);
+	page.dedicated = dedicated;
+
+	return page;
+}
+
+void AtlasBuilder::upload(Page& page)
+{
+	// A new page goes up whole so the gaps between images are defined
+	if (!page.uploaded) {
+		page.texture.update(page.pixels.data());
+		page.uploaded = true;
+	} else if (page.dirty_top != page.dirty_bottom) {
+		const uvec2 extent = page.texture.extent();
+		const uint32_t bottom = std::min(page.dirty_bottom, extent.y);
+
+		page.texture.update(
+			page.pixels.data() + static_cast<size_t>(page.dirty_top) * extent.x,
+			ivec2(0, page.dirty_top),
+			uvec2(extent.x, bottom - page.dirty_top));
+	}
+
+	page.dirty_top    = 0;
+	page.dirty_bottom = 0;
+}
+
+bool AtlasBuilder::packShelf(Page& page, uvec2 size, uvec2& position)
+{
+	const uvec2 extent = page.texture.extent();
+
+	// The shelf that wastes the least height, skipping ones much taller than the image
+	Shelf* best = nullptr;
+	for (auto& shelf : page.shelves) {
+		if (shelf.height < size.y || shelf.height > size.y + size.y / 2) continue;
+		if (extent.x - shelf.width < size.x) continue;
+
+		if (!best || shelf.height < best->height)
+			best = &shelf;
+	}
+
+	if (!best) {
+		if (size.x > extent.x || size.y > extent.y - page.next_shelf)
+			return false;
+
+		page.shelves.push_back({ page.next_shelf, size.y, 0 });
+		page.next_shelf += size.y;
+		best = &page.shelves.back();
+	}
+
+	position = uvec2(best->width, best->top);
+	best->width += size.x;
+
+	return true;
+}
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+static void expand_565(uint16_t color, uint8_t* rgb)
+{
+	const uint32_t r = (color >> 11) & 0x1f;
+	const uint32_t g = (color >> 5) & 0x3f;
+	const uint32_t b = color & 0x1f;
+
+	rgb[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+	rgb[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+	rgb[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+}
+
+// Rounds to the nearest 565 value, truncating would bias every endpoint towards 0
+static uint16_t pack_565(const uint8_t* rgb)
+{
+	const uint32_t r = (rgb[0] * 31u + 127) / 255;
+	const uint32_t g = (rgb[1] * 63u + 127) / 255;
+	const uint32_t b = (rgb[2] * 31u + 127) / 255;
+
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static uint16_t read_u16(const uint8_t* data)
+{
+	return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static void write_u16(uint8_t* data, uint16_t value)
+{
+	data[0] = static_cast<uint8_t>(value);
+	data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+// Color part of BC1/2/3. BC2 and BC3 always use the four color mode.
+static void decode_color_block(const uint8_t* block, uint8_t (*texels)[4], bool bc1)
+{
+	const uint16_t c0 = read_u16(block);
+	const uint16_t c1 = read_u16(block + 2);
+
+	uint8_t palette[4][4] = {};
+	expand_565(c0, palette[0]);
+	expand_565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = 255;
+
+	if (c0 > c1 || !bc1) {
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+		palette[2][3] = palette[3][3] = 255;
+	} else {
+		for (int c = 0; c < 3; c++)
+			palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+		palette[2][3] = 255;
+	}
+
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+	for (int i = 0; i < 16; i++, indices >>= 2)
+		std::memcpy(texels[i], palette[indices & 3], 4);
+}
+
+// BC3 alpha and BC4/BC5 channel block
+static void decode_channel_block(const uint8_t* block, uint8_t (*texels)[4], int channel)
+{
+	const uint32_t a0 = block[0];
+	const uint32_t a1 = block[1];
+
+	uint8_t palette[8] = { static_cast<uint8_t>(a0), static_cast<uint8_t>(a1) };
+
+	if (a0 > a1) {
+		for (uint32_t i = 1; i < 7; i++)
+			palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+	} else {
+		for (uint32_t i = 1; i < 5; i++)
+			palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+
+	for (int i = 0; i < 16; i++, indices >>= 3)
+		texels[i][channel] = palette[indices & 7];
+}
+
+static void encode_color_block(const uint8_t (*texels)[4], uint8_t* block)
+{
+	uint8_t min_color[3] = { 255, 255, 255 };
+	uint8_t max_color[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			min_color[c] = std::min(min_color[c], texels[i][c]);
+			max_color[c] = std::max(max_color[c], texels[i][c]);
+		}
+	}
+
+	// Inset the box a little so the endpoints are not wasted on outliers
+	for (int c = 0; c < 3; c++) {
+		const int inset = (max_color[c] - min_color[c]) >> 4;
+		min_color[c] = static_cast<uint8_t>(std::min(255, min_color[c] + inset));
+		max_color[c] = static_cast<uint8_t>(std::max(0, max_color[c] - inset));
+	}
+
+	// The endpoints span the box diagonal the colors run along. Channels that fall
+	// while the widest one rises swap their ends, otherwise a red to green block
+	// would be encoded along black to yellow.
+	int axis = 0;
+	for (int c = 1; c < 3; c++)
+		if (max_color[c] - min_color[c] > max_color[axis] - min_color[axis]) axis = c;
+
+	int mean[3] = {};
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++) mean[c] += texels[i][c];
+
+	for (int c = 0; c < 3; c++) {
+		if (c == axis) continue;
+
+		int covariance = 0;
+		for (int i = 0; i < 16; i++)
+			covariance += (texels[i][axis] * 16 - mean[axis]) * (texels[i][c] * 16 - mean[c]) / 16;
+
+		if (covariance < 0) std::swap(min_color[c], max_color[c]);
+	}
+
+	uint16_t c0 = pack_565(max_color);
+	uint16_t c1 = pack_565(min_color);
+
+	// Four color mode needs c0 > c1
+	if (c0 < c1) std::swap(c0, c1);
+
+	write_u16(block, c0);
+	write_u16(block + 2, c1);
+
+	uint32_t indices = 0;
+
+	if (c0 != c1) {
+		int palette[4][3];
+		uint8_t rgb[3];
+
+		expand_565(c0, rgb);
+		for (int c = 0; c < 3; c++) palette[0][c] = rgb[c];
+		expand_565(c1, rgb);
+		for (int c = 0; c < 3; c++) palette[1][c] = rgb[c];
+
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			uint32_t best       = 0;
+			int      best_error = INT32_MAX;
+
+			for (uint32_t p = 0; p < 4; p++) {
+				int error = 0;
+				for (int c = 0; c < 3; c++) {
+					const int d = texels[i][c] - palette[p][c];
+					error += d * d;
+				}
+
+				if (error < best_error) {
+					best_error = error;
+					best       = p;
+				}
+			}
+
+			indices |= best << (2 * i);
+		}
+	}
+
+	block[4] = static_cast<uint8_t>(indices);
+	block[5] = static_cast<uint8_t>(indices >> 8);
+	block[6] = static_cast<uint8_t>(indices >> 16);
+	block[7] = static_cast<uint8_t>(indices >> 24);
+}
+
+static void encode_alpha_block(const uint8_t (*texels)[4], uint8_t* block)
+{
+	uint8_t a_min = 255;
+	uint8_t a_max = 0;
+
+	for (int i = 0; i < 16; i++) {
+		a_min = std::min(a_min, texels[i][3]);
+		a_max = std::max(a_max, texels[i][3]);
+	}
+
+	block[0] = a_max;
+	block[1] = a_min;
+
+	uint64_t indices = 0;
+
+	if (a_max != a_min) {
+		int palette[8] = { a_max, a_min };
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * a_max + i * a_min) / 7;
+
+		for (int i = 0; i < 16; i++) {
+			uint64_t best       = 0;
+			int      best_error = INT32_MAX;
+
+			for (uint64_t p = 0; p < 8; p++) {
+				const int error = std::abs(texels[i][3] - palette[p]);
+
+				if (error < best_error) {
+					best_error = error;
+					best       = p;
+				}
+			}
+
+			indices |= best << (3 * i);
+		}
+	}
+
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+// Gathers a 4x4 block, clamping at the image edges
+static void fetch_block(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t (*texels)[4])
+{
+	for (uint32_t y = 0; y < 4; y++) {
+		const uint32_t sy = std::min(by * 4 + y, height - 1);
+
+		for (uint32_t x = 0; x < 4; x++) {
+			const uint32_t sx = std::min(bx * 4 + x, width - 1);
+			std::memcpy(texels[y * 4 + x], rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+		}
+	}
+}
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+VKDL_NODISCARD uint32_t blockSizeInBytes(vk::Format format)
+{
+	switch (format) {
+	case vk::Format::eBc1RgbUnormBlock:
+	case vk::Format::eBc1RgbSrgbBlock:
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc1RgbaSrgbBlock:
+	case vk::Format::eBc4UnormBlock:
+	case vk::Format::eBc4SnormBlock:
+		return 8;
+	case vk::Format::eBc2UnormBlock:
+	case vk::Format::eBc2SrgbBlock:
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+	case vk::Format::eBc5UnormBlock:
+	case vk::Format::eBc5SnormBlock:
+	case vk::Format::eBc6HUfloatBlock:
+	case vk::Format::eBc6HSfloatBlock:
+	case vk::Format::eBc7UnormBlock:
+	case vk::Format::eBc7SrgbBlock:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+VKDL_NODISCARD size_t compressedSizeInBytes(vk::Format format, uint32_t width, uint32_t height)
+{
+	const size_t blocks_x = (std::max(width, 1u) + 3) / 4;
+	const size_t blocks_y = (std::max(height, 1u) + 3) / 4;
+
+	return blocks_x * blocks_y * blockSizeInBytes(format);
+}
+
+VKDL_NODISCARD bool canDecodeBlocks(vk::Format format)
+{
+	switch (format) {
+	case vk::Format::eBc1RgbUnormBlock:
+	case vk::Format::eBc1RgbSrgbBlock:
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc1RgbaSrgbBlock:
+	case vk::Format::eBc2UnormBlock:
+	case vk::Format::eBc2SrgbBlock:
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+	case vk::Format::eBc4UnormBlock:
+	case vk::Format::eBc5UnormBlock:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void decodeBlocks(vk::Format format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* rgba)
+{
+	const uint32_t blocks_x   = (width + 3) / 4;
+	const uint32_t blocks_y   = (height + 3) / 4;
+	const uint32_t block_size = blockSizeInBytes(format);
+
+	const bool bc1_alpha = format == vk::Format::eBc1RgbaUnormBlock || format == vk::Format::eBc1RgbaSrgbBlock;
+
+	for (uint32_t by = 0; by < blocks_y; by++) {
+		for (uint32_t bx = 0; bx < blocks_x; bx++, src += block_size) {
+			uint8_t texels[16][4] = {};
+
+			switch (format) {
+			case vk::Format::eBc1RgbUnormBlock:
+			case vk::Format::eBc1RgbSrgbBlock:
+			case vk::Format::eBc1RgbaUnormBlock:
+			case vk::Format::eBc1RgbaSrgbBlock:
+				decode_color_block(src, texels, true);
+
+				// Index 3 of the three color mode is transparent black in BC1 RGBA
+				if (bc1_alpha && read_u16(src) <= read_u16(src + 2)) {
+					uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | (static_cast<uint32_t>(src[7]) << 24);
+					for (int i = 0; i < 16; i++, indices >>= 2)
+						if ((indices & 3) == 3) texels[i][3] = 0;
+				}
+				break;
+			case vk::Format::eBc2UnormBlock:
+			case vk::Format::eBc2SrgbBlock:
+				decode_color_block(src + 8, texels, false);
+				for (int i = 0; i < 16; i++) {
+					const uint8_t alpha = (src[i / 2] >> (4 * (i & 1))) & 0xf;
+					texels[i][3] = static_cast<uint8_t>(alpha * 17);
+				}
+				break;
+			case vk::Format::eBc3UnormBlock:
+			case vk::Format::eBc3SrgbBlock:
+				decode_color_block(src + 8, texels, false);
+				decode_channel_block(src, texels, 3);
+				break;
+			case vk::Format::eBc4UnormBlock:
+				decode_channel_block(src, texels, 0);
+				for (auto& texel : texels) texel[3] = 255;
+				break;
+			case vk::Format::eBc5UnormBlock:
+				decode_channel_block(src, texels, 0);
+				decode_channel_block(src + 8, texels, 1);
+				for (auto& texel : texels) texel[3] = 255;
+				break;
+			default:
+				VKDL_ERROR("Unsupported block compressed format");
+			}
+
+			for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+					const size_t dst = (static_cast<size_t>(by * 4 + y) * width + bx * 4 + x) * 4;
+					std::memcpy(rgba + dst, texels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+void encodeBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst)
+{
+	const uint32_t blocks_x = (width + 3) / 4;
+	const uint32_t blocks_y = (height + 3) / 4;
+
+	for (uint32_t by = 0; by < blocks_y; by++) {
+		for (uint32_t bx = 0; bx < blocks_x; bx++, dst += 8) {
+			uint8_t texels[16][4];
+			fetch_block(rgba, width, height, bx, by, texels);
+			encode_color_block(texels, dst);
+		}
+	}
+}
+
+void encodeBC3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst)
+{
+	const uint32_t blocks_x = (width + 3) / 4;
+	const uint32_t blocks_y = (height + 3) / 4;
+
+	for (uint32_t by = 0; by < blocks_y; by++) {
+		for (uint32_t bx = 0; bx < blocks_x; bx++, dst += 16) {
+			uint8_t texels[16][4];
+			fetch_block(rgba, width, height, bx, by, texels);
+			encode_alpha_block(texels, dst);
+			encode_color_block(texels, dst + 8);
+		}
+	}
+}
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
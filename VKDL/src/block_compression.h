@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../include/vkdl/core/include_vulkan.h"
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// Bytes per 4x4 block of a BCn format, 0 for formats that are not block compressed
+VKDL_NODISCARD uint32_t blockSizeInBytes(vk::Format format);
+
+VKDL_NODISCARD size_t compressedSizeInBytes(vk::Format format, uint32_t width, uint32_t height);
+
+// Decodes BC1 to BC5 into RGBA8. BC4 and BC5 fill red and green, blue is 0 and alpha 255.
+VKDL_NODISCARD bool canDecodeBlocks(vk::Format format);
+void decodeBlocks(vk::Format format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* rgba);
+
+// Bounding box encoders, fast enough to bake at load time. BC1 ignores alpha.
+void encodeBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst);
+void encodeBC3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* dst);
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
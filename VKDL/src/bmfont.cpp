@@ -0,0 +1,241 @@
+#include "bmfont.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+template <typename T>
+static bool read(const uint8_t*& data, const uint8_t* end, T& value)
+{
+	if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+
+	std::memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+
+	return true;
+}
+
+// Splits `key=value` pairs, values may be quoted
+static void parse_line(const std::string& line, std::string& tag, std::vector<std::pair<std::string, std::string>>& attributes)
+{
+	attributes.clear();
+
+	size_t pos = line.find_first_of(" \t");
+	tag = line.substr(0, pos);
+
+	while (pos != std::string::npos) {
+		pos = line.find_first_not_of(" \t\r", pos);
+		if (pos == std::string::npos) break;
+
+		const size_t eq = line.find('=', pos);
+		if (eq == std::string::npos) break;
+
+		std::string key = line.substr(pos, eq - pos);
+		std::string value;
+
+		if (eq + 1 < line.size() && line[eq + 1] == '"') {
+			const size_t close = line.find('"', eq + 2);
+			value = line.substr(eq + 2, close == std::string::npos ? std::string::npos : close - eq - 2);
+			pos   = close == std::string::npos ? close : close + 1;
+		} else {
+			const size_t next = line.find_first_of(" \t\r", eq + 1);
+			value = line.substr(eq + 1, next == std::string::npos ? std::string::npos : next - eq - 1);
+			pos   = next;
+		}
+
+		attributes.emplace_back(std::move(key), std::move(value));
+	}
+}
+
+static bool parse_text(const uint8_t* data, size_t size_in_bytes, VKDL_NAMESPACE_NAME::VKDL_PRIV_NAMESPACE_NAME::BMFontDescriptor& desc)
+{
+	using namespace VKDL_NAMESPACE_NAME::VKDL_PRIV_NAMESPACE_NAME;
+
+	std::istringstream stream(std::string(reinterpret_cast<const char*>(data), size_in_bytes));
+	std::string line;
+	std::string tag;
+	std::vector<std::pair<std::string, std::string>> attributes;
+
+	while (std::getline(stream, line)) {
+		parse_line(line, tag, attributes);
+
+		if (tag == "info") {
+			for (const auto& [key, value] : attributes) {
+				if (key == "face")      desc.face = value;
+				else if (key == "size") desc.size = std::atoi(value.c_str());
+				else if (key == "bold") desc.bold = std::atoi(value.c_str()) != 0;
+			}
+		} else if (tag == "common") {
+			for (const auto& [key, value] : attributes) {
+				if (key == "lineHeight")     desc.line_height   = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "base")      desc.base          = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "scaleW")    desc.scale_w       = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "scaleH")    desc.scale_h       = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "packed")    desc.packed        = std::atoi(value.c_str()) != 0;
+				else if (key == "alphaChnl") desc.alpha_channel = std::strtoul(value.c_str(), nullptr, 10);
+			}
+		} else if (tag == "page") {
+			uint32_t    id = 0;
+			std::string file;
+
+			for (const auto& [key, value] : attributes) {
+				if (key == "id")        id   = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "file") file = value;
+			}
+
+			if (desc.pages.size() <= id)
+				desc.pages.resize(id + 1);
+			desc.pages[id] = file;
+		} else if (tag == "char") {
+			BMFontChar ch = {};
+			ch.channel = 15;
+
+			for (const auto& [key, value] : attributes) {
+				if (key == "id")            ch.id       = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "x")        ch.x        = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "y")        ch.y        = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "width")    ch.width    = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "height")   ch.height   = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "xoffset")  ch.xoffset  = std::atoi(value.c_str());
+				else if (key == "yoffset")  ch.yoffset  = std::atoi(value.c_str());
+				else if (key == "xadvance") ch.xadvance = std::atoi(value.c_str());
+				else if (key == "page")     ch.page     = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "chnl")     ch.channel  = std::strtoul(value.c_str(), nullptr, 10);
+			}
+
+			desc.chars.push_back(ch);
+		} else if (tag == "kerning") {
+			BMFontKerning kerning = {};
+
+			for (const auto& [key, value] : attributes) {
+				if (key == "first")       kerning.first  = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "second") kerning.second = std::strtoul(value.c_str(), nullptr, 10);
+				else if (key == "amount") kerning.amount = std::atoi(value.c_str());
+			}
+
+			desc.kernings.push_back(kerning);
+		}
+	}
+
+	return !desc.pages.empty() && desc.line_height != 0;
+}
+
+static bool parse_binary(const uint8_t* data, size_t size_in_bytes, VKDL_NAMESPACE_NAME::VKDL_PRIV_NAMESPACE_NAME::BMFontDescriptor& desc)
+{
+	using namespace VKDL_NAMESPACE_NAME::VKDL_PRIV_NAMESPACE_NAME;
+
+	const uint8_t* end = data + size_in_bytes;
+
+	// "BMF" followed by the format version
+	if (size_in_bytes < 4 || data[3] != 3) return false;
+	data += 4;
+
+	while (data < end) {
+		uint8_t  type;
+		uint32_t block_size;
+
+		if (!read(data, end, type) || !read(data, end, block_size)) return false;
+		if (static_cast<size_t>(end - data) < block_size) return false;
+
+		const uint8_t* block     = data;
+		const uint8_t* block_end = data + block_size;
+		data = block_end;
+
+		switch (type) {
+		case 1: { // info
+			int16_t font_size;
+			uint8_t bit_field;
+
+			if (!read(block, block_end, font_size) || !read(block, block_end, bit_field)) return false;
+
+			desc.size = font_size;
+			desc.bold = (bit_field & (1 << 3)) != 0;
+
+			// Skip charSet, stretchH, aa, padding, spacing and outline, the face name follows
+			block += 11;
+			if (block < block_end)
+				desc.face.assign(reinterpret_cast<const char*>(block), strnlen(reinterpret_cast<const char*>(block), block_end - block));
+		} break;
+		case 2: { // common
+			uint16_t line_height, base, scale_w, scale_h, pages;
+			uint8_t  bit_field, alpha_channel;
+
+			if (!read(block, block_end, line_height)
+				|| !read(block, block_end, base)
+				|| !read(block, block_end, scale_w)
+				|| !read(block, block_end, scale_h)
+				|| !read(block, block_end, pages)
+				|| !read(block, block_end, bit_field)
+				|| !read(block, block_end, alpha_channel))
+				return false;
+
+			desc.line_height   = line_height;
+			desc.base          = base;
+			desc.scale_w       = scale_w;
+			desc.scale_h       = scale_h;
+			desc.packed        = (bit_field & (1 << 7)) != 0;
+			desc.alpha_channel = alpha_channel;
+		} break;
+		case 3: { // pages
+			while (block < block_end) {
+				const size_t length = strnlen(reinterpret_cast<const char*>(block), block_end - block);
+				desc.pages.emplace_back(reinterpret_cast<const char*>(block), length);
+				block += length + 1;
+			}
+		} break;
+		case 4: { // chars
+			while (block_end - block >= 20) {
+				uint32_t id;
+				uint16_t x, y, width, height;
+				int16_t  xoffset, yoffset, xadvance;
+				uint8_t  page, channel;
+
+				read(block, block_end, id);
+				read(block, block_end, x);
+				read(block, block_end, y);
+				read(block, block_end, width);
+				read(block, block_end, height);
+				read(block, block_end, xoffset);
+				read(block, block_end, yoffset);
+				read(block, block_end, xadvance);
+				read(block, block_end, page);
+				read(block, block_end, channel);
+
+				desc.chars.push_back({ id, x, y, width, height, xoffset, yoffset, xadvance, page, channel });
+			}
+		} break;
+		case 5: { // kerning pairs
+			while (block_end - block >= 10) {
+				uint32_t first, second;
+				int16_t  amount;
+
+				read(block, block_end, first);
+				read(block, block_end, second);
+				read(block, block_end, amount);
+
+				desc.kernings.push_back({ first, second, amount });
+			}
+		} break;
+		default:
+			break;
+		}
+	}
+
+	return !desc.pages.empty() && desc.line_height != 0;
+}
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+VKDL_NODISCARD bool parseBMFont(const uint8_t* data, size_t size_in_bytes, BMFontDescriptor& desc)
+{
+	desc = BMFontDescriptor();
+
+	if (size_in_bytes >= 3 && std::memcmp(data, "BMF", 3) == 0)
+		return parse_binary(data, size_in_bytes, desc);
+
+	return parse_text(data, size_in_bytes, desc);
+}
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
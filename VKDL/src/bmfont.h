@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../include/vkdl/core/config.h"
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// AngelCode BMFont descriptor, parsed from either the text or the binary (version 3) format
+struct BMFontChar
+{
+	uint32_t id;
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	int32_t  xoffset;
+	int32_t  yoffset;
+	int32_t  xadvance;
+	uint32_t page;
+	uint32_t channel;
+};
+
+struct BMFontKerning
+{
+	uint32_t first;
+	uint32_t second;
+	int32_t  amount;
+};
+
+struct BMFontDescriptor
+{
+	std::string                face;
+	int32_t                    size          = 0;
+	bool                       bold          = false;
+	uint32_t                   line_height   = 0;
+	uint32_t                   base          = 0;
+	uint32_t                   scale_w       = 0;
+	uint32_t                   scale_h       = 0;
+	bool                       packed        = false;
+	uint32_t                   alpha_channel = 0;
+	std::vector<std::string>   pages;
+	std::vector<BMFontChar>    chars;
+	std::vector<BMFontKerning> kernings;
+};
+
+VKDL_NODISCARD bool parseBMFont(const uint8_t* data, size_t size_in_bytes, BMFontDescriptor& desc);
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "buddy_allocator.h"
+
+#include <algorithm>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+BuddyAllocator::BuddyAllocator() :
+	min_size(1),
+	free_lists()
+{
+}
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t min_size) :
+	min_size(min_size),
+	free_lists()
+{
+	free_lists.resize(orderFor(size) + 1);
+	free_lists.back().insert(0);
+}
+
+VKDL_NODISCARD uint32_t BuddyAllocator::orderFor(uint64_t size) const
+{
+	uint32_t order = 0;
+	while ((min_size << order) < size) order++;
+	return order;
+}
+
+VKDL_NODISCARD uint32_t BuddyAllocator::maxOrder() const
+{
+	return static_cast<uint32_t>(free_lists.size()) - 1;
+}
+
+VKDL_NODISCARD uint64_t BuddyAllocator::rangeSize(uint32_t order) const
+{
+	return min_size << order;
+}
+
+VKDL_NODISCARD bool BuddyAllocator::allocate(uint32_t order, uint64_t& offset)
+{
+	uint32_t found = order;
+	while (found < free_lists.size() && free_lists[found].empty()) found++;
+
+	if (found >= free_lists.size()) return false;
+
+	offset = *free_lists[found].begin();
+	free_lists[found].erase(free_lists[found].begin());
+
+	// The upper halves go back to the free lists
+	while (found > order) {
+		found--;
+		free_lists[found].insert(offset + (min_size << found));
+	}
+
+	return true;
+}
+
+void BuddyAllocator::free(uint64_t offset, uint32_t order)
+{
+	const uint32_t max_order = maxOrder();
+
+	while (order < max_order) {
+		const uint64_t buddy = offset ^ (min_size << order);
+
+		auto& list = free_lists[order];
+		auto  it   = list.find(buddy);
+		if (it == list.end()) break;
+
+		list.erase(it);
+		offset = std::min(offset, buddy);
+		order++;
+	}
+
+	free_lists[order].insert(offset);
+}
+
+VKDL_PRIV_END
+VKDL_END
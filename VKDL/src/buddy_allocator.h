@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../include/vkdl/core/config.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// Hands out power of two ranges of one power of two sized range, order n spanning
+// `min_size << n` bytes. Ranges are aligned to their own size. Not thread safe.
+class BuddyAllocator
+{
+public:
+	BuddyAllocator();
+	BuddyAllocator(uint64_t size, uint64_t min_size);
+
+	// Order of the smallest range holding `size` bytes
+	VKDL_NODISCARD uint32_t orderFor(uint64_t size) const;
+	VKDL_NODISCARD uint32_t maxOrder() const;
+	VKDL_NODISCARD uint64_t rangeSize(uint32_t order) const;
+
+	// Takes the smallest free range that fits and splits it down to `order`
+	VKDL_NODISCARD bool allocate(uint32_t order, uint64_t& offset);
+
+	// Merges the range with its buddy for as long as the buddy is free
+	void free(uint64_t offset, uint32_t order);
+
+private:
+	uint64_t                        min_size;
+	std::vector<std::set<uint64_t>> free_lists; // Free ranges by order
+};
+
+VKDL_PRIV_END
+VKDL_END
@@ -360,11 +360,11 @@ static const uint32_t __glsl_shader2_frag_spv[] =
 
 VKDL_BEGIN
 
-void registerBuiltinRenderpass(UUID uuid)
+RenderPassHandle registerBuiltinRenderpass(UUID uuid)
 {
 	auto& ctx = Context::get();
 
-	if (ctx.hasRenderPass(uuid)) return;
+	if (ctx.hasRenderPass(uuid)) return ctx.findRenderPass(uuid);
 
 	if (uuid == VKDL_BUILTIN_RENDERPASS0_UUID) { // renderpass0
 		auto render_pass = RenderPassBuilder()
@@ -386,25 +386,62 @@ void registerBuiltinRenderpass(UUID uuid)
 
 		ctx.registerRenderPass(VKDL_BUILTIN_RENDERPASS0_UUID, render_pass);
 	}
+
+	// Same attachment as renderpass0, so every builtin pipeline stays compatible, but
+	// left ready to be copied instead of presented
+	if (uuid == VKDL_BUILTIN_RENDERPASS1_UUID) { // renderpass1
+		auto render_pass = RenderPassBuilder()
+			.setAttachmentFormat(vk::Format::eR8G8B8A8Unorm)
+			.setAttachmentSampleCount(vk::SampleCountFlagBits::e1)
+			.setAttachmentLoadOp(vk::AttachmentLoadOp::eClear)
+			.setAttachmentStoreOp(vk::AttachmentStoreOp::eStore)
+			.setAttachmentStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+			.setAttachmentStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+			.setAttachmentInitialLayout(vk::ImageLayout::eUndefined)
+			.setAttachmentFinalLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.pushCurrentAttachment()
+
+			.setSubpassPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+			.addSubpassColorAttachment(0, vk::ImageLayout::eColorAttachmentOptimal)
+			.pushCurrentSubpass()
+
+			.build();
+
+		ctx.registerRenderPass(VKDL_BUILTIN_RENDERPASS1_UUID, render_pass);
+	}
+
+	return ctx.findRenderPass(uuid);
 }
 
-void registerBuiltinPipeline(UUID uuid)
+PipelineHandle registerBuiltinPipeline(UUID uuid)
 {
 	auto& ctx = Context::get();
 
-	if (ctx.hasPipeline(uuid)) return;
-
-	auto descriptor_set_layout = DescriptorSetLayoutBuilder()
-		.setShaderStage(vk::ShaderStageFlagBits::eFragment)
-		.setBinding(0)
-		.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-		.addSampler(nullptr)
-		.pushCurrentBinding()
-		.build();
+	if (ctx.hasPipeline(uuid)) return ctx.findPipeline(uuid);
+
+	// Every builtin pipeline is built against renderpass0, registered here when
+	// neither the context nor a drawable did it yet
+	auto render_pass_handle = registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID);
+	auto render_pass        = ctx.render_passes[render_pass_handle];
+
+	// Textures drawn with the builtin pipelines push their image inline when the
+	// device allows it, and own a descriptor set only otherwise. Built only for the
+	// textured pipelines, equal builds share one layout.
+	auto make_descriptor_set_layout = [&ctx]() {
+		return DescriptorSetLayoutBuilder()
+			.setFlags(ctx.push_descriptor_supported ? vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR : vk::DescriptorSetLayoutCreateFlags())
+			.setShaderStage(vk::ShaderStageFlagBits::eFragment)
+			.setBinding(0)
+			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+			.addSampler(nullptr)
+			.pushCurrentBinding()
+			.build();
+	};
 
 	if (uuid == VKDL_BUILTIN_PIPELINE0_UUID) { // pipeline0
 		auto vert_module = ShaderModule::loadFromMemory(__glsl_shader0_vert_spv, sizeof(__glsl_shader0_vert_spv));
 		auto frag_module = ShaderModule::loadFromMemory(__glsl_shader0_frag_spv, sizeof(__glsl_shader0_frag_spv));
+		auto descriptor_set_layout = make_descriptor_set_layout();
 
 		auto pipeline_layout = PipelineLayoutBuilder()
 			.addPushConstant(vk::ShaderStageFlagBits::eVertex, 0, sizeof(Transform2D) + sizeof(vec2))
@@ -431,13 +468,13 @@ void registerBuiltinPipeline(UUID uuid)
 			.addDynamicState(vk::DynamicState::eViewport)
 			.addDynamicState(vk::DynamicState::eScissor)
 			.setPipelineLayout(pipeline_layout)
-			.setRenderPass(ctx.render_passes[VKDL_BUILTIN_RENDERPASS0_UUID])
-			.build();
+			.setRenderPass(render_pass)
+			.buildAsync();
 
 		ctx.registerPipeline(VKDL_BUILTIN_PIPELINE0_UUID, pipeline);
 	}
 
-	if (uuid == VKDL_BUILTIN_PIPELINE1_UUID) { // pipeline0
+	if (uuid == VKDL_BUILTIN_PIPELINE1_UUID) { // pipeline1
 		auto vert_module = ShaderModule::loadFromMemory(__glsl_shader1_vert_spv, sizeof(__glsl_shader1_vert_spv));
 		auto frag_module = ShaderModule::loadFromMemory(__glsl_shader1_frag_spv, sizeof(__glsl_shader1_frag_spv));
 
@@ -464,8 +501,8 @@ void registerBuiltinPipeline(UUID uuid)
 			.addDynamicState(vk::DynamicState::eViewport)
 			.addDynamicState(vk::DynamicState::eScissor)
 			.setPipelineLayout(pipeline_layout)
-			.setRenderPass(ctx.render_passes[VKDL_BUILTIN_RENDERPASS0_UUID])
-			.build();
+			.setRenderPass(render_pass)
+			.buildAsync();
 
 		ctx.registerPipeline(VKDL_BUILTIN_PIPELINE1_UUID, pipeline);
 	}
@@ -473,6 +510,7 @@ void registerBuiltinPipeline(UUID uuid)
 	if (uuid == VKDL_BUILTIN_PIPELINE2_UUID) { // pipeline2
 		auto vert_module = ShaderModule::loadFromMemory(__glsl_shader2_vert_spv, sizeof(__glsl_shader2_vert_spv));
 		auto frag_module = ShaderModule::loadFromMemory(__glsl_shader2_frag_spv, sizeof(__glsl_shader2_frag_spv));
+		auto descriptor_set_layout = make_descriptor_set_layout();
 
 		auto pipeline_layout = PipelineLayoutBuilder()
 			.addPushConstant(vk::ShaderStageFlagBits::eVertex, 0, 
@@ -499,11 +537,13 @@ void registerBuiltinPipeline(UUID uuid)
 			.addDynamicState(vk::DynamicState::eViewport)
 			.addDynamicState(vk::DynamicState::eScissor)
 			.setPipelineLayout(pipeline_layout)
-			.setRenderPass(ctx.render_passes[VKDL_BUILTIN_RENDERPASS0_UUID])
-			.build();
+			.setRenderPass(render_pass)
+			.buildAsync();
 
 		ctx.registerPipeline(VKDL_BUILTIN_PIPELINE2_UUID, pipeline);
 	}
+
+	return ctx.findPipeline(uuid);
 }
 
 VKDL_END
\ No newline at end of file
@@ -1,6 +1,22 @@
 #include "../include/vkdl/core/context.h"
 
 #include "../include/vkdl/core/exception.h"
+#include "../include/vkdl/core/memory_allocator.h"
+#include "../include/vkdl/core/descriptor_allocator.h"
+#include "../include/vkdl/core/sampler_cache.h"
+#include "../include/vkdl/core/upload_service.h"
+#include "../include/vkdl/core/readback_queue.h"
+#include "../include/vkdl/core/gpu_profiler.h"
+#include "../include/vkdl/core/builtin_objects.h"
+#include "../include/vkdl/core/cpu_profiler.h"
+#include "../include/vkdl/util/file_io.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
 
 #ifdef VKDL_PLATFORM_WINDOWS
 #define PLATFORM_SURFACE_EXT_NAME "VK_KHR_win32_surface"
@@ -15,6 +31,15 @@ static bool check_layer_support(const char* layer_name) {
 	return false;
 }
 
+static bool check_extension_support(const char* ext_name) {
+	auto props = vk::enumerateInstanceExtensionProperties();
+
+	for (const auto& prop : props) {
+		if (!strcmp(prop.extensionName.data(), ext_name)) return true;
+	}
+	return false;
+}
+
 static const char* get_message_type_str(VkDebugReportFlagsEXT flags)
 {
 	switch (flags) {
@@ -51,11 +76,100 @@ static struct DebugCallbackDispatcher {
 	PFN_vkDestroyDebugReportCallbackEXT vkDestroyDebugReportCallbackEXT = nullptr;
 } debug_callback_dispatcher;
 
+static struct PushDescriptorDispatcher {
+	void create(vk::Device device) {
+		vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+	}
+
+	static int getVkHeaderVersion() { return VK_HEADER_VERSION; }
+
+	PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR = nullptr;
+} push_descriptor_dispatcher;
+
+#define PIPELINE_CACHE_VERSION 1
+
+// vkGetPipelineCacheData has its own header, but it lacks the driver version,
+// and a driver update may keep the UUID while changing the binaries
+struct PipelineCacheHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint8_t  pipeline_cache_uuid[VK_UUID_SIZE];
+	uint32_t reserved;
+	uint64_t data_size;
+	uint64_t data_hash;
+};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool matches_device(const PipelineCacheHeader& header, const vk::PhysicalDeviceProperties& props)
+{
+	return header.vendor_id == props.vendorID
+		&& header.device_id == props.deviceID
+		&& header.driver_version == props.driverVersion
+		&& std::memcmp(header.pipeline_cache_uuid, props.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
+// Returns the cache payload, or nothing when the file is missing, damaged or from another device or driver
+static std::vector<uint8_t> read_pipeline_cache(const std::string& path, const vk::PhysicalDeviceProperties& props)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return {};
+
+	PipelineCacheHeader  header;
+	std::vector<uint8_t> data;
+
+	bool valid = std::fread(&header, sizeof(PipelineCacheHeader), 1, file) == 1
+		&& std::memcmp(header.magic, "VKPC", 4) == 0
+		&& header.version == PIPELINE_CACHE_VERSION
+		&& matches_device(header, props)
+		&& header.data_size <= (256ull << 20);
+
+	if (valid) {
+		data.resize(static_cast<size_t>(header.data_size));
+		valid = std::fread(data.data(), 1, data.size(), file) == data.size()
+			&& VKDL_NAMESPACE_NAME::hashFNV1a(data.data(), data.size()) == header.data_hash;
+	}
+
+	std::fclose(file);
+
+	if (!valid)
+		return {};
+
+	return data;
+}
+
+static bool check_device_extension_support(vk::PhysicalDevice physical_device, const char* ext_name)
+{
+	auto props = physical_device.enumerateDeviceExtensionProperties();
+
+	for (const auto& prop : props) {
+		if (!strcmp(prop.extensionName.data(), ext_name)) return true;
+	}
+	return false;
+}
+
 VKDL_BEGIN
 
 ContextCreator::ContextCreator() :
 	physical_device_type(vk::PhysicalDeviceType::eDiscreteGpu),
-	debug_level(0)
+	debug_level(0),
+	pipeline_cache_path(),
+	precompile_builtins(true),
+#ifdef PLATFORM_SURFACE_EXT_NAME
+	headless(false),
+#else
+	headless(true),
+#endif
+	gpu_profiler_scopes(0),
+	debug_utils(false)
 {
 }
 
@@ -103,11 +217,48 @@ ContextCreator& ContextCreator::enableDebug(uint32_t level)
 	return *this;
 }
 
+ContextCreator& ContextCreator::setHeadless(bool value)
+{
+#ifdef PLATFORM_SURFACE_EXT_NAME
+	headless = value;
+#endif
+	return *this;
+}
+
+ContextCreator& ContextCreator::enableGpuProfiler(uint32_t max_scopes_per_frame)
+{
+	VKDL_CHECK(max_scopes_per_frame > 0);
+	gpu_profiler_scopes = max_scopes_per_frame;
+
+	if (!debug_utils && check_extension_support(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		debug_utils = true;
+	}
+
+	return *this;
+}
+
+ContextCreator& ContextCreator::setPipelineCachePath(const std::string& path)
+{
+	pipeline_cache_path = path;
+	return *this;
+}
+
+ContextCreator& ContextCreator::setPrecompileBuiltins(bool value)
+{
+	precompile_builtins = value;
+	return *this;
+}
+
 std::unique_ptr<Context> ContextCreator::create()
 {
-	extensions.push_back(PLATFORM_SURFACE_EXT_NAME);
-	extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-	device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+#ifdef PLATFORM_SURFACE_EXT_NAME
+	if (!headless) {
+		extensions.push_back(PLATFORM_SURFACE_EXT_NAME);
+		extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+		device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
+#endif
 
 	return std::unique_ptr<Context>(new Context(*this));
 }
@@ -116,35 +267,82 @@ Context* Context::context_inst = nullptr;
 
 Context::Context(const ContextCreator& creator) :
 	graphics_queue_family_idx((uint32_t)-1),
-	debug_callback(nullptr)
+	compute_queue_family_idx((uint32_t)-1),
+	transfer_queue_family_idx((uint32_t)-1),
+	push_descriptor_supported(false),
+	headless(creator.headless),
+	frame_count(0),
+	debug_callback(nullptr),
+	pipeline_cache_path(creator.pipeline_cache_path)
 {
 	if (context_inst) VKDL_ERROR("VKDL Context already exists");
 	context_inst = this;
 
+	auto start = std::chrono::steady_clock::now();
+
 	vk::InstanceCreateInfo inst_info({}, &creator.app_info, creator.layers, creator. extensions);
 	instance = vk::createInstance(inst_info);
 
 	setDebugCallback(creator.debug_level);
+	timings.instance_ms = elapsed_ms(start);
+
+	start = std::chrono::steady_clock::now();
 	selectPhysicalDevice(creator.physical_device_type);
 	createDevice(creator.device_extensions);
-	createDescriptorPool();
-	createCommandPool();
+	timings.device_ms = elapsed_ms(start);
+
+	createPipelineCache();
+
+	memory_allocator     = std::make_unique<MemoryAllocator>();
+	descriptor_allocator = std::make_unique<DescriptorAllocator>();
+	sampler_cache        = std::make_unique<SamplerCache>();
+	upload_service       = std::make_unique<UploadService>();
+	readback_queue       = std::make_unique<ReadbackQueue>();
 
-	pipeline_cache = device.createPipelineCache({ {}, 0, nullptr });
+	if (creator.gpu_profiler_scopes)
+		gpu_profiler = std::make_unique<GpuProfiler>(creator.gpu_profiler_scopes, creator.debug_utils);
+
+	// Each pipeline compiles as its own job, registration only records the layouts
+	if (creator.precompile_builtins) {
+		registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID);
+		registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE0_UUID);
+		registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE1_UUID);
+		registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE2_UUID);
+	}
 }
 
 Context::~Context()
 {
+	readback_queue.reset();
+	upload_service.reset();
+
 	device.waitIdle();
 
+	for (auto& batch : retired_batches)
+		device.destroy(batch.fence);
+
+	retired_batches.clear();
+
+	// Releasing may retire more, a Texture defers its image the same way
+	while (!retired.empty())
+		std::exchange(retired, {}).clear();
+
 	for (auto& pipeline : pipelines)
-		pipeline.second.reset();
+		pipeline.reset();
 
 	for (auto& render_pass : render_passes)
-		render_pass.second.reset();
+		render_pass.reset();
+
+	savePipelineCache();
+
+	gpu_profiler.reset();
+	sampler_cache.reset();
+	descriptor_allocator.reset();
+	memory_allocator.reset();
+
+	for (auto& [thread_id, command_pool] : command_pools)
+		device.destroy(command_pool);
 
-	device.destroy(command_pool);
-	device.destroy(descriptor_pool);
 	device.destroy(pipeline_cache);
 	device.destroy();
 
@@ -158,8 +356,9 @@ Context::~Context()
 
 vk::CommandBuffer Context::beginSingleTimeCommmand()
 {
+	// Only the calling thread allocates from, records on and frees to its pool
 	vk::CommandBufferAllocateInfo buffer_info = {
-		command_pool,
+		threadCommandPool(),
 		vk::CommandBufferLevel::ePrimary,
 		1,
 	};
@@ -181,9 +380,122 @@ void Context::endSingleTimeCommmand(vk::CommandBuffer cmd_buffer)
 		1, &cmd_buffer
 	};
 
-	VK_CHECK(queues[graphics_queue_family_idx].submit(1, &submit_info, nullptr));
-	queues[graphics_queue_family_idx].waitIdle();
-	device.freeCommandBuffers(command_pool, 1, &cmd_buffer);
+	// Wait on a fence rather than the whole queue, which may hold frames in flight
+	auto fence = device.createFence({});
+
+	submit(QueueType::Graphics, 1, &submit_info, fence);
+	VK_CHECK(device.waitForFences(1, &fence, true, UINT64_MAX));
+
+	device.destroy(fence);
+	device.freeCommandBuffers(threadCommandPool(), 1, &cmd_buffer);
+}
+
+void Context::submit(QueueType type, uint32_t submit_count, const vk::SubmitInfo* submits, vk::Fence fence)
+{
+	const auto family = getQueueFamilyIndex(type);
+
+	std::lock_guard<std::mutex> lock(queueMutex(family));
+	VK_CHECK(queues[family].submit(submit_count, submits, fence));
+}
+
+vk::Result Context::present(uint32_t queue_family_idx, const vk::PresentInfoKHR& present_info)
+{
+	std::lock_guard<std::mutex> lock(queueMutex(queue_family_idx));
+	return queues[queue_family_idx].presentKHR(&present_info);
+}
+
+void Context::waitIdle(QueueType type)
+{
+	const auto family = getQueueFamilyIndex(type);
+
+	std::lock_guard<std::mutex> lock(queueMutex(family));
+	queues[family].waitIdle();
+}
+
+void Context::retire(std::shared_ptr<void> object)
+{
+	if (!object) return;
+
+	std::lock_guard<std::mutex> lock(retire_mutex);
+	retired.push_back(std::move(object));
+}
+
+void Context::retire(std::function<void()> release)
+{
+	struct Release
+	{
+		Release(std::function<void()> function) : function(std::move(function)) {}
+		~Release() { function(); }
+
+		std::function<void()> function;
+	};
+
+	if (release)
+		retire(std::make_shared<Release>(std::move(release)));
+}
+
+void Context::endFrame()
+{
+	frame_count++;
+
+	// Released outside the lock, destructors may retire more objects
+	std::vector<std::shared_ptr<void>> released;
+
+	{
+		std::lock_guard<std::mutex> lock(retire_mutex);
+
+		for (auto it = retired_batches.begin(); it != retired_batches.end();) {
+			if (device.getFenceStatus(it->fence) != vk::Result::eSuccess) {
+				++it;
+				continue;
+			}
+
+			device.destroy(it->fence);
+			std::move(it->objects.begin(), it->objects.end(), std::back_inserter(released));
+			it = retired_batches.erase(it);
+		}
+
+		if (!retired.empty()) {
+			RetiredBatch batch;
+			batch.fence = device.createFence({});
+			batch.objects.swap(retired);
+
+			// An empty submission signals its fence once all the work submitted
+			// before it completed, frames only ever use the graphics queue
+			submit(QueueType::Graphics, 0, nullptr, batch.fence);
+
+			retired_batches.push_back(std::move(batch));
+		}
+	}
+
+	VKDL_PROFILE_FRAME();
+}
+
+VKDL_NODISCARD vk::Queue Context::getQueue(QueueType type) const
+{
+	return queues[getQueueFamilyIndex(type)];
+}
+
+VKDL_NODISCARD uint32_t Context::getQueueFamilyIndex(QueueType type) const
+{
+	switch (type) {
+	case QueueType::Graphics: return graphics_queue_family_idx;
+	case QueueType::Compute:  return compute_queue_family_idx;
+	case QueueType::Transfer: return transfer_queue_family_idx;
+	}
+
+	VKDL_ERROR("Unknown queue type");
+}
+
+VKDL_NODISCARD bool Context::hasDedicatedQueue(QueueType type) const
+{
+	return type != QueueType::Graphics && getQueueFamilyIndex(type) != graphics_queue_family_idx;
+}
+
+void Context::pushDescriptorSet(vk::CommandBuffer cmd, vk::PipelineBindPoint bind_point, vk::PipelineLayout layout, uint32_t set, uint32_t write_count, const vk::WriteDescriptorSet* writes)
+{
+	VKDL_CHECK_MSG(push_descriptor_supported, "VK_KHR_push_descriptor is not supported");
+	cmd.pushDescriptorSetKHR(bind_point, layout, set, write_count, writes, push_descriptor_dispatcher);
 }
 
 void Context::transitionImageLayout(vk::CommandBuffer cmd_buffer, vk::Image image, vk::Format format, vk::ImageLayout old_layout, vk::ImageLayout new_layout)
@@ -198,7 +510,7 @@ void Context::transitionImageLayout(vk::CommandBuffer cmd_buffer, vk::Image imag
 		image,
 		{
 			vk::ImageAspectFlagBits::eColor,
-			0, 1, 0, 1
+			0, VK_REMAINING_MIP_LEVELS, 0, 1
 		}
 	};
 
@@ -236,6 +548,18 @@ void Context::transitionImageLayout(vk::CommandBuffer cmd_buffer, vk::Image imag
 
 		src_stage = vk::PipelineStageFlagBits::eTransfer;
 		dst_stage = vk::PipelineStageFlagBits::eFragmentShader;
+	} else if (old_layout == vk::ImageLayout::eShaderReadOnlyOptimal && new_layout == vk::ImageLayout::eTransferSrcOptimal) {
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderRead;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+		src_stage = vk::PipelineStageFlagBits::eFragmentShader;
+		dst_stage = vk::PipelineStageFlagBits::eTransfer;
+	} else if (old_layout == vk::ImageLayout::eShaderReadOnlyOptimal && new_layout == vk::ImageLayout::eTransferDstOptimal) {
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderRead;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+		src_stage = vk::PipelineStageFlagBits::eFragmentShader;
+		dst_stage = vk::PipelineStageFlagBits::eTransfer;
 	} else {
 		VKDL_ERROR("unsupported layout transition");
 	}
@@ -282,32 +606,81 @@ uint32_t Context::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags p
 
 bool Context::hasPipeline(const UUID& pipeline_uuid) const
 {
-	return pipelines.find(pipeline_uuid) != pipelines.end();
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	return pipeline_handles.find(pipeline_uuid) != pipeline_handles.end();
+}
+
+PipelineHandle Context::registerPipeline(const UUID& pipeline_uuid, std::shared_ptr<Pipeline>& pipeline)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto [iter, inserted] = pipeline_handles.try_emplace(pipeline_uuid, static_cast<PipelineHandle>(pipelines.size()));
+	if (inserted)
+		pipelines.push_back(pipeline);
+
+	return iter->second;
 }
 
-void Context::registerPipeline(const UUID& pipeline_uuid, std::shared_ptr<Pipeline>& pipeline)
+VKDL_NODISCARD PipelineHandle Context::findPipeline(const UUID& pipeline_uuid) const
 {
-	pipelines.insert(std::make_pair(pipeline_uuid, pipeline));
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto iter = pipeline_handles.find(pipeline_uuid);
+	return iter != pipeline_handles.end() ? iter->second : invalid_handle;
 }
 
 Pipeline& Context::getPipeline(const UUID& uuid)
 {
-	return *pipelines[uuid];
+	auto handle = findPipeline(uuid);
+	VKDL_CHECK_MSG(handle != invalid_handle, "Pipeline is not registered");
+
+	return getPipeline(handle);
+}
+
+Pipeline& Context::getPipeline(PipelineHandle handle)
+{
+	// The array may grow meanwhile, the pipeline itself stays where it is
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	return *pipelines[handle];
 }
 
 bool Context::hasRenderPass(const UUID& renderpass_uuid) const
 {
-	return render_passes.find(renderpass_uuid) != render_passes.end();;
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	return render_pass_handles.find(renderpass_uuid) != render_pass_handles.end();
+}
+
+RenderPassHandle Context::registerRenderPass(const UUID& renderpass_uuid, std::shared_ptr<RenderPass>& renderpass)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto [iter, inserted] = render_pass_handles.try_emplace(renderpass_uuid, static_cast<RenderPassHandle>(render_passes.size()));
+	if (inserted)
+		render_passes.push_back(renderpass);
+
+	return iter->second;
 }
 
-void Context::registerRenderPass(const UUID& renderpass_uuid, std::shared_ptr<RenderPass>& renderpass)
+VKDL_NODISCARD RenderPassHandle Context::findRenderPass(const UUID& renderpass_uuid) const
 {
-	render_passes.insert(std::make_pair(renderpass_uuid, renderpass));
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto iter = render_pass_handles.find(renderpass_uuid);
+	return iter != render_pass_handles.end() ? iter->second : invalid_handle;
 }
 
 RenderPass& Context::getRenderpass(const UUID& uuid)
 {
-	return *render_passes[uuid];
+	auto handle = findRenderPass(uuid);
+	VKDL_CHECK_MSG(handle != invalid_handle, "Render pass is not registered");
+
+	return getRenderpass(handle);
+}
+
+RenderPass& Context::getRenderpass(RenderPassHandle handle)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	return *render_passes[handle];
 }
 
 void Context::setDebugCallback(uint32_t debug_level)
@@ -348,7 +721,7 @@ void Context::selectPhysicalDevice(vk::PhysicalDeviceType preffered_type)
 	physical_device_memory_props = physical_device.getMemoryProperties();
 }
 
-void Context::createDevice(const std::vector<const char*>& device_extensions)
+void Context::createDevice(std::vector<const char*> device_extensions)
 {
 	auto properties      = physical_device.getQueueFamilyProperties();
 	float queue_priority = 1.f;
@@ -356,9 +729,22 @@ void Context::createDevice(const std::vector<const char*>& device_extensions)
 	std::vector<vk::DeviceQueueCreateInfo> queue_infos;
 
 	for (uint32_t i = 0; i < properties.size(); ++i) {
-		if (properties[i].queueFlags & vk::QueueFlagBits::eGraphics)
+		const auto flags = properties[i].queueFlags;
+
+		if ((flags & vk::QueueFlagBits::eGraphics) && graphics_queue_family_idx == (uint32_t)-1)
 			graphics_queue_family_idx = i;
 
+		// Async compute lives in a family without graphics
+		if ((flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics) && compute_queue_family_idx == (uint32_t)-1)
+			compute_queue_family_idx = i;
+
+		// Prefer a transfer-only family (usually backed by a DMA engine),
+		// then any family that can transfer without doing graphics
+		if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics)) {
+			if (transfer_queue_family_idx == (uint32_t)-1 || !(flags & vk::QueueFlagBits::eCompute))
+				transfer_queue_family_idx = i;
+		}
+
 		vk::DeviceQueueCreateInfo queue_info = {
 			{},
 			i,
@@ -369,35 +755,147 @@ void Context::createDevice(const std::vector<const char*>& device_extensions)
 		queue_infos.push_back(queue_info);
 	}
 
+	if (graphics_queue_family_idx == (uint32_t)-1)
+		VKDL_ERROR("No graphics queue family found");
+
+	if (compute_queue_family_idx == (uint32_t)-1)
+		compute_queue_family_idx = graphics_queue_family_idx;
+	if (transfer_queue_family_idx == (uint32_t)-1)
+		transfer_queue_family_idx = graphics_queue_family_idx;
+
+	push_descriptor_supported = check_device_extension_support(physical_device, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+	if (push_descriptor_supported) {
+		auto requested = std::find_if(device_extensions.begin(), device_extensions.end(), [](const char* ext_name) {
+			return !strcmp(ext_name, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		});
+
+		if (requested == device_extensions.end())
+			device_extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+	}
+
 	device = physical_device.createDevice({ {}, queue_infos, {}, device_extensions });
 
-	for (size_t i = 0; i < properties.size(); ++i)
-		queues.push_back(device.getQueue(graphics_queue_family_idx, 0));
+	if (push_descriptor_supported)
+		push_descriptor_dispatcher.create(device);
+
+	for (uint32_t i = 0; i < properties.size(); ++i) {
+		queues.push_back(device.getQueue(i, 0));
+		queue_mutexes.push_back(std::make_unique<std::mutex>());
+	}
 }
 
-void Context::createDescriptorPool()
+std::mutex& Context::queueMutex(uint32_t queue_family_idx)
 {
-	std::array<vk::DescriptorPoolSize, 1> pool_sizes = {{
-		{ vk::DescriptorType::eCombinedImageSampler, 100 }
-	}};
+	return *queue_mutexes[queue_family_idx];
+}
 
-	vk::DescriptorPoolCreateInfo pool_info = {
-		vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-		100,
-		pool_sizes
-	};
+bool Context::savePipelineCache()
+{
+	if (pipeline_cache_path.empty())
+		return false;
+
+	std::vector<uint8_t> data;
+
+	try {
+		data = device.getPipelineCacheData(pipeline_cache);
+	} catch (const std::exception&) {
+		return false;
+	}
 
-	descriptor_pool = device.createDescriptorPool(pool_info);
+	PipelineCacheHeader header = {};
+	std::memcpy(header.magic, "VKPC", 4);
+	std::memcpy(header.pipeline_cache_uuid, physical_device_props.pipelineCacheUUID.data(), VK_UUID_SIZE);
+	header.version        = PIPELINE_CACHE_VERSION;
+	header.vendor_id      = physical_device_props.vendorID;
+	header.device_id      = physical_device_props.deviceID;
+	header.driver_version = physical_device_props.driverVersion;
+	header.data_size      = data.size();
+	header.data_hash      = hashFNV1a(data.data(), data.size());
+
+	std::vector<uint8_t> output(sizeof(PipelineCacheHeader) + data.size());
+	std::memcpy(output.data(), &header, sizeof(PipelineCacheHeader));
+	std::memcpy(output.data() + sizeof(PipelineCacheHeader), data.data(), data.size());
+
+	// An interrupted save keeps the previous file
+	return writeFile(pipeline_cache_path.c_str(), output.data(), output.size());
 }
 
-void Context::createCommandPool()
+void Context::recordPipelineBuild(double milliseconds)
 {
-	vk::CommandPoolCreateInfo pool_info = {
-		vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		graphics_queue_family_idx,
-	};
+	std::lock_guard<std::mutex> lock(timings_mutex);
+	timings.pipeline_build_ms += milliseconds;
+	timings.pipeline_count++;
+}
+
+void Context::recordPipelineWait(double milliseconds)
+{
+	std::lock_guard<std::mutex> lock(timings_mutex);
+	timings.pipeline_wait_ms += milliseconds;
+	timings.pipeline_wait_count++;
+}
+
+VKDL_NODISCARD StartupTimings Context::getStartupTimings() const
+{
+	std::lock_guard<std::mutex> lock(timings_mutex);
+	return timings;
+}
+
+VKDL_NODISCARD std::string Context::startupReport() const
+{
+	const auto t = getStartupTimings();
+
+	char report[512];
+	std::snprintf(report, sizeof(report),
+		"Instance:       %8.2f ms\n"
+		"Device:         %8.2f ms\n"
+		"Pipeline cache: %8.2f ms (%s, %zu bytes)\n"
+		"Pipelines:      %8.2f ms (%u built)\n"
+		"Pipeline waits: %8.2f ms (%u draws blocked)\n",
+		t.instance_ms,
+		t.device_ms,
+		t.pipeline_cache_ms, t.pipeline_cache_hit ? "reused" : "cold", t.pipeline_cache_size,
+		t.pipeline_build_ms, t.pipeline_count,
+		t.pipeline_wait_ms, t.pipeline_wait_count);
+
+	return report;
+}
+
+vk::CommandPool Context::threadCommandPool()
+{
+	std::lock_guard<std::mutex> lock(command_pool_mutex);
+
+	auto& command_pool = command_pools[std::this_thread::get_id()];
+
+	if (!command_pool) {
+		vk::CommandPoolCreateInfo pool_info = {
+			vk::CommandPoolCreateFlagBits::eTransient,
+			graphics_queue_family_idx,
+		};
+
+		command_pool = device.createCommandPool(pool_info);
+	}
+
+	return command_pool;
+}
+
+void Context::createPipelineCache()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<uint8_t> data;
+	if (!pipeline_cache_path.empty())
+		data = read_pipeline_cache(pipeline_cache_path, physical_device_props);
+
+	vk::PipelineCacheCreateInfo cache_info = {};
+	cache_info.initialDataSize = data.size();
+	cache_info.pInitialData    = data.data();
+
+	pipeline_cache = device.createPipelineCache(cache_info);
 
-	command_pool = device.createCommandPool(pool_info);
+	timings.pipeline_cache_ms   = elapsed_ms(start);
+	timings.pipeline_cache_size = data.size();
+	timings.pipeline_cache_hit  = !data.empty();
 }
 
 VKDL_END
\ No newline at end of file
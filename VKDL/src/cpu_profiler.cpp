@@ -0,0 +1,298 @@
+#include "../include/vkdl/core/cpu_profiler.h"
+#include "../include/vkdl/util/file_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define COUNTER_COUNT static_cast<size_t>(VKDL_NAMESPACE_NAME::CpuCounter::Count)
+
+struct ZoneEvent
+{
+	const char* name;
+	uint64_t    begin;
+	uint64_t    end;
+};
+
+struct ThreadRing
+{
+	std::mutex             mutex;
+	std::vector<ZoneEvent> events; // Ring, allocated by the first zone of the thread
+	size_t                 next   = 0;
+	bool                   exited = false;
+	uint32_t               thread_id;
+	std::string            name;
+};
+
+struct ProfilerState
+{
+	std::mutex                                        mutex;
+	std::vector<std::shared_ptr<ThreadRing>>          rings;
+	std::deque<VKDL_NAMESPACE_NAME::CpuFrameCounters> frames;
+	uint64_t                                          frame_count    = 0;
+	uint32_t                                          next_thread_id = 1;
+};
+
+static std::atomic<uint64_t> counters[COUNTER_COUNT] = {};
+
+static ProfilerState& profiler_state()
+{
+	static ProfilerState state;
+	return state;
+}
+
+// Registered on first use, the ring outlives its thread until its zones were exported
+static ThreadRing& thread_ring()
+{
+	struct Holder
+	{
+		Holder() : ring(std::make_shared<ThreadRing>())
+		{
+			auto& state = profiler_state();
+			std::lock_guard<std::mutex> lock(state.mutex);
+
+			ring->thread_id = state.next_thread_id++;
+			ring->name      = "Thread " + std::to_string(ring->thread_id);
+			state.rings.push_back(ring);
+		}
+
+		~Holder()
+		{
+			std::lock_guard<std::mutex> lock(ring->mutex);
+			ring->exited = true;
+		}
+
+		std::shared_ptr<ThreadRing> ring;
+	};
+
+	thread_local Holder holder;
+	return *holder.ring;
+}
+
+static void append_json_string(std::string& output, const char* str)
+{
+	output += '"';
+
+	for (; *str; ++str) {
+		const char c = *str;
+
+		if (c == '"' || c == '\\') {
+			output += '\\';
+			output += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			output += escaped;
+		} else {
+			output += c;
+		}
+	}
+
+	output += '"';
+}
+
+VKDL_BEGIN
+
+uint64_t CpuFrameCounters::operator[](CpuCounter counter) const
+{
+	return values[static_cast<size_t>(counter)];
+}
+
+uint64_t CpuProfiler::now()
+{
+	static const auto epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void CpuProfiler::recordZone(const char* name, uint64_t begin_ns, uint64_t end_ns)
+{
+	auto& ring = thread_ring();
+	std::lock_guard<std::mutex> lock(ring.mutex);
+
+	if (ring.events.empty())
+		ring.events.reserve(ring_capacity);
+
+	if (ring.events.size() < ring_capacity)
+		ring.events.push_back({ name, begin_ns, end_ns });
+	else
+		ring.events[ring.next] = { name, begin_ns, end_ns };
+
+	ring.next = (ring.next + 1) % ring_capacity;
+}
+
+void CpuProfiler::count(CpuCounter counter, uint64_t value)
+{
+	counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void CpuProfiler::endFrame()
+{
+	CpuFrameCounters frame;
+	frame.end_ns = now();
+
+	for (size_t i = 0; i < COUNTER_COUNT; ++i)
+		frame.values[i] = counters[i].exchange(0, std::memory_order_relaxed);
+
+	auto& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	frame.frame = state.frame_count++;
+
+	if (state.frames.size() == frame_history)
+		state.frames.pop_front();
+
+	state.frames.push_back(frame);
+}
+
+void CpuProfiler::setThreadName(const char* name)
+{
+	auto& ring = thread_ring();
+	std::lock_guard<std::mutex> lock(ring.mutex);
+	ring.name = name;
+}
+
+CpuFrameCounters CpuProfiler::lastFrame()
+{
+	auto& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	return state.frames.empty() ? CpuFrameCounters() : state.frames.back();
+}
+
+const char* CpuProfiler::counterName(CpuCounter counter)
+{
+	switch (counter) {
+	case CpuCounter::DrawCalls:    return "draw_calls";
+	case CpuCounter::Vertices:     return "vertices";
+	case CpuCounter::Indices:      return "indices";
+	case CpuCounter::SkippedBinds: return "skipped_binds";
+	case CpuCounter::UploadBytes:  return "upload_bytes";
+	case CpuCounter::GlyphMisses:  return "glyph_misses";
+	default:                       return "unknown";
+	}
+}
+
+std::string CpuProfiler::exportChromeTrace()
+{
+	auto& state = profiler_state();
+
+	std::vector<std::shared_ptr<ThreadRing>> rings;
+	std::deque<CpuFrameCounters>             frames;
+
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		rings  = state.rings;
+		frames = state.frames;
+	}
+
+	// Threads that exited record nothing more, their rings go once exported
+	std::vector<std::shared_ptr<ThreadRing>> exported;
+
+	std::string output = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool        first  = true;
+	char        line[256];
+
+	const auto begin_event = [&]() {
+		output += first ? "\n" : ",\n";
+		first = false;
+	};
+
+	for (const auto& ring : rings) {
+		std::vector<ZoneEvent> events;
+		std::string            name;
+
+		{
+			std::lock_guard<std::mutex> lock(ring->mutex);
+			name = ring->name;
+
+			if (ring->exited)
+				exported.push_back(ring);
+
+			// Oldest first once the ring wrapped
+			const size_t split = ring->events.size() == ring_capacity ? ring->next : 0;
+
+			events.reserve(ring->events.size());
+			events.insert(events.end(), ring->events.begin() + split, ring->events.end());
+			events.insert(events.end(), ring->events.begin(), ring->events.begin() + split);
+		}
+
+		begin_event();
+		std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ring->thread_id);
+		output += line;
+		append_json_string(output, name.c_str());
+		output += "}}";
+
+		for (const auto& event : events) {
+			begin_event();
+			output += "{\"name\":";
+			append_json_string(output, event.name);
+			std::snprintf(line, sizeof(line), ",\"cat\":\"vkdl\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				event.begin / 1e3, (event.end - event.begin) / 1e3, ring->thread_id);
+			output += line;
+		}
+	}
+
+	for (const auto& frame : frames) {
+		begin_event();
+		std::snprintf(line, sizeof(line), "{\"name\":\"Frame counters\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{", frame.end_ns / 1e3);
+		output += line;
+
+		for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+			std::snprintf(line, sizeof(line), "%s\"%s\":%llu", i ? "," : "",
+				counterName(static_cast<CpuCounter>(i)), static_cast<unsigned long long>(frame.values[i]));
+			output += line;
+		}
+
+		output += "}}";
+	}
+
+	output += "\n]}\n";
+
+	if (!exported.empty()) {
+		std::lock_guard<std::mutex> lock(state.mutex);
+
+		state.rings.erase(std::remove_if(state.rings.begin(), state.rings.end(), [&](const std::shared_ptr<ThreadRing>& ring) {
+			return std::find(exported.begin(), exported.end(), ring) != exported.end();
+		}), state.rings.end());
+	}
+
+	return output;
+}
+
+bool CpuProfiler::saveChromeTrace(const char* path)
+{
+	const auto trace = exportChromeTrace();
+	return writeFile(path, trace.data(), trace.size());
+}
+
+void CpuProfiler::clear()
+{
+	auto& state = profiler_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	state.frames.clear();
+
+	// Rings of threads that exited are only kept for their zones
+	auto it = state.rings.begin();
+	while (it != state.rings.end()) {
+		bool exited;
+
+		{
+			std::lock_guard<std::mutex> ring_lock((*it)->mutex);
+
+			exited = (*it)->exited;
+
+			(*it)->events.clear();
+			(*it)->next = 0;
+		}
+
+		it = exited ? state.rings.erase(it) : it + 1;
+	}
+}
+
+VKDL_END
\ No newline at end of file
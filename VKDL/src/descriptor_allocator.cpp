@@ -0,0 +1,148 @@
+#include "../include/vkdl/core/descriptor_allocator.h"
+
+#include "../include/vkdl/core/context.h"
+
+#include <algorithm>
+#include <cmath>
+
+using PoolRatio = VKDL_NAMESPACE_NAME::DescriptorAllocator::PoolRatio;
+
+// Textures take one combined image sampler each, the rest covers user layouts
+static const std::vector<PoolRatio> default_ratios = {
+	{ vk::DescriptorType::eCombinedImageSampler, 1.0f  },
+	{ vk::DescriptorType::eUniformBuffer,        1.0f  },
+	{ vk::DescriptorType::eStorageBuffer,        0.5f  },
+	{ vk::DescriptorType::eSampledImage,         0.5f  },
+	{ vk::DescriptorType::eSampler,              0.25f },
+	{ vk::DescriptorType::eStorageImage,         0.25f },
+	{ vk::DescriptorType::eUniformBufferDynamic, 0.25f },
+	{ vk::DescriptorType::eStorageBufferDynamic, 0.25f },
+	{ vk::DescriptorType::eInputAttachment,      0.1f  }
+};
+
+VKDL_BEGIN
+
+DescriptorAllocator::DescriptorAllocator(uint32_t sets_per_pool) :
+	DescriptorAllocator(default_ratios, sets_per_pool)
+{
+}
+
+DescriptorAllocator::DescriptorAllocator(const std::vector<PoolRatio>& ratios, uint32_t sets_per_pool) :
+	ratios(ratios),
+	next_pool_size(std::clamp(sets_per_pool, 1u, max_sets_per_pool)),
+	mutex(),
+	pools(),
+	free_sets(),
+	stats()
+{
+	VKDL_CHECK_MSG(!ratios.empty(), "Descriptor pools need at least one descriptor type");
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	auto& device = Context::get().device;
+
+	for (auto pool : pools)
+		device.destroy(pool);
+}
+
+VKDL_NODISCARD vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout)
+{
+	auto& device = Context::get().device;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto iter = free_sets.find(layout);
+	if (iter != free_sets.end() && !iter->second.empty()) {
+		vk::DescriptorSet desc_set = iter->second.back();
+		iter->second.pop_back();
+
+		stats.free_set_count--;
+		stats.live_set_count++;
+		stats.recycled_count++;
+		return desc_set;
+	}
+
+	vk::DescriptorSetAllocateInfo desc_set_info = {};
+	desc_set_info.descriptorSetCount = 1;
+	desc_set_info.pSetLayouts        = &layout;
+
+	vk::DescriptorSet desc_set;
+
+	// Sets never go back to the pools, so only the newest one can have room left
+	if (!pools.empty()) {
+		desc_set_info.descriptorPool = pools.back();
+
+		vk::Result result = device.allocateDescriptorSets(&desc_set_info, &desc_set);
+		if (result == vk::Result::eSuccess) {
+			stats.live_set_count++;
+			return desc_set;
+		}
+
+		VKDL_CHECK_MSG(result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool,
+			"Failed to allocate descriptor set");
+	}
+
+	pools.push_back(createPool(next_pool_size));
+	stats.pool_count++;
+	stats.pool_set_count += next_pool_size;
+	next_pool_size = std::min(next_pool_size * 2, max_sets_per_pool);
+
+	desc_set_info.descriptorPool = pools.back();
+
+	vk::Result result = device.allocateDescriptorSets(&desc_set_info, &desc_set);
+	VKDL_CHECK_MSG(result == vk::Result::eSuccess, "Descriptor set layout does not fit in a descriptor pool");
+
+	stats.live_set_count++;
+	return desc_set;
+}
+
+void DescriptorAllocator::free(vk::DescriptorSetLayout layout, vk::DescriptorSet desc_set)
+{
+	if (!desc_set) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	free_sets[layout].push_back(desc_set);
+
+	stats.live_set_count--;
+	stats.free_set_count++;
+}
+
+void DescriptorAllocator::forget(vk::DescriptorSetLayout layout)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto iter = free_sets.find(layout);
+	if (iter == free_sets.end()) return;
+
+	stats.free_set_count -= iter->second.size();
+	free_sets.erase(iter);
+}
+
+VKDL_NODISCARD DescriptorAllocatorStats DescriptorAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+vk::DescriptorPool DescriptorAllocator::createPool(uint32_t max_sets) const
+{
+	std::vector<vk::DescriptorPoolSize> pool_sizes;
+	pool_sizes.reserve(ratios.size());
+
+	for (const auto& [type, ratio] : ratios) {
+		uint32_t count = static_cast<uint32_t>(std::ceil(ratio * max_sets));
+		pool_sizes.emplace_back(type, std::max(count, 1u));
+	}
+
+	vk::DescriptorPoolCreateInfo pool_info = {
+		{},
+		max_sets,
+		pool_sizes
+	};
+
+	return Context::get().device.createDescriptorPool(pool_info);
+}
+
+VKDL_END
\ No newline at end of file
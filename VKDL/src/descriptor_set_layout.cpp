@@ -1,18 +1,24 @@
 #include "../include/vkdl/core/descriptor_set_layout.h"
 
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/descriptor_allocator.h"
 
 VKDL_BEGIN
 
-DescriptorSetLayout::DescriptorSetLayout(vk::DescriptorSetLayout layout) :
-	layout(layout)
+DescriptorSetLayout::DescriptorSetLayout(vk::DescriptorSetLayout layout, vk::DescriptorSetLayoutCreateFlags flags) :
+	layout(layout),
+	flags(flags)
 {
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
-	auto& device = Context::get().device;
-	device.destroy(layout);
+	auto& ctx = Context::get();
+
+	if (ctx.descriptor_allocator)
+		ctx.descriptor_allocator->forget(layout);
+
+	ctx.device.destroy(layout);
 }
 
 vk::DescriptorSetLayout DescriptorSetLayout::getDescriptorSetLayout() const
@@ -25,4 +31,9 @@ DescriptorSetLayout::operator vk::DescriptorSetLayout() const
 	return layout;
 }
 
+bool DescriptorSetLayout::isPushDescriptor() const
+{
+	return static_cast<bool>(flags & vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+}
+
 VKDL_END
\ No newline at end of file
@@ -1,8 +1,63 @@
 #include "../include/vkdl/builder/descriptor_set_layout_builder.h"
 
 #include "../include/vkdl/core/context.h"
+#include "structural_cache.h"
 
 VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+struct DescriptorSetLayoutKey
+{
+	struct Binding
+	{
+		uint32_t             binding;
+		vk::DescriptorType   type;
+		uint32_t             count;
+		vk::ShaderStageFlags stages;
+		bool                 immutable_samplers;
+
+		bool operator==(const Binding& rhs) const
+		{
+			return binding == rhs.binding && type == rhs.type && count == rhs.count
+				&& stages == rhs.stages && immutable_samplers == rhs.immutable_samplers;
+		}
+	};
+
+	vk::DescriptorSetLayoutCreateFlags flags;
+	std::vector<Binding>               bindings;
+	std::vector<vk::Sampler>           samplers;
+
+	bool operator==(const DescriptorSetLayoutKey& rhs) const
+	{
+		return flags == rhs.flags && bindings == rhs.bindings && samplers == rhs.samplers;
+	}
+
+	size_t hash() const
+	{
+		size_t seed = 0;
+		hashCombine(seed, static_cast<VkDescriptorSetLayoutCreateFlags>(flags));
+
+		for (const auto& binding : bindings) {
+			hashCombine(seed, binding.binding);
+			hashCombine(seed, static_cast<int>(binding.type));
+			hashCombine(seed, binding.count);
+			hashCombine(seed, static_cast<VkShaderStageFlags>(binding.stages));
+		}
+
+		for (auto sampler : samplers)
+			hashCombine(seed, static_cast<VkSampler>(sampler));
+
+		return seed;
+	}
+};
+
+static StructuralCache<DescriptorSetLayoutKey, DescriptorSetLayout>& layout_cache()
+{
+	static StructuralCache<DescriptorSetLayoutKey, DescriptorSetLayout> cache;
+	return cache;
+}
+
+VKDL_PRIV_END
 
 DescriptorSetLayoutBuilder::DescriptorSetLayoutBuilder()
 {
@@ -14,6 +69,7 @@ void DescriptorSetLayoutBuilder::clear()
 	bindings.clear();
 	samplers.clear();
 	curr_binding = vk::DescriptorSetLayoutBinding();
+	flags        = {};
 }
 
 DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::setBinding(uint32_t binding)
@@ -51,10 +107,23 @@ DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::pushCurrentBinding()
 	return *this;
 }
 
+DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::setFlags(vk::DescriptorSetLayoutCreateFlags flags)
+{
+	this->flags = flags;
+	return *this;
+}
+
 std::shared_ptr<DescriptorSetLayout> DescriptorSetLayoutBuilder::build()
 {
 	auto& device = Context::get().device;
 
+	VKDL_PRIV_NAMESPACE_NAME::DescriptorSetLayoutKey key;
+	key.flags    = flags;
+	key.samplers = samplers;
+
+	for (const auto& binding : bindings)
+		key.bindings.push_back({ binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags, binding.pImmutableSamplers != nullptr });
+
 	uint32_t sampler_idx = 0;
 
 	for (auto& binding : bindings) {
@@ -68,10 +137,14 @@ std::shared_ptr<DescriptorSetLayout> DescriptorSetLayoutBuilder::build()
 	}
 
 	vk::DescriptorSetLayoutCreateInfo info = {};
+	info.flags        = flags;
 	info.bindingCount = (uint32_t)bindings.size();
 	info.pBindings    = bindings.data();
 
-	return std::shared_ptr<DescriptorSetLayout>(new DescriptorSetLayout(device.createDescriptorSetLayout(info)));
+	// Equal layouts are shared, so pipelines built from them end up with equal pipeline layouts too
+	return VKDL_PRIV_NAMESPACE_NAME::layout_cache().getOrCreate(key, [&]() {
+		return std::shared_ptr<DescriptorSetLayout>(new DescriptorSetLayout(device.createDescriptorSetLayout(info), flags));
+	});
 }
 
 VKDL_END
\ No newline at end of file
@@ -2,8 +2,13 @@
 
 #include "../include/vkdl/core/context.h"
 #include "../include/vkdl/core/builtin_objects.h"
+#include "../include/vkdl/core/cpu_profiler.h"
 #include "../include/vkdl/graphics/texture.h"
+#include "../include/vkdl/graphics/atlas_builder.h"
 #include "../include/vkdl/graphics/font.h"
+#include "../include/vkdl/graphics/glyph_atlas.h"
+
+#include <algorithm>
 
 VKDL_BEGIN
 
@@ -17,13 +22,13 @@ DrawCommand2D::DrawCommand2D() :
 }
 
 DrawList2D::DrawList2D() :
-	vertex_buffer(Buffer<Vertex2D>::createVertexBuffer(0)),
-	index_buffer(Buffer<uint32_t>::createIndexBuffer(0)),
-	update_buffer(false)
+	vertex_buffer(vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible),
+	index_buffer(vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible),
+	update_buffer(false),
+	render_pass(Context::invalid_handle),
+	textured_pipeline(Context::invalid_handle),
+	color_pipeline(Context::invalid_handle)
 {
-	registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE0_UUID);
-	registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE1_UUID);
-
 	auto& cmd = commands.emplace_back();
 }
 
@@ -199,6 +204,11 @@ void DrawList2D::addImage(const vec2& pos, const vec2& size, const vec2& uv0, co
 	indices.emplace_back(idx + 3);
 }
 
+void DrawList2D::addImage(const AtlasRegion& region, const vec2& pos, const vec2& size, const Color& col)
+{
+	addImage(*region.texture, pos, size, region.uv0(), region.uv1(), col);
+}
+
 void DrawList2D::addImageQuad(const vec2& p0, const vec2& p1, const vec2& p2, const vec2& p3, const vec2& uv0, const vec2& uv1, const vec2& uv2, const vec2& uv3, const Color& col)
 {
 	auto idx = reservePrimitives(4, 6);
@@ -218,10 +228,16 @@ void DrawList2D::addImageQuad(const vec2& p0, const vec2& p1, const vec2& p2, co
 
 void DrawList2D::addText(const vec2& pos, const std::string& text, const TextStyle& style)
 {
-	pushTexture(style.font->getTexture(style.character_size));
-
 	if (text.empty()) return;
 
+	VKDL_PROFILE_ZONE("DrawList2D::addText");
+
+	// Looked up once, a page is only dropped at the first lookup of a frame
+	const auto atlas = style.font->getGlyphAtlas(style.character_size);
+
+	pushTexture(atlas->getTexture());
+	useGlyphTexture(*atlas);
+
 	size_t vertex_begin = vertices.size();
 
 	const float italicShear         = (style.italic) ? to_radian(12.f) : (radian)0.f;
@@ -234,6 +250,8 @@ void DrawList2D::addText(const vec2& pos, const std::string& text, const TextSty
 	whitespaceWidth += letterSpacing;
 	const float lineSpacing = style.font->getLineSpacing(style.character_size) * style.line_spacing_factor;
 
+	useGlyphTexture(*atlas);
+
 	float    x         = 0.f;
 	auto     y         = static_cast<float>(style.character_size);
 
@@ -273,6 +291,7 @@ void DrawList2D::addText(const vec2& pos, const std::string& text, const TextSty
 		}
 
 		const Glyph& glyph = style.font->getGlyph(curChar, style.character_size, style.bold);
+		useGlyphTexture(*atlas);
 
 		addGlyphQuad(vec2(x, y), style.fill_color, glyph, italicShear);
 
@@ -439,24 +458,52 @@ void DrawList2D::clear()
 	texture_stack.clear();
 	clip_rect_stack.clear();
 	transform_stack.clear();
+	glyph_textures.clear();
 
 	update_buffer = true;
 
 	commands.emplace_back();
 }
 
+const std::vector<DrawCommand2D>& DrawList2D::getCommands() const
+{
+	return commands;
+}
+
+const std::vector<Vertex2D>& DrawList2D::getVertices() const
+{
+	return vertices;
+}
+
+const std::vector<uint32_t>& DrawList2D::getIndices() const
+{
+	return indices;
+}
+
 void DrawList2D::draw(RenderTarget& target, RenderStates& states, const RenderOptions& options) const
 {
 	if (commands.empty()) return;
 	if (commands.front().index_count == 0) return;
 
+	VKDL_PROFILE_ZONE("DrawList2D::draw");
+
+	if (textured_pipeline == Context::invalid_handle) {
+		render_pass       = registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID);
+		textured_pipeline = registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE0_UUID);
+		color_pipeline    = registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE1_UUID);
+	}
+
 	if (std::exchange(update_buffer, false)) {
+		VKDL_PROFILE_ZONE("DrawList2D upload");
+
 		vertex_buffer.resize(vertices.size(), false);
 		index_buffer.resize(indices.size(), false);
 		memcpy(vertex_buffer.map(), vertices.data(), vertex_buffer.size_in_bytes());
 		memcpy(index_buffer.map(), indices.data(), index_buffer.size_in_bytes());
 		vertex_buffer.flush();
 		index_buffer.flush();
+
+		VKDL_PROFILE_COUNT(UploadBytes, vertex_buffer.size_in_bytes() + index_buffer.size_in_bytes());
 	}
 
 	auto& ctx    = Context::get();
@@ -464,27 +511,22 @@ void DrawList2D::draw(RenderTarget& target, RenderStates& states, const RenderOp
 	auto offset  = vk::DeviceSize{ 0 };
 	auto fb_size = target.getFrameBufferSize();
 
-	auto& pipeline_layout = ctx.getPipeline(VKDL_BUILTIN_PIPELINE0_UUID).getPipelineLayout();
+	auto& pipeline_layout = ctx.getPipeline(textured_pipeline).getPipelineLayout();
 	
 	auto transform = Transform2D()
 		.translate(-1.f, -1.f)
 		.scale(2.f / fb_size.x, 2.f / fb_size.y);
 
-	states.updateRenderPassUUID(VKDL_BUILTIN_RENDERPASS0_UUID);
+	states.updateRenderPass(render_pass);
 
 	cmd.bindVertexBuffers(0, 1, &vertex_buffer.getBuffer(), &offset);
 	cmd.bindIndexBuffer(index_buffer.getBuffer(), 0, vk::IndexType::eUint32);
 	
 	for (const auto& command : commands) {
 		if (command.texture != nullptr) {
-			states.updatePipelineUUID(VKDL_BUILTIN_PIPELINE0_UUID);
+			states.updatePipeline(textured_pipeline);
 			
-			cmd.bindDescriptorSets(
-				vk::PipelineBindPoint::eGraphics,
-				pipeline_layout,
-				0,
-				1, &command.texture->getDescriptorSet(),
-				0, nullptr);
+			command.texture->bind(cmd, pipeline_layout);
 
 			auto texture_size = (vec2)command.texture->extent();
 			cmd.pushConstants(
@@ -494,7 +536,7 @@ void DrawList2D::draw(RenderTarget& target, RenderStates& states, const RenderOp
 				sizeof(vec2),
 				&texture_size);
 		} else {
-			states.updatePipelineUUID(VKDL_BUILTIN_PIPELINE1_UUID);
+			states.updatePipeline(color_pipeline);
 		}
 
 		if (command.clip_rect == vk::Rect2D())
@@ -514,6 +556,10 @@ void DrawList2D::draw(RenderTarget& target, RenderStates& states, const RenderOp
 		states.bind(target, options);
 
 		cmd.drawIndexed(command.index_count, 1, command.index_offset, 0, 0);
+
+		VKDL_PROFILE_COUNT(DrawCalls, 1);
+		VKDL_PROFILE_COUNT(Vertices, command.vertex_count);
+		VKDL_PROFILE_COUNT(Indices, command.index_count);
 	}
 }
 
@@ -530,6 +576,21 @@ void DrawList2D::newCommand()
 	cmd->index_offset   = (uint32_t)indices.size();
 }
 
+void DrawList2D::useGlyphTexture(const GlyphAtlas& atlas)
+{
+	// A glyph lookup may evict into a new texture, the quads recorded before keep the previous one
+	const auto* texture = &atlas.getTexture();
+
+	if (texture_stack.back() != texture) {
+		texture_stack.back() = texture;
+		newCommand();
+	}
+
+	const auto it = std::find_if(glyph_textures.begin(), glyph_textures.end(), [&](const auto& entry) { return entry.get() == texture; });
+	if (it == glyph_textures.end())
+		glyph_textures.push_back(atlas.shareTexture());
+}
+
 uint32_t DrawList2D::reservePrimitives(uint32_t vert_size, uint32_t idx_size)
 {
 	auto& cmd = commands.back();
@@ -0,0 +1,45 @@
+#include "../include/vkdl/util/file_io.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+VKDL_BEGIN
+
+VKDL_NODISCARD uint64_t hashFNV1a(const void* data, size_t size_in_bytes)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size_in_bytes; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+bool writeFile(const char* path, const void* data, size_t size_in_bytes)
+{
+	const std::string temp_path = std::string(path) + ".tmp";
+
+	FILE* file = std::fopen(temp_path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	const bool written = std::fwrite(data, 1, size_in_bytes, file) == size_in_bytes;
+	const bool closed  = std::fclose(file) == 0;
+
+	std::error_code error;
+	if (written && closed)
+		std::filesystem::rename(temp_path, path, error);
+
+	if (!written || !closed || error) {
+		std::filesystem::remove(temp_path, error);
+		return false;
+	}
+
+	return true;
+}
+
+VKDL_END
\ No newline at end of file
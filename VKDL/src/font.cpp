@@ -1,41 +1,253 @@
 #include "../include/vkdl/graphics/font.h"
 
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/cpu_profiler.h"
 #include "../include/vkdl/core/builtin_objects.h"
+#include "../include/vkdl/util/file_io.h"
+#include "../include/vkdl/util/mapped_file.h"
+#include "bmfont.h"
 
+#ifndef VKDL_NO_FREETYPE
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
 #include FT_OUTLINE_H
 #include FT_BITMAP_H
 #include FT_STROKER_H
+#include FT_SIZES_H
+#endif
 
-#define TEXTURE_MAXIMUM_SIZE 8192
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 
-template <typename T, typename U>
-static T reinterpret(const U& input)
+#define FONT_CACHE_VERSION 2
+
+static std::atomic<uint64_t> next_face_id = 1;
+
+struct FontCacheHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t freetype_version;
+	uint32_t padding;
+	uint64_t content_hash;
+	uint64_t payload_hash; // Everything after the header
+	uint32_t page_count;
+	uint32_t reserved;
+};
+
+#ifndef VKDL_NO_FREETYPE
+static uint32_t freetype_version(FT_Library library)
 {
-	T output;
-	std::memcpy(&output, &input, sizeof(U));
-	return output;
+	FT_Int major = 0, minor = 0, patch = 0;
+	FT_Library_Version(library, &major, &minor, &patch);
+
+	return static_cast<uint32_t>(major << 16 | minor << 8 | patch);
 }
+#endif
 
-static uint64_t combine(float outline_thickness, bool bold, std::uint32_t index)
+static uint64_t kerning_key(uint32_t first, uint32_t second)
 {
-	return (uint64_t{ reinterpret<std::uint32_t>(outline_thickness) } << 32) | (std::uint64_t{ bold } << 31) | index;
+	return static_cast<uint64_t>(first) << 32 | second;
 }
 
 VKDL_BEGIN
 
+#ifdef VKDL_NO_FREETYPE
 struct Font::FontHandles
 {
-	FontHandles() :
+};
+#else
+VKDL_PRIV_BEGIN
+
+// Parsed font file, shared by every Font opened from the same path or content.
+// Each Font keeps its own FT_Size and stroker on top of it, so the shared state
+// is only the file mapping and the face tables. FreeType faces are not thread-safe,
+// every call on the face or its library holds `mutex`, so Fonts sharing a face
+// can be used from different threads. A single Font still belongs to one thread.
+struct SharedFace
+{
+	SharedFace() :
 		library(nullptr),
-		stream_rec(),
 		face(nullptr),
+		face_id(0),
+		content_hash(0)
+	{
+	}
+
+	~SharedFace()
+	{
+		FT_Done_Face(face);
+		FT_Done_FreeType(library);
+	}
+
+	// clang-format off
+	SharedFace(const SharedFace&) = delete;
+	SharedFace& operator=(const SharedFace&) = delete;
+	// clang-format on
+
+	const uint8_t* data() const { return file.is_open() ? file.data() : memory.data(); }
+	size_t size() const { return file.is_open() ? file.size() : memory.size(); }
+
+	MappedFile           file;
+	std::vector<uint8_t> memory;
+	FT_Library           library;
+	FT_Face              face;
+	uint64_t             face_id;
+	uint64_t             content_hash;
+	std::recursive_mutex mutex; // Recursive, glyph lookups nest inside kerning queries
+};
+
+class FaceRegistry
+{
+public:
+	static FaceRegistry& get()
+	{
+		static FaceRegistry registry;
+		return registry;
+	}
+
+	std::shared_ptr<SharedFace> open(const char* path)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::error_code error;
+		auto key = std::filesystem::absolute(path, error).lexically_normal().string();
+		if (error) key = path;
+
+		// A file rewritten since it was opened is read again
+		const auto write_time = std::filesystem::last_write_time(path, error);
+
+		if (auto it = paths.find(key); it != paths.end() && !error && it->second.write_time == write_time)
+			if (auto face = it->second.face.lock())
+				return face;
+
+		MappedFile file;
+		VKDL_CHECK_MSG(file.open(path),
+			"Failed to load font (failed to open the file)");
+
+		const uint64_t hash = hashFNV1a(file.data(), file.size());
+
+		auto face = find(hash, file.data(), file.size());
+		if (!face) {
+			face = create(file.data(), file.size(), hash);
+			face->file = std::move(file);
+		}
+
+		prune();
+		paths[key] = { face, write_time };
+
+		return face;
+	}
+
+	std::shared_ptr<SharedFace> open(const void* data, size_t size_in_bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const uint64_t hash = hashFNV1a(data, size_in_bytes);
+
+		if (auto face = find(hash, static_cast<const uint8_t*>(data), size_in_bytes))
+			return face;
+
+		// Keep a private copy, the face may outlive the caller's buffer once shared
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		std::vector<uint8_t> memory(bytes, bytes + size_in_bytes);
+
+		auto face = create(memory.data(), memory.size(), hash);
+		face->memory = std::move(memory);
+
+		prune();
+
+		return face;
+	}
+
+private:
+	struct PathEntry
+	{
+		std::weak_ptr<SharedFace>       face;
+		std::filesystem::file_time_type write_time;
+	};
+
+	FaceRegistry() = default;
+
+	// The hash only narrows the search, a face is shared when its bytes match
+	std::shared_ptr<SharedFace> find(uint64_t hash, const uint8_t* data, size_t size_in_bytes)
+	{
+		auto it = contents.find(hash);
+		if (it == contents.end()) return nullptr;
+
+		auto face = it->second.lock();
+		if (face && face->size() == size_in_bytes && std::memcmp(face->data(), data, size_in_bytes) == 0)
+			return face;
+
+		return nullptr;
+	}
+
+	std::shared_ptr<SharedFace> create(const uint8_t* data, size_t size_in_bytes, uint64_t hash)
+	{
+		auto face = std::make_shared<SharedFace>();
+
+		VKDL_CHECK_MSG(FT_Init_FreeType(&face->library) == 0,
+			"Failed to load font (failed to initialize FreeType)");
+
+		VKDL_CHECK_MSG(FT_New_Memory_Face(
+			face->library,
+			reinterpret_cast<const FT_Byte*>(data),
+			static_cast<FT_Long>(size_in_bytes),
+			0,
+			&face->face) == 0,
+			"Failed to load font (failed to create the font face)");
+
+		VKDL_CHECK_MSG(FT_Select_Charmap(face->face, FT_ENCODING_UNICODE) == 0,
+			"Failed to load font (failed to set the Unicode character set)");
+
+		face->face_id      = next_face_id++;
+		face->content_hash = hash;
+		contents[hash]     = face;
+
+		return face;
+	}
+
+	void prune()
+	{
+		for (auto it = paths.begin(); it != paths.end();)
+			it = it->second.face.expired() ? paths.erase(it) : std::next(it);
+
+		for (auto it = contents.begin(); it != contents.end();)
+			it = it->second.expired() ? contents.erase(it) : std::next(it);
+	}
+
+	std::mutex                                              mutex;
+	std::unordered_map<std::string, PathEntry>              paths;
+	std::unordered_map<uint64_t, std::weak_ptr<SharedFace>> contents;
+};
+
+VKDL_PRIV_END
+
+struct Font::FontHandles
+{
+	using SharedFace = VKDL_PRIV_NAMESPACE_NAME::SharedFace;
+
+	FontHandles(std::shared_ptr<SharedFace> shared_face) :
+		shared(std::move(shared_face)),
+		library(shared->library),
+		face(shared->face),
+		size(nullptr),
 		stroker(nullptr)
-	
 	{
+		std::lock_guard<std::recursive_mutex> lock(shared->mutex);
+
+		VKDL_CHECK_MSG(FT_New_Size(face, &size) == 0,
+			"Failed to load font (failed to create the size object)");
+
+		if (FT_Stroker_New(library, &stroker) != 0) {
+			FT_Done_Size(size);
+			VKDL_ERROR("Failed to load font (failed to create the stroker)");
+		}
 	}
 
 	~FontHandles()
@@ -44,10 +256,10 @@ struct Font::FontHandles
 		// The documentation of FreeType isn't clear on the matter, but the
 		// implementation does explicitly check for null.
 
+		std::lock_guard<std::recursive_mutex> lock(shared->mutex);
+
 		FT_Stroker_Done(stroker);
-		FT_Done_Face(face);
-		// `streamRec` doesn't need to be explicitly freed.
-		FT_Done_FreeType(library);
+		FT_Done_Size(size);
 	}
 
 	// clang-format off
@@ -58,48 +270,34 @@ struct Font::FontHandles
 	FontHandles& operator=(FontHandles&&) = delete;
 	// clang-format on
 
-	FT_Library   library;
-	FT_StreamRec stream_rec;
-	FT_Face      face;
-	FT_Stroker   stroker;
+	std::shared_ptr<SharedFace> shared;
+	FT_Library                  library;
+	FT_Face                     face;
+	FT_Size                     size;
+	FT_Stroker                  stroker;
 };
-
-Font::Page::Page(bool smooth) :
-	next_row(3)
-{
-	ColorImage image(Colors::Transparent, 128, 128);
-
-	image.at(0, 0) = Colors::White;
-	image.at(0, 1) = Colors::White;
-	image.at(1, 0) = Colors::White;
-	image.at(1, 1) = Colors::White;
-
-	auto& ctx             = Context::get();
-	auto& desc_set_layout = ctx.getPipeline(VKDL_BUILTIN_PIPELINE0_UUID).getPipelineLayout().getDescriptorSetLayout(0);
-	
-	texture = TextureCreator()
-		.setImageFormat(image.format())
-		.setImageUsage(vk::ImageUsageFlagBits::eSampled 
-			| vk::ImageUsageFlagBits::eTransferDst
-			| vk::ImageUsageFlagBits::eTransferSrc)
-		.setImageExtent(image.width(), image.height())
-		.setDescriptorSetLayout(desc_set_layout)
-		.create();
-
-	texture.update(image.data());
-}
+#endif
 
 Font::Font() :
-	is_smooth(false)
+	face_id(0),
+	content_hash(0),
+	is_smooth(false),
+	memory_budget(0),
+	current_frame(0),
+	page_evictions(0),
+	bitmap_size(0),
+	bitmap_line_height(0)
 {
 }
 
-Font::Font(const char* path)
+Font::Font(const char* path) :
+	Font()
 {
 	VKDL_CHECK_MSG(loadFromFile(path), "Failed to open font from file");
 }
 
-Font::Font(const void* data, size_t size_in_bytes)
+Font::Font(const void* data, size_t size_in_bytes) :
+	Font()
 {
 	VKDL_CHECK_MSG(loadFromMemory(data, size_in_bytes), "Failed to open font from memory");
 }
@@ -108,81 +306,219 @@ VKDL_NODISCARD bool Font::loadFromFile(const char* path)
 {
 	cleanup();
 
-	auto handle = std::make_shared<FontHandles>();
+#ifdef VKDL_NO_FREETYPE
+	VKDL_ERROR("Failed to load font (built without FreeType, use loadFromBMFont)");
+#else
+	auto handle = std::make_shared<FontHandles>(VKDL_PRIV_NAMESPACE_NAME::FaceRegistry::get().open(path));
 
-	VKDL_CHECK_MSG(FT_Init_FreeType(&handle->library) == 0,
-		"Failed to load font (failed to initialize FreeType)");
+	info.family  = handle->face->family_name ? handle->face->family_name : std::string();
+	content_hash = handle->shared->content_hash;
+	face_id      = handle->shared->face_id;
+	font_handles = std::move(handle);
 
-	VKDL_CHECK_MSG(FT_New_Face(handle->library, path, 0, &handle->face) == 0,
-		"Failed to load font (failed to create the font face)");
+	return true;
+#endif
+}
 
-	VKDL_CHECK_MSG(FT_Stroker_New(handle->library, &handle->stroker) == 0,
-		"Failed to load font (failed to create the stroker)")
+VKDL_NODISCARD bool Font::loadFromMemory(const void* data, size_t size_in_bytes)
+{
+	cleanup();
 
-	VKDL_CHECK_MSG(FT_Select_Charmap(handle->face, FT_ENCODING_UNICODE) == 0,
-		"Failed to load font (failed to set the Unicode character set)");
+#ifdef VKDL_NO_FREETYPE
+	VKDL_ERROR("Failed to load font (built without FreeType, use loadFromBMFont)");
+#else
+	auto handle = std::make_shared<FontHandles>(VKDL_PRIV_NAMESPACE_NAME::FaceRegistry::get().open(data, size_in_bytes));
 
 	info.family  = handle->face->family_name ? handle->face->family_name : std::string();
+	content_hash = handle->shared->content_hash;
+	face_id      = handle->shared->face_id;
 	font_handles = std::move(handle);
 
 	return true;
+#endif
 }
 
-VKDL_NODISCARD bool Font::loadFromMemory(const void* data, size_t size_in_bytes)
+VKDL_NODISCARD bool Font::loadFromBMFont(const char* path)
 {
 	cleanup();
 
-	auto handle = std::make_shared<FontHandles>();
+	MappedFile file;
+	if (!file.open(path))
+		return false;
 
-	VKDL_CHECK_MSG(FT_Init_FreeType(&handle->library) == 0,
-		"Failed to load font (failed to initialize FreeType)");
+	VKDL_PRIV_NAMESPACE_NAME::BMFontDescriptor desc;
+	VKDL_CHECK_MSG(VKDL_PRIV_NAMESPACE_NAME::parseBMFont(file.data(), file.size(), desc),
+		"Failed to load font (invalid BMFont descriptor)");
 
-	VKDL_CHECK_MSG(FT_New_Memory_Face(
-		handle->library,
-		reinterpret_cast<const FT_Byte*>(data),
-		static_cast<FT_Long>(size_in_bytes),
-		0,
-		&handle->face) == 0,
-		"Failed to load font (failed to create the font face)");
+	VKDL_CHECK_MSG(!desc.packed,
+		"Failed to load font (BMFont channel packing is not supported)");
 
-	VKDL_CHECK_MSG(FT_Stroker_New(handle->library, &handle->stroker) == 0,
-		"Failed to load font (failed to create the stroker)")
+	const auto directory = std::filesystem::path(path).parent_path();
 
-	VKDL_CHECK_MSG(FT_Select_Charmap(handle->face, FT_ENCODING_UNICODE) == 0,
-		"Failed to load font (failed to set the Unicode character set)");
+	std::vector<ColorImage> images(desc.pages.size());
+	for (size_t i = 0; i < desc.pages.size(); ++i) {
+		VKDL_CHECK_MSG(images[i].loadFromFile((directory / desc.pages[i]).string().c_str()),
+			"Failed to load font (failed to load page " + desc.pages[i] + ")");
 
+		// Pages exported without an alpha channel carry the coverage in the color channels
+		if (desc.alpha_channel == 3 || desc.alpha_channel == 4) {
+			for (uint32_t y = 0; y < images[i].height(); ++y) {
+				for (uint32_t x = 0; x < images[i].width(); ++x) {
+					auto& pixel = images[i].at(x, y);
+					pixel = Color(255, 255, 255, pixel.r);
+				}
+			}
+		}
+	}
 
-	info.family  = handle->face->family_name ? handle->face->family_name : std::string();
-	font_handles = std::move(handle);
+	shared_atlas.reset();
+
+	const uint32_t padding = GlyphAtlas::padding;
+
+	face_id            = next_face_id++;
+	content_hash       = hashFNV1a(file.data(), file.size());
+	bitmap_size        = std::max<uint32_t>(1, static_cast<uint32_t>(std::abs(desc.size)));
+	bitmap_line_height = static_cast<float>(desc.line_height);
+	info.family        = desc.face;
+
+	GlyphAtlas& page = *pages.emplace(bitmap_size, std::make_shared<GlyphAtlas>()).first->second;
+
+	// Place every glyph first so the atlas reaches its final size,
+	// then compose the pixels on the CPU and upload them at once
+	struct PlacedGlyph
+	{
+		GlyphKey                key;
+		Glyph                   glyph;
+		const VKDL_PRIV_NAMESPACE_NAME::BMFontChar* source;
+	};
+
+	std::vector<PlacedGlyph> glyphs;
+	glyphs.reserve(desc.chars.size());
+
+	for (const auto& ch : desc.chars) {
+		if (ch.page >= images.size()) continue;
+
+		GlyphKey key = {};
+		key.face_id        = face_id;
+		key.glyph_index    = ch.id;
+		key.character_size = bitmap_size;
+
+		Glyph glyph = {};
+		glyph.advance         = static_cast<float>(ch.xadvance);
+		glyph.bounds.position = vec2(static_cast<float>(ch.xoffset), static_cast<float>(ch.yoffset) - static_cast<float>(desc.base));
+		glyph.bounds.size     = vec2(static_cast<float>(ch.width), static_cast<float>(ch.height));
+
+		if (ch.width > 0 && ch.height > 0) {
+			glyph.texture_rect = page.allocate(uvec2(ch.width, ch.height) + 2u * uvec2(padding, padding));
+
+			glyph.texture_rect.position += ivec2(padding, padding);
+			glyph.texture_rect.size     -= 2 * ivec2(padding, padding);
+		}
+
+		glyphs.push_back({ key, glyph, &ch });
+	}
+
+	const uvec2 extent = page.getTexture().extent();
+
+	ColorImage atlas(Colors::Transparent, extent.x, extent.y);
+	atlas.at(0, 0) = Colors::White;
+	atlas.at(0, 1) = Colors::White;
+	atlas.at(1, 0) = Colors::White;
+	atlas.at(1, 1) = Colors::White;
+
+	for (const auto& [key, glyph, source] : glyphs) {
+		const auto& ch    = *source;
+		const auto& image = images[ch.page];
+
+		for (uint32_t y = 0; y < static_cast<uint32_t>(glyph.texture_rect.size.y); ++y) {
+			for (uint32_t x = 0; x < static_cast<uint32_t>(glyph.texture_rect.size.x); ++x) {
+				if (ch.x + x >= image.width() || ch.y + y >= image.height()) continue;
+				atlas.at(glyph.texture_rect.position.x + x, glyph.texture_rect.position.y + y) = image.at(ch.x + x, ch.y + y);
+			}
+		}
+	}
+
+	page.update(atlas.data(), ivec2(0, 0), extent);
+
+	// Pinned, the page images are gone once loaded and evicted glyphs could not come back
+	for (const auto& [key, glyph, source] : glyphs)
+		page.insertGlyph(key, glyph, true);
+
+	for (const auto& kerning : desc.kernings)
+		bitmap_kernings[kerning_key(kerning.first, kerning.second)] = static_cast<float>(kerning.amount);
 
 	return true;
 }
 
+VKDL_NODISCARD bool Font::isBitmapFont() const
+{
+	return bitmap_size != 0;
+}
+
 VKDL_NODISCARD const Glyph& Font::getGlyph(std::uint32_t code_point, uint32_t character_size, bool bold, float outline_thickness) const
 {
-	GlyphTable& glyphs = loadPage(character_size).glyphs;
+	static const Glyph empty_glyph = {};
+
+	auto lock = lockFace();
+
+	if (isBitmapFont()) {
+		character_size    = bitmap_size;
+		bold              = false;
+		outline_thickness = 0;
+	}
+
+	GlyphAtlas& page = *loadPage(character_size);
 
-	const std::uint64_t key = combine(outline_thickness,
-		bold,
-		FT_Get_Char_Index(font_handles ? font_handles->face : nullptr, code_point));
+	GlyphKey key = {};
+	key.face_id           = face_id;
+	key.glyph_index       = getGlyphIndex(code_point);
+	key.character_size    = character_size;
+	key.bold              = bold;
+	key.outline_thickness = outline_thickness;
 
-	if (const auto it = glyphs.find(key); it != glyphs.end())
-		return it->second;
+	if (const Glyph* glyph = page.findGlyph(key))
+		return *glyph;
+
+	// Bitmap fonts have nothing to rasterize, their glyphs are pinned
+	// so a miss is a character the font does not have
+	if (isBitmapFont())
+		return empty_glyph;
+
+	VKDL_PROFILE_ZONE("Font::loadGlyph");
 
 	const Glyph glyph = loadGlyph(code_point, character_size, bold, outline_thickness);
 	
-	return glyphs.emplace(key, glyph).first->second;
+	return page.insertGlyph(key, glyph);
 }
 
 VKDL_NODISCARD bool Font::hasGlyph(std::uint32_t code_point) const
 {
-	return FT_Get_Char_Index(font_handles ? font_handles->face : nullptr, code_point) != 0;
+	if (isBitmapFont()) {
+		GlyphKey key = {};
+		key.face_id        = face_id;
+		key.glyph_index    = code_point;
+		key.character_size = bitmap_size;
+
+		return loadPage(bitmap_size)->findGlyph(key) != nullptr;
+	}
+
+	auto lock = lockFace();
+
+	return getGlyphIndex(code_point) != 0;
 }
 
 VKDL_NODISCARD float Font::getKerning(std::uint32_t first, std::uint32_t second, uint32_t character_size, bool bold) const
 {
 	if (first == 0 || second == 0) return 0.f;
 
+	if (isBitmapFont()) {
+		const auto it = bitmap_kernings.find(kerning_key(first, second));
+		return it != bitmap_kernings.end() ? it->second : 0.f;
+	}
+
+#ifndef VKDL_NO_FREETYPE
+	auto lock = lockFace();
+
 	FT_Face face = font_handles ? font_handles->face : nullptr;
 
 	if (face && setCurrentSize(character_size)) {
@@ -201,22 +537,36 @@ VKDL_NODISCARD float Font::getKerning(std::uint32_t first, std::uint32_t second,
 
 		return std::floor((secondLsbDelta - firstRsbDelta + static_cast<float>(kerning.x) + 32) / float{ 1 << 6 });
 	}
+#endif
 
 	return 0.f;
 }
 
 VKDL_NODISCARD float Font::getLineSpacing(uint32_t character_size) const
 {
+	if (isBitmapFont())
+		return bitmap_line_height;
+
+#ifndef VKDL_NO_FREETYPE
+	auto lock = lockFace();
+
 	FT_Face face = font_handles ? font_handles->face : nullptr;
 
 	if (face && setCurrentSize(character_size))
 		return static_cast<float>(face->size->metrics.height) / float{ 1 << 6 };
+#endif
 
 	return 0.f;
 }
 
 VKDL_NODISCARD float Font::getUnderlinePosition(uint32_t character_size) const
 {
+	if (isBitmapFont())
+		return static_cast<float>(bitmap_size) / 10.f;
+
+#ifndef VKDL_NO_FREETYPE
+	auto lock = lockFace();
+
 	FT_Face face = font_handles ? font_handles->face : nullptr;
 
 	if (face && setCurrentSize(character_size)) {
@@ -224,12 +574,19 @@ VKDL_NODISCARD float Font::getUnderlinePosition(uint32_t character_size) const
 			return static_cast<float>(character_size) / 10.f;
 		return -static_cast<float>(FT_MulFix(face->underline_position, face->size->metrics.y_scale)) / float{ 1 << 6 };
 	}
+#endif
 
 	return 0.f;
 }
 
 VKDL_NODISCARD float Font::getUnderlineThickness(uint32_t character_size) const
 {
+	if (isBitmapFont())
+		return static_cast<float>(bitmap_size) / 14.f;
+
+#ifndef VKDL_NO_FREETYPE
+	auto lock = lockFace();
+
 	FT_Face face = font_handles ? font_handles->face : nullptr;
 
 	if (face && setCurrentSize(character_size))	{
@@ -237,13 +594,174 @@ VKDL_NODISCARD float Font::getUnderlineThickness(uint32_t character_size) const
 			return static_cast<float>(character_size) / 14.f;
 		return static_cast<float>(FT_MulFix(face->underline_thickness, face->size->metrics.y_scale)) / float{ 1 << 6 };
 	}
+#endif
 
 	return 0.f;
 }
 
 VKDL_NODISCARD const Texture& Font::getTexture(uint32_t character_size) const
 {
-	return loadPage(character_size).texture;
+	return loadPage(isBitmapFont() ? bitmap_size : character_size)->getTexture();
+}
+
+void Font::setGlyphAtlas(std::shared_ptr<GlyphAtlas> atlas)
+{
+	if (shared_atlas == atlas) return;
+
+	VKDL_CHECK_MSG(!isBitmapFont(), "Bitmap fonts keep their glyphs in their own atlas");
+
+	pages.clear();
+	shared_atlas = std::move(atlas);
+}
+
+VKDL_NODISCARD const std::shared_ptr<GlyphAtlas>& Font::getGlyphAtlas() const
+{
+	return shared_atlas;
+}
+
+VKDL_NODISCARD std::shared_ptr<GlyphAtlas> Font::getGlyphAtlas(uint32_t character_size) const
+{
+	return loadPage(isBitmapFont() ? bitmap_size : character_size);
+}
+
+void Font::setMemoryBudget(size_t size_in_bytes)
+{
+	memory_budget = size_in_bytes;
+	current_frame = Context::get().frame_count - 1;
+}
+
+VKDL_NODISCARD size_t Font::getMemoryBudget() const
+{
+	return memory_budget;
+}
+
+VKDL_NODISCARD GlyphAtlasStats Font::getStats() const
+{
+	if (shared_atlas)
+		return shared_atlas->getStats();
+
+	GlyphAtlasStats stats;
+	for (const auto& [size, page] : pages)
+		stats += page->getStats();
+
+	stats.page_evictions += page_evictions;
+
+	return stats;
+}
+
+VKDL_NODISCARD bool Font::saveCache(const char* path) const
+{
+#ifdef VKDL_NO_FREETYPE
+	return false;
+#else
+	if (!font_handles || shared_atlas)
+		return false;
+
+	FontCacheHeader header = {};
+	std::memcpy(header.magic, "VKFC", 4);
+	header.version          = FONT_CACHE_VERSION;
+	header.freetype_version = freetype_version(font_handles->library);
+	header.padding          = GlyphAtlas::padding;
+	header.content_hash     = content_hash;
+	header.page_count       = static_cast<uint32_t>(pages.size());
+
+	std::vector<uint8_t> output(sizeof(FontCacheHeader));
+	std::memcpy(output.data(), &header, sizeof(FontCacheHeader));
+
+	for (const auto& [character_size, page] : pages) {
+		const auto* bytes = reinterpret_cast<const uint8_t*>(&character_size);
+		output.insert(output.end(), bytes, bytes + sizeof(uint32_t));
+
+		page->serialize(output);
+	}
+
+	header.payload_hash = hashFNV1a(output.data() + sizeof(FontCacheHeader), output.size() - sizeof(FontCacheHeader));
+	std::memcpy(output.data(), &header, sizeof(FontCacheHeader));
+
+	return writeFile(path, output.data(), output.size());
+#endif
+}
+
+VKDL_NODISCARD bool Font::loadCache(const char* path)
+{
+#ifdef VKDL_NO_FREETYPE
+	return false;
+#else
+	if (!font_handles || shared_atlas)
+		return false;
+
+	MappedFile file;
+	if (!file.open(path) || file.size() < sizeof(FontCacheHeader))
+		return false;
+
+	FontCacheHeader header;
+	std::memcpy(&header, file.data(), sizeof(FontCacheHeader));
+
+	if (std::memcmp(header.magic, "VKFC", 4) != 0
+		|| header.version != FONT_CACHE_VERSION
+		|| header.freetype_version != freetype_version(font_handles->library)
+		|| header.padding != GlyphAtlas::padding
+		|| header.content_hash != content_hash)
+		return false;
+
+	const uint8_t* data = file.data() + sizeof(FontCacheHeader);
+	const uint8_t* end  = file.data() + file.size();
+
+	// Catches truncated and corrupted files before anything is parsed
+	if (hashFNV1a(data, static_cast<size_t>(end - data)) != header.payload_hash)
+		return false;
+
+	PageTable                                           new_pages;
+	std::vector<std::pair<GlyphAtlas*, const uint8_t*>> uploads;
+	size_t                                              upload_size = 0;
+
+	try {
+		for (uint32_t i = 0; i < header.page_count; ++i) {
+			VKDL_CHECK_MSG(static_cast<size_t>(end - data) >= sizeof(uint32_t), "Font cache is truncated");
+
+			uint32_t character_size;
+			std::memcpy(&character_size, data, sizeof(uint32_t));
+			data += sizeof(uint32_t);
+
+			auto [it, inserted] = new_pages.try_emplace(character_size, std::make_shared<GlyphAtlas>(data, end, face_id));
+			VKDL_CHECK_MSG(inserted, "Font cache is corrupted");
+
+			uploads.emplace_back(it->second.get(), data);
+			upload_size += it->second->memoryUsage();
+			data        += it->second->memoryUsage();
+		}
+	} catch (const std::exception&) {
+		return false;
+	}
+
+	// All pages go through one staging buffer and one submission
+	if (upload_size != 0) {
+		auto& ctx = Context::get();
+
+		Buffer<uint8_t> staging_buffer(
+			upload_size,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible);
+
+		auto* mapped = staging_buffer.map();
+		auto  cmd    = ctx.beginSingleTimeCommmand();
+
+		vk::DeviceSize offset = 0;
+		for (auto& [page, pixels] : uploads) {
+			std::memcpy(mapped + offset, pixels, page->memoryUsage());
+			page->upload(cmd, staging_buffer.getBuffer(), offset);
+			offset += page->memoryUsage();
+		}
+
+		staging_buffer.flush();
+		ctx.endSingleTimeCommmand(cmd);
+	}
+
+	// Replaced pages retire their textures, frames in flight keep sampling them
+	pages = std::move(new_pages);
+
+	return true;
+#endif
 }
 
 //void Font::setSmooth(bool smooth)
@@ -274,17 +792,95 @@ void Font::cleanup()
 	font_handles.reset();
 	pages.clear();
 	pixel_buffer.clear();
+	bitmap_kernings.clear();
+
+	bitmap_size        = 0;
+	bitmap_line_height = 0;
+}
+
+std::unique_lock<std::recursive_mutex> Font::lockFace() const
+{
+#ifndef VKDL_NO_FREETYPE
+	if (font_handles)
+		return std::unique_lock<std::recursive_mutex>(font_handles->shared->mutex);
+#endif
+
+	return {};
+}
+
+const std::shared_ptr<GlyphAtlas>& Font::loadPage(uint32_t character_size) const
+{
+	if (shared_atlas)
+		return shared_atlas;
+
+	enforceMemoryBudget();
+
+	auto& page = pages[character_size];
+	if (!page)
+		page = std::make_shared<GlyphAtlas>();
+
+	return page;
+}
+
+void Font::enforceMemoryBudget() const
+{
+	const uint64_t frame = Context::get().frame_count;
+	if (memory_budget == 0 || frame == current_frame || isBitmapFont()) return;
+
+	current_frame = frame;
+
+	size_t usage = 0;
+	for (const auto& [size, page] : pages)
+		usage += page->memoryUsage();
+
+	if (usage <= memory_budget) return;
+
+	// Drop whole pages not used this frame, least recently used first. Draw lists
+	// keep the textures they were recorded with, the rest is retired
+	std::vector<PageTable::iterator> stale;
+	for (auto it = pages.begin(); it != pages.end(); ++it)
+		if (it->second->lastUsedFrame() != frame)
+			stale.push_back(it);
+
+	std::sort(stale.begin(), stale.end(), [](const PageTable::iterator& lhs, const PageTable::iterator& rhs) {
+		return lhs->second->lastUsedFrame() < rhs->second->lastUsedFrame();
+	});
+
+	size_t evict_count = 0;
+	while (evict_count < stale.size() && usage > memory_budget)
+		usage -= stale[evict_count++]->second->memoryUsage();
+
+	for (size_t i = 0; i < evict_count; ++i)
+		pages.erase(stale[i]);
+
+	page_evictions += evict_count;
+
+	// The pages still in use share what is left of the budget
+	if (usage > memory_budget) {
+		const size_t share = memory_budget / pages.size();
+		for (auto& [size, page] : pages)
+			page->trim(share);
+	}
 }
 
-Font::Page& Font::loadPage(uint32_t character_size) const
+uint32_t Font::getGlyphIndex(std::uint32_t code_point) const
 {
-	return pages.try_emplace(character_size, is_smooth).first->second;
+	// Bitmap fonts are indexed by code point directly
+	if (isBitmapFont())
+		return code_point;
+
+#ifndef VKDL_NO_FREETYPE
+	return FT_Get_Char_Index(font_handles ? font_handles->face : nullptr, code_point);
+#else
+	return 0;
+#endif
 }
 
 Glyph Font::loadGlyph(std::uint32_t code_point, uint32_t character_size, bool bold, float outline_thickness) const
 {
-	Glyph glyph;
+	Glyph glyph = {};
 
+#ifndef VKDL_NO_FREETYPE
 	if (!font_handles)
 		return glyph;
 
@@ -349,13 +945,13 @@ Glyph Font::loadGlyph(std::uint32_t code_point, uint32_t character_size, bool bo
 	uvec2 size(bitmap.width, bitmap.rows);
 
 	if ((size.x > 0) && (size.y > 0)) {
-		const uint32_t padding = 2;
+		const uint32_t padding = GlyphAtlas::padding;
 
 		size += 2u * uvec2(padding, padding);
 
-		Page& page = loadPage(character_size);
+		GlyphAtlas& page = *loadPage(character_size);
 
-		glyph.texture_rect = findGlyphRect(page, size);
+		glyph.texture_rect = page.allocate(size);
 
 		glyph.texture_rect.position += ivec2(padding, padding);
 		glyph.texture_rect.size     -= 2 * ivec2(padding, padding);
@@ -396,66 +992,25 @@ Glyph Font::loadGlyph(std::uint32_t code_point, uint32_t character_size, bool bo
 
 		const auto dest = uvec2(glyph.texture_rect.position) - uvec2(padding, padding);
 		const auto updateSize = uvec2(glyph.texture_rect.size) + 2u * uvec2(padding, padding);
-		page.texture.update(pixel_buffer.data(), (ivec2)dest, updateSize);
+		page.update(pixel_buffer.data(), (ivec2)dest, updateSize);
 	}
 
 	FT_Done_Glyph(glyphDesc);
+#endif
 
 	return glyph;
 }
 
-irect Font::findGlyphRect(Page& page, uvec2 size) const
+VKDL_NODISCARD bool Font::setCurrentSize(uint32_t character_size) const
 {
-	Row* row = nullptr;
-	float bestRatio = 0;
-	for (auto it = page.rows.begin(); it != page.rows.end() && !row; ++it)
-	{
-		const float ratio = static_cast<float>(size.y) / static_cast<float>(it->height);
-
-		// Ignore rows that are either too small or too high
-		if ((ratio < 0.7f) || (ratio > 1.f))
-			continue;
-
-		// Check if there's enough horizontal space left in the row
-		if (size.x > page.texture.extent().x - it->width)
-			continue;
-
-		// Make sure that this new row is the best found so far
-		if (ratio < bestRatio)
-			continue;
-
-		// The current row passed all the tests: we can select it
-		row = &*it;
-		bestRatio = ratio;
-	}
-
-	// If we didn't find a matching row, create a new one (10% taller than the glyph)
-	if (!row) {
-		const uint32_t rowHeight = size.y + size.y / 10;
-		while ((page.next_row + rowHeight >= page.texture.extent().y) || (size.x >= page.texture.extent().x)) {
-			const uvec2 textureSize = page.texture.extent();
-			if ((textureSize.x * 2 <= TEXTURE_MAXIMUM_SIZE) && (textureSize.y * 2 <= TEXTURE_MAXIMUM_SIZE)) {
-				page.texture.resize(2u * textureSize.x, 2u * textureSize.y);
-			} else {
-				VKDL_ERROR("Failed to add a new character to the font: the maximum texture size has been reached");
-				return { {0, 0}, {2, 2} };
-			}
-		}
-
-		page.rows.emplace_back(page.next_row, rowHeight);
-		page.next_row += rowHeight;
-		row = &page.rows.back();
-	}
+#ifdef VKDL_NO_FREETYPE
+	return false;
+#else
+	FT_Face face = font_handles->face;
 
-	irect rect({ row->width, row->top }, size);
-	row->width += size.x;
+	// The face is shared, select this font's size object before touching it
+	FT_Activate_Size(font_handles->size);
 
-	return rect;
-}
-
-VKDL_NODISCARD bool Font::setCurrentSize(uint32_t character_size) const
-{
-	FT_Face         face = font_handles->face;
 	const FT_UShort currentSize = face->size->metrics.x_ppem;
 
 	if (currentSize != character_size) {
@@ -468,6 +1023,7 @@ VKDL_NODISCARD bool Font::setCurrentSize(uint32_t character_size) const
 	}
 
 	return true;
+#endif
 }
 
 VKDL_END
\ No newline at end of file
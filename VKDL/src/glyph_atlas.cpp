@@ -0,0 +1,617 @@
+#include "../include/vkdl/graphics/glyph_atlas.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/cpu_profiler.h"
+#include "../include/vkdl/core/builtin_objects.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Bytes serialize() writes per glyph: key, metrics and both rects
+#define GLYPH_RECORD_SIZE (4 * sizeof(uint32_t) + 3 * sizeof(int32_t) + sizeof(rect) + 2 * sizeof(irect))
+
+template <typename T, typename U>
+static T reinterpret(const U& input)
+{
+	T output;
+	std::memcpy(&output, &input, sizeof(U));
+	return output;
+}
+
+static void hash_combine(size_t& seed, uint64_t value)
+{
+	seed ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+template <typename T>
+static void write(std::vector<uint8_t>& output, const T& value)
+{
+	const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+	output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T read(const uint8_t*& data, const uint8_t* end)
+{
+	VKDL_CHECK_MSG(static_cast<size_t>(end - data) >= sizeof(T), "Glyph atlas cache is truncated");
+
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+
+	return value;
+}
+
+// The last owner, the atlas or a draw list recorded against it, retires the texture
+static std::shared_ptr<vkdl::Texture> share_texture(vkdl::Texture&& texture)
+{
+	return std::shared_ptr<vkdl::Texture>(new vkdl::Texture(std::move(texture)), [](vkdl::Texture* texture) {
+		vkdl::Context::get().retire(std::shared_ptr<vkdl::Texture>(texture));
+	});
+}
+
+VKDL_BEGIN
+
+bool GlyphKey::operator==(const GlyphKey& rhs) const
+{
+	return face_id == rhs.face_id
+		&& glyph_index == rhs.glyph_index
+		&& character_size == rhs.character_size
+		&& bold == rhs.bold
+		&& outline_thickness == rhs.outline_thickness;
+}
+
+bool GlyphKey::operator!=(const GlyphKey& rhs) const
+{
+	return !(*this == rhs);
+}
+
+size_t GlyphKeyHash::operator()(const GlyphKey& key) const
+{
+	size_t seed = 0;
+	hash_combine(seed, key.face_id);
+	hash_combine(seed, (uint64_t)key.glyph_index << 32 | key.character_size);
+	hash_combine(seed, (uint64_t)reinterpret<uint32_t>(key.outline_thickness) << 1 | key.bold);
+	return seed;
+}
+
+float GlyphAtlasStats::hitRate() const
+{
+	const auto lookups = hits + misses;
+	return lookups ? static_cast<float>(hits) / static_cast<float>(lookups) : 0.f;
+}
+
+float GlyphAtlasStats::occupancy() const
+{
+	return total_texels ? static_cast<float>(used_texels) / static_cast<float>(total_texels) : 0.f;
+}
+
+GlyphAtlasStats& GlyphAtlasStats::operator+=(const GlyphAtlasStats& rhs)
+{
+	hits           += rhs.hits;
+	misses         += rhs.misses;
+	evictions      += rhs.evictions;
+	page_evictions += rhs.page_evictions;
+	compactions    += rhs.compactions;
+	glyph_count    += rhs.glyph_count;
+	used_texels    += rhs.used_texels;
+	total_texels   += rhs.total_texels;
+	memory_usage   += rhs.memory_usage;
+
+	return *this;
+}
+
+GlyphAtlas::GlyphAtlas(uint32_t width, uint32_t height) :
+	next_row(3),
+	memory_budget(0),
+	current_frame(Context::get().frame_count),
+	last_used(current_frame),
+	used_texels(0),
+	generation(0),
+	stats()
+{
+	texture = share_texture(createTexture(width, height));
+}
+
+GlyphAtlas::GlyphAtlas(const uint8_t*& data, const uint8_t* end, uint64_t face_id) :
+	next_row(3),
+	memory_budget(0),
+	current_frame(Context::get().frame_count),
+	last_used(current_frame),
+	used_texels(0),
+	generation(0),
+	stats()
+{
+	const auto width       = read<uint32_t>(data, end);
+	const auto height      = read<uint32_t>(data, end);
+	const auto row_count   = read<uint32_t>(data, end);
+	const auto glyph_count = read<uint32_t>(data, end);
+
+	next_row = read<uint32_t>(data, end);
+
+	VKDL_CHECK_MSG(0 < width && width <= texture_max_size && 0 < height && height <= texture_max_size && next_row <= height,
+		"Glyph atlas cache is corrupted");
+
+	VKDL_CHECK_MSG(row_count <= height && glyph_count <= static_cast<size_t>(end - data) / GLYPH_RECORD_SIZE,
+		"Glyph atlas cache is corrupted");
+
+	const auto inside = [&](const irect& r) {
+		return r.position.x >= 0 && r.position.y >= 0 && r.size.x >= 0 && r.size.y >= 0
+			&& static_cast<uint64_t>(r.position.x) + r.size.x <= width
+			&& static_cast<uint64_t>(r.position.y) + r.size.y <= height;
+	};
+
+	rows.reserve(row_count);
+	for (uint32_t i = 0; i < row_count; ++i) {
+		const auto row_width  = read<uint32_t>(data, end);
+		const auto row_top    = read<uint32_t>(data, end);
+		const auto row_height = read<uint32_t>(data, end);
+
+		VKDL_CHECK_MSG(row_width <= width && static_cast<uint64_t>(row_top) + row_height <= height,
+			"Glyph atlas cache is corrupted");
+
+		rows.emplace_back(row_top, row_height).width = row_width;
+	}
+
+	glyphs.reserve(glyph_count);
+	for (uint32_t i = 0; i < glyph_count; ++i) {
+		GlyphKey key = {};
+		key.face_id           = face_id;
+		key.glyph_index       = read<uint32_t>(data, end);
+		key.character_size    = read<uint32_t>(data, end);
+		key.bold              = read<uint32_t>(data, end) != 0;
+		key.outline_thickness = read<float>(data, end);
+
+		Entry entry;
+		entry.glyph.advance      = read<float>(data, end);
+		entry.glyph.lsb_delta    = read<int32_t>(data, end);
+		entry.glyph.rsb_delta    = read<int32_t>(data, end);
+		entry.glyph.bounds       = read<rect>(data, end);
+		entry.glyph.texture_rect = read<irect>(data, end);
+		entry.rect               = read<irect>(data, end);
+		entry.last_used          = current_frame;
+		entry.pinned             = false;
+
+		// Out of bounds rects would sample and copy outside the page
+		VKDL_CHECK_MSG(inside(entry.rect) && inside(entry.glyph.texture_rect),
+			"Glyph atlas cache is corrupted");
+
+		used_texels += static_cast<size_t>(entry.rect.size.x) * entry.rect.size.y;
+
+		glyphs.insert_or_assign(key, entry);
+	}
+
+	texture = share_texture(createTexture(width, height, false));
+
+	VKDL_CHECK_MSG(static_cast<size_t>(end - data) >= texture->size_in_bytes(), "Glyph atlas cache is truncated");
+}
+
+VKDL_NODISCARD const Glyph* GlyphAtlas::findGlyph(const GlyphKey& key)
+{
+	syncFrame();
+
+	last_used = current_frame;
+
+	if (auto it = glyphs.find(key); it != glyphs.end()) {
+		++stats.hits;
+		it->second.last_used = current_frame;
+		return &it->second.glyph;
+	}
+
+	++stats.misses;
+	VKDL_PROFILE_COUNT(GlyphMisses, 1);
+	return nullptr;
+}
+
+const Glyph& GlyphAtlas::insertGlyph(const GlyphKey& key, const Glyph& glyph, bool pinned)
+{
+	Entry entry;
+	entry.glyph     = glyph;
+	entry.rect      = irect({ 0, 0 }, { 0, 0 });
+	entry.last_used = Context::get().frame_count;
+	entry.pinned    = pinned;
+
+	// Keep the padded region the glyph was allocated with, so a repack
+	// moves the transparent border along with the bitmap
+	const auto& rect = glyph.texture_rect;
+	if (rect.size.x > 0 && rect.size.y > 0)
+		entry.rect = irect(rect.position - ivec2(padding), rect.size + ivec2(2 * padding));
+
+	auto [it, inserted] = glyphs.try_emplace(key, entry);
+	if (!inserted) {
+		used_texels -= static_cast<size_t>(it->second.rect.size.x) * it->second.rect.size.y;
+		it->second = entry;
+	}
+
+	used_texels += static_cast<size_t>(entry.rect.size.x) * entry.rect.size.y;
+
+	return it->second.glyph;
+}
+
+VKDL_NODISCARD irect GlyphAtlas::allocate(uvec2 size)
+{
+	irect  rect;
+	size_t target = memory_budget != 0 ? std::min(memory_budget, memoryUsage()) : memoryUsage();
+
+	while (!packRect(rows, next_row, texture->extent(), size, rect)) {
+		const uvec2 texture_size = texture->extent();
+
+		if ((texture_size.x * 2 > texture_max_size) || (texture_size.y * 2 > texture_max_size)) {
+			VKDL_CHECK_MSG(target != 0, "Failed to add a new character to the font: it does not fit next to the pinned glyphs");
+
+			// Evicts right away, draw lists recorded before keep the previous texture (see shareTexture())
+			compact(target);
+			target /= 2;
+			continue;
+		}
+
+		// Growing keeps every glyph at its texel position
+		auto grown = createTexture(2u * texture_size.x, 2u * texture_size.y);
+
+		vk::ImageCopy region = {};
+		region.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		region.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		region.extent         = vk::Extent3D{ texture_size.x, texture_size.y, 1 };
+
+		grown.copy(*texture, &region, 1);
+		replaceTexture(std::move(grown), true);
+	}
+
+	return rect;
+}
+
+void GlyphAtlas::update(const void* pixels, const ivec2& offset, const uvec2& size)
+{
+	texture->update(const_cast<void*>(pixels), offset, size);
+}
+
+void GlyphAtlas::upload(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize buffer_offset)
+{
+	texture->update(cmd, buffer, buffer_offset, ivec2(0, 0), texture->extent());
+}
+
+void GlyphAtlas::serialize(std::vector<uint8_t>& output) const
+{
+	const auto extent = texture->extent();
+
+	write<uint32_t>(output, extent.x);
+	write<uint32_t>(output, extent.y);
+	write<uint32_t>(output, static_cast<uint32_t>(rows.size()));
+	write<uint32_t>(output, static_cast<uint32_t>(glyphs.size()));
+	write<uint32_t>(output, next_row);
+
+	for (const auto& row : rows) {
+		write<uint32_t>(output, row.width);
+		write<uint32_t>(output, row.top);
+		write<uint32_t>(output, row.height);
+	}
+
+	for (const auto& [key, entry] : glyphs) {
+		write<uint32_t>(output, key.glyph_index);
+		write<uint32_t>(output, key.character_size);
+		write<uint32_t>(output, key.bold ? 1 : 0);
+		write<float>(output, key.outline_thickness);
+
+		write<float>(output, entry.glyph.advance);
+		write<int32_t>(output, entry.glyph.lsb_delta);
+		write<int32_t>(output, entry.glyph.rsb_delta);
+		write<rect>(output, entry.glyph.bounds);
+		write<irect>(output, entry.glyph.texture_rect);
+		write<irect>(output, entry.rect);
+	}
+
+	const size_t offset = output.size();
+	output.resize(offset + texture->size_in_bytes());
+	texture->readback(output.data() + offset);
+}
+
+void GlyphAtlas::setMemoryBudget(size_t size_in_bytes)
+{
+	memory_budget = size_in_bytes;
+}
+
+VKDL_NODISCARD size_t GlyphAtlas::getMemoryBudget() const
+{
+	return memory_budget;
+}
+
+VKDL_NODISCARD size_t GlyphAtlas::memoryUsage() const
+{
+	return texture->size_in_bytes();
+}
+
+void GlyphAtlas::trim()
+{
+	if (memory_budget != 0)
+		trim(memory_budget);
+}
+
+void GlyphAtlas::trim(size_t size_in_bytes)
+{
+	if (memoryUsage() > size_in_bytes)
+		compact(size_in_bytes);
+}
+
+VKDL_NODISCARD const Texture& GlyphAtlas::getTexture() const
+{
+	return *texture;
+}
+
+VKDL_NODISCARD std::shared_ptr<const Texture> GlyphAtlas::shareTexture() const
+{
+	return texture;
+}
+
+VKDL_NODISCARD size_t GlyphAtlas::glyphCount() const
+{
+	return glyphs.size();
+}
+
+VKDL_NODISCARD uint64_t GlyphAtlas::lastUsedFrame() const
+{
+	return last_used;
+}
+
+VKDL_NODISCARD uint64_t GlyphAtlas::getGeneration() const
+{
+	return generation;
+}
+
+VKDL_NODISCARD GlyphAtlasStats GlyphAtlas::getStats() const
+{
+	const auto extent = texture->extent();
+
+	GlyphAtlasStats result = stats;
+	result.glyph_count  = glyphs.size();
+	result.used_texels  = used_texels;
+	result.total_texels = static_cast<size_t>(extent.x) * extent.y;
+	result.memory_usage = memoryUsage();
+
+	return result;
+}
+
+void GlyphAtlas::clear()
+{
+	auto extent = texture->extent();
+
+	glyphs.clear();
+	rows.clear();
+	next_row    = 3;
+	used_texels = 0;
+
+	replaceTexture(createTexture(extent.x, extent.y), false);
+	generation++;
+}
+
+void GlyphAtlas::syncFrame()
+{
+	const uint64_t frame = Context::get().frame_count;
+	if (frame == current_frame) return;
+
+	current_frame = frame;
+
+	if (memory_budget != 0 && memoryUsage() > memory_budget)
+		compact(memory_budget);
+}
+
+bool GlyphAtlas::compact(size_t size_in_bytes)
+{
+	using Iterator = GlyphTable::iterator;
+
+	const uvec2  prev_extent   = texture->extent();
+	const size_t texel_size    = texture->size_in_bytes() / (static_cast<size_t>(prev_extent.x) * prev_extent.y);
+	const size_t target_texels = size_in_bytes / texel_size;
+
+	std::vector<Iterator> order;
+	order.reserve(glyphs.size());
+	for (auto it = glyphs.begin(); it != glyphs.end(); ++it)
+		order.push_back(it);
+
+	std::sort(order.begin(), order.end(), [](const Iterator& lhs, const Iterator& rhs) {
+		if (lhs->second.pinned != rhs->second.pinned)
+			return lhs->second.pinned;
+
+		return lhs->second.last_used > rhs->second.last_used;
+	});
+
+	// Keep the pinned glyphs, then the most recently used ones until three quarters
+	// of the target are filled, the rest is left as room for glyphs loaded afterwards
+	std::vector<Iterator> survivors;
+	std::vector<Iterator> evicted;
+	size_t kept_texels = 0;
+
+	for (const auto& it : order) {
+		const auto& entry = it->second;
+		const auto  area  = static_cast<size_t>(entry.rect.size.x) * entry.rect.size.y;
+
+		if (entry.pinned || kept_texels + area <= target_texels / 4 * 3) {
+			survivors.push_back(it);
+			kept_texels += area;
+		} else {
+			evicted.push_back(it);
+		}
+	}
+
+	uint32_t side = texture_min_size;
+	while (side < texture_max_size && static_cast<size_t>(side) * side / 4 * 3 < kept_texels)
+		side *= 2;
+
+	// Taller glyphs first packs the rows tighter
+	std::stable_sort(survivors.begin(), survivors.end(), [](const Iterator& lhs, const Iterator& rhs) {
+		return lhs->second.rect.size.y > rhs->second.rect.size.y;
+	});
+
+	std::vector<Row>   new_rows;
+	std::vector<irect> new_rects;
+	uint32_t           new_next_row;
+
+	for (bool packed = false; !packed;) {
+		new_rows.clear();
+		new_rects.assign(survivors.size(), irect({ 0, 0 }, { 0, 0 }));
+		new_next_row = 3;
+		packed       = true;
+
+		for (size_t i = 0; i < survivors.size() && packed; ++i) {
+			const auto& rect = survivors[i]->second.rect;
+			if (rect.size.x == 0 || rect.size.y == 0) continue;
+
+			if (!packRect(new_rows, new_next_row, uvec2(side), uvec2(rect.size), new_rects[i])) {
+				if (side < texture_max_size) {
+					side  *= 2;
+					packed = false;
+				} else {
+					new_rects[i] = irect({ 0, 0 }, { -1, -1 });
+				}
+			}
+		}
+	}
+
+	// Whatever did not fit even at the maximum size is evicted as well,
+	// unless it is pinned, then the atlas stays as it is
+	for (size_t i = survivors.size(); i-- > 0;) {
+		if (new_rects[i].size.x < 0) {
+			if (survivors[i]->second.pinned)
+				return false;
+
+			evicted.push_back(survivors[i]);
+			survivors.erase(survivors.begin() + i);
+			new_rects.erase(new_rects.begin() + i);
+		}
+	}
+
+	if (evicted.empty() && side >= prev_extent.x && side >= prev_extent.y)
+		return false;
+
+	auto new_texture = createTexture(side, side);
+
+	std::vector<vk::ImageCopy> regions;
+	regions.reserve(survivors.size());
+
+	for (size_t i = 0; i < survivors.size(); ++i) {
+		const auto& src = survivors[i]->second.rect;
+		const auto& dst = new_rects[i];
+		if (src.size.x == 0 || src.size.y == 0) continue;
+
+		vk::ImageCopy region = {};
+		region.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		region.srcOffset      = vk::Offset3D{ src.position.x, src.position.y, 0 };
+		region.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		region.dstOffset      = vk::Offset3D{ dst.position.x, dst.position.y, 0 };
+		region.extent         = vk::Extent3D{ static_cast<uint32_t>(src.size.x), static_cast<uint32_t>(src.size.y), 1 };
+
+		regions.push_back(region);
+	}
+
+	if (!regions.empty())
+		new_texture.copy(*texture, regions.data(), static_cast<uint32_t>(regions.size()));
+
+	used_texels = 0;
+	for (size_t i = 0; i < survivors.size(); ++i) {
+		auto& entry = survivors[i]->second;
+		if (entry.rect.size.x == 0 || entry.rect.size.y == 0) continue;
+
+		entry.glyph.texture_rect.position += new_rects[i].position - entry.rect.position;
+		entry.rect   = new_rects[i];
+		used_texels += static_cast<size_t>(entry.rect.size.x) * entry.rect.size.y;
+	}
+
+	for (const auto& it : evicted)
+		glyphs.erase(it);
+
+	replaceTexture(std::move(new_texture), false);
+
+	rows     = std::move(new_rows);
+	next_row = new_next_row;
+
+	generation++;
+	stats.evictions += evicted.size();
+	stats.compactions++;
+
+	return true;
+}
+
+void GlyphAtlas::replaceTexture(Texture&& new_texture, bool keep_glyphs)
+{
+	if (keep_glyphs) {
+		// Same Texture object, draw lists keep pointing at it with valid texel coordinates
+		Context::get().retire(std::make_shared<Texture>(std::move(*texture)));
+		*texture = std::move(new_texture);
+	} else {
+		// Moved glyphs get a new object, draw lists keep the previous one
+		texture = share_texture(std::move(new_texture));
+	}
+}
+
+Texture GlyphAtlas::createTexture(uint32_t width, uint32_t height, bool initialize) const
+{
+	auto& ctx             = Context::get();
+	auto& desc_set_layout = ctx.getPipeline(registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE0_UUID)).getPipelineLayout().getDescriptorSetLayout(0);
+
+	auto result = TextureCreator()
+		.setImageFormat(vk::Format::eR8G8B8A8Unorm)
+		.setImageUsage(vk::ImageUsageFlagBits::eSampled
+			| vk::ImageUsageFlagBits::eTransferDst
+			| vk::ImageUsageFlagBits::eTransferSrc)
+		.setImageExtent(width, height)
+		.setDescriptorSetLayout(desc_set_layout)
+		.create();
+
+	if (initialize) {
+		ColorImage image(Colors::Transparent, width, height);
+
+		// The top-left texels stay white so untextured quads (underlines,
+		// strike-throughs) can be drawn from the same texture as the glyphs.
+		image.at(0, 0) = Colors::White;
+		image.at(0, 1) = Colors::White;
+		image.at(1, 0) = Colors::White;
+		image.at(1, 1) = Colors::White;
+
+		result.update(image.data());
+	}
+
+	return result;
+}
+
+bool GlyphAtlas::packRect(std::vector<Row>& rows, uint32_t& next_row, uvec2 extent, uvec2 size, irect& rect)
+{
+	Row* row = nullptr;
+	float bestRatio = 0;
+	for (auto it = rows.begin(); it != rows.end() && !row; ++it)
+	{
+		const float ratio = static_cast<float>(size.y) / static_cast<float>(it->height);
+
+		// Ignore rows that are either too small or too high
+		if ((ratio < 0.7f) || (ratio > 1.f))
+			continue;
+
+		// Check if there's enough horizontal space left in the row
+		if (size.x > extent.x - it->width)
+			continue;
+
+		// Make sure that this new row is the best found so far
+		if (ratio < bestRatio)
+			continue;
+
+		// The current row passed all the tests: we can select it
+		row = &*it;
+		bestRatio = ratio;
+	}
+
+	// If we didn't find a matching row, create a new one (10% taller than the glyph)
+	if (!row) {
+		const uint32_t rowHeight = size.y + size.y / 10;
+		if ((next_row + rowHeight >= extent.y) || (size.x >= extent.x))
+			return false;
+
+		rows.emplace_back(next_row, rowHeight);
+		next_row += rowHeight;
+		row = &rows.back();
+	}
+
+	rect = irect(ivec2(row->width, row->top), ivec2(size));
+	row->width += size.x;
+
+	return true;
+}
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "../include/vkdl/core/gpu_profiler.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/drawable.h"
+#include "../include/vkdl/core/render_options.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <typeinfo>
+
+static struct DebugUtilsDispatcher {
+	void create(vk::Instance instance) {
+		vkCmdBeginDebugUtilsLabelEXT = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+		vkCmdEndDebugUtilsLabelEXT   = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+	}
+
+	static int getVkHeaderVersion() { return VK_HEADER_VERSION; }
+
+	PFN_vkCmdBeginDebugUtilsLabelEXT vkCmdBeginDebugUtilsLabelEXT = nullptr;
+	PFN_vkCmdEndDebugUtilsLabelEXT   vkCmdEndDebugUtilsLabelEXT   = nullptr;
+} debug_utils_dispatcher;
+
+// Marks scopes that got no queries, their end only closes the debug label
+#define NO_SCOPE (~0u)
+
+VKDL_BEGIN
+
+GpuProfiler::GpuProfiler(uint32_t max_scopes_per_frame, bool debug_labels) :
+	max_queries(max_scopes_per_frame * 2),
+	debug_labels(debug_labels),
+	timestamp_period(0.0),
+	timestamp_mask(0),
+	dropped(0)
+{
+	VKDL_CHECK(max_scopes_per_frame > 0);
+
+	auto& ctx = Context::get();
+
+	const auto families   = ctx.physical_device.getQueueFamilyProperties();
+	const auto valid_bits = families[ctx.graphics_queue_family_idx].timestampValidBits;
+
+	VKDL_CHECK_MSG(valid_bits > 0, "Graphics queue does not support timestamps");
+
+	timestamp_period = ctx.physical_device_props.limits.timestampPeriod;
+	timestamp_mask   = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+	if (debug_labels)
+		debug_utils_dispatcher.create(ctx.instance);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+void GpuProfiler::createFrame(GpuQueryFrame& frame) const
+{
+	vk::QueryPoolCreateInfo pool_info = {};
+	pool_info.queryType  = vk::QueryType::eTimestamp;
+	pool_info.queryCount = max_queries;
+
+	frame.pool     = Context::get().device.createQueryPool(pool_info);
+	frame.used     = 0;
+	frame.recorded = false;
+	frame.labels.clear();
+	frame.open.clear();
+}
+
+void GpuProfiler::destroyFrame(GpuQueryFrame& frame) const
+{
+	Context::get().device.destroy(std::exchange(frame.pool, nullptr));
+
+	frame.used     = 0;
+	frame.recorded = false;
+	frame.labels.clear();
+	frame.open.clear();
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer cmd, GpuQueryFrame& frame, const char* label)
+{
+	if (frame.recorded)
+		resolve(frame);
+
+	cmd.resetQueryPool(frame.pool, 0, max_queries);
+
+	frame.used     = 0;
+	frame.recorded = true;
+	frame.labels.clear();
+	frame.open.clear();
+
+	beginScope(cmd, frame, label);
+}
+
+void GpuProfiler::endFrame(vk::CommandBuffer cmd, GpuQueryFrame& frame)
+{
+	// Scopes a drawable left open end with the frame
+	while (!frame.open.empty())
+		endScope(cmd, frame);
+}
+
+void GpuProfiler::beginScope(vk::CommandBuffer cmd, GpuQueryFrame& frame, const char* label)
+{
+	if (debug_labels) {
+		vk::DebugUtilsLabelEXT label_info = {};
+		label_info.pLabelName = label;
+
+		cmd.beginDebugUtilsLabelEXT(label_info, debug_utils_dispatcher);
+	}
+
+	if (frame.used + 2 > max_queries) {
+		frame.open.push_back(NO_SCOPE);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		dropped++;
+		return;
+	}
+
+	frame.open.push_back(static_cast<uint32_t>(frame.labels.size()));
+	frame.labels.emplace_back(label);
+
+	cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.pool, frame.used);
+	frame.used += 2;
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer cmd, GpuQueryFrame& frame)
+{
+	VKDL_CHECK_MSG(!frame.open.empty(), "endScope without beginScope");
+
+	const uint32_t scope = frame.open.back();
+	frame.open.pop_back();
+
+	if (scope != NO_SCOPE)
+		cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.pool, scope * 2 + 1);
+
+	if (debug_labels)
+		cmd.endDebugUtilsLabelEXT(debug_utils_dispatcher);
+}
+
+std::vector<GpuProfileStats> GpuProfiler::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<GpuProfileStats> stats;
+	stats.reserve(histories.size());
+
+	for (const auto& [label, history] : histories) {
+		GpuProfileStats stat;
+		stat.label   = label;
+		stat.last_ms = history.last;
+		stat.calls   = history.calls;
+		stat.frames  = history.frames;
+
+		if (!history.samples.empty()) {
+			const auto [min, max] = std::minmax_element(history.samples.begin(), history.samples.end());
+
+			double sum = 0.0;
+			for (auto sample : history.samples)
+				sum += sample;
+
+			stat.avg_ms = sum / history.samples.size();
+			stat.min_ms = *min;
+			stat.max_ms = *max;
+		}
+
+		stats.push_back(std::move(stat));
+	}
+
+	// Most expensive first
+	std::sort(stats.begin(), stats.end(), [](const auto& lhs, const auto& rhs) { return lhs.avg_ms > rhs.avg_ms; });
+
+	return stats;
+}
+
+std::string GpuProfiler::report() const
+{
+	std::string report;
+
+	for (const auto& stat : getStats()) {
+		char line[256];
+		std::snprintf(line, sizeof(line), "%-32.32s %8.3f ms avg %8.3f min %8.3f max %4u calls\n",
+			stat.label.c_str(), stat.avg_ms, stat.min_ms, stat.max_ms, stat.calls);
+
+		report += line;
+	}
+
+	return report;
+}
+
+void GpuProfiler::resetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	histories.clear();
+	dropped = 0;
+}
+
+uint64_t GpuProfiler::droppedScopes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return dropped;
+}
+
+const char* GpuProfiler::drawableLabel(const Drawable& drawable, const RenderOptions& options)
+{
+	return options.label ? options.label : typeid(drawable).name();
+}
+
+void GpuProfiler::resolve(GpuQueryFrame& frame)
+{
+	frame.recorded = false;
+
+	if (frame.used == 0) return;
+
+	// Value and availability per query, without waiting, the frame's fence already signaled
+	std::vector<uint64_t> results(static_cast<size_t>(frame.used) * 2);
+
+	const auto result = Context::get().device.getQueryPoolResults(
+		frame.pool, 0, frame.used,
+		results.size() * sizeof(uint64_t), results.data(),
+		sizeof(uint64_t) * 2,
+		vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+	if (result != vk::Result::eSuccess && result != vk::Result::eNotReady) return;
+
+	std::map<std::string, std::pair<double, uint32_t>> frame_times;
+
+	for (size_t i = 0; i < frame.labels.size(); ++i) {
+		const uint64_t* begin = &results[i * 4];
+		const uint64_t* end   = &results[i * 4 + 2];
+
+		if (!begin[1] || !end[1]) continue;
+
+		const double ms = static_cast<double>((end[0] - begin[0]) & timestamp_mask) * timestamp_period / 1e6;
+
+		auto& [time, calls] = frame_times[frame.labels[i]];
+		time  += ms;
+		calls += 1;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const auto& [label, time] : frame_times) {
+		auto& history = histories[label];
+
+		if (history.samples.size() < history_size)
+			history.samples.push_back(time.first);
+		else
+			history.samples[history.next] = time.first;
+
+		history.next    = (history.next + 1) % history_size;
+		history.last    = time.first;
+		history.calls   = time.second;
+		history.frames += 1;
+	}
+}
+
+VKDL_END
\ No newline at end of file
@@ -1,28 +1,64 @@
 #include "../include/vkdl/graphics/image.h"
+#include "../include/vkdl/graphics/image_encoder.h"
+#include "image_decode.h"
 
+#include <algorithm>
+#include <cstring>
+
+// MSVC has the bounds-checked CRT functions stb_image_write uses when this is defined
+#ifdef _MSC_VER
 #define __STDC_LIB_EXT1__
+#endif
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
+// Lets a decoder hand stb the final pixel buffer (mapped staging memory). The first
+// allocation of exactly the output size on this thread is served from it.
+struct DecodeTarget
+{
+	uint8_t* data;
+	size_t   size;
+	bool     taken;
+};
+
+static thread_local DecodeTarget* decode_target = nullptr;
+
 static void* new_malloc(size_t size)
 {
+	if (decode_target && !decode_target->taken && size == decode_target->size) {
+		decode_target->taken = true;
+		return decode_target->data;
+	}
+
 	return static_cast<void*>(new uint8_t[size]);
 }
 
-static void* new_realloc(void* block, size_t size)
+static void new_free(void* block)
 {
+	if (decode_target && block == decode_target->data) {
+		decode_target->taken = false;
+		return;
+	}
+
 	delete[] static_cast<uint8_t*>(block);
-	return static_cast<void*>(new uint8_t[size]);
 }
 
-static void new_free(void* block)
+static void* new_realloc_sized(void* block, size_t old_size, size_t new_size)
 {
-	delete[] static_cast<uint8_t*>(block);
+	void* new_block = new_malloc(new_size);
+
+	if (block) {
+		memcpy(new_block, block, std::min(old_size, new_size));
+		new_free(block);
+	}
+
+	return new_block;
 }
 
-#define STBI_MALLOC(sz)       new_malloc(sz)
-#define STBI_REALLOC(p,newsz) new_realloc(p,newsz)
-#define STBI_FREE(p)          new_free(p)
+#define STBI_MALLOC(sz)                    new_malloc(sz)
+#define STBI_REALLOC_SIZED(p,oldsz,newsz) new_realloc_sized(p,oldsz,newsz)
+#define STBI_FREE(p)                       new_free(p)
 
 #include "../../thirdparty/stb/stb_image.h"
 #include "../../thirdparty/stb/stb_image_write.h"
@@ -49,6 +85,12 @@ ColorImage::ColorImage(Color* pixels, uint32_t width, uint32_t height) :
 {
 }
 
+ColorImage::ColorImage(const void* pixels, PixelLayout layout, uint32_t width, uint32_t height) :
+	Image(width, height, vk::Format::eR8G8B8A8Unorm)
+{
+	ImageKernels::convert(pixels, layout, this->pixels, PixelLayout::RGBA8, static_cast<size_t>(width) * height);
+}
+
 ColorImage::ColorImage(const char* path)
 {
 	loadFromFile(path);
@@ -68,15 +110,28 @@ bool ColorImage::loadFromFile(const char* path)
 	return true;
 }
 
+static const ImageEncoder& encoder_for(const char* path)
+{
+	static const PNGEncoder png;
+
+	const auto* encoder = ImageEncoder::fromExtension(path);
+	return encoder ? *encoder : png;
+}
+
 bool ColorImage::saveToFile(const char* path)
 {
-	return stbi_write_png(path, (int)img_w, (int)img_h, 4, pixels, 0);
+	return encoder_for(path).saveToFile(*this, path);
+}
+
+VKDL_NODISCARD std::future<bool> ColorImage::saveToFileAsync(const char* path) const
+{
+	return encoder_for(path).saveToFileAsync(*this, path);
 }
 
 ColorImage ColorImage::blit(const uvec2& offset, const uvec2& size) const
 {
-	VKDL_CHECK(offset.x + size.x < img_w);
-	VKDL_CHECK(offset.x + size.x < img_h);
+	VKDL_CHECK(offset.x + size.x <= img_w);
+	VKDL_CHECK(offset.y + size.y <= img_h);
 
 	ColorImage new_image(size.x, size.y);
 
@@ -92,13 +147,93 @@ ColorImage ColorImage::blit(const uvec2& offset, const uvec2& size) const
 
 ColorImage ColorImage::createMask(Color from, Color to) const
 {
-	ColorImage image(pixels, img_w, img_h);
+	ColorImage image(*this);
 
-	for (size_t i = 0; i < img_w * img_h; ++i)
-		if (image.data()[i] == from)
-			image.data()[i] = to;
+	ImageKernels::replaceColor(
+		reinterpret_cast<uint32_t*>(image.data()),
+		static_cast<size_t>(img_w) * img_h,
+		*reinterpret_cast<const uint32_t*>(&from),
+		*reinterpret_cast<const uint32_t*>(&to));
 
 	return image;
 }
 
+void ColorImage::convertTo(void* dst, PixelLayout layout) const
+{
+	ImageKernels::convert(pixels, PixelLayout::RGBA8, dst, layout, static_cast<size_t>(img_w) * img_h);
+}
+
+void ColorImage::premultiplyAlpha()
+{
+	ImageKernels::premultiplyAlpha(reinterpret_cast<uint8_t*>(pixels), static_cast<size_t>(img_w) * img_h);
+}
+
+void ColorImage::unpremultiplyAlpha()
+{
+	ImageKernels::unpremultiplyAlpha(reinterpret_cast<uint8_t*>(pixels), static_cast<size_t>(img_w) * img_h);
+}
+
+ColorImage ColorImage::rotate(ImageRotation rotation) const
+{
+	const bool transposed = rotation != ImageRotation::Rotate180;
+
+	ColorImage image(transposed ? img_h : img_w, transposed ? img_w : img_h);
+
+	ImageKernels::rotate(pixels, image.data(), img_w, img_h, sizeof(Color), rotation);
+
+	return image;
+}
+
+ColorImage ColorImage::resize(const uvec2& size, ResizeFilter filter) const
+{
+	ColorImage image(size.x, size.y);
+
+	ImageKernels::resize(
+		reinterpret_cast<const uint8_t*>(pixels), img_w, img_h,
+		reinterpret_cast<uint8_t*>(image.data()), size.x, size.y,
+		sizeof(Color), filter);
+
+	return image;
+}
+
+VKDL_PRIV_BEGIN
+
+VKDL_NODISCARD bool readImageInfo(const char* path, uint32_t& width, uint32_t& height)
+{
+	int w, h, comp = 0;
+
+	if (!stbi_info(path, &w, &h, &comp)) return false;
+
+	width  = static_cast<uint32_t>(w);
+	height = static_cast<uint32_t>(h);
+
+	return true;
+}
+
+VKDL_NODISCARD bool decodeImageRGBA(const char* path, uint8_t* dst, uint32_t width, uint32_t height)
+{
+	DecodeTarget target = { dst, static_cast<size_t>(width) * height * 4, false };
+
+	decode_target = &target;
+
+	int w, h, comp = 0;
+	auto* pixels = stbi_load(path, &w, &h, &comp, STBI_rgb_alpha);
+
+	decode_target = nullptr;
+
+	if (pixels == nullptr || static_cast<uint32_t>(w) != width || static_cast<uint32_t>(h) != height) {
+		if (pixels != dst) stbi_image_free(pixels);
+		return false;
+	}
+
+	// stb produced its result in a buffer of its own, e.g. after a format conversion
+	if (pixels != dst) {
+		memcpy(dst, pixels, target.size);
+		stbi_image_free(pixels);
+	}
+
+	return true;
+}
+
+VKDL_PRIV_END
 VKDL_END
\ No newline at end of file
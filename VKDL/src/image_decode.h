@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../include/vkdl/core/config.h"
+
+#include <cstdint>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// Reads the image dimensions from the file header without decoding
+VKDL_NODISCARD bool readImageInfo(const char* path, uint32_t& width, uint32_t& height);
+
+// Decodes PNG, JPEG and the other stb formats to RGBA8 into `dst` (width * height * 4 bytes).
+// stb writes its output straight into `dst` whenever no format conversion follows the decode.
+VKDL_NODISCARD bool decodeImageRGBA(const char* path, uint8_t* dst, uint32_t width, uint32_t height);
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "../include/vkdl/graphics/image_decoder.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/upload_service.h"
+#include "image_decode.h"
+
+#include <stdexcept>
+
+VKDL_BEGIN
+
+ImageDecoder::ImageDecoder(size_t max_in_flight) :
+	state(std::make_shared<State>())
+{
+	VKDL_CHECK(max_in_flight > 0);
+
+	state->max_in_flight = max_in_flight;
+}
+
+ImageDecoder::~ImageDecoder()
+{
+	std::unique_lock<std::mutex> lock(state->mutex);
+
+	// Decodes already running finish and complete their futures, queued ones are dropped
+	state->closed = true;
+
+	for (auto& request : state->queued)
+		request.promise->set_exception(std::make_exception_ptr(std::runtime_error("ImageDecoder destroyed before the load started")));
+
+	state->queued.clear();
+
+	// The pool outlives the decoder, so the decodes it still runs are waited for here
+	state->decoded.wait(lock, [this]() { return state->decoding == 0; });
+}
+
+VKDL_NODISCARD std::future<Texture> ImageDecoder::loadTexture(const char* path, TextureCreator creator)
+{
+	Request request = { path, std::move(creator), std::make_shared<std::promise<Texture>>() };
+
+	auto future = request.promise->get_future();
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+
+	state->queued.push_back(std::move(request));
+	dispatch(state);
+
+	return future;
+}
+
+void ImageDecoder::setMaxInFlight(size_t count)
+{
+	VKDL_CHECK(count > 0);
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+
+	state->max_in_flight = count;
+	dispatch(state);
+}
+
+VKDL_NODISCARD size_t ImageDecoder::getMaxInFlight() const
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->max_in_flight;
+}
+
+VKDL_NODISCARD size_t ImageDecoder::queuedCount() const
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->queued.size();
+}
+
+// Expects state->mutex to be held
+void ImageDecoder::dispatch(const std::shared_ptr<State>& state)
+{
+	while (!state->closed && state->in_flight < state->max_in_flight && !state->queued.empty()) {
+		auto request = std::move(state->queued.front());
+		state->queued.pop_front();
+		state->in_flight++;
+		state->decoding++;
+
+		(void)ThreadPool::shared().submit([state, request]() mutable {
+			decode(state, request);
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (--state->decoding == 0)
+				state->decoded.notify_all();
+		});
+	}
+}
+
+void ImageDecoder::decode(const std::shared_ptr<State>& state, Request& request)
+{
+	auto& upload_service = *Context::get().upload_service;
+
+	UploadService::Staging staging = {};
+
+	try {
+		uint32_t width  = 0;
+		uint32_t height = 0;
+
+		if (!VKDL_PRIV_NAMESPACE_NAME::readImageInfo(request.path.c_str(), width, height))
+			VKDL_ERROR("Failed to read image header");
+
+		staging = upload_service.allocateStaging(static_cast<vk::DeviceSize>(width) * height * 4);
+
+		if (!VKDL_PRIV_NAMESPACE_NAME::decodeImageRGBA(request.path.c_str(), staging.mapped, width, height))
+			VKDL_ERROR("Failed to decode image");
+
+		auto texture = std::make_shared<Texture>(request.creator
+			.setImageFormat(vk::Format::eR8G8B8A8Unorm)
+			.setImageExtent(width, height)
+			.setImageUsage(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst)
+			.create());
+
+		auto promise = request.promise;
+
+		// The texture is only handed out once the GPU copy is done, so it can be drawn right away
+		upload_service.uploadTexture(*texture, std::move(staging), ivec2(0, 0), uvec2(width, height), [state, texture, promise]() {
+			promise->set_value(std::move(*texture));
+			release(state);
+		});
+	} catch (...) {
+		if (staging.buffer)
+			upload_service.releaseStaging(staging);
+
+		request.promise->set_exception(std::current_exception());
+		release(state);
+	}
+}
+
+void ImageDecoder::release(const std::shared_ptr<State>& state)
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+
+	state->in_flight--;
+	dispatch(state);
+}
+
+VKDL_END
\ No newline at end of file
@@ -0,0 +1,854 @@
+#include "../include/vkdl/graphics/image_encoder.h"
+#include "../include/vkdl/util/thread_pool.h"
+#include "../include/vkdl/core/exception.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <queue>
+
+#define PNG_STRIP_MIN_BYTES   (64 * 1024)
+#define DEFLATE_WINDOW_SIZE   32768
+#define DEFLATE_MIN_MATCH     3
+#define DEFLATE_MAX_MATCH     258
+#define DEFLATE_HASH_BITS     15
+#define DEFLATE_BLOCK_SYMBOLS 32768
+#define DEFLATE_MAX_STORED    65535
+
+
+static void write_u32_be(uint8_t* dst, uint32_t value)
+{
+	dst[0] = static_cast<uint8_t>(value >> 24);
+	dst[1] = static_cast<uint8_t>(value >> 16);
+	dst[2] = static_cast<uint8_t>(value >> 8);
+	dst[3] = static_cast<uint8_t>(value);
+}
+
+static void append_u32_be(std::vector<uint8_t>& output, uint32_t value)
+{
+	output.resize(output.size() + 4);
+	write_u32_be(output.data() + output.size() - 4, value);
+}
+
+/* Checksums */
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+	static const auto table = []() {
+		std::array<uint32_t, 256> table = {};
+
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+
+		return table;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static uint32_t adler32(const uint8_t* data, size_t size)
+{
+	uint32_t a = 1;
+	uint32_t b = 0;
+
+	// 5552 bytes is the most that can be summed before b overflows
+	while (size) {
+		const size_t n = std::min<size_t>(size, 5552);
+
+		for (size_t i = 0; i < n; i++) {
+			a += data[i];
+			b += a;
+		}
+
+		a %= 65521;
+		b %= 65521;
+
+		data += n;
+		size -= n;
+	}
+
+	return (b << 16) | a;
+}
+
+// Checksum of two concatenated buffers from the checksums of each, as zlib does
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2)
+{
+	const uint32_t base = 65521;
+	const uint32_t rem  = static_cast<uint32_t>(size2 % base);
+
+	uint32_t sum1 = adler1 & 0xffff;
+	uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % base);
+
+	sum1 += (adler2 & 0xffff) + base - 1;
+	sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+
+	if (sum1 >= base) sum1 -= base;
+	if (sum1 >= base) sum1 -= base;
+	if (sum2 >= (base << 1)) sum2 -= (base << 1);
+	if (sum2 >= base) sum2 -= base;
+
+	return (sum2 << 16) | sum1;
+}
+
+/* Deflate */
+
+static const uint16_t length_base[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t  length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t dist_base[30]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t  dist_extra[30]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static const uint8_t code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+struct BitWriter
+{
+	std::vector<uint8_t>& output;
+	uint64_t              bits  = 0;
+	uint32_t              count = 0;
+
+	void write(uint32_t value, uint32_t bit_count)
+	{
+		bits  |= static_cast<uint64_t>(value) << count;
+		count += bit_count;
+
+		while (count >= 8) {
+			output.push_back(static_cast<uint8_t>(bits));
+			bits  >>= 8;
+			count -= 8;
+		}
+	}
+
+	void align()
+	{
+		if (count) write(0, 8 - count);
+	}
+};
+
+// A literal when distance is 0, otherwise a match
+struct Symbol
+{
+	uint16_t value;
+	uint16_t distance;
+};
+
+static uint32_t length_code(uint32_t length)
+{
+	return static_cast<uint32_t>(std::upper_bound(length_base, length_base + 29, length) - length_base) - 1;
+}
+
+static uint32_t distance_code(uint32_t distance)
+{
+	return static_cast<uint32_t>(std::upper_bound(dist_base, dist_base + 30, distance) - dist_base) - 1;
+}
+
+// Huffman code lengths no longer than `max_length`. At least two symbols always
+// get a code, a complete code is accepted by every inflater.
+static void build_lengths(const uint32_t* freqs, uint32_t count, uint32_t max_length, uint8_t* lengths)
+{
+	std::fill_n(lengths, count, uint8_t(0));
+
+	std::vector<uint32_t> used;
+	for (uint32_t i = 0; i < count; i++)
+		if (freqs[i]) used.push_back(i);
+
+	for (uint32_t i = 0; used.size() < 2; i++)
+		if (!freqs[i]) used.push_back(i);
+
+	struct Node
+	{
+		uint64_t freq;
+		int32_t  parent;
+	};
+
+	std::vector<Node> nodes;
+	for (uint32_t symbol : used)
+		nodes.push_back({ std::max<uint64_t>(freqs[symbol], 1), -1 });
+
+	using Entry = std::pair<uint64_t, int32_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+	for (int32_t i = 0; i < static_cast<int32_t>(nodes.size()); i++)
+		queue.push({ nodes[i].freq, i });
+
+	while (queue.size() > 1) {
+		const auto a = queue.top(); queue.pop();
+		const auto b = queue.top(); queue.pop();
+
+		const auto parent = static_cast<int32_t>(nodes.size());
+		nodes.push_back({ a.first + b.first, -1 });
+		nodes[a.second].parent = parent;
+		nodes[b.second].parent = parent;
+
+		queue.push({ a.first + b.first, parent });
+	}
+
+	// Count the depths, clamped to the limit, then give up leaves at the limit
+	// until the Kraft sum is back to exactly one
+	std::vector<uint32_t> length_counts(max_length + 1, 0);
+
+	for (size_t i = 0; i < used.size(); i++) {
+		uint32_t depth = 0;
+		for (int32_t node = static_cast<int32_t>(i); nodes[node].parent >= 0; node = nodes[node].parent)
+			depth++;
+
+		length_counts[std::min(depth, max_length)]++;
+	}
+
+	uint64_t total = 0;
+	for (uint32_t len = 1; len <= max_length; len++)
+		total += static_cast<uint64_t>(length_counts[len]) << (max_length - len);
+
+	while (total != (uint64_t(1) << max_length)) {
+		length_counts[max_length]--;
+
+		for (uint32_t len = max_length - 1; len > 0; len--) {
+			if (length_counts[len]) {
+				length_counts[len]--;
+				length_counts[len + 1] += 2;
+				break;
+			}
+		}
+
+		total--;
+	}
+
+	// Most frequent symbols take the shortest codes
+	std::stable_sort(used.begin(), used.end(), [&](uint32_t a, uint32_t b) { return freqs[a] > freqs[b]; });
+
+	size_t next = 0;
+	for (uint32_t len = 1; len <= max_length; len++)
+		for (uint32_t i = 0; i < length_counts[len]; i++)
+			lengths[used[next++]] = static_cast<uint8_t>(len);
+}
+
+// Canonical codes, bit reversed since deflate writes them starting at the top bit
+static void build_codes(const uint8_t* lengths, uint32_t count, uint16_t* codes)
+{
+	uint32_t length_counts[16] = {};
+	uint32_t next_code[16]     = {};
+
+	for (uint32_t i = 0; i < count; i++)
+		length_counts[lengths[i]]++;
+	length_counts[0] = 0;
+
+	uint32_t code = 0;
+	for (uint32_t bits = 1; bits < 16; bits++) {
+		code = (code + length_counts[bits - 1]) << 1;
+		next_code[bits] = code;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		const uint32_t len = lengths[i];
+		if (!len) continue;
+
+		uint32_t value    = next_code[len]++;
+		uint32_t reversed = 0;
+
+		for (uint32_t bit = 0; bit < len; bit++, value >>= 1)
+			reversed = (reversed << 1) | (value & 1);
+
+		codes[i] = static_cast<uint16_t>(reversed);
+	}
+}
+
+static void write_stored_blocks(BitWriter& writer, const uint8_t* data, size_t size, bool final)
+{
+	do {
+		const size_t chunk = std::min<size_t>(size, DEFLATE_MAX_STORED);
+
+		writer.write(final && chunk == size ? 1 : 0, 1);
+		writer.write(0, 2);
+		writer.align();
+
+		writer.output.push_back(static_cast<uint8_t>(chunk));
+		writer.output.push_back(static_cast<uint8_t>(chunk >> 8));
+		writer.output.push_back(static_cast<uint8_t>(~chunk));
+		writer.output.push_back(static_cast<uint8_t>(~chunk >> 8));
+		writer.output.insert(writer.output.end(), data, data + chunk);
+
+		data += chunk;
+		size -= chunk;
+	} while (size);
+}
+
+// Writes the symbols as one dynamic Huffman block, or as stored blocks when
+// the input does not compress
+static void write_block(BitWriter& writer, const std::vector<Symbol>& symbols, const uint8_t* raw, size_t raw_size, bool final)
+{
+	uint32_t lit_freqs[286]  = {};
+	uint32_t dist_freqs[30]  = {};
+
+	for (const auto& symbol : symbols) {
+		if (symbol.distance) {
+			lit_freqs[257 + length_code(symbol.value)]++;
+			dist_freqs[distance_code(symbol.distance)]++;
+		} else {
+			lit_freqs[symbol.value]++;
+		}
+	}
+	lit_freqs[256] = 1;
+
+	uint8_t  lit_lengths[286];
+	uint8_t  dist_lengths[30];
+	uint16_t lit_codes[286]  = {};
+	uint16_t dist_codes[30]  = {};
+
+	build_lengths(lit_freqs, 286, 15, lit_lengths);
+	build_lengths(dist_freqs, 30, 15, dist_lengths);
+	build_codes(lit_lengths, 286, lit_codes);
+	build_codes(dist_lengths, 30, dist_codes);
+
+	uint32_t lit_count  = 286;
+	uint32_t dist_count = 30;
+	while (lit_count > 257 && !lit_lengths[lit_count - 1]) lit_count--;
+	while (dist_count > 1 && !dist_lengths[dist_count - 1]) dist_count--;
+
+	// Run length encode both length tables as one sequence
+	std::vector<uint8_t> all_lengths(lit_lengths, lit_lengths + lit_count);
+	all_lengths.insert(all_lengths.end(), dist_lengths, dist_lengths + dist_count);
+
+	std::vector<std::pair<uint8_t, uint8_t>> runs; // Code length symbol, extra bits value
+	uint32_t cl_freqs[19] = {};
+
+	for (size_t i = 0; i < all_lengths.size();) {
+		const uint8_t len = all_lengths[i];
+
+		size_t run = 1;
+		while (i + run < all_lengths.size() && all_lengths[i + run] == len) run++;
+
+		i += run;
+
+		if (len == 0) {
+			while (run >= 11) {
+				const size_t count = std::min<size_t>(run, 138);
+				runs.push_back({ 18, static_cast<uint8_t>(count - 11) });
+				run -= count;
+			}
+			if (run >= 3) {
+				runs.push_back({ 17, static_cast<uint8_t>(run - 3) });
+				run = 0;
+			}
+		} else {
+			runs.push_back({ len, 0 });
+			run--;
+
+			while (run >= 3) {
+				const size_t count = std::min<size_t>(run, 6);
+				runs.push_back({ 16, static_cast<uint8_t>(count - 3) });
+				run -= count;
+			}
+		}
+
+		for (; run; run--)
+			runs.push_back({ len, 0 });
+	}
+
+	for (const auto& run : runs)
+		cl_freqs[run.first]++;
+
+	uint8_t  cl_lengths[19];
+	uint16_t cl_codes[19] = {};
+
+	build_lengths(cl_freqs, 19, 7, cl_lengths);
+	build_codes(cl_lengths, 19, cl_codes);
+
+	uint32_t cl_count = 19;
+	while (cl_count > 4 && !cl_lengths[code_length_order[cl_count - 1]]) cl_count--;
+
+	// Compare sizes in bits before committing to the Huffman block
+	static const uint8_t cl_extra[19] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7 };
+
+	size_t dynamic_bits = 3 + 14 + 3 * cl_count + lit_lengths[256];
+	for (const auto& run : runs)
+		dynamic_bits += cl_lengths[run.first] + cl_extra[run.first];
+
+	for (uint32_t i = 0; i < 286; i++)
+		dynamic_bits += static_cast<size_t>(lit_freqs[i]) * (lit_lengths[i] + (i > 256 ? length_extra[i - 257] : 0));
+	for (uint32_t i = 0; i < 30; i++)
+		dynamic_bits += static_cast<size_t>(dist_freqs[i]) * (dist_lengths[i] + dist_extra[i]);
+	dynamic_bits -= lit_lengths[256]; // Counted once through lit_freqs
+
+	const size_t stored_blocks = std::max<size_t>((raw_size + DEFLATE_MAX_STORED - 1) / DEFLATE_MAX_STORED, 1);
+	const size_t stored_bits   = stored_blocks * (3 + 7 + 32) + raw_size * 8;
+
+	if (stored_bits <= dynamic_bits) {
+		write_stored_blocks(writer, raw, raw_size, final);
+		return;
+	}
+
+	writer.write(final ? 1 : 0, 1);
+	writer.write(2, 2);
+	writer.write(lit_count - 257, 5);
+	writer.write(dist_count - 1, 5);
+	writer.write(cl_count - 4, 4);
+
+	for (uint32_t i = 0; i < cl_count; i++)
+		writer.write(cl_lengths[code_length_order[i]], 3);
+
+	for (const auto& run : runs) {
+		writer.write(cl_codes[run.first], cl_lengths[run.first]);
+		if (cl_extra[run.first]) writer.write(run.second, cl_extra[run.first]);
+	}
+
+	for (const auto& symbol : symbols) {
+		if (!symbol.distance) {
+			writer.write(lit_codes[symbol.value], lit_lengths[symbol.value]);
+			continue;
+		}
+
+		const uint32_t lcode = length_code(symbol.value);
+		const uint32_t dcode = distance_code(symbol.distance);
+
+		writer.write(lit_codes[257 + lcode], lit_lengths[257 + lcode]);
+		writer.write(symbol.value - length_base[lcode], length_extra[lcode]);
+		writer.write(dist_codes[dcode], dist_lengths[dcode]);
+		writer.write(symbol.distance - dist_base[dcode], dist_extra[dcode]);
+	}
+
+	writer.write(lit_codes[256], lit_lengths[256]);
+}
+
+static uint32_t hash3(const uint8_t* data)
+{
+	return ((data[0] << 10) ^ (data[1] << 5) ^ data[2]) & ((1u << DEFLATE_HASH_BITS) - 1);
+}
+
+// Compresses one strip into deflate blocks. Every strip but the last ends with an
+// empty stored block, which byte aligns it so the next strip can follow directly.
+static void deflate_strip(const uint8_t* data, size_t size, int level, bool final, std::vector<uint8_t>& output)
+{
+	static const uint32_t max_chain[10]   = { 0, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+	static const uint32_t nice_length[10] = { 0, 16, 32, 32, 64, 128, 128, 258, 258, 258 };
+
+	BitWriter writer = { output };
+
+	if (level == 0) {
+		write_stored_blocks(writer, data, size, final);
+	} else {
+		std::vector<int32_t> head(size_t(1) << DEFLATE_HASH_BITS, -1);
+		std::vector<int32_t> prev(DEFLATE_WINDOW_SIZE, -1);
+
+		std::vector<Symbol> symbols;
+		symbols.reserve(DEFLATE_BLOCK_SYMBOLS);
+
+		const auto insert = [&](size_t pos) {
+			const uint32_t hash = hash3(data + pos);
+			prev[pos & (DEFLATE_WINDOW_SIZE - 1)] = head[hash];
+			head[hash] = static_cast<int32_t>(pos);
+		};
+
+		size_t block_start = 0;
+		size_t pos         = 0;
+
+		while (pos < size) {
+			const size_t max_length = std::min<size_t>(size - pos, DEFLATE_MAX_MATCH);
+
+			size_t best_length   = 0;
+			size_t best_distance = 0;
+
+			if (max_length >= DEFLATE_MIN_MATCH) {
+				int32_t  candidate = head[hash3(data + pos)];
+				uint32_t chain     = max_chain[level];
+
+				while (candidate >= 0 && chain--) {
+					const size_t distance = pos - candidate;
+					if (distance > DEFLATE_WINDOW_SIZE) break;
+
+					const uint8_t* a = data + candidate;
+					const uint8_t* b = data + pos;
+
+					if (a[best_length] == b[best_length]) {
+						size_t length = 0;
+						while (length < max_length && a[length] == b[length]) length++;
+
+						if (length > best_length) {
+							best_length   = length;
+							best_distance = distance;
+							if (length >= nice_length[level] || length == max_length) break;
+						}
+					}
+
+					// A slot overwritten by a newer position ends the chain
+					const int32_t next = prev[candidate & (DEFLATE_WINDOW_SIZE - 1)];
+					if (next >= candidate) break;
+					candidate = next;
+				}
+
+				insert(pos);
+			}
+
+			if (best_length >= DEFLATE_MIN_MATCH) {
+				symbols.push_back({ static_cast<uint16_t>(best_length), static_cast<uint16_t>(best_distance) });
+
+				// The fast levels skip indexing the inside of matches
+				const size_t end = pos + best_length;
+				if (level >= 4)
+					for (size_t i = pos + 1; i < end && i + DEFLATE_MIN_MATCH <= size; i++)
+						insert(i);
+
+				pos = end;
+			} else {
+				symbols.push_back({ data[pos], 0 });
+				pos++;
+			}
+
+			if (symbols.size() >= DEFLATE_BLOCK_SYMBOLS) {
+				write_block(writer, symbols, data + block_start, pos - block_start, final && pos == size);
+				symbols.clear();
+				block_start = pos;
+			}
+		}
+
+		// A full block flushed at the very end was already written as the last one
+		if (!symbols.empty() || block_start == 0)
+			write_block(writer, symbols, data + block_start, pos - block_start, final);
+	}
+
+	if (!final)
+		write_stored_blocks(writer, data + size, 0, false);
+
+	writer.align();
+}
+
+/* PNG */
+
+static uint8_t paeth(int32_t a, int32_t b, int32_t c)
+{
+	const int32_t p  = a + b - c;
+	const int32_t pa = std::abs(p - a);
+	const int32_t pb = std::abs(p - b);
+	const int32_t pc = std::abs(p - c);
+
+	if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+	if (pb <= pc)             return static_cast<uint8_t>(b);
+	return static_cast<uint8_t>(c);
+}
+
+// Tries all five PNG filters on a row and keeps the one with the smallest sum of
+// absolute values, the usual predictor of how well a row deflates
+static void filter_row(const uint8_t* row, const uint8_t* prev_row, size_t size, uint8_t* dst, std::vector<uint8_t>& scratch)
+{
+	const size_t bpp = 4;
+
+	scratch.resize(size * 5);
+
+	for (size_t i = 0; i < size; i++) {
+		const uint8_t a = i >= bpp ? row[i - bpp] : 0;
+		const uint8_t b = prev_row ? prev_row[i] : 0;
+		const uint8_t c = i >= bpp && prev_row ? prev_row[i - bpp] : 0;
+
+		scratch[i]            = row[i];
+		scratch[size + i]     = static_cast<uint8_t>(row[i] - a);
+		scratch[size * 2 + i] = static_cast<uint8_t>(row[i] - b);
+		scratch[size * 3 + i] = static_cast<uint8_t>(row[i] - ((a + b) >> 1));
+		scratch[size * 4 + i] = static_cast<uint8_t>(row[i] - paeth(a, b, c));
+	}
+
+	size_t   best_filter = 0;
+	uint64_t best_cost   = UINT64_MAX;
+
+	for (size_t filter = 0; filter < 5; filter++) {
+		const uint8_t* filtered = scratch.data() + size * filter;
+
+		uint64_t cost = 0;
+		for (size_t i = 0; i < size; i++)
+			cost += static_cast<uint64_t>(std::abs(static_cast<int8_t>(filtered[i])));
+
+		if (cost < best_cost) {
+			best_cost   = cost;
+			best_filter = filter;
+		}
+	}
+
+	dst[0] = static_cast<uint8_t>(best_filter);
+	std::memcpy(dst + 1, scratch.data() + size * best_filter, size);
+}
+
+static void append_chunk(std::vector<uint8_t>& output, const char* type, const uint8_t* data, size_t size)
+{
+	append_u32_be(output, static_cast<uint32_t>(size));
+
+	const size_t start = output.size();
+	output.insert(output.end(), type, type + 4);
+	output.insert(output.end(), data, data + size);
+
+	append_u32_be(output, crc32(0, output.data() + start, size + 4));
+}
+
+struct PNGStrip
+{
+	std::vector<uint8_t> chunk;
+	uint32_t             adler;
+	size_t               size;
+};
+
+VKDL_BEGIN
+
+bool ImageEncoder::saveToFile(const ColorImage& image, const char* path) const
+{
+	const auto output = encode(image);
+
+	FILE* file = std::fopen(path, "wb");
+	if (!file)
+		return false;
+
+	const bool written = std::fwrite(output.data(), 1, output.size(), file) == output.size();
+	std::fclose(file);
+
+	return written;
+}
+
+VKDL_NODISCARD std::future<bool> ImageEncoder::saveToFileAsync(ColorImage image, std::string path) const
+{
+	// The save task waits on its strips through ThreadPool::wait, so it can run on the pool it fans out to
+	return ThreadPool::shared().submit([this, image = std::move(image), path = std::move(path)]() {
+		return saveToFile(image, path.c_str());
+	});
+}
+
+VKDL_NODISCARD const ImageEncoder* ImageEncoder::fromExtension(const char* path)
+{
+	static const PNGEncoder png;
+	static const QOIEncoder qoi;
+	static const PPMEncoder ppm;
+
+	auto extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == ".png") return &png;
+	if (extension == ".qoi") return &qoi;
+	if (extension == ".ppm") return &ppm;
+
+	return nullptr;
+}
+
+PNGEncoder::PNGEncoder(int compression_level) :
+	compression_level(),
+	strip_rows(0)
+{
+	setCompressionLevel(compression_level);
+}
+
+VKDL_NODISCARD std::vector<uint8_t> PNGEncoder::encode(const ColorImage& image) const
+{
+	VKDL_CHECK(!image.empty());
+
+	const uint32_t width     = image.width();
+	const uint32_t height    = image.height();
+	const size_t   row_size  = static_cast<size_t>(width) * 4;
+	const auto*    pixels    = reinterpret_cast<const uint8_t*>(image.data());
+
+	uint32_t rows = strip_rows;
+	if (rows == 0) {
+		// About two strips per thread, but not so small that the per strip
+		// dictionary reset hurts the ratio
+		const size_t min_rows    = (PNG_STRIP_MIN_BYTES + row_size) / (row_size + 1);
+		const size_t threads     = ThreadPool::shared().threadCount();
+		const size_t thread_rows = (height + threads * 2 - 1) / (threads * 2);
+
+		rows = static_cast<uint32_t>(std::max(min_rows, thread_rows));
+	}
+
+	const uint32_t strip_count = (height + rows - 1) / rows;
+
+	// zlib header, FLEVEL only advertises the effort
+	static const uint8_t zlib_flags[10] = { 0x01, 0x01, 0x5e, 0x5e, 0x5e, 0x5e, 0x9c, 0xda, 0xda, 0xda };
+
+	const int level = compression_level;
+
+	const auto encode_strip = [=](uint32_t strip) {
+		const uint32_t first = strip * rows;
+		const uint32_t last  = std::min(first + rows, height);
+
+		std::vector<uint8_t> filtered((last - first) * (row_size + 1));
+		std::vector<uint8_t> scratch;
+
+		for (uint32_t y = first; y < last; y++) {
+			const uint8_t* row      = pixels + y * row_size;
+			const uint8_t* prev_row = y ? row - row_size : nullptr;
+			uint8_t*       dst      = filtered.data() + (y - first) * (row_size + 1);
+
+			if (level == 0) {
+				dst[0] = 0;
+				std::memcpy(dst + 1, row, row_size);
+			} else {
+				filter_row(row, prev_row, row_size, dst, scratch);
+			}
+		}
+
+		PNGStrip result;
+		result.adler = adler32(filtered.data(), filtered.size());
+		result.size  = filtered.size();
+
+		// Length and type are filled in once the size is known
+		result.chunk = { 0, 0, 0, 0, 'I', 'D', 'A', 'T' };
+		if (strip == 0) {
+			result.chunk.push_back(0x78);
+			result.chunk.push_back(zlib_flags[level]);
+		}
+
+		deflate_strip(filtered.data(), filtered.size(), level, strip + 1 == strip_count, result.chunk);
+
+		const size_t data_size = result.chunk.size() - 8;
+		write_u32_be(result.chunk.data(), static_cast<uint32_t>(data_size));
+		append_u32_be(result.chunk, crc32(0, result.chunk.data() + 4, data_size + 4));
+
+		return result;
+	};
+
+	std::vector<std::future<PNGStrip>> futures;
+	for (uint32_t strip = 1; strip < strip_count; strip++)
+		futures.push_back(ThreadPool::shared().submit([&encode_strip, strip]() { return encode_strip(strip); }));
+
+	std::vector<PNGStrip> strips;
+	strips.push_back(encode_strip(0));
+	for (auto& future : futures)
+		strips.push_back(ThreadPool::shared().wait(future));
+
+	std::vector<uint8_t> output = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	uint8_t header[13];
+	write_u32_be(header, width);
+	write_u32_be(header + 4, height);
+	header[8]  = 8; // Bit depth
+	header[9]  = 6; // RGBA
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	append_chunk(output, "IHDR", header, sizeof(header));
+
+	size_t total_size = output.size() + 12 + 4 + 12;
+	for (const auto& strip : strips)
+		total_size += strip.chunk.size();
+	output.reserve(total_size);
+
+	uint32_t adler = strips[0].adler;
+	for (size_t i = 0; i < strips.size(); i++) {
+		if (i) adler = adler32_combine(adler, strips[i].adler, strips[i].size);
+		output.insert(output.end(), strips[i].chunk.begin(), strips[i].chunk.end());
+	}
+
+	// The zlib trailer goes in a chunk of its own, it needs every strip's checksum
+	uint8_t trailer[4];
+	write_u32_be(trailer, adler);
+	append_chunk(output, "IDAT", trailer, sizeof(trailer));
+	append_chunk(output, "IEND", nullptr, 0);
+
+	return output;
+}
+
+void PNGEncoder::setCompressionLevel(int level)
+{
+	VKDL_CHECK_MSG(level >= 0 && level <= 9, "PNG compression level must be between 0 and 9");
+	compression_level = level;
+}
+
+VKDL_NODISCARD int PNGEncoder::getCompressionLevel() const
+{
+	return compression_level;
+}
+
+void PNGEncoder::setStripRows(uint32_t rows)
+{
+	strip_rows = rows;
+}
+
+VKDL_NODISCARD uint32_t PNGEncoder::getStripRows() const
+{
+	return strip_rows;
+}
+
+VKDL_NODISCARD std::vector<uint8_t> QOIEncoder::encode(const ColorImage& image) const
+{
+	VKDL_CHECK(!image.empty());
+
+	const size_t pixel_count = static_cast<size_t>(image.width()) * image.height();
+	const Color* pixels      = image.data();
+
+	std::vector<uint8_t> output = { 'q', 'o', 'i', 'f', 0, 0, 0, 0, 0, 0, 0, 0, 4, 0 };
+	write_u32_be(output.data() + 4, image.width());
+	write_u32_be(output.data() + 8, image.height());
+
+	// Worst case is a 5 byte op per pixel
+	output.reserve(output.size() + pixel_count * 5 + 8);
+
+	Color    index[64] = {};
+	Color    prev      = Color(0, 0, 0, 255);
+	uint32_t run       = 0;
+
+	for (size_t i = 0; i < pixel_count; i++) {
+		const Color px = pixels[i];
+
+		if (px == prev) {
+			if (++run == 62 || i + 1 == pixel_count) {
+				output.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run) {
+			output.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+			run = 0;
+		}
+
+		const uint32_t hash = (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+
+		if (index[hash] == px) {
+			output.push_back(static_cast<uint8_t>(hash));
+		} else if (px.a == prev.a) {
+			index[hash] = px;
+
+			const int32_t vr   = static_cast<int8_t>(px.r - prev.r);
+			const int32_t vg   = static_cast<int8_t>(px.g - prev.g);
+			const int32_t vb   = static_cast<int8_t>(px.b - prev.b);
+			const int32_t vg_r = vr - vg;
+			const int32_t vg_b = vb - vg;
+
+			if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+				output.push_back(static_cast<uint8_t>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+			} else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+				output.push_back(static_cast<uint8_t>(0x80 | (vg + 32)));
+				output.push_back(static_cast<uint8_t>((vg_r + 8) << 4 | (vg_b + 8)));
+			} else {
+				output.insert(output.end(), { 0xfe, px.r, px.g, px.b });
+			}
+		} else {
+			index[hash] = px;
+			output.insert(output.end(), { 0xff, px.r, px.g, px.b, px.a });
+		}
+
+		prev = px;
+	}
+
+	output.insert(output.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+
+	return output;
+}
+
+VKDL_NODISCARD std::vector<uint8_t> PPMEncoder::encode(const ColorImage& image) const
+{
+	VKDL_CHECK(!image.empty());
+
+	const std::string header = "P6\n" + std::to_string(image.width()) + " " + std::to_string(image.height()) + "\n255\n";
+	const size_t pixel_count = static_cast<size_t>(image.width()) * image.height();
+
+	std::vector<uint8_t> output(header.size() + pixel_count * 3);
+	std::memcpy(output.data(), header.data(), header.size());
+
+	ImageKernels::convert(image.data(), PixelLayout::RGBA8, output.data() + header.size(), PixelLayout::RGB8, pixel_count);
+
+	return output;
+}
+
+VKDL_END
\ No newline at end of file
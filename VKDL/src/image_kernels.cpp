@@ -0,0 +1,755 @@
+#include "../include/vkdl/graphics/image_kernels.h"
+#include "../include/vkdl/util/thread_pool.h"
+#include "../include/vkdl/core/exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#  define KERNELS_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#  define KERNELS_NEON
+#  include <arm_neon.h>
+#endif
+
+// GCC and clang only emit AVX2/SSSE3 instructions inside functions marked for them
+#if defined(__GNUC__) || defined(__clang__)
+#  define TARGET_AVX2  __attribute__((target("avx2")))
+#  define TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#  define TARGET_AVX2
+#  define TARGET_SSSE3
+#endif
+
+// Below this many bytes the thread pool costs more than it saves
+#define PARALLEL_MIN_BYTES (256 * 1024)
+#define ROTATE_TILE_SIZE   32
+
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	SSSE3,
+	AVX2,
+	NEON
+};
+
+static SimdLevel detect_simd_level()
+{
+#if defined(KERNELS_X86)
+#  ifdef _MSC_VER
+	int info[4] = {};
+
+	__cpuid(info, 1);
+	const bool sse2    = (info[3] & (1 << 26)) != 0;
+	const bool ssse3   = (info[2] & (1 << 9)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+	// AVX2 also needs the OS to save the upper halves of the ymm registers
+	bool avx2 = false;
+	if (osxsave && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#  else
+	__builtin_cpu_init();
+	const bool sse2  = __builtin_cpu_supports("sse2");
+	const bool ssse3 = __builtin_cpu_supports("ssse3");
+	const bool avx2  = __builtin_cpu_supports("avx2");
+#  endif
+
+	if (avx2)  return SimdLevel::AVX2;
+	if (ssse3) return SimdLevel::SSSE3;
+	if (sse2)  return SimdLevel::SSE2;
+	return SimdLevel::Scalar;
+#elif defined(KERNELS_NEON)
+	return SimdLevel::NEON;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+static const SimdLevel  detected_level = detect_simd_level();
+static std::atomic_bool simd_enabled   = true;
+
+static SimdLevel simd_level()
+{
+	return simd_enabled ? detected_level : SimdLevel::Scalar;
+}
+
+// Runs fn(begin, end) over row bands on the shared pool
+template <class Func>
+static void parallel_rows(size_t rows, size_t bytes_per_row, Func&& fn)
+{
+	auto& pool = VKDL_NAMESPACE_NAME::ThreadPool::shared();
+
+	const size_t bands = std::min({ rows, pool.threadCount(), rows * bytes_per_row / PARALLEL_MIN_BYTES });
+
+	if (bands <= 1) {
+		fn(size_t(0), rows);
+		return;
+	}
+
+	std::vector<std::future<void>> futures;
+
+	const size_t band_rows = (rows + bands - 1) / bands;
+
+	for (size_t begin = band_rows; begin < rows; begin += band_rows)
+		futures.push_back(pool.submit([&fn, begin, end = std::min(begin + band_rows, rows)]() { fn(begin, end); }));
+
+	// The calling thread takes the first band instead of idling
+	fn(size_t(0), std::min(band_rows, rows));
+
+	for (auto& future : futures)
+		pool.wait(future);
+}
+
+// Contiguous pixel runs are split the same way, as rows of 4096 pixels
+template <class Func>
+static void parallel_pixels(size_t pixel_count, size_t pixel_size, Func&& fn)
+{
+	const size_t run = 4096;
+
+	parallel_rows((pixel_count + run - 1) / run, run * pixel_size, [&](size_t begin, size_t end) {
+		fn(begin * run, std::min(end * run, pixel_count));
+	});
+}
+
+static uint8_t premultiply_channel(uint32_t c, uint32_t a)
+{
+	const uint32_t t = c * a + 128;
+	return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+/* Scalar kernels */
+
+static void swizzle_rb_scalar(const uint8_t* src, uint8_t* dst, size_t count)
+{
+	for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+		const uint8_t r = src[0];
+		const uint8_t b = src[2];
+
+		dst[0] = b;
+		dst[1] = src[1];
+		dst[2] = r;
+		dst[3] = src[3];
+	}
+}
+
+static void premultiply_scalar(uint8_t* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++, pixels += 4) {
+		const uint32_t a = pixels[3];
+
+		pixels[0] = premultiply_channel(pixels[0], a);
+		pixels[1] = premultiply_channel(pixels[1], a);
+		pixels[2] = premultiply_channel(pixels[2], a);
+	}
+}
+
+static void replace_color_scalar(uint32_t* pixels, size_t count, uint32_t from, uint32_t to)
+{
+	for (size_t i = 0; i < count; i++)
+		if (pixels[i] == from) pixels[i] = to;
+}
+
+/* x86 kernels */
+
+#if defined(KERNELS_X86)
+
+TARGET_SSSE3 static size_t swizzle_rb_ssse3(const uint8_t* src, uint8_t* dst, size_t count)
+{
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(v, mask));
+	}
+
+	return i;
+}
+
+TARGET_AVX2 static size_t swizzle_rb_avx2(const uint8_t* src, uint8_t* dst, size_t count)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+	}
+
+	return i;
+}
+
+// Two pixels per register as 16 bit lanes, alpha multiplies by 255 to stay unchanged
+static __m128i premultiply_lanes_sse2(__m128i x)
+{
+	const __m128i rgb_mask  = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i rounding  = _mm_set1_epi16(128);
+
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_one);
+
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), rounding);
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static size_t premultiply_sse2(uint8_t* pixels, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		auto* ptr = reinterpret_cast<__m128i*>(pixels + i * 4);
+
+		const __m128i v  = _mm_loadu_si128(ptr);
+		const __m128i lo = premultiply_lanes_sse2(_mm_unpacklo_epi8(v, zero));
+		const __m128i hi = premultiply_lanes_sse2(_mm_unpackhi_epi8(v, zero));
+
+		_mm_storeu_si128(ptr, _mm_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+TARGET_AVX2 static __m256i premultiply_lanes_avx2(__m256i x)
+{
+	const __m256i rgb_mask  = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+	const __m256i alpha_one = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+	const __m256i rounding  = _mm256_set1_epi16(128);
+
+	__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm256_or_si256(_mm256_and_si256(a, rgb_mask), alpha_one);
+
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), rounding);
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+TARGET_AVX2 static size_t premultiply_avx2(uint8_t* pixels, size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto* ptr = reinterpret_cast<__m256i*>(pixels + i * 4);
+
+		// Unpack and pack both work per 128 bit lane, so the pixel order survives
+		const __m256i v  = _mm256_loadu_si256(ptr);
+		const __m256i lo = premultiply_lanes_avx2(_mm256_unpacklo_epi8(v, zero));
+		const __m256i hi = premultiply_lanes_avx2(_mm256_unpackhi_epi8(v, zero));
+
+		_mm256_storeu_si256(ptr, _mm256_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+static size_t replace_color_sse2(uint32_t* pixels, size_t count, uint32_t from, uint32_t to)
+{
+	const __m128i from_v = _mm_set1_epi32(static_cast<int>(from));
+	const __m128i to_v   = _mm_set1_epi32(static_cast<int>(to));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		auto* ptr = reinterpret_cast<__m128i*>(pixels + i);
+
+		const __m128i v  = _mm_loadu_si128(ptr);
+		const __m128i eq = _mm_cmpeq_epi32(v, from_v);
+
+		_mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(eq, to_v), _mm_andnot_si128(eq, v)));
+	}
+
+	return i;
+}
+
+TARGET_AVX2 static size_t replace_color_avx2(uint32_t* pixels, size_t count, uint32_t from, uint32_t to)
+{
+	const __m256i from_v = _mm256_set1_epi32(static_cast<int>(from));
+	const __m256i to_v   = _mm256_set1_epi32(static_cast<int>(to));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto* ptr = reinterpret_cast<__m256i*>(pixels + i);
+
+		const __m256i v  = _mm256_loadu_si256(ptr);
+		const __m256i eq = _mm256_cmpeq_epi32(v, from_v);
+
+		_mm256_storeu_si256(ptr, _mm256_blendv_epi8(v, to_v, eq));
+	}
+
+	return i;
+}
+
+#endif
+
+/* NEON kernels */
+
+#if defined(KERNELS_NEON)
+
+static size_t swizzle_rb_neon(const uint8_t* src, uint8_t* dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(src + i * 4);
+		std::swap(v.val[0], v.val[2]);
+		vst4q_u8(dst + i * 4, v);
+	}
+
+	return i;
+}
+
+// round(c * a / 255) through (t + ((t + 128) >> 8) + 128) >> 8, same as the scalar path
+static uint8x16_t premultiply_channel_neon(uint8x16_t c, uint8x16_t a)
+{
+	const uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+	const uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+
+	return vcombine_u8(
+		vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+		vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+static size_t premultiply_neon(uint8_t* pixels, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+
+		v.val[0] = premultiply_channel_neon(v.val[0], v.val[3]);
+		v.val[1] = premultiply_channel_neon(v.val[1], v.val[3]);
+		v.val[2] = premultiply_channel_neon(v.val[2], v.val[3]);
+
+		vst4q_u8(pixels + i * 4, v);
+	}
+
+	return i;
+}
+
+static size_t replace_color_neon(uint32_t* pixels, size_t count, uint32_t from, uint32_t to)
+{
+	const uint32x4_t from_v = vdupq_n_u32(from);
+	const uint32x4_t to_v   = vdupq_n_u32(to);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const uint32x4_t v = vld1q_u32(pixels + i);
+		vst1q_u32(pixels + i, vbslq_u32(vceqq_u32(v, from_v), to_v, v));
+	}
+
+	return i;
+}
+
+#endif
+
+/* Dispatch */
+
+static void swizzle_rb(const uint8_t* src, uint8_t* dst, size_t count)
+{
+	size_t done = 0;
+
+	switch (simd_level()) {
+#if defined(KERNELS_X86)
+	case SimdLevel::AVX2:  done = swizzle_rb_avx2(src, dst, count); break;
+	case SimdLevel::SSSE3: done = swizzle_rb_ssse3(src, dst, count); break;
+#elif defined(KERNELS_NEON)
+	case SimdLevel::NEON:  done = swizzle_rb_neon(src, dst, count); break;
+#endif
+	default: break;
+	}
+
+	swizzle_rb_scalar(src + done * 4, dst + done * 4, count - done);
+}
+
+static void premultiply(uint8_t* pixels, size_t count)
+{
+	size_t done = 0;
+
+	switch (simd_level()) {
+#if defined(KERNELS_X86)
+	case SimdLevel::AVX2:  done = premultiply_avx2(pixels, count); break;
+	case SimdLevel::SSSE3:
+	case SimdLevel::SSE2:  done = premultiply_sse2(pixels, count); break;
+#elif defined(KERNELS_NEON)
+	case SimdLevel::NEON:  done = premultiply_neon(pixels, count); break;
+#endif
+	default: break;
+	}
+
+	premultiply_scalar(pixels + done * 4, count - done);
+}
+
+static void replace_color(uint32_t* pixels, size_t count, uint32_t from, uint32_t to)
+{
+	size_t done = 0;
+
+	switch (simd_level()) {
+#if defined(KERNELS_X86)
+	case SimdLevel::AVX2:  done = replace_color_avx2(pixels, count, from, to); break;
+	case SimdLevel::SSSE3:
+	case SimdLevel::SSE2:  done = replace_color_sse2(pixels, count, from, to); break;
+#elif defined(KERNELS_NEON)
+	case SimdLevel::NEON:  done = replace_color_neon(pixels, count, from, to); break;
+#endif
+	default: break;
+	}
+
+	replace_color_scalar(pixels + done, count - done, from, to);
+}
+
+/* Layout conversion */
+
+struct LayoutInfo
+{
+	size_t size;
+	int    r, g, b, a; // Byte offsets, -1 when the channel is missing
+};
+
+static LayoutInfo layout_info(VKDL_NAMESPACE_NAME::PixelLayout layout)
+{
+	using VKDL_NAMESPACE_NAME::PixelLayout;
+
+	switch (layout) {
+	case PixelLayout::RGBA8: return { 4, 0, 1, 2, 3 };
+	case PixelLayout::BGRA8: return { 4, 2, 1, 0, 3 };
+	case PixelLayout::RGB8:  return { 3, 0, 1, 2, -1 };
+	case PixelLayout::Gray8: return { 1, 0, 0, 0, -1 };
+	default: VKDL_ERROR("Unknown pixel layout");
+	}
+}
+
+static void convert_generic(const uint8_t* src, const LayoutInfo& s, uint8_t* dst, const LayoutInfo& d, bool to_gray, size_t count)
+{
+	for (size_t i = 0; i < count; i++, src += s.size, dst += d.size) {
+		const uint8_t r = src[s.r];
+		const uint8_t g = src[s.g];
+		const uint8_t b = src[s.b];
+		const uint8_t a = s.a >= 0 ? src[s.a] : 255;
+
+		if (to_gray) {
+			// BT.601 luma in 8 bit fixed point
+			dst[0] = static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+			continue;
+		}
+
+		dst[d.r] = r;
+		dst[d.g] = g;
+		dst[d.b] = b;
+		if (d.a >= 0) dst[d.a] = a;
+	}
+}
+
+/* Resampling */
+
+struct FilterTaps
+{
+	std::vector<uint32_t> first;   // First source index per destination index
+	std::vector<uint32_t> count;
+	std::vector<float>    weights; // `max_taps` per destination index
+	uint32_t              max_taps = 0;
+};
+
+static float filter_support(VKDL_NAMESPACE_NAME::ResizeFilter filter)
+{
+	switch (filter) {
+	case VKDL_NAMESPACE_NAME::ResizeFilter::Box:      return 0.5f;
+	case VKDL_NAMESPACE_NAME::ResizeFilter::Bilinear: return 1.f;
+	default:                                          return 3.f;
+	}
+}
+
+static float filter_weight(VKDL_NAMESPACE_NAME::ResizeFilter filter, float x)
+{
+	x = std::fabs(x);
+
+	switch (filter) {
+	case VKDL_NAMESPACE_NAME::ResizeFilter::Box:
+		return x <= 0.5f ? 1.f : 0.f;
+	case VKDL_NAMESPACE_NAME::ResizeFilter::Bilinear:
+		return x < 1.f ? 1.f - x : 0.f;
+	default: {
+		if (x < 1e-6f) return 1.f;
+		if (x >= 3.f)  return 0.f;
+
+		const float pi_x = 3.14159265358979f * x;
+		return 3.f * std::sin(pi_x) * std::sin(pi_x / 3.f) / (pi_x * pi_x);
+	}
+	}
+}
+
+static FilterTaps build_taps(uint32_t src_size, uint32_t dst_size, VKDL_NAMESPACE_NAME::ResizeFilter filter)
+{
+	const float scale   = static_cast<float>(src_size) / dst_size;
+	const float fscale  = std::max(scale, 1.f); // Widen the filter when minifying
+	const float support = filter_support(filter) * fscale;
+
+	FilterTaps taps;
+	taps.max_taps = static_cast<uint32_t>(std::ceil(support * 2.f)) + 1;
+	taps.first.resize(dst_size);
+	taps.count.resize(dst_size);
+	taps.weights.assign(static_cast<size_t>(dst_size) * taps.max_taps, 0.f);
+
+	for (uint32_t i = 0; i < dst_size; i++) {
+		const float center = (i + 0.5f) * scale;
+
+		int32_t left  = static_cast<int32_t>(std::floor(center - support));
+		int32_t right = static_cast<int32_t>(std::ceil(center + support));
+
+		left  = std::max(left, 0);
+		right = std::min(right, static_cast<int32_t>(src_size));
+		right = std::min(right, left + static_cast<int32_t>(taps.max_taps));
+
+		float* weights = &taps.weights[static_cast<size_t>(i) * taps.max_taps];
+		float  total   = 0.f;
+
+		for (int32_t j = left; j < right; j++) {
+			weights[j - left] = filter_weight(filter, (j + 0.5f - center) / fscale);
+			total += weights[j - left];
+		}
+
+		// Degenerate footprints fall back to the nearest texel
+		if (total <= 0.f) {
+			left       = std::min(static_cast<int32_t>(center), static_cast<int32_t>(src_size) - 1);
+			right      = left + 1;
+			weights[0] = total = 1.f;
+		}
+
+		for (int32_t j = 0; j < right - left; j++)
+			weights[j] /= total;
+
+		taps.first[i] = static_cast<uint32_t>(left);
+		taps.count[i] = static_cast<uint32_t>(right - left);
+	}
+
+	return taps;
+}
+
+VKDL_BEGIN
+
+VKDL_NODISCARD const char* ImageKernels::simdLevel()
+{
+	switch (simd_level()) {
+	case SimdLevel::AVX2:  return "avx2";
+	case SimdLevel::SSSE3: return "ssse3";
+	case SimdLevel::SSE2:  return "sse2";
+	case SimdLevel::NEON:  return "neon";
+	default:               return "scalar";
+	}
+}
+
+void ImageKernels::setSimdEnabled(bool enabled)
+{
+	simd_enabled = enabled;
+}
+
+void ImageKernels::convert(const void* src, PixelLayout src_layout, void* dst, PixelLayout dst_layout, size_t pixel_count)
+{
+	const auto* src_bytes = static_cast<const uint8_t*>(src);
+	auto*       dst_bytes = static_cast<uint8_t*>(dst);
+
+	const auto s = layout_info(src_layout);
+	const auto d = layout_info(dst_layout);
+
+	if (src_layout == dst_layout) {
+		if (src != dst) std::memcpy(dst, src, pixel_count * s.size);
+		return;
+	}
+
+	const bool swizzle = (src_layout == PixelLayout::RGBA8 && dst_layout == PixelLayout::BGRA8)
+		|| (src_layout == PixelLayout::BGRA8 && dst_layout == PixelLayout::RGBA8);
+
+	parallel_pixels(pixel_count, s.size + d.size, [&](size_t begin, size_t end) {
+		if (swizzle)
+			swizzle_rb(src_bytes + begin * 4, dst_bytes + begin * 4, end - begin);
+		else
+			convert_generic(src_bytes + begin * s.size, s, dst_bytes + begin * d.size, d, dst_layout == PixelLayout::Gray8, end - begin);
+	});
+}
+
+void ImageKernels::premultiplyAlpha(uint8_t* pixels, size_t pixel_count)
+{
+	parallel_pixels(pixel_count, 4, [&](size_t begin, size_t end) {
+		premultiply(pixels + begin * 4, end - begin);
+	});
+}
+
+void ImageKernels::unpremultiplyAlpha(uint8_t* pixels, size_t pixel_count)
+{
+	// Fixed point reciprocals of the alpha values
+	static const auto reciprocals = []() {
+		std::vector<uint32_t> table(256, 0);
+		for (uint32_t a = 1; a < 256; a++)
+			table[a] = ((255u << 16) + a / 2) / a;
+		return table;
+	}();
+
+	parallel_pixels(pixel_count, 4, [&](size_t begin, size_t end) {
+		uint8_t* p = pixels + begin * 4;
+
+		for (size_t i = begin; i < end; i++, p += 4) {
+			const uint32_t r = reciprocals[p[3]];
+
+			p[0] = static_cast<uint8_t>(std::min((p[0] * r + 32768) >> 16, 255u));
+			p[1] = static_cast<uint8_t>(std::min((p[1] * r + 32768) >> 16, 255u));
+			p[2] = static_cast<uint8_t>(std::min((p[2] * r + 32768) >> 16, 255u));
+		}
+	});
+}
+
+void ImageKernels::replaceColor(uint32_t* pixels, size_t pixel_count, uint32_t from, uint32_t to)
+{
+	parallel_pixels(pixel_count, 4, [&](size_t begin, size_t end) {
+		replace_color(pixels + begin, end - begin, from, to);
+	});
+}
+
+void ImageKernels::flipHorizontal(void* pixels, uint32_t width, uint32_t height, size_t pixel_size)
+{
+	if (width == 0) return;
+
+	auto* bytes = static_cast<uint8_t*>(pixels);
+
+	const size_t stride = width * pixel_size;
+
+	parallel_rows(height, stride, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			uint8_t* row = bytes + y * stride;
+
+			if (pixel_size == 4) {
+				auto* texels = reinterpret_cast<uint32_t*>(row);
+				std::reverse(texels, texels + width);
+				continue;
+			}
+
+			for (size_t l = 0, r = width - 1; l < r; l++, r--)
+				std::swap_ranges(row + l * pixel_size, row + (l + 1) * pixel_size, row + r * pixel_size);
+		}
+	});
+}
+
+void ImageKernels::flipVertical(void* pixels, uint32_t width, uint32_t height, size_t pixel_size)
+{
+	auto* bytes = static_cast<uint8_t*>(pixels);
+
+	const size_t stride = width * pixel_size;
+
+	parallel_rows(height / 2, stride * 2, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++)
+			std::swap_ranges(bytes + y * stride, bytes + (y + 1) * stride, bytes + (height - 1 - y) * stride);
+	});
+}
+
+void ImageKernels::rotate(const void* src, void* dst, uint32_t width, uint32_t height, size_t pixel_size, ImageRotation rotation)
+{
+	VKDL_CHECK(src != dst);
+
+	const auto* src_bytes = static_cast<const uint8_t*>(src);
+	auto*       dst_bytes = static_cast<uint8_t*>(dst);
+
+	const size_t tiles_y = (height + ROTATE_TILE_SIZE - 1) / ROTATE_TILE_SIZE;
+
+	// Tiles keep both the reads and the transposed writes inside the cache
+	parallel_rows(tiles_y, width * pixel_size * ROTATE_TILE_SIZE, [&](size_t begin, size_t end) {
+		for (size_t ty = begin; ty < end; ty++) {
+			const uint32_t y0 = static_cast<uint32_t>(ty * ROTATE_TILE_SIZE);
+			const uint32_t y1 = std::min(y0 + ROTATE_TILE_SIZE, height);
+
+			for (uint32_t x0 = 0; x0 < width; x0 += ROTATE_TILE_SIZE) {
+				const uint32_t x1 = std::min(x0 + ROTATE_TILE_SIZE, width);
+
+				for (uint32_t y = y0; y < y1; y++) {
+					for (uint32_t x = x0; x < x1; x++) {
+						size_t dst_index;
+
+						switch (rotation) {
+						case ImageRotation::Rotate90:  dst_index = static_cast<size_t>(x) * height + (height - 1 - y); break;
+						case ImageRotation::Rotate180: dst_index = static_cast<size_t>(height - 1 - y) * width + (width - 1 - x); break;
+						default:                       dst_index = static_cast<size_t>(width - 1 - x) * height + y; break;
+						}
+
+						const size_t src_index = static_cast<size_t>(y) * width + x;
+
+						if (pixel_size == 4)
+							reinterpret_cast<uint32_t*>(dst_bytes)[dst_index] = reinterpret_cast<const uint32_t*>(src_bytes)[src_index];
+						else
+							std::memcpy(dst_bytes + dst_index * pixel_size, src_bytes + src_index * pixel_size, pixel_size);
+					}
+				}
+			}
+		}
+	});
+}
+
+void ImageKernels::resize(
+	const uint8_t* src, uint32_t src_width, uint32_t src_height,
+	uint8_t*       dst, uint32_t dst_width, uint32_t dst_height,
+	size_t channels, ResizeFilter filter)
+{
+	VKDL_CHECK(channels >= 1 && channels <= 4);
+	VKDL_CHECK(src_width && src_height && dst_width && dst_height);
+
+	const auto h_taps = build_taps(src_width, dst_width, filter);
+	const auto v_taps = build_taps(src_height, dst_height, filter);
+
+	// Horizontal pass into floats, keeps the precision for the vertical one
+	std::vector<float> temp(static_cast<size_t>(src_height) * dst_width * channels);
+
+	parallel_rows(src_height, dst_width * channels * sizeof(float), [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			const uint8_t* row = src + y * src_width * channels;
+			float*         out = temp.data() + y * dst_width * channels;
+
+			for (uint32_t x = 0; x < dst_width; x++) {
+				const float* weights = &h_taps.weights[static_cast<size_t>(x) * h_taps.max_taps];
+				const size_t first   = h_taps.first[x];
+
+				float sum[4] = {};
+
+				for (uint32_t t = 0; t < h_taps.count[x]; t++)
+					for (size_t c = 0; c < channels; c++)
+						sum[c] += weights[t] * row[(first + t) * channels + c];
+
+				for (size_t c = 0; c < channels; c++)
+					out[x * channels + c] = sum[c];
+			}
+		}
+	});
+
+	parallel_rows(dst_height, dst_width * channels, [&](size_t begin, size_t end) {
+		std::vector<float> sum(static_cast<size_t>(dst_width) * channels);
+
+		for (size_t y = begin; y < end; y++) {
+			const float* weights = &v_taps.weights[y * v_taps.max_taps];
+			const size_t first   = v_taps.first[y];
+
+			std::fill(sum.begin(), sum.end(), 0.f);
+
+			// Row by row, so the inner loop runs over contiguous memory and vectorizes
+			for (uint32_t t = 0; t < v_taps.count[y]; t++) {
+				const float* row    = temp.data() + (first + t) * dst_width * channels;
+				const float  weight = weights[t];
+
+				for (size_t i = 0; i < sum.size(); i++)
+					sum[i] += weight * row[i];
+			}
+
+			uint8_t* out = dst + y * dst_width * channels;
+
+			for (size_t i = 0; i < sum.size(); i++)
+				out[i] = static_cast<uint8_t>(std::clamp(sum[i] + 0.5f, 0.f, 255.f));
+		}
+	});
+}
+
+VKDL_END
\ No newline at end of file
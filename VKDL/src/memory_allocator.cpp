@@ -0,0 +1,468 @@
+#include "../include/vkdl/core/memory_allocator.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/upload_service.h"
+#include "buddy_allocator.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+struct MemoryBlock
+{
+	struct Live
+	{
+		uint32_t       order;
+		vk::DeviceSize size;
+		MemoryCategory category;
+		MemoryOwner*   owner;
+	};
+
+	vk::DeviceMemory memory;
+	uint8_t*         mapped;
+	vk::DeviceSize   size;
+	uint32_t         memory_type;
+	bool             linear;
+	bool             evacuating;
+	vk::DeviceSize   used;
+
+	// Order n spans min_allocation << n bytes
+	BuddyAllocator                 buddy;
+	std::map<vk::DeviceSize, Live> live;
+};
+
+VKDL_PRIV_END
+VKDL_END
+
+using MemoryBlock = VKDL_NAMESPACE_NAME::VKDL_PRIV_NAMESPACE_NAME::MemoryBlock;
+
+static VKDL_CONSTEXPR vk::DeviceSize min_allocation = VKDL_NAMESPACE_NAME::MemoryAllocator::min_allocation;
+
+static vk::DeviceSize round_up_pow2(vk::DeviceSize size)
+{
+	vk::DeviceSize result = 1;
+	while (result < size) result <<= 1;
+	return result;
+}
+
+VKDL_BEGIN
+
+MemoryAllocator::MemoryAllocator(vk::DeviceSize block_size) :
+	block_size(round_up_pow2(std::max(block_size, min_allocation))),
+	mutex(),
+	pools(),
+	stats()
+{
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	auto& device = Context::get().device;
+
+	for (auto& [key, pool] : pools) {
+		for (auto& block : pool) {
+			if (block->mapped) device.unmapMemory(block->memory);
+			device.free(block->memory);
+		}
+	}
+}
+
+VKDL_NODISCARD MemoryAllocation MemoryAllocator::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags props, MemoryCategory category, bool linear, MemoryOwner* owner)
+{
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	const uint32_t memory_type = ctx.findMemoryType(requirements.memoryTypeBits, props);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const vk::DeviceSize pool_block_size = blockSizeFor(memory_type);
+
+	MemoryAllocation allocation = {};
+	allocation.memory_type = memory_type;
+	allocation.category    = category;
+
+	// Large resources would fragment the blocks more than they save
+	if (requirements.size > pool_block_size / 2) {
+		allocation.memory = device.allocateMemory({ requirements.size, memory_type });
+		allocation.size   = requirements.size;
+		allocation.mapped = mapIfHostVisible(allocation.memory, memory_type);
+
+		stats.dedicated_count++;
+		stats.dedicated_bytes += allocation.size;
+		addStats(allocation, 1);
+
+		return allocation;
+	}
+
+	auto& pool = pools[{ memory_type, linear }];
+
+	if (!allocateFromPool(pool, requirements.size, requirements.alignment, category, owner, allocation)) {
+		auto block = std::make_unique<MemoryBlock>();
+		block->memory      = device.allocateMemory({ pool_block_size, memory_type });
+		block->mapped      = mapIfHostVisible(block->memory, memory_type);
+		block->size        = pool_block_size;
+		block->memory_type = memory_type;
+		block->linear      = linear;
+		block->evacuating  = false;
+		block->used        = 0;
+		block->buddy       = VKDL_PRIV_NAMESPACE_NAME::BuddyAllocator(pool_block_size, min_allocation);
+
+		pool.push_back(std::move(block));
+
+		stats.block_count++;
+		stats.block_bytes += pool_block_size;
+
+		VKDL_CHECK(allocateFromPool(pool, requirements.size, requirements.alignment, category, owner, allocation));
+	}
+
+	addStats(allocation, 1);
+
+	return allocation;
+}
+
+VKDL_NODISCARD MemoryAllocation MemoryAllocator::allocate(vk::Buffer buffer, vk::MemoryPropertyFlags props, MemoryCategory category, MemoryOwner* owner)
+{
+	auto& device = Context::get().device;
+
+	auto allocation = allocate(device.getBufferMemoryRequirements(buffer), props, category, true, owner);
+	device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+
+	return allocation;
+}
+
+VKDL_NODISCARD MemoryAllocation MemoryAllocator::allocate(vk::Image image, vk::MemoryPropertyFlags props, MemoryCategory category, bool linear, MemoryOwner* owner)
+{
+	auto& device = Context::get().device;
+
+	auto allocation = allocate(device.getImageMemoryRequirements(image), props, category, linear, owner);
+	device.bindImageMemory(image, allocation.memory, allocation.offset);
+
+	return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation)
+{
+	if (allocation.empty()) return;
+
+	auto& device = Context::get().device;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	addStats(allocation, -1);
+
+	if (auto* block = allocation.block) {
+		auto it = block->live.find(allocation.offset);
+		VKDL_CHECK_MSG(it != block->live.end(), "freeing memory that was not allocated");
+
+		const uint32_t order = it->second.order;
+		block->live.erase(it);
+
+		block->buddy.free(allocation.offset, order);
+
+		block->used            -= min_allocation << order;
+		stats.block_used_bytes -= min_allocation << order;
+
+		// One empty block per pool is kept so a free/allocate cycle does not hit the driver
+		auto& pool = pools[{ block->memory_type, block->linear }];
+
+		if (block->used == 0 && !block->evacuating) {
+			const bool has_spare = std::any_of(pool.begin(), pool.end(), [block](const auto& other) {
+				return other.get() != block && other->used == 0;
+			});
+
+			if (has_spare) releaseBlock(pool, block);
+		}
+	} else {
+		if (allocation.mapped) device.unmapMemory(allocation.memory);
+		device.free(allocation.memory);
+
+		stats.dedicated_count--;
+		stats.dedicated_bytes -= allocation.size;
+	}
+
+	allocation = {};
+}
+
+void MemoryAllocator::setOwner(const MemoryAllocation& allocation, MemoryOwner* owner)
+{
+	if (!allocation.block) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = allocation.block->live.find(allocation.offset);
+	if (it != allocation.block->live.end())
+		it->second.owner = owner;
+}
+
+void MemoryAllocator::flush(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+	flushOrInvalidate(allocation, offset, size, true);
+}
+
+void MemoryAllocator::invalidate(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+	flushOrInvalidate(allocation, offset, size, false);
+}
+
+size_t MemoryAllocator::defragment(float max_occupancy)
+{
+	struct Candidate
+	{
+		MemoryBlock*     block;
+		MemoryAllocation from;
+		vk::DeviceSize   alignment;
+		MemoryOwner*     owner;
+	};
+
+	auto& ctx = Context::get();
+
+	// Batches already recorded still copy into the current images and buffers
+	if (ctx.upload_service)
+		ctx.upload_service->wait();
+
+	std::vector<Candidate> candidates;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto& [key, pool] : pools) {
+			if (pool.size() < 2) continue;
+
+			for (auto& block : pool) {
+				const float occupancy = static_cast<float>(block->used) / static_cast<float>(block->size);
+				if (block->used == 0 || occupancy >= max_occupancy) continue;
+
+				// Only owned allocations can be moved, one unknown one pins the block
+				const bool movable = std::all_of(block->live.begin(), block->live.end(), [](const auto& entry) {
+					return entry.second.owner != nullptr;
+				});
+				if (!movable) continue;
+
+				block->evacuating = true;
+
+				for (const auto& [offset, live] : block->live) {
+					Candidate candidate = {};
+					candidate.block            = block.get();
+					candidate.from.memory      = block->memory;
+					candidate.from.offset      = offset;
+					candidate.from.size        = live.size;
+					candidate.from.mapped      = block->mapped ? block->mapped + offset : nullptr;
+					candidate.from.memory_type = block->memory_type;
+					candidate.from.category    = live.category;
+					candidate.from.block       = block.get();
+					candidate.alignment        = min_allocation << live.order;
+					candidate.owner            = live.owner;
+
+					candidates.push_back(candidate);
+				}
+			}
+		}
+	}
+
+	size_t moved = 0;
+
+	for (auto& candidate : candidates) {
+		MemoryAllocation to = {};
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// Never grows the pool, the point is to end up with fewer blocks
+			auto& pool = pools[{ candidate.block->memory_type, candidate.block->linear }];
+			if (!allocateFromPool(pool, candidate.from.size, candidate.alignment, candidate.from.category, candidate.owner, to))
+				continue;
+
+			to.memory_type = candidate.from.memory_type;
+			to.category    = candidate.from.category;
+			addStats(to, 1);
+		}
+
+		// Owners run unlocked, they usually allocate and free themselves
+		if (candidate.owner->relocate(candidate.from, to)) {
+			// Frames in flight may still read the old range. Without an owner it
+			// pins its block until then, so the next pass does not move it again
+			setOwner(candidate.from, nullptr);
+
+			ctx.retire([this, from = candidate.from]() mutable { free(from); });
+			moved++;
+		} else {
+			free(to);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto& [key, pool] : pools) {
+			for (auto& block : pool)
+				block->evacuating = false;
+
+			std::vector<MemoryBlock*> empty;
+			for (auto& block : pool)
+				if (block->used == 0) empty.push_back(block.get());
+
+			// Same policy as free(), one spare block per pool
+			for (size_t i = 1; i < empty.size(); i++)
+				releaseBlock(pool, empty[i]);
+		}
+	}
+
+	return moved;
+}
+
+void MemoryAllocator::trim()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto& [key, pool] : pools) {
+		std::vector<MemoryBlock*> empty;
+		for (auto& block : pool)
+			if (block->used == 0) empty.push_back(block.get());
+
+		for (auto* block : empty)
+			releaseBlock(pool, block);
+	}
+}
+
+VKDL_NODISCARD MemoryStats MemoryAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+VKDL_NODISCARD MemoryCategory MemoryAllocator::categoryOf(vk::BufferUsageFlags usage)
+{
+	if (usage & vk::BufferUsageFlagBits::eVertexBuffer) return MemoryCategory::VertexBuffer;
+	if (usage & vk::BufferUsageFlagBits::eIndexBuffer)  return MemoryCategory::IndexBuffer;
+
+	if (usage & (vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer))
+		return MemoryCategory::UniformBuffer;
+
+	return MemoryCategory::StagingBuffer;
+}
+
+VKDL_NODISCARD const char* MemoryAllocator::categoryName(MemoryCategory category)
+{
+	switch (category) {
+	case MemoryCategory::Texture:       return "texture";
+	case MemoryCategory::VertexBuffer:  return "vertex buffer";
+	case MemoryCategory::IndexBuffer:   return "index buffer";
+	case MemoryCategory::UniformBuffer: return "uniform buffer";
+	case MemoryCategory::StagingBuffer: return "staging buffer";
+	default:                            return "other";
+	}
+}
+
+bool MemoryAllocator::allocateFromPool(Pool& pool, vk::DeviceSize size, vk::DeviceSize alignment, MemoryCategory category, MemoryOwner* owner, MemoryAllocation& allocation)
+{
+	// Buddy ranges are aligned to their own size, which covers the alignment
+	for (auto& block : pool) {
+		const uint32_t order = block->buddy.orderFor(std::max(size, alignment));
+
+		if (block->evacuating || order > block->buddy.maxOrder()) continue;
+
+		uint64_t offset;
+		if (!block->buddy.allocate(order, offset)) continue;
+
+		block->live[offset] = { order, size, category, owner };
+		block->used            += min_allocation << order;
+		stats.block_used_bytes += min_allocation << order;
+
+		allocation.memory = block->memory;
+		allocation.offset = offset;
+		allocation.size   = size;
+		allocation.mapped = block->mapped ? block->mapped + offset : nullptr;
+		allocation.block  = block.get();
+
+		return true;
+	}
+
+	return false;
+}
+
+void MemoryAllocator::releaseBlock(Pool& pool, MemoryBlock* block)
+{
+	auto& device = Context::get().device;
+
+	auto it = std::find_if(pool.begin(), pool.end(), [block](const auto& entry) { return entry.get() == block; });
+	if (it == pool.end()) return;
+
+	if (block->mapped) device.unmapMemory(block->memory);
+	device.free(block->memory);
+
+	stats.block_count--;
+	stats.block_bytes -= block->size;
+
+	pool.erase(it);
+}
+
+void MemoryAllocator::flushOrInvalidate(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size, bool flush) const
+{
+	if (allocation.empty()) return;
+
+	auto& ctx = Context::get();
+
+	const auto flags = ctx.physical_device_memory_props.memoryTypes[allocation.memory_type].propertyFlags;
+	if (flags & vk::MemoryPropertyFlagBits::eHostCoherent) return;
+
+	// Ranges have to be aligned to nonCoherentAtomSize, and may run past the
+	// allocation only up to the end of the memory object
+	const vk::DeviceSize atom        = ctx.physical_device_props.limits.nonCoherentAtomSize;
+	const vk::DeviceSize memory_size = allocation.block ? allocation.block->size : allocation.size;
+
+	const vk::DeviceSize begin = allocation.offset + offset;
+	const vk::DeviceSize end   = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+	vk::MappedMemoryRange range = {};
+	range.memory = allocation.memory;
+	range.offset = begin / atom * atom;
+	range.size   = (end + atom - 1) / atom * atom;
+	range.size   = range.size >= memory_size ? VK_WHOLE_SIZE : range.size - range.offset;
+
+	if (flush)
+		VK_CHECK(ctx.device.flushMappedMemoryRanges(1, &range));
+	else
+		VK_CHECK(ctx.device.invalidateMappedMemoryRanges(1, &range));
+}
+
+uint8_t* MemoryAllocator::mapIfHostVisible(vk::DeviceMemory memory, uint32_t memory_type) const
+{
+	const auto flags = Context::get().physical_device_memory_props.memoryTypes[memory_type].propertyFlags;
+
+	if (!(flags & vk::MemoryPropertyFlagBits::eHostVisible))
+		return nullptr;
+
+	return static_cast<uint8_t*>(Context::get().device.mapMemory(memory, 0, VK_WHOLE_SIZE));
+}
+
+vk::DeviceSize MemoryAllocator::blockSizeFor(uint32_t memory_type) const
+{
+	const auto& mem_props = Context::get().physical_device_memory_props;
+	const auto  heap_size = mem_props.memoryHeaps[mem_props.memoryTypes[memory_type].heapIndex].size;
+
+	// Small heaps (BAR memory, integrated GPUs) get smaller blocks, at most an eighth of the heap
+	vk::DeviceSize size = block_size;
+	while (size > (1ull << 20) && size > heap_size / 8)
+		size >>= 1;
+
+	return size;
+}
+
+void MemoryAllocator::addStats(const MemoryAllocation& allocation, int64_t sign)
+{
+	auto& category = stats.categories[static_cast<size_t>(allocation.category)];
+
+	if (sign > 0) {
+		category.allocation_count++;
+		category.bytes += allocation.size;
+	} else {
+		category.allocation_count--;
+		category.bytes -= allocation.size;
+	}
+}
+
+VKDL_END
\ No newline at end of file
@@ -4,27 +4,48 @@
 
 VKDL_BEGIN
 
-Pipeline::Pipeline(vk::Pipeline pipeline, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules) :
+Pipeline::Pipeline(vk::Pipeline pipeline, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules, std::shared_ptr<RenderPass>& renderpass) :
 	pipeline(pipeline),
+	pending(),
 	layout(layout),
-	modules(modules)
+	modules(modules),
+	renderpass(renderpass)
+{
+}
+
+Pipeline::Pipeline(std::shared_future<vk::Pipeline> pending, std::shared_ptr<PipelineLayout>& layout, std::vector<std::shared_ptr<ShaderModule>>& modules, std::shared_ptr<RenderPass>& renderpass) :
+	pipeline(nullptr),
+	pending(std::move(pending)),
+	layout(layout),
+	modules(modules),
+	renderpass(renderpass)
 {
 }
 
 Pipeline::~Pipeline()
 {
 	auto& device = Context::get().device;
-	device.destroy(pipeline);
+
+	// A compile that failed has nothing to destroy
+	try {
+		device.destroy(get());
+	} catch (const std::exception&) {
+	}
+}
+
+bool Pipeline::isReady() const
+{
+	return !pending.valid() || pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 }
 
-vk::Pipeline Pipeline::get()
+vk::Pipeline Pipeline::get() const
 {
-	return pipeline;
+	return pending.valid() ? pending.get() : pipeline;
 }
 
 Pipeline::operator vk::Pipeline() const
 {
-	return pipeline;
+	return get();
 }
 
 PipelineLayout& Pipeline::getPipelineLayout() const
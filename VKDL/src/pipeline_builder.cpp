@@ -1,6 +1,113 @@
 #include "../include/vkdl/builder/pipeline_builder.h"
 
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/util/thread_pool.h"
+
+#include <chrono>
+
+#include "structural_cache.h"
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// Shader modules, layout and render pass are compared by identity, ShaderModule shares
+// one module per SPIR-V blob so separate loads of the same code still match. A cached
+// pipeline holds all three, so none of them can be destroyed and have its handle reused
+// while its entry can still match.
+struct PipelineKey
+{
+	struct Stage
+	{
+		vk::ShaderStageFlagBits stage;
+		vk::ShaderModule        module;
+		std::string             entry;
+
+		bool operator==(const Stage& rhs) const
+		{
+			return stage == rhs.stage && module == rhs.module && entry == rhs.entry;
+		}
+	};
+
+	std::vector<Stage>                                 stages;
+	std::vector<vk::VertexInputBindingDescription>     vertex_bindings;
+	std::vector<vk::VertexInputAttributeDescription>   vertex_attributes;
+	std::vector<vk::Viewport>                          viewports;
+	std::vector<vk::Rect2D>                            scissors;
+	std::vector<vk::DynamicState>                      dynamic_states;
+	std::vector<vk::PipelineColorBlendAttachmentState> blend_states;
+
+	vk::PipelineInputAssemblyStateCreateInfo ia_info;
+	vk::PipelineRasterizationStateCreateInfo raster_info;
+	vk::PipelineMultisampleStateCreateInfo   ms_info;
+	vk::PipelineDepthStencilStateCreateInfo  depth_info;
+	vk::PipelineColorBlendStateCreateInfo    blend_info;
+
+	const PipelineLayout* layout;
+	const RenderPass*     renderpass;
+
+	bool operator==(const PipelineKey& rhs) const
+	{
+		return stages == rhs.stages
+			&& vertex_bindings == rhs.vertex_bindings
+			&& vertex_attributes == rhs.vertex_attributes
+			&& viewports == rhs.viewports
+			&& scissors == rhs.scissors
+			&& dynamic_states == rhs.dynamic_states
+			&& blend_states == rhs.blend_states
+			&& ia_info == rhs.ia_info
+			&& raster_info == rhs.raster_info
+			&& ms_info == rhs.ms_info
+			&& depth_info == rhs.depth_info
+			&& blend_info == rhs.blend_info
+			&& layout == rhs.layout
+			&& renderpass == rhs.renderpass;
+	}
+
+	// Covers what usually differs between pipelines, operator== settles the rest
+	size_t hash() const
+	{
+		size_t seed = 0;
+
+		for (const auto& stage : stages) {
+			hashCombine(seed, static_cast<VkShaderModule>(stage.module));
+			hashCombine(seed, stage.entry);
+		}
+
+		for (const auto& attribute : vertex_attributes) {
+			hashCombine(seed, attribute.location);
+			hashCombine(seed, static_cast<int>(attribute.format));
+			hashCombine(seed, attribute.offset);
+		}
+
+		for (auto state : dynamic_states)
+			hashCombine(seed, static_cast<int>(state));
+
+		for (const auto& blend : blend_states) {
+			hashCombine(seed, blend.blendEnable);
+			hashCombine(seed, static_cast<int>(blend.srcColorBlendFactor));
+			hashCombine(seed, static_cast<int>(blend.dstColorBlendFactor));
+		}
+
+		hashCombine(seed, static_cast<int>(ia_info.topology));
+		hashCombine(seed, static_cast<int>(raster_info.polygonMode));
+		hashCombine(seed, static_cast<VkCullModeFlags>(raster_info.cullMode));
+		hashCombine(seed, static_cast<int>(ms_info.rasterizationSamples));
+		hashCombine(seed, depth_info.depthTestEnable);
+		hashCombine(seed, layout);
+		hashCombine(seed, renderpass);
+
+		return seed;
+	}
+};
+
+static StructuralCache<PipelineKey, Pipeline>& shared_pipelines()
+{
+	static StructuralCache<PipelineKey, Pipeline> cache;
+	return cache;
+}
+
+VKDL_PRIV_END
+VKDL_END
 
 VKDL_BEGIN
 
@@ -275,6 +382,70 @@ PipelineBuilder& PipelineBuilder::setRenderPass(std::shared_ptr<RenderPass> rend
 }
 
 std::shared_ptr<Pipeline> PipelineBuilder::build()
+{
+	auto create = [this]() {
+		return std::shared_ptr<Pipeline>(new Pipeline(createPipeline(), layout, modules, renderpass));
+	};
+
+	VKDL_PRIV_NAMESPACE_NAME::PipelineKey key;
+	if (!makeKey(key))
+		return create();
+
+	return VKDL_PRIV_NAMESPACE_NAME::shared_pipelines().getOrCreate(key, create);
+}
+
+std::shared_ptr<Pipeline> PipelineBuilder::buildAsync() const
+{
+	auto create = [this]() {
+		// The job works on its own copy, the create info pointers are only taken inside createPipeline
+		auto builder = std::make_shared<PipelineBuilder>(*this);
+
+		std::shared_future<vk::Pipeline> pending = ThreadPool::shared().submit([builder]() {
+			return builder->createPipeline();
+		});
+
+		auto pipeline_layout     = layout;
+		auto shader_modules      = modules;
+		auto pipeline_renderpass = renderpass;
+
+		return std::shared_ptr<Pipeline>(new Pipeline(std::move(pending), pipeline_layout, shader_modules, pipeline_renderpass));
+	};
+
+	VKDL_PRIV_NAMESPACE_NAME::PipelineKey key;
+	if (!makeKey(key))
+		return create();
+
+	return VKDL_PRIV_NAMESPACE_NAME::shared_pipelines().getOrCreate(key, create);
+}
+
+bool PipelineBuilder::makeKey(VKDL_PRIV_NAMESPACE_NAME::PipelineKey& key) const
+{
+	for (const auto& stage : ss_info) {
+		if (stage.pNext || stage.pSpecializationInfo) return false;
+		key.stages.push_back({ stage.stage, stage.module, stage.pName });
+	}
+
+	if (ia_info.pNext || raster_info.pNext || ms_info.pNext || ms_info.pSampleMask || depth_info.pNext || blend_info.pNext)
+		return false;
+
+	key.vertex_bindings   = vib_desc;
+	key.vertex_attributes = via_desc;
+	key.viewports         = viewports;
+	key.scissors          = scissors;
+	key.dynamic_states    = dynamic_states;
+	key.blend_states      = blend_states;
+	key.ia_info           = ia_info;
+	key.raster_info       = raster_info;
+	key.ms_info           = ms_info;
+	key.depth_info        = depth_info;
+	key.blend_info        = blend_info;
+	key.layout            = layout.get();
+	key.renderpass        = renderpass.get();
+
+	return true;
+}
+
+vk::Pipeline PipelineBuilder::createPipeline() const
 {
 	auto& ctx    = Context::get();
 	auto& device = ctx.device;
@@ -300,8 +471,9 @@ std::shared_ptr<Pipeline> PipelineBuilder::build()
 		viewport_info.pScissors     = scissors.data();
 	}
 
-	blend_info.attachmentCount = (uint32_t)blend_states.size();
-	blend_info.pAttachments    = blend_states.data();
+	auto color_blend_info = blend_info;
+	color_blend_info.attachmentCount = (uint32_t)blend_states.size();
+	color_blend_info.pAttachments    = blend_states.data();
 
 	vk::PipelineDynamicStateCreateInfo ds_info = {};
 	ds_info.dynamicStateCount = (uint32_t)dynamic_states.size();
@@ -317,7 +489,7 @@ std::shared_ptr<Pipeline> PipelineBuilder::build()
 	image_info.pRasterizationState = &raster_info;
 	image_info.pMultisampleState   = &ms_info;
 	image_info.pDepthStencilState  = &depth_info;
-	image_info.pColorBlendState    = &blend_info;
+	image_info.pColorBlendState    = &color_blend_info;
 	image_info.pDynamicState       = &ds_info;
 	image_info.layout              = *layout;
 	image_info.renderPass          = renderpass->get();
@@ -325,10 +497,13 @@ std::shared_ptr<Pipeline> PipelineBuilder::build()
 	image_info.basePipelineHandle  = nullptr;
 	image_info.basePipelineIndex   = 0;
 
+	auto start  = std::chrono::steady_clock::now();
 	auto result = device.createGraphicsPipeline(ctx.pipeline_cache, image_info);
+
+	ctx.recordPipelineBuild(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 	VKDL_CHECK_MSG(result.result == vk::Result::eSuccess, "Failed to create graphics pipeline");
 
-	return std::shared_ptr<Pipeline>(new Pipeline(result.value, layout, modules));
+	return result.value;
 }
 
 VKDL_END
@@ -1,8 +1,46 @@
 #include "../include/vkdl/builder/pipeline_layout_builder.h"
 
 #include "../include/vkdl/core/context.h"
+#include "structural_cache.h"
 
 VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+// Set layouts are deduplicated themselves, so comparing them by address is enough
+struct PipelineLayoutKey
+{
+	std::vector<const DescriptorSetLayout*> set_layouts;
+	std::vector<vk::PushConstantRange>      push_constants;
+
+	bool operator==(const PipelineLayoutKey& rhs) const
+	{
+		return set_layouts == rhs.set_layouts && push_constants == rhs.push_constants;
+	}
+
+	size_t hash() const
+	{
+		size_t seed = 0;
+
+		for (const auto* layout : set_layouts)
+			hashCombine(seed, layout);
+
+		for (const auto& range : push_constants) {
+			hashCombine(seed, static_cast<VkShaderStageFlags>(range.stageFlags));
+			hashCombine(seed, range.offset);
+			hashCombine(seed, range.size);
+		}
+
+		return seed;
+	}
+};
+
+static StructuralCache<PipelineLayoutKey, PipelineLayout>& layout_cache()
+{
+	static StructuralCache<PipelineLayoutKey, PipelineLayout> cache;
+	return cache;
+}
+
+VKDL_PRIV_END
 
 PipelineLayoutBuilder::PipelineLayoutBuilder()
 {
@@ -12,6 +50,7 @@ PipelineLayoutBuilder::PipelineLayoutBuilder()
 void PipelineLayoutBuilder::clear()
 {
 	desc_layouts.clear();
+	desc_layout_ptrs.clear();
 	pc_ranges.clear();
 }
 
@@ -39,7 +78,15 @@ std::shared_ptr<PipelineLayout> PipelineLayoutBuilder::build()
 	info.pushConstantRangeCount = (uint32_t)pc_ranges.size();
 	info.pPushConstantRanges    = pc_ranges.data();
 
-	return std::shared_ptr<PipelineLayout>(new PipelineLayout(device.createPipelineLayout(info), desc_layout_ptrs));
+	VKDL_PRIV_NAMESPACE_NAME::PipelineLayoutKey key;
+	key.push_constants = pc_ranges;
+
+	for (const auto& layout : desc_layout_ptrs)
+		key.set_layouts.push_back(layout.get());
+
+	return VKDL_PRIV_NAMESPACE_NAME::layout_cache().getOrCreate(key, [&]() {
+		return std::shared_ptr<PipelineLayout>(new PipelineLayout(device.createPipelineLayout(info), desc_layout_ptrs));
+	});
 }
 
 VKDL_END
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "../../include/vkdl/util/mapped_file.h"
+#include "../../include/vkdl/core/exception.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <Windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+VKDL_BEGIN
+
+MappedFile::MappedFile() :
+	file_handle(nullptr),
+	mapping_handle(nullptr),
+	ptr(nullptr),
+	length(0)
+{
+}
+
+MappedFile::MappedFile(const char* path) :
+	MappedFile()
+{
+	VKDL_CHECK_MSG(open(path), "Failed to map file");
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) VKDL_NOEXCEPT :
+	file_handle(std::exchange(rhs.file_handle, nullptr)),
+	mapping_handle(std::exchange(rhs.mapping_handle, nullptr)),
+	ptr(std::exchange(rhs.ptr, nullptr)),
+	length(std::exchange(rhs.length, 0))
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) VKDL_NOEXCEPT
+{
+	close();
+
+	file_handle    = std::exchange(rhs.file_handle, nullptr);
+	mapping_handle = std::exchange(rhs.mapping_handle, nullptr);
+	ptr            = std::exchange(rhs.ptr, nullptr);
+	length         = std::exchange(rhs.length, 0);
+
+	return *this;
+}
+
+#ifdef _WIN32
+
+VKDL_NODISCARD bool MappedFile::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size = {};
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	file_handle    = file;
+	mapping_handle = mapping;
+	ptr            = static_cast<const uint8_t*>(view);
+	length         = static_cast<size_t>(file_size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (ptr) UnmapViewOfFile(ptr);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (file_handle) CloseHandle(file_handle);
+
+	file_handle    = nullptr;
+	mapping_handle = nullptr;
+	ptr            = nullptr;
+	length         = 0;
+}
+
+#else
+
+VKDL_NODISCARD bool MappedFile::open(const char* path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st = {};
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping keeps its own reference to the file
+	::close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	ptr    = static_cast<const uint8_t*>(view);
+	length = static_cast<size_t>(st.st_size);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (ptr) munmap(const_cast<uint8_t*>(ptr), length);
+
+	file_handle    = nullptr;
+	mapping_handle = nullptr;
+	ptr            = nullptr;
+	length         = 0;
+}
+
+#endif
+
+VKDL_NODISCARD const uint8_t* MappedFile::data() const
+{
+	return ptr;
+}
+
+VKDL_NODISCARD size_t MappedFile::size() const
+{
+	return length;
+}
+
+VKDL_NODISCARD bool MappedFile::is_open() const
+{
+	return ptr != nullptr;
+}
+
+VKDL_END
\ No newline at end of file
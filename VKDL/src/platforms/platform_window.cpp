@@ -2,7 +2,10 @@
 #  include "windows_platform_window_impl.h"
 #endif
 
+#include "../../include/vkdl/core/cpu_profiler.h"
 #include "../../include/vkdl/core/drawable.h"
+#include "../../include/vkdl/core/upload_service.h"
+#include "../../include/vkdl/core/readback_queue.h"
 
 VKDL_BEGIN
 
@@ -13,7 +16,10 @@ void PlatformWindow::render(const Drawable& drawable, const RenderOptions& optio
 	if (impl->render_begin == false) {
 		auto& device = Context::get().device;
 		
-		impl->acquireSwapchainImage();
+		{
+			VKDL_PROFILE_ZONE("PlatformWindow acquire");
+			impl->acquireSwapchainImage();
+		}
 
 		auto cmd = getCommandBuffer();
 		cmd.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
@@ -21,14 +27,29 @@ void PlatformWindow::render(const Drawable& drawable, const RenderOptions& optio
 		auto& frame = impl->frames[impl->frame_idx];
 
 		VK_CHECK(device.waitForFences(1, &frame.fence, true, UINT64_MAX));
+		Context::get().readback_queue->collect();
 		VK_CHECK(device.resetFences(1, &frame.fence));
 
+		Context::get().upload_service->flush();
+
+		if (auto& profiler = Context::get().gpu_profiler)
+			profiler->beginFrame(cmd, frame.queries, "PlatformWindow");
+
 		frame.states.reset(*this);
 
 		impl->render_begin = true;
 	}
 
-	drawable.draw(*this, impl->frames[impl->frame_idx].states, options);
+	auto& frame    = impl->frames[impl->frame_idx];
+	auto& profiler = Context::get().gpu_profiler;
+
+	if (profiler)
+		profiler->beginScope(frame.cmd_buffer, frame.queries, GpuProfiler::drawableLabel(drawable, options));
+
+	drawable.draw(*this, frame.states, options);
+
+	if (profiler)
+		profiler->endScope(frame.cmd_buffer, frame.queries);
 }
 
 void PlatformWindow::display()
@@ -44,7 +65,19 @@ void PlatformWindow::display()
 	auto& image_acquired  = semaphores.image_acquired;
 	auto& render_complete = semaphores.render_complete;
 
-	cmd.endRenderPass();
+	frame.states.endRenderPass(*this);
+
+	const uvec2 extent = { impl->capabilities.currentExtent.width, impl->capabilities.currentExtent.height };
+
+	for (auto& callback : impl->captures)
+		ctx.readback_queue->record(cmd, frame.image, impl->image_format, extent, vk::ImageLayout::ePresentSrcKHR, std::move(callback));
+	impl->captures.clear();
+
+	ctx.readback_queue->record(cmd);
+
+	if (ctx.gpu_profiler)
+		ctx.gpu_profiler->endFrame(cmd, frame.queries);
+
 	cmd.end();
 
 	vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
@@ -56,7 +89,8 @@ void PlatformWindow::display()
 		1, &render_complete
 	};
 
-	VK_CHECK(ctx.queues[ctx.graphics_queue_family_idx].submit(1, &submit_info, frame.fence));
+	ctx.submit(QueueType::Graphics, 1, &submit_info, frame.fence);
+	ctx.readback_queue->submitted(frame.fence);
 
 	vk::PresentInfoKHR present_info = {
 		1, &render_complete,
@@ -64,10 +98,15 @@ void PlatformWindow::display()
 		&impl->frame_idx,
 	};
 
-	VK_CHECK(ctx.queues[impl->present_queue_family_idx].presentKHR(&present_info));
+	{
+		VKDL_PROFILE_ZONE("PlatformWindow present");
+		VK_CHECK(ctx.present(impl->present_queue_family_idx, present_info));
+	}
 
 	impl->semaphore_idx = (impl->semaphore_idx + 1) % impl->semaphores.size();
 	impl->render_begin = false;
+
+	ctx.endFrame();
 }
 
 void PlatformWindow::clear(const Color& color)
@@ -97,6 +136,27 @@ void PlatformWindow::clear(const Color& color)
 	//	1, &range);
 }
 
+std::future<ColorImage> PlatformWindow::capture()
+{
+	auto promise = std::make_shared<std::promise<ColorImage>>();
+	auto future  = promise->get_future();
+
+	capture([promise](ColorImage&& image) {
+		promise->set_value(std::move(image));
+	});
+
+	return future;
+}
+
+void PlatformWindow::capture(std::function<void(ColorImage&&)> callback)
+{
+	// Checked here, display() records the copy after the render pass ended and must not throw
+	VKDL_CHECK_MSG(impl->capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc, "swapchain images cannot be copied on this surface");
+	VKDL_CHECK_MSG(ReadbackQueue::supportsFormat(impl->image_format), "capture needs an RGBA8 or BGRA8 swapchain");
+
+	impl->captures.push_back(std::move(callback));
+}
+
 vk::CommandBuffer PlatformWindow::getCommandBuffer()
 {
 	return impl->frames[impl->frame_idx].cmd_buffer;
@@ -107,6 +167,11 @@ vk::Framebuffer PlatformWindow::getFrameBuffer()
 	return impl->frames[impl->frame_idx].frame_buffer;
 }
 
+vk::RenderPass PlatformWindow::getRenderPass()
+{
+	return Context::get().getRenderpass(impl->render_pass).get();
+}
+
 
 uvec2 PlatformWindow::getFrameBufferSize() const
 {
@@ -2,6 +2,8 @@
 
 #include <queue>
 #include "../../include/vkdl/core/context.h"
+#include "../../include/vkdl/core/readback_queue.h"
+#include "../../include/vkdl/core/gpu_profiler.h"
 #include "../../include/vkdl/core/render_states.h"
 #include "../../include/vkdl/core/builtin_objects.h"
 #include "../../include/vkdl/system/window_event.h"
@@ -20,7 +22,8 @@ struct WindowFrame {
 
 	vk::Fence fence;
 
-	RenderStates states;
+	RenderStates  states;
+	GpuQueryFrame queries;
 };
 
 struct FrameSemaphore {
@@ -46,6 +49,7 @@ struct PlatformWindowBase
 		surface(nullptr),
 		swapchain(nullptr),
 		present_queue_family_idx(~0),
+		render_pass(Context::invalid_handle),
 		present_mode(vk::PresentModeKHR::eFifo),
 		image_format(vk::Format::eR8G8B8A8Unorm),
 		clear_color(0, 0, 0, 255),
@@ -76,6 +80,7 @@ struct PlatformWindowBase
 	vk::SurfaceKHR                    surface;
 	vk::SwapchainKHR                  swapchain;
 	uint32_t                          present_queue_family_idx;
+	RenderPassHandle                  render_pass;
 	vk::SurfaceCapabilitiesKHR        capabilities;
 	std::vector<vk::SurfaceFormatKHR> formats;
 	std::vector<vk::PresentModeKHR>   present_modes;
@@ -87,6 +92,8 @@ struct PlatformWindowBase
 	std::vector<FrameSemaphore> semaphores;
 	std::queue<WindowEvent>     events;
 
+	std::vector<ReadbackQueue::Callback> captures; // Recorded with the next displayed frame
+
 	uint32_t frame_idx;
 	uint32_t semaphore_idx;
 
@@ -114,7 +121,7 @@ struct PlatformWindowBase
 		formats = ctx.physical_device.getSurfaceFormatsKHR(surface);
 		present_modes = ctx.physical_device.getSurfacePresentModesKHR(surface);
 
-		registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID);
+		render_pass = registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID);
 		recreate_swapchain();
 	}
 
@@ -166,7 +173,7 @@ struct PlatformWindowBase
 			vk::ColorSpaceKHR::eSrgbNonlinear,
 			get_swapchain_extent(),
 			1,
-			vk::ImageUsageFlagBits::eColorAttachment,
+			vk::ImageUsageFlagBits::eColorAttachment | (capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc),
 			{}, {}, {},
 			vk::SurfaceTransformFlagBitsKHR::eIdentity,
 			vk::CompositeAlphaFlagBitsKHR::eOpaque,
@@ -275,7 +282,7 @@ struct PlatformWindowBase
 
 			vk::FramebufferCreateInfo frame_buffer_info = {
 				{},
-				ctx.render_passes[VKDL_BUILTIN_RENDERPASS0_UUID]->get(),
+				ctx.getRenderpass(render_pass).get(),
 				1, &image_view,
 				capabilities.currentExtent.width,
 				capabilities.currentExtent.height,
@@ -305,6 +312,9 @@ struct PlatformWindowBase
 			frame.cmd_buffer = device.allocateCommandBuffers(command_buffer_info).front();
 			frame.fence = device.createFence(fence_info);
 
+			if (ctx.gpu_profiler)
+				ctx.gpu_profiler->createFrame(frame.queries);
+
 			frames.push_back(frame);
 		}
 	}
@@ -329,12 +339,18 @@ struct PlatformWindowBase
 	{
 		auto& device = Context::get().device;
 
+		// Callers wait idle first, so every pending readback is delivered before its fence goes away
+		Context::get().readback_queue->collect();
+
 		for (auto& frame : frames) {
 			device.destroy(frame.image_view);
 			device.destroy(frame.frame_buffer);
 			device.freeCommandBuffers(frame.cmd_pool, 1, &frame.cmd_buffer);
 			device.destroy(frame.cmd_pool);
 			device.destroy(frame.fence);
+
+			if (Context::get().gpu_profiler)
+				Context::get().gpu_profiler->destroyFrame(frame.queries);
 		}
 
 		frames.clear();
@@ -284,6 +284,8 @@ void PlatformWindow::create(uint32_t width, uint32_t height, const char* title,
 
 void PlatformWindow::create(uint32_t width, uint32_t height, const char* title, PlatformWindow* parent, PlatformWindowStyleFlags style)
 {
+	VKDL_CHECK_MSG(!Context::get().headless, "A headless context cannot present, render to a RenderTexture instead");
+
 	impl = std::make_unique<VKDL_PRIV_NAMESPACE_NAME::PlatformWindowImpl>();
 
 	impl->platform_window = this;
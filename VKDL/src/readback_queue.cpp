@@ -0,0 +1,282 @@
+#include "../include/vkdl/core/readback_queue.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/graphics/texture.h"
+
+#include <cstring>
+#include <utility>
+
+static bool is_bgra8(vk::Format format)
+{
+	return format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb;
+}
+
+static bool is_rgba8(vk::Format format)
+{
+	return format == vk::Format::eR8G8B8A8Unorm || format == vk::Format::eR8G8B8A8Srgb;
+}
+
+static void layout_barrier(vk::CommandBuffer cmd, vk::Image image, vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+	vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access)
+{
+	vk::ImageMemoryBarrier barrier = {};
+	barrier.oldLayout           = old_layout;
+	barrier.newLayout           = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image               = image;
+	barrier.subresourceRange    = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+	barrier.srcAccessMask       = src_access;
+	barrier.dstAccessMask       = dst_access;
+
+	cmd.pipelineBarrier(src_stage, dst_stage, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VKDL_BEGIN
+
+ReadbackQueue::ReadbackQueue(uint32_t slot_count) :
+	next_slot(0)
+{
+	VKDL_CHECK(slot_count > 0);
+
+	slots.resize(slot_count);
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+	// Recorded copies may still be running, and their fences may already be gone
+	Context::get().device.waitIdle();
+
+	for (auto& slot : slots)
+		destroySlotBuffer(slot);
+}
+
+VKDL_NODISCARD bool ReadbackQueue::supportsFormat(vk::Format format)
+{
+	return is_rgba8(format) || is_bgra8(format);
+}
+
+std::future<ColorImage> ReadbackQueue::readback(const Texture& texture)
+{
+	auto promise = std::make_shared<std::promise<ColorImage>>();
+	auto future  = promise->get_future();
+
+	readback(texture, [promise](ColorImage&& image) {
+		promise->set_value(std::move(image));
+	});
+
+	return future;
+}
+
+void ReadbackQueue::readback(const Texture& texture, Callback callback)
+{
+	VKDL_CHECK(!texture.is_null());
+	VKDL_CHECK_MSG(supportsFormat(texture.format()), "readback needs an RGBA8 or BGRA8 texture");
+	VKDL_CHECK_MSG(texture.info.image_info.usage & vk::ImageUsageFlagBits::eTransferSrc, "readback needs a texture with transfer source usage");
+	VKDL_CHECK_MSG(texture.layout != vk::ImageLayout::eUndefined, "readback of a texture that was never written");
+
+	std::lock_guard<std::mutex> lock(mutex);
+	requests.push_back({ &texture, std::move(callback) });
+}
+
+void ReadbackQueue::record(vk::CommandBuffer cmd, vk::Image image, vk::Format format, const uvec2& extent, vk::ImageLayout layout, Callback callback)
+{
+	VKDL_CHECK_MSG(supportsFormat(format), "readback needs an RGBA8 or BGRA8 image");
+	VKDL_CHECK(layout != vk::ImageLayout::eUndefined);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto& slot = acquireSlot(static_cast<vk::DeviceSize>(extent.x) * extent.y * 4);
+	slot.busy     = true;
+	slot.fence    = nullptr;
+	slot.format   = format;
+	slot.extent   = extent;
+	slot.callback = std::move(callback);
+
+	if (layout != vk::ImageLayout::eTransferSrcOptimal) {
+		layout_barrier(cmd, image, layout, vk::ImageLayout::eTransferSrcOptimal,
+			vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eMemoryWrite,
+			vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+	}
+
+	vk::BufferImageCopy region = {};
+	region.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+	region.imageExtent      = vk::Extent3D{ extent.x, extent.y, 1 };
+
+	cmd.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer, 1, &region);
+
+	if (layout != vk::ImageLayout::eTransferSrcOptimal) {
+		layout_barrier(cmd, image, vk::ImageLayout::eTransferSrcOptimal, layout,
+			vk::PipelineStageFlagBits::eTransfer, {},
+			vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+	}
+
+	// Makes the copy visible to the host once the fence signals
+	vk::BufferMemoryBarrier host_barrier = {};
+	host_barrier.srcAccessMask       = vk::AccessFlagBits::eTransferWrite;
+	host_barrier.dstAccessMask       = vk::AccessFlagBits::eHostRead;
+	host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	host_barrier.buffer              = slot.buffer;
+	host_barrier.size                = VK_WHOLE_SIZE;
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0, nullptr, 1, &host_barrier, 0, nullptr);
+}
+
+void ReadbackQueue::record(vk::CommandBuffer cmd)
+{
+	std::vector<Request> queued;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.swap(requests);
+	}
+
+	for (auto& request : queued) {
+		const auto& texture = *request.texture;
+		record(cmd, texture.image, texture.format(), texture.extent(), texture.layout, std::move(request.callback));
+	}
+}
+
+void ReadbackQueue::submitted(vk::Fence fence)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto& slot : slots)
+		if (slot.busy && !slot.fence) slot.fence = fence;
+}
+
+void ReadbackQueue::collect()
+{
+	auto& device = Context::get().device;
+
+	std::vector<std::pair<Callback, ColorImage>> finished;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto& slot : slots) {
+			if (!slot.busy || !slot.fence || device.getFenceStatus(slot.fence) != vk::Result::eSuccess)
+				continue;
+
+			ColorImage image(slot.extent.x, slot.extent.y);
+
+			if (!slot.coherent)
+				VK_CHECK(device.invalidateMappedMemoryRanges(vk::MappedMemoryRange{ slot.memory, 0, VK_WHOLE_SIZE }));
+
+			const size_t pixel_count = static_cast<size_t>(slot.extent.x) * slot.extent.y;
+
+			if (is_bgra8(slot.format))
+				ImageKernels::convert(slot.mapped, PixelLayout::BGRA8, image.data(), PixelLayout::RGBA8, pixel_count);
+			else
+				std::memcpy(image.data(), slot.mapped, pixel_count * 4);
+
+			finished.emplace_back(std::move(slot.callback), std::move(image));
+
+			slot.busy     = false;
+			slot.fence    = nullptr;
+			slot.callback = nullptr;
+		}
+	}
+
+	// Outside the lock, callbacks may queue the next readback
+	for (auto& [callback, image] : finished)
+		callback(std::move(image));
+}
+
+VKDL_NODISCARD size_t ReadbackQueue::pendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	size_t count = requests.size();
+	for (const auto& slot : slots)
+		if (slot.busy) count++;
+
+	return count;
+}
+
+ReadbackQueue::Slot& ReadbackQueue::acquireSlot(vk::DeviceSize size)
+{
+	// Round robin, so a slot is reused as late as possible
+	for (size_t i = 0; i < slots.size(); i++) {
+		auto& slot = slots[(next_slot + i) % slots.size()];
+		if (slot.busy) continue;
+
+		next_slot = static_cast<uint32_t>((next_slot + i + 1) % slots.size());
+
+		if (slot.size < size) {
+			destroySlotBuffer(slot);
+			createSlotBuffer(slot, size);
+		}
+
+		return slot;
+	}
+
+	// Every slot is still in flight. Waiting would stall the frame, so the ring
+	// grows instead; it settles at the number of frames the consumer lags behind.
+	auto& slot = slots.emplace_back();
+	createSlotBuffer(slot, size);
+
+	return slot;
+}
+
+void ReadbackQueue::createSlotBuffer(Slot& slot, vk::DeviceSize size) const
+{
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	vk::BufferCreateInfo buffer_info = {};
+	buffer_info.size        = size;
+	buffer_info.usage       = vk::BufferUsageFlagBits::eTransferDst;
+	buffer_info.sharingMode = vk::SharingMode::eExclusive;
+
+	slot.buffer = device.createBuffer(buffer_info);
+	slot.size   = size;
+
+	auto req = device.getBufferMemoryRequirements(slot.buffer);
+
+	// Cached memory makes the host reads fast, coherent saves the invalidate
+	const vk::MemoryPropertyFlags preferred[] = {
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+	};
+
+	const auto& mem_props = ctx.physical_device_memory_props;
+
+	uint32_t                memory_type = UINT32_MAX;
+	vk::MemoryPropertyFlags memory_flags;
+
+	for (const auto& props : preferred) {
+		for (uint32_t i = 0; i < mem_props.memoryTypeCount && memory_type == UINT32_MAX; i++) {
+			if ((req.memoryTypeBits & (1 << i)) && (mem_props.memoryTypes[i].propertyFlags & props) == props) {
+				memory_type  = i;
+				memory_flags = mem_props.memoryTypes[i].propertyFlags;
+			}
+		}
+	}
+
+	VKDL_CHECK_MSG(memory_type != UINT32_MAX, "no host visible memory for readback buffers");
+
+	slot.memory   = device.allocateMemory({ req.size, memory_type });
+	slot.coherent = static_cast<bool>(memory_flags & vk::MemoryPropertyFlagBits::eHostCoherent);
+	device.bindBufferMemory(slot.buffer, slot.memory, 0);
+
+	slot.mapped = static_cast<uint8_t*>(device.mapMemory(slot.memory, 0, VK_WHOLE_SIZE));
+}
+
+void ReadbackQueue::destroySlotBuffer(Slot& slot) const
+{
+	auto& device = Context::get().device;
+
+	if (slot.mapped)
+		device.unmapMemory(slot.memory);
+
+	device.destroy(std::exchange(slot.buffer, nullptr));
+	device.free(std::exchange(slot.memory, nullptr));
+
+	slot.mapped = nullptr;
+	slot.size   = 0;
+}
+
+VKDL_END
\ No newline at end of file
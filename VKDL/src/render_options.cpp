@@ -3,12 +3,14 @@
 VKDL_BEGIN
 
 RenderOptions::RenderOptions() :
-	lazyRendering(false)
+	lazyRendering(false),
+	label(nullptr)
 {
 }
 
 RenderOptions::RenderOptions(const Transform2D& transform) :
 	lazyRendering(false),
+	label(nullptr),
 	transform(transform)
 {
 }
@@ -4,6 +4,9 @@
 #include "../include/vkdl/core/render_target.h"
 #include "../include/vkdl/core/render_options.h"
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/cpu_profiler.h"
+
+#include <chrono>
 
 template <class T>
 static bool check_update(T& val, const std::optional<T>& new_val)
@@ -23,14 +26,24 @@ static bool check_update(T& val, const T& new_val)
 
 VKDL_BEGIN
 
+void RenderStates::updateRenderPass(RenderPassHandle handle)
+{
+	renderpass.update_value(&Context::get().getRenderpass(handle));
+}
+
+void RenderStates::updatePipeline(PipelineHandle handle)
+{
+	pipeline.update_value(&Context::get().getPipeline(handle));
+}
+
 void RenderStates::updateRenderPassUUID(const UUID& uuid)
 {
-	renderpass_uuid.update_value(uuid);
+	renderpass.update_value(&Context::get().getRenderpass(uuid));
 }
 
 void RenderStates::updatePipelineUUID(const UUID& uuid)
 {
-	pipeline_uuid.update_value(uuid);
+	pipeline.update_value(&Context::get().getPipeline(uuid));
 }
 
 void RenderStates::updateViewport(const vk::Viewport& viewport)
@@ -47,44 +60,81 @@ void RenderStates::reset(const RenderTarget& target)
 {
 	auto fb_size = target.getFrameBufferSize();
 
-	renderpass_uuid.reset();
-	pipeline_uuid.reset();
+	renderpass.reset();
+	pipeline.reset();
 	viewport.reset({ 0.f, 0.f, (float)fb_size.x, (float)fb_size.y, 0.f, 0.f });
 	scissor.reset({ { 0, 0 }, { fb_size.x, fb_size.y } });
+
+	renderpass_begun = false;
 }
 
 void RenderStates::bind(RenderTarget& target, const RenderOptions& options)
 {
+	VKDL_PROFILE_ZONE("RenderStates::bind");
+
 	auto& ctx = Context::get();
 	auto cmd  = target.getCommandBuffer();
 
-	if (renderpass_uuid.check_and_update()) {
-		auto fb_size = target.getFrameBufferSize();
+	const bool renderpass_changed = renderpass.check_and_update();
+	const bool pipeline_changed   = pipeline.check_and_update();
+	const bool viewport_changed   = viewport.check_and_update(options.viewport);
+	const bool scissor_changed    = scissor.check_and_update(options.scissor);
 
-		vk::ClearValue clear_value = {};
-		clear_value.color = target.getClearColorValue();
+	VKDL_PROFILE_COUNT(SkippedBinds, !renderpass_changed + !pipeline_changed + !viewport_changed + !scissor_changed);
 
-		vk::RenderPassBeginInfo image_info = {};
-		image_info.renderPass      = ctx.getRenderpass(renderpass_uuid.value);
-		image_info.framebuffer     = target.getFrameBuffer();
-		image_info.renderArea      = vk::Rect2D({ 0, 0 }, { fb_size.x, fb_size.y });
-		image_info.clearValueCount = 1;
-		image_info.pClearValues    = &clear_value;
-
-		cmd.beginRenderPass(image_info, vk::SubpassContents::eInline);
+	if (renderpass_changed && renderpass.value && !renderpass_begun) {
+		beginRenderPass(target);
 	}
 
-	if (pipeline_uuid.check_and_update()) {
-		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, ctx.getPipeline(pipeline_uuid.value));
+	if (pipeline_changed && pipeline.value) {
+		// Only the first draw with a pipeline still compiling blocks on it
+		if (!pipeline.value->isReady()) {
+			auto start  = std::chrono::steady_clock::now();
+			auto handle = pipeline.value->get();
+			ctx.recordPipelineWait(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+			cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, handle);
+		} else {
+			cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.value);
+		}
 	}
 
-	if (viewport.check_and_update(options.viewport)) {
+	if (viewport_changed) {
 		cmd.setViewport(0, 1, &viewport.value);
 	}
 
-	if (scissor.check_and_update(options.scissor)) {
+	if (scissor_changed) {
 		cmd.setScissor(0, 1, &scissor.value);
 	}
 }
 
+void RenderStates::endRenderPass(RenderTarget& target)
+{
+	if (!renderpass_begun)
+		beginRenderPass(target);
+
+	target.getCommandBuffer().endRenderPass();
+
+	renderpass_begun = false;
+}
+
+void RenderStates::beginRenderPass(RenderTarget& target)
+{
+	auto fb_size = target.getFrameBufferSize();
+
+	vk::ClearValue clear_value = {};
+	clear_value.color = target.getClearColorValue();
+
+	vk::RenderPassBeginInfo image_info = {};
+	image_info.renderPass      = target.getRenderPass();
+	image_info.framebuffer     = target.getFrameBuffer();
+	image_info.renderArea      = vk::Rect2D({ 0, 0 }, { fb_size.x, fb_size.y });
+	image_info.clearValueCount = 1;
+	image_info.pClearValues    = &clear_value;
+
+	target.getCommandBuffer().beginRenderPass(image_info, vk::SubpassContents::eInline);
+
+	renderpass_begun = true;
+}
+
 VKDL_END
@@ -0,0 +1,353 @@
+#include "../include/vkdl/graphics/render_texture.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/drawable.h"
+#include "../include/vkdl/core/upload_service.h"
+#include "../include/vkdl/core/builtin_objects.h"
+
+// One fence per submission, shared by every target of the batch and destroyed with the
+// last frame still referring to it. Frames only drop it after collecting its readbacks.
+static std::shared_ptr<vk::Fence> create_shared_fence()
+{
+	auto& device = VKDL_NAMESPACE_NAME::Context::get().device;
+
+	return std::shared_ptr<vk::Fence>(new vk::Fence(device.createFence({})), [](vk::Fence* fence) {
+		VKDL_NAMESPACE_NAME::Context::get().device.destroy(*fence);
+		delete fence;
+	});
+}
+
+VKDL_BEGIN
+
+RenderTexture::RenderTexture() :
+	cmd_pool(nullptr),
+	render_pass(Context::invalid_handle),
+	size(0, 0),
+	clear_color(0.f, 0.f, 0.f, 1.f),
+	frame_idx(0),
+	render_begin(false)
+{
+}
+
+RenderTexture::RenderTexture(uint32_t width, uint32_t height, uint32_t frames_in_flight) :
+	RenderTexture()
+{
+	create(width, height, frames_in_flight);
+}
+
+RenderTexture::~RenderTexture()
+{
+	destroy();
+}
+
+void RenderTexture::create(uint32_t width, uint32_t height, uint32_t frames_in_flight)
+{
+	VKDL_CHECK(width > 0 && height > 0);
+	VKDL_CHECK(frames_in_flight > 0);
+
+	destroy();
+
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	render_pass = registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS1_UUID);
+	size        = { width, height };
+
+	cmd_pool = device.createCommandPool({
+		vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		ctx.graphics_queue_family_idx
+	});
+
+	auto cmd_buffers = device.allocateCommandBuffers({ cmd_pool, vk::CommandBufferLevel::ePrimary, frames_in_flight });
+
+	frames.resize(frames_in_flight);
+
+	for (uint32_t i = 0; i < frames_in_flight; ++i)
+		createFrame(frames[i], cmd_buffers[i]);
+
+	frame_idx = 0;
+}
+
+void RenderTexture::destroy()
+{
+	if (is_null()) return;
+
+	auto& device = Context::get().device;
+
+	// A frame still recording is dropped, its command buffer is freed with the pool
+	render_begin = false;
+	captures.clear();
+
+	wait();
+
+	for (auto& frame : frames)
+		destroyFrame(frame);
+
+	frames.clear();
+
+	device.destroy(std::exchange(cmd_pool, nullptr));
+}
+
+void RenderTexture::render(const Drawable& drawable, const RenderOptions& options)
+{
+	VKDL_CHECK_MSG(!is_null(), "RenderTexture was not created");
+
+	if (!render_begin)
+		beginFrame();
+
+	auto& frame    = frames[frame_idx];
+	auto& profiler = Context::get().gpu_profiler;
+
+	if (profiler)
+		profiler->beginScope(frame.cmd_buffer, frame.queries, GpuProfiler::drawableLabel(drawable, options));
+
+	drawable.draw(*this, frame.states, options);
+
+	if (profiler)
+		profiler->endScope(frame.cmd_buffer, frame.queries);
+}
+
+void RenderTexture::display()
+{
+	RenderTexture* target = this;
+	display(&target, 1);
+}
+
+void RenderTexture::clear(const Color& color)
+{
+	clear_color.float32[0] = (float)color.r / 255.f;
+	clear_color.float32[1] = (float)color.g / 255.f;
+	clear_color.float32[2] = (float)color.b / 255.f;
+	clear_color.float32[3] = (float)color.a / 255.f;
+}
+
+void RenderTexture::display(RenderTexture* const* targets, size_t count)
+{
+	auto& ctx = Context::get();
+
+	std::vector<RenderTexture*>    submitted;
+	std::vector<vk::CommandBuffer> cmd_buffers;
+
+	submitted.reserve(count);
+	cmd_buffers.reserve(count);
+
+	// endFrame clears render_begin, a target listed twice is submitted once
+	for (size_t i = 0; i < count; ++i) {
+		if (!targets[i]->render_begin) continue;
+
+		cmd_buffers.push_back(targets[i]->endFrame());
+		submitted.push_back(targets[i]);
+	}
+
+	if (cmd_buffers.empty()) return;
+
+	auto fence = create_shared_fence();
+
+	vk::SubmitInfo submit_info = {};
+	submit_info.commandBufferCount = static_cast<uint32_t>(cmd_buffers.size());
+	submit_info.pCommandBuffers    = cmd_buffers.data();
+
+	ctx.submit(QueueType::Graphics, 1, &submit_info, *fence);
+	ctx.readback_queue->submitted(*fence);
+
+	for (auto* target : submitted) {
+		target->frames[target->frame_idx].fence = fence;
+		target->frame_idx = (target->frame_idx + 1) % static_cast<uint32_t>(target->frames.size());
+	}
+
+	ctx.endFrame();
+}
+
+std::future<ColorImage> RenderTexture::capture()
+{
+	auto promise = std::make_shared<std::promise<ColorImage>>();
+	auto future  = promise->get_future();
+
+	capture([promise](ColorImage&& image) {
+		promise->set_value(std::move(image));
+	});
+
+	return future;
+}
+
+void RenderTexture::capture(std::function<void(ColorImage&&)> callback)
+{
+	VKDL_CHECK_MSG(!is_null(), "RenderTexture was not created");
+
+	captures.push_back(std::move(callback));
+}
+
+void RenderTexture::wait()
+{
+	auto& ctx = Context::get();
+
+	for (auto& frame : frames) {
+		if (frame.fence)
+			VK_CHECK(ctx.device.waitForFences(1, frame.fence.get(), true, UINT64_MAX));
+	}
+
+	ctx.readback_queue->collect();
+
+	for (auto& frame : frames)
+		frame.fence.reset();
+}
+
+uvec2 RenderTexture::getSize() const
+{
+	return size;
+}
+
+uint32_t RenderTexture::getFramesInFlight() const
+{
+	return static_cast<uint32_t>(frames.size());
+}
+
+Color RenderTexture::getClearColor() const
+{
+	Color color;
+	color.r = (uint8_t)(clear_color.float32[0] * 255.99f);
+	color.g = (uint8_t)(clear_color.float32[1] * 255.99f);
+	color.b = (uint8_t)(clear_color.float32[2] * 255.99f);
+	color.a = (uint8_t)(clear_color.float32[3] * 255.99f);
+
+	return color;
+}
+
+bool RenderTexture::is_null() const
+{
+	return frames.empty();
+}
+
+vk::CommandBuffer RenderTexture::getCommandBuffer()
+{
+	return frames[frame_idx].cmd_buffer;
+}
+
+vk::Framebuffer RenderTexture::getFrameBuffer()
+{
+	return frames[frame_idx].frame_buffer;
+}
+
+vk::RenderPass RenderTexture::getRenderPass()
+{
+	return Context::get().getRenderpass(render_pass).get();
+}
+
+uvec2 RenderTexture::getFrameBufferSize() const
+{
+	return size;
+}
+
+vk::ClearColorValue RenderTexture::getClearColorValue() const
+{
+	return clear_color;
+}
+
+void RenderTexture::beginFrame()
+{
+	auto& ctx   = Context::get();
+	auto& frame = frames[frame_idx];
+
+	// Only this frame's last submission has to finish, the other frames keep rendering
+	if (frame.fence) {
+		VK_CHECK(ctx.device.waitForFences(1, frame.fence.get(), true, UINT64_MAX));
+		ctx.readback_queue->collect();
+		frame.fence.reset();
+	}
+
+	ctx.upload_service->flush();
+
+	frame.cmd_buffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+	if (ctx.gpu_profiler)
+		ctx.gpu_profiler->beginFrame(frame.cmd_buffer, frame.queries, "RenderTexture");
+
+	frame.states.reset(*this);
+
+	render_begin = true;
+}
+
+vk::CommandBuffer RenderTexture::endFrame()
+{
+	auto& ctx   = Context::get();
+	auto& frame = frames[frame_idx];
+	auto  cmd   = frame.cmd_buffer;
+
+	frame.states.endRenderPass(*this);
+
+	// The render pass leaves the image in transfer source layout
+	for (auto& callback : captures)
+		ctx.readback_queue->record(cmd, frame.image, vk::Format::eR8G8B8A8Unorm, size, vk::ImageLayout::eTransferSrcOptimal, std::move(callback));
+	captures.clear();
+
+	ctx.readback_queue->record(cmd);
+
+	if (ctx.gpu_profiler)
+		ctx.gpu_profiler->endFrame(cmd, frame.queries);
+
+	cmd.end();
+
+	render_begin = false;
+
+	return cmd;
+}
+
+void RenderTexture::createFrame(Frame& frame, vk::CommandBuffer cmd_buffer)
+{
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	vk::ImageCreateInfo image_info = {};
+	image_info.imageType     = vk::ImageType::e2D;
+	image_info.format        = vk::Format::eR8G8B8A8Unorm;
+	image_info.extent        = vk::Extent3D{ size.x, size.y, 1 };
+	image_info.mipLevels     = 1;
+	image_info.arrayLayers   = 1;
+	image_info.samples       = vk::SampleCountFlagBits::e1;
+	image_info.tiling        = vk::ImageTiling::eOptimal;
+	image_info.usage         = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+	image_info.sharingMode   = vk::SharingMode::eExclusive;
+	image_info.initialLayout = vk::ImageLayout::eUndefined;
+
+	frame.image      = device.createImage(image_info);
+	frame.allocation = ctx.memory_allocator->allocate(frame.image, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Texture);
+
+	vk::ImageViewCreateInfo image_view_info = {};
+	image_view_info.image            = frame.image;
+	image_view_info.viewType         = vk::ImageViewType::e2D;
+	image_view_info.format           = image_info.format;
+	image_view_info.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+	frame.image_view = device.createImageView(image_view_info);
+
+	vk::FramebufferCreateInfo frame_buffer_info = {
+		{},
+		ctx.getRenderpass(render_pass).get(),
+		1, &frame.image_view,
+		size.x,
+		size.y,
+		1,
+	};
+
+	frame.frame_buffer = device.createFramebuffer(frame_buffer_info);
+	frame.cmd_buffer   = cmd_buffer;
+
+	if (ctx.gpu_profiler)
+		ctx.gpu_profiler->createFrame(frame.queries);
+}
+
+void RenderTexture::destroyFrame(Frame& frame)
+{
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	device.destroy(frame.frame_buffer);
+	device.destroy(frame.image_view);
+	device.destroy(frame.image);
+	ctx.memory_allocator->free(frame.allocation);
+
+	if (ctx.gpu_profiler)
+		ctx.gpu_profiler->destroyFrame(frame.queries);
+}
+
+VKDL_END
\ No newline at end of file
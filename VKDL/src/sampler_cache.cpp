@@ -0,0 +1,108 @@
+#include "../include/vkdl/core/sampler_cache.h"
+
+#include "../include/vkdl/core/context.h"
+
+#include <functional>
+
+template <class T>
+static void hash_combine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// 0.0f and -0.0f compare equal, so they must hash equal too
+static float normalize_zero(float value)
+{
+	return value == 0.0f ? 0.0f : value;
+}
+
+VKDL_BEGIN
+
+size_t SamplerInfoHash::operator()(const vk::SamplerCreateInfo& info) const
+{
+	size_t seed = 0;
+	hash_combine(seed, static_cast<VkSamplerCreateFlags>(info.flags));
+	hash_combine(seed, static_cast<int>(info.magFilter));
+	hash_combine(seed, static_cast<int>(info.minFilter));
+	hash_combine(seed, static_cast<int>(info.mipmapMode));
+	hash_combine(seed, static_cast<int>(info.addressModeU));
+	hash_combine(seed, static_cast<int>(info.addressModeV));
+	hash_combine(seed, static_cast<int>(info.addressModeW));
+	hash_combine(seed, normalize_zero(info.mipLodBias));
+	hash_combine(seed, info.anisotropyEnable);
+	hash_combine(seed, normalize_zero(info.maxAnisotropy));
+	hash_combine(seed, info.compareEnable);
+	hash_combine(seed, static_cast<int>(info.compareOp));
+	hash_combine(seed, normalize_zero(info.minLod));
+	hash_combine(seed, normalize_zero(info.maxLod));
+	hash_combine(seed, static_cast<int>(info.borderColor));
+	hash_combine(seed, info.unnormalizedCoordinates);
+	return seed;
+}
+
+SamplerCache::SamplerCache() :
+	mutex(),
+	lookup(),
+	entries()
+{
+}
+
+SamplerCache::~SamplerCache()
+{
+	auto& device = Context::get().device;
+
+	for (auto& [sampler, entry] : entries)
+		device.destroy(sampler);
+}
+
+VKDL_NODISCARD vk::Sampler SamplerCache::acquire(const vk::SamplerCreateInfo& info)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Extension structs may point at caller owned memory, there is nothing to compare them by
+	const bool shared = info.pNext == nullptr;
+
+	if (shared) {
+		auto iter = lookup.find(info);
+		if (iter != lookup.end()) {
+			entries[iter->second].ref_count++;
+			return iter->second;
+		}
+	}
+
+	vk::Sampler sampler = Context::get().device.createSampler(info);
+
+	entries.emplace(sampler, Entry{ info, 1, shared });
+	if (shared) lookup.emplace(info, sampler);
+
+	return sampler;
+}
+
+void SamplerCache::release(vk::Sampler sampler)
+{
+	if (!sampler) return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto iter = entries.find(sampler);
+		VKDL_CHECK_MSG(iter != entries.end(), "Sampler was not acquired from the cache");
+
+		if (--iter->second.ref_count > 0) return;
+
+		if (iter->second.shared) lookup.erase(iter->second.info);
+		entries.erase(iter);
+	}
+
+	// Descriptor sets of frames in flight may still use it
+	auto& ctx = Context::get();
+	ctx.retire([device = ctx.device, sampler]() { device.destroy(sampler); });
+}
+
+VKDL_NODISCARD size_t SamplerCache::samplerCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+VKDL_END
\ No newline at end of file
@@ -1,23 +1,56 @@
 #include "../include/vkdl/core/shader_module.h"
 
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/util/file_io.h"
+
+#include <cstring>
+#include <unordered_map>
 
 VKDL_BEGIN
 
-ShaderModule::ShaderModule(vk::ShaderModule module) :
+// Live modules by hash of their SPIR-V, hits are compared byte for byte
+static std::mutex                                                     registry_mutex;
+static std::unordered_multimap<uint64_t, std::weak_ptr<ShaderModule>> registry;
+
+ShaderModule::ShaderModule(vk::ShaderModule module, const uint32_t* code, size_t size_in_byte) :
+	stages(),
+	names(),
+	code(code, code + size_in_byte / sizeof(uint32_t)),
+	mutex(),
 	module(module)
 {
 }
 
 std::shared_ptr<ShaderModule> ShaderModule::loadFromMemory(const uint32_t* code, size_t size_in_byte)
 {
+	VKDL_CHECK(code && size_in_byte % sizeof(uint32_t) == 0);
+
+	const uint64_t hash = hashFNV1a(code, size_in_byte);
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	for (auto [it, end] = registry.equal_range(hash); it != end;) {
+		auto shared = it->second.lock();
+
+		if (!shared) {
+			it = registry.erase(it);
+		} else if (shared->matches(code, size_in_byte)) {
+			return shared;
+		} else {
+			++it;
+		}
+	}
+
 	auto& device = Context::get().device;
 
 	vk::ShaderModuleCreateInfo image_info = {};
 	image_info.codeSize = size_in_byte;
 	image_info.pCode    = code;
 
-	return std::shared_ptr<ShaderModule>(new ShaderModule(device.createShaderModule(image_info)));
+	auto shared = std::shared_ptr<ShaderModule>(new ShaderModule(device.createShaderModule(image_info), code, size_in_byte));
+	registry.emplace(hash, shared);
+
+	return shared;
 }
 
 ShaderModule::~ShaderModule()
@@ -28,7 +61,12 @@ ShaderModule::~ShaderModule()
 
 vk::PipelineShaderStageCreateInfo ShaderModule::makeShaderStageCreateInfo(vk::ShaderStageFlagBits stage, const char* name)
 {
-	VKDL_CHECK_MSG(stages.find(stage) == stages.end(), "Cannot create shader stage with duplicate stage");
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (auto found = stages.find(stage); found != stages.end()) {
+		VKDL_CHECK_MSG(std::strcmp(found->second.pName, name) == 0, "Cannot create shader stage with duplicate stage");
+		return found->second;
+	}
 
 	auto& name_str = names.emplace_back(name);
 
@@ -42,7 +80,14 @@ vk::PipelineShaderStageCreateInfo ShaderModule::makeShaderStageCreateInfo(vk::Sh
 
 vk::PipelineShaderStageCreateInfo ShaderModule::operator[](vk::ShaderStageFlagBits stage) const
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	return stages.find(stage)->second;
 }
 
+VKDL_NODISCARD bool ShaderModule::matches(const uint32_t* code, size_t size_in_byte) const
+{
+	return this->code.size() * sizeof(uint32_t) == size_in_byte
+		&& std::memcmp(this->code.data(), code, size_in_byte) == 0;
+}
+
 VKDL_END
@@ -0,0 +1,554 @@
+#include "../include/vkdl/graphics/software_rasterizer.h"
+
+#include "../include/vkdl/graphics/drawlist_2d.h"
+#include "../include/vkdl/graphics/texture.h"
+#include "../include/vkdl/util/thread_pool.h"
+#include "../include/vkdl/core/exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define RASTER_SSE2
+#  include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#  define RASTER_NEON
+#  include <arm_neon.h>
+#endif
+
+// Positions are snapped to 1/256 pixel like the GPU does. Edge functions of snapped
+// positions at pixel centers are exact in double precision, so shared edges are
+// never drawn twice or skipped.
+#define SUBPIXEL_STEPS 256.0
+#define EDGE_EPSILON   (1.0 / (SUBPIXEL_STEPS * SUBPIXEL_STEPS))
+#define NO_SAMPLER     (~0u)
+
+struct ScreenVertex
+{
+	float x, y;       // Pixels, snapped
+	float u, v;       // Normalized texture coordinates
+	float r, g, b, a;
+};
+
+struct RasterSampler
+{
+	const VKDL_NAMESPACE_NAME::Color* texels;
+	int32_t                           width;
+	int32_t                           height;
+	bool                              linear;
+	vk::SamplerAddressMode            mode_u;
+	vk::SamplerAddressMode            mode_v;
+};
+
+// Edge i is opposite to vertex i, e_i(x, y) = a[i] * x + b[i] * y + c[i]. Inside a
+// triangle every e_i >= bias[i], and e_i / area is the weight of vertex i.
+struct RasterTriangle
+{
+	uint32_t v[3];
+	uint32_t sampler;
+	int32_t  min_x, min_y, max_x, max_y; // Covered pixels within the scissor, max exclusive
+
+	double   a[3];
+	double   b[3];
+	double   c[3];
+	double   bias[3]; // 0 on top and left edges, which own the pixels centered on them
+	double   inv_area;
+};
+
+static uint8_t to_unorm(float value)
+{
+	return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+}
+
+// Texel index after the address mode, -1 for border texels
+static int32_t address_texel(int32_t i, int32_t size, vk::SamplerAddressMode mode)
+{
+	switch (mode) {
+	case vk::SamplerAddressMode::eRepeat:
+		i %= size;
+		return i < 0 ? i + size : i;
+
+	case vk::SamplerAddressMode::eMirroredRepeat: {
+		const int32_t period = size * 2;
+		i %= period;
+		if (i < 0) i += period;
+		return i < size ? i : period - 1 - i;
+	}
+
+	case vk::SamplerAddressMode::eClampToBorder:
+		return i < 0 || i >= size ? -1 : i;
+
+	default:
+		return std::clamp(i, 0, size - 1);
+	}
+}
+
+// Border texels are transparent black
+static void fetch_texel(const RasterSampler& sampler, int32_t x, int32_t y, float* out)
+{
+	x = address_texel(x, sampler.width, sampler.mode_u);
+	y = address_texel(y, sampler.height, sampler.mode_v);
+
+	if (x < 0 || y < 0) {
+		out[0] = out[1] = out[2] = out[3] = 0.f;
+		return;
+	}
+
+	const auto& texel = sampler.texels[static_cast<size_t>(y) * sampler.width + x];
+
+	out[0] = texel.r / 255.f;
+	out[1] = texel.g / 255.f;
+	out[2] = texel.b / 255.f;
+	out[3] = texel.a / 255.f;
+}
+
+static void sample_texture(const RasterSampler& sampler, float u, float v, float* out)
+{
+	const float x = u * sampler.width;
+	const float y = v * sampler.height;
+
+	if (!sampler.linear) {
+		fetch_texel(sampler, static_cast<int32_t>(std::floor(x)), static_cast<int32_t>(std::floor(y)), out);
+		return;
+	}
+
+	const float   fx = x - 0.5f;
+	const float   fy = y - 0.5f;
+	const int32_t x0 = static_cast<int32_t>(std::floor(fx));
+	const int32_t y0 = static_cast<int32_t>(std::floor(fy));
+	const float   tx = fx - x0;
+	const float   ty = fy - y0;
+
+	float t00[4], t10[4], t01[4], t11[4];
+	fetch_texel(sampler, x0,     y0,     t00);
+	fetch_texel(sampler, x0 + 1, y0,     t10);
+	fetch_texel(sampler, x0,     y0 + 1, t01);
+	fetch_texel(sampler, x0 + 1, y0 + 1, t11);
+
+	for (int i = 0; i < 4; ++i) {
+		const float top    = t00[i] + (t10[i] - t00[i]) * tx;
+		const float bottom = t01[i] + (t11[i] - t01[i]) * tx;
+		out[i] = top + (bottom - top) * ty;
+	}
+}
+
+// Fragment shader and blend state of the builtin pipelines
+static void shade_pixel(const RasterTriangle& tri, const ScreenVertex* vertices, const RasterSampler* samplers,
+	double e0, double e1, double e2, VKDL_NAMESPACE_NAME::Color& dst)
+{
+	const float w0 = static_cast<float>(e0 * tri.inv_area);
+	const float w1 = static_cast<float>(e1 * tri.inv_area);
+	const float w2 = static_cast<float>(e2 * tri.inv_area);
+
+	const auto& v0 = vertices[tri.v[0]];
+	const auto& v1 = vertices[tri.v[1]];
+	const auto& v2 = vertices[tri.v[2]];
+
+	float src[4] = {
+		w0 * v0.r + w1 * v1.r + w2 * v2.r,
+		w0 * v0.g + w1 * v1.g + w2 * v2.g,
+		w0 * v0.b + w1 * v1.b + w2 * v2.b,
+		w0 * v0.a + w1 * v1.a + w2 * v2.a
+	};
+
+	if (tri.sampler != NO_SAMPLER) {
+		float texel[4];
+		sample_texture(samplers[tri.sampler],
+			w0 * v0.u + w1 * v1.u + w2 * v2.u,
+			w0 * v0.v + w1 * v1.v + w2 * v2.v,
+			texel);
+
+		for (int i = 0; i < 4; ++i)
+			src[i] *= texel[i];
+	}
+
+	// UNORM attachments clamp the shader output before blending
+	for (auto& channel : src)
+		channel = std::clamp(channel, 0.f, 1.f);
+
+	const float inv_alpha = 1.f - src[3];
+
+	dst.r = to_unorm(src[0] * src[3] + dst.r / 255.f * inv_alpha);
+	dst.g = to_unorm(src[1] * src[3] + dst.g / 255.f * inv_alpha);
+	dst.b = to_unorm(src[2] * src[3] + dst.b / 255.f * inv_alpha);
+	dst.a = to_unorm(src[3] + dst.a / 255.f * inv_alpha);
+}
+
+// Draws the part of `tri` inside the tile [x0, x1) x [y0, y1)
+static void draw_triangle(const RasterTriangle& tri, const ScreenVertex* vertices, const RasterSampler* samplers,
+	VKDL_NAMESPACE_NAME::Color* pixels, int32_t stride, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	const int32_t min_x = std::max(tri.min_x, x0);
+	const int32_t min_y = std::max(tri.min_y, y0);
+	const int32_t max_x = std::min(tri.max_x, x1);
+	const int32_t max_y = std::min(tri.max_y, y1);
+
+	if (min_x >= max_x || min_y >= max_y) return;
+
+	const double px = min_x + 0.5;
+
+	for (int32_t y = min_y; y < max_y; ++y) {
+		const double py  = y + 0.5;
+		auto*        row = pixels + static_cast<size_t>(y) * stride;
+
+		double e[3];
+		for (int i = 0; i < 3; ++i)
+			e[i] = tri.a[i] * px + tri.b[i] * py + tri.c[i];
+
+		int32_t x = min_x;
+
+#if defined(RASTER_SSE2)
+		// Two pixels per step, one per double lane
+		__m128d ev[3], step[3], bias[3];
+		for (int i = 0; i < 3; ++i) {
+			ev[i]   = _mm_setr_pd(e[i], e[i] + tri.a[i]);
+			step[i] = _mm_set1_pd(tri.a[i] * 2.0);
+			bias[i] = _mm_set1_pd(tri.bias[i]);
+		}
+
+		for (; x + 1 < max_x; x += 2) {
+			const __m128d inside = _mm_and_pd(
+				_mm_and_pd(_mm_cmpge_pd(ev[0], bias[0]), _mm_cmpge_pd(ev[1], bias[1])),
+				_mm_cmpge_pd(ev[2], bias[2]));
+
+			const int mask = _mm_movemask_pd(inside);
+
+			if (mask) {
+				alignas(16) double lanes[3][2];
+				for (int i = 0; i < 3; ++i)
+					_mm_store_pd(lanes[i], ev[i]);
+
+				for (int lane = 0; lane < 2; ++lane) {
+					if (mask & (1 << lane))
+						shade_pixel(tri, vertices, samplers, lanes[0][lane], lanes[1][lane], lanes[2][lane], row[x + lane]);
+				}
+			}
+
+			for (int i = 0; i < 3; ++i)
+				ev[i] = _mm_add_pd(ev[i], step[i]);
+		}
+
+		for (int i = 0; i < 3; ++i)
+			e[i] += tri.a[i] * (x - min_x);
+#elif defined(RASTER_NEON)
+		float64x2_t ev[3], step[3], bias[3];
+		for (int i = 0; i < 3; ++i) {
+			const double start[2] = { e[i], e[i] + tri.a[i] };
+			ev[i]   = vld1q_f64(start);
+			step[i] = vdupq_n_f64(tri.a[i] * 2.0);
+			bias[i] = vdupq_n_f64(tri.bias[i]);
+		}
+
+		for (; x + 1 < max_x; x += 2) {
+			const uint64x2_t inside = vandq_u64(
+				vandq_u64(vcgeq_f64(ev[0], bias[0]), vcgeq_f64(ev[1], bias[1])),
+				vcgeq_f64(ev[2], bias[2]));
+
+			if (vgetq_lane_u64(inside, 0) | vgetq_lane_u64(inside, 1)) {
+				double lanes[3][2];
+				for (int i = 0; i < 3; ++i)
+					vst1q_f64(lanes[i], ev[i]);
+
+				if (vgetq_lane_u64(inside, 0))
+					shade_pixel(tri, vertices, samplers, lanes[0][0], lanes[1][0], lanes[2][0], row[x]);
+				if (vgetq_lane_u64(inside, 1))
+					shade_pixel(tri, vertices, samplers, lanes[0][1], lanes[1][1], lanes[2][1], row[x + 1]);
+			}
+
+			for (int i = 0; i < 3; ++i)
+				ev[i] = vaddq_f64(ev[i], step[i]);
+		}
+
+		for (int i = 0; i < 3; ++i)
+			e[i] += tri.a[i] * (x - min_x);
+#endif
+
+		for (; x < max_x; ++x) {
+			if (e[0] >= tri.bias[0] && e[1] >= tri.bias[1] && e[2] >= tri.bias[2])
+				shade_pixel(tri, vertices, samplers, e[0], e[1], e[2], row[x]);
+
+			for (int i = 0; i < 3; ++i)
+				e[i] += tri.a[i];
+		}
+	}
+}
+
+// False for triangles without area or outside the scissor
+static bool setup_triangle(RasterTriangle& tri, const ScreenVertex* vertices, const vk::Rect2D& scissor)
+{
+	double x[3], y[3];
+	for (int i = 0; i < 3; ++i) {
+		x[i] = vertices[tri.v[i]].x;
+		y[i] = vertices[tri.v[i]].y;
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		const int o = (i + 1) % 3;
+		const int q = (i + 2) % 3;
+
+		tri.a[i] = y[o] - y[q];
+		tri.b[i] = x[q] - x[o];
+		tri.c[i] = -(tri.a[i] * x[o] + tri.b[i] * y[o]);
+	}
+
+	double area = tri.a[0] * x[0] + tri.b[0] * y[0] + tri.c[0];
+
+	if (area == 0.0 || !std::isfinite(area)) return false;
+
+	// Nothing is culled, clockwise triangles get their edges flipped
+	if (area < 0.0) {
+		for (int i = 0; i < 3; ++i) {
+			tri.a[i] = -tri.a[i];
+			tri.b[i] = -tri.b[i];
+			tri.c[i] = -tri.c[i];
+		}
+
+		area = -area;
+	}
+
+	// The inside is where e grows, so left edges grow along x and top edges along y
+	for (int i = 0; i < 3; ++i) {
+		const bool top_left = tri.a[i] > 0.0 || (tri.a[i] == 0.0 && tri.b[i] > 0.0);
+		tri.bias[i] = top_left ? 0.0 : EDGE_EPSILON;
+	}
+
+	tri.inv_area = 1.0 / area;
+
+	// Pixels whose centers fall inside the bounds
+	const double scissor_x0 = scissor.offset.x;
+	const double scissor_y0 = scissor.offset.y;
+	const double scissor_x1 = scissor_x0 + scissor.extent.width;
+	const double scissor_y1 = scissor_y0 + scissor.extent.height;
+
+	const double min_x = std::clamp(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5), scissor_x0, scissor_x1);
+	const double min_y = std::clamp(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5), scissor_y0, scissor_y1);
+	const double max_x = std::clamp(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5) + 1.0, scissor_x0, scissor_x1);
+	const double max_y = std::clamp(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5) + 1.0, scissor_y0, scissor_y1);
+
+	tri.min_x = static_cast<int32_t>(min_x);
+	tri.min_y = static_cast<int32_t>(min_y);
+	tri.max_x = static_cast<int32_t>(max_x);
+	tri.max_y = static_cast<int32_t>(max_y);
+
+	return tri.min_x < tri.max_x && tri.min_y < tri.max_y;
+}
+
+static bool is_rgba8(vk::Format format)
+{
+	return format == vk::Format::eR8G8B8A8Unorm || format == vk::Format::eR8G8B8A8Srgb;
+}
+
+static bool is_bgra8(vk::Format format)
+{
+	return format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb;
+}
+
+VKDL_BEGIN
+
+SoftwareRasterizer::SoftwareRasterizer()
+{
+}
+
+void SoftwareRasterizer::setTextureImage(const Texture& texture, ColorImage image)
+{
+	texture_images[&texture] = std::move(image);
+}
+
+void SoftwareRasterizer::clearTextureImages()
+{
+	texture_images.clear();
+}
+
+void SoftwareRasterizer::render(ColorImage& target, const DrawList2D& drawlist)
+{
+	VKDL_CHECK(!target.empty());
+
+	const auto& commands = drawlist.getCommands();
+	const auto& vertices = drawlist.getVertices();
+	const auto& indices  = drawlist.getIndices();
+
+	const int32_t width   = static_cast<int32_t>(target.width());
+	const int32_t height  = static_cast<int32_t>(target.height());
+	const int32_t tile    = static_cast<int32_t>(tile_size);
+	const int32_t tiles_x = (width + tile - 1) / tile;
+	const int32_t tiles_y = (height + tile - 1) / tile;
+
+	const vk::Rect2D target_rect = { { 0, 0 }, { target.width(), target.height() } };
+
+	std::vector<ScreenVertex>                    screen_vertices;
+	std::vector<RasterSampler>                   samplers;
+	std::unordered_map<const Texture*, uint32_t> sampler_indices;
+	std::vector<RasterTriangle>                  triangles;
+	std::vector<std::vector<uint32_t>>           bins(static_cast<size_t>(tiles_x) * tiles_y);
+
+	screen_vertices.reserve(vertices.size());
+	triangles.reserve(indices.size() / 3);
+
+	for (const auto& command : commands) {
+		if (command.index_count == 0) continue;
+
+		uint32_t sampler  = NO_SAMPLER;
+		vec2     uv_scale = vec2(1.f, 1.f);
+
+		if (command.texture) {
+			auto [iter, inserted] = sampler_indices.try_emplace(command.texture, static_cast<uint32_t>(samplers.size()));
+
+			if (inserted) {
+				const auto& image        = textureImage(*command.texture);
+				const auto  sampler_info = command.texture->getTextureInfo().sampler_info;
+
+				samplers.push_back({
+					image.data(),
+					static_cast<int32_t>(image.width()),
+					static_cast<int32_t>(image.height()),
+					sampler_info.magFilter == vk::Filter::eLinear,
+					sampler_info.addressModeU,
+					sampler_info.addressModeV
+				});
+			}
+
+			// Texture coordinates are in texels of the texture, as in the builtin vertex shader
+			sampler  = iter->second;
+			uv_scale = vec2(1.f, 1.f) / vec2(command.texture->extent());
+		}
+
+		// An empty clip rect stands for the whole target, like in DrawList2D::draw
+		vk::Rect2D scissor = target_rect;
+
+		if (command.clip_rect != vk::Rect2D()) {
+			const int32_t x0 = std::max(command.clip_rect.offset.x, 0);
+			const int32_t y0 = std::max(command.clip_rect.offset.y, 0);
+			const int32_t x1 = static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(command.clip_rect.offset.x) + command.clip_rect.extent.width, width));
+			const int32_t y1 = static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(command.clip_rect.offset.y) + command.clip_rect.extent.height, height));
+
+			if (x0 >= x1 || y0 >= y1) continue;
+
+			scissor = { { x0, y0 }, { static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) } };
+		}
+
+		const uint32_t base = static_cast<uint32_t>(screen_vertices.size());
+
+		for (uint32_t i = 0; i < command.vertex_count; ++i) {
+			const auto& vertex = vertices[command.vertex_offset + i];
+			const vec2  pos    = command.transform * vertex.pos;
+
+			ScreenVertex screen;
+			screen.x = static_cast<float>(std::round(pos.x * SUBPIXEL_STEPS) / SUBPIXEL_STEPS);
+			screen.y = static_cast<float>(std::round(pos.y * SUBPIXEL_STEPS) / SUBPIXEL_STEPS);
+			screen.u = vertex.uv.x * uv_scale.x;
+			screen.v = vertex.uv.y * uv_scale.y;
+			screen.r = vertex.col.r / 255.f;
+			screen.g = vertex.col.g / 255.f;
+			screen.b = vertex.col.b / 255.f;
+			screen.a = vertex.col.a / 255.f;
+
+			screen_vertices.push_back(screen);
+		}
+
+		for (uint32_t i = 0; i + 2 < command.index_count; i += 3) {
+			RasterTriangle tri;
+			tri.sampler = sampler;
+
+			for (uint32_t k = 0; k < 3; ++k) {
+				const uint32_t index = indices[command.index_offset + i + k];
+				VKDL_CHECK(index - command.vertex_offset < command.vertex_count);
+				tri.v[k] = base + index - command.vertex_offset;
+			}
+
+			if (!setup_triangle(tri, screen_vertices.data(), scissor)) continue;
+
+			const uint32_t tri_idx = static_cast<uint32_t>(triangles.size());
+			triangles.push_back(tri);
+
+			for (int32_t ty = tri.min_y / tile; ty <= (tri.max_y - 1) / tile; ++ty)
+				for (int32_t tx = tri.min_x / tile; tx <= (tri.max_x - 1) / tile; ++tx)
+					bins[static_cast<size_t>(ty) * tiles_x + tx].push_back(tri_idx);
+		}
+	}
+
+	if (triangles.empty()) return;
+
+	auto* pixels = target.data();
+
+	// Tiles are handed out one at a time, big triangles make their cost very uneven
+	std::atomic<size_t> next_tile = 0;
+
+	auto rasterize_tiles = [&]() {
+		for (size_t bin; (bin = next_tile++) < bins.size();) {
+			if (bins[bin].empty()) continue;
+
+			const int32_t x0 = static_cast<int32_t>(bin % tiles_x) * tile;
+			const int32_t y0 = static_cast<int32_t>(bin / tiles_x) * tile;
+			const int32_t x1 = std::min(x0 + tile, width);
+			const int32_t y1 = std::min(y0 + tile, height);
+
+			for (auto tri_idx : bins[bin])
+				draw_triangle(triangles[tri_idx], screen_vertices.data(), samplers.data(), pixels, width, x0, y0, x1, y1);
+		}
+	};
+
+	auto& pool = ThreadPool::shared();
+
+	const size_t busy_tiles = std::count_if(bins.begin(), bins.end(), [](const auto& bin) { return !bin.empty(); });
+	const size_t helpers    = std::min(pool.threadCount(), busy_tiles) - 1;
+
+	std::vector<std::future<void>> futures;
+	for (size_t i = 0; i < helpers; ++i)
+		futures.push_back(pool.submit(rasterize_tiles));
+
+	// The calling thread rasterizes too instead of idling
+	rasterize_tiles();
+
+	for (auto& future : futures)
+		pool.wait(future);
+}
+
+ColorImage SoftwareRasterizer::render(const DrawList2D& drawlist, const uvec2& size, const Color& clear_color)
+{
+	ColorImage image(clear_color, size.x, size.y);
+	render(image, drawlist);
+	return image;
+}
+
+size_t SoftwareRasterizer::compare(const ColorImage& lhs, const ColorImage& rhs, uint8_t tolerance)
+{
+	if (lhs.width() != rhs.width() || lhs.height() != rhs.height())
+		return std::max(static_cast<size_t>(lhs.width()) * lhs.height(), static_cast<size_t>(rhs.width()) * rhs.height());
+
+	const size_t count = static_cast<size_t>(lhs.width()) * lhs.height();
+	const auto*  a     = lhs.data();
+	const auto*  b     = rhs.data();
+
+	size_t differences = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		if (std::abs(a[i].r - b[i].r) > tolerance ||
+			std::abs(a[i].g - b[i].g) > tolerance ||
+			std::abs(a[i].b - b[i].b) > tolerance ||
+			std::abs(a[i].a - b[i].a) > tolerance)
+			differences++;
+	}
+
+	return differences;
+}
+
+const ColorImage& SoftwareRasterizer::textureImage(const Texture& texture)
+{
+	auto iter = texture_images.find(&texture);
+	if (iter != texture_images.end()) return iter->second;
+
+	const auto format = texture.format();
+	VKDL_CHECK_MSG(is_rgba8(format) || is_bgra8(format), "software rasterizer needs RGBA8 or BGRA8 textures");
+
+	std::vector<uint8_t> pixels(texture.size_in_bytes());
+	texture.readback(pixels.data());
+
+	const auto extent = texture.extent();
+	const auto layout = is_bgra8(format) ? PixelLayout::BGRA8 : PixelLayout::RGBA8;
+
+	return texture_images.emplace(&texture, ColorImage(pixels.data(), layout, extent.x, extent.y)).first->second;
+}
+
+VKDL_END
\ No newline at end of file
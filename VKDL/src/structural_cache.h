@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../include/vkdl/core/config.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstddef>
+
+VKDL_BEGIN
+VKDL_PRIV_BEGIN
+
+template <class T>
+VKDL_INLINE void hashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// Maps a description of an object to the live object built from an equal description.
+// Only weak references are kept, objects die with their last user and their entries
+// are dropped the next time their bucket is searched. Key needs operator== and a
+// hash() member. Thread safe.
+template <class Key, class T>
+class StructuralCache
+{
+	struct Entry
+	{
+		Key              key;
+		std::weak_ptr<T> object;
+	};
+
+public:
+	// `create` runs unlocked, when two threads race for the same key the first insert wins
+	template <class Create>
+	std::shared_ptr<T> getOrCreate(const Key& key, Create&& create)
+	{
+		const size_t hash = key.hash();
+
+		if (auto object = find(hash, key))
+			return object;
+
+		std::shared_ptr<T> object = create();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (auto existing = findLocked(hash, key))
+			return existing;
+
+		entries.emplace(hash, Entry{ key, object });
+		return object;
+	}
+
+private:
+	std::shared_ptr<T> find(size_t hash, const Key& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return findLocked(hash, key);
+	}
+
+	std::shared_ptr<T> findLocked(size_t hash, const Key& key)
+	{
+		auto range = entries.equal_range(hash);
+
+		for (auto iter = range.first; iter != range.second;) {
+			auto object = iter->second.object.lock();
+
+			if (!object) {
+				iter = entries.erase(iter);
+				continue;
+			}
+
+			if (iter->second.key == key)
+				return object;
+
+			++iter;
+		}
+
+		return nullptr;
+	}
+
+	std::unordered_multimap<size_t, Entry> entries;
+	std::mutex                             mutex;
+};
+
+VKDL_PRIV_END
+VKDL_END
\ No newline at end of file
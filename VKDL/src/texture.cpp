@@ -1,6 +1,14 @@
 #include "../include/vkdl/graphics/texture.h"
 
 #include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/cpu_profiler.h"
+#include "../include/vkdl/core/upload_service.h"
+#include "../include/vkdl/core/descriptor_allocator.h"
+#include "../include/vkdl/core/sampler_cache.h"
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cstring>
 
 vk::ImageViewType to_image_view_type(vk::ImageType type) {
 	switch (type) {
@@ -175,15 +183,128 @@ static vk::ImageView create_image_view(const vk::ImageCreateInfo& image_info, vk
 	return device.createImageView(view_info);
 }
 
+static uint32_t mip_level_count(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+
+	for (auto size = std::max(width, height); size > 1; size >>= 1)
+		levels++;
+
+	return levels;
+}
+
+static void mip_barrier(
+	vk::CommandBuffer      cmd,
+	vk::Image              image,
+	uint32_t               base_level,
+	uint32_t               level_count,
+	vk::ImageLayout        old_layout,
+	vk::ImageLayout        new_layout,
+	vk::AccessFlags        src_access,
+	vk::AccessFlags        dst_access,
+	vk::PipelineStageFlags src_stage,
+	vk::PipelineStageFlags dst_stage)
+{
+	vk::ImageMemoryBarrier barrier = {
+		src_access,
+		dst_access,
+		old_layout,
+		new_layout,
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		image,
+		{
+			vk::ImageAspectFlagBits::eColor,
+			base_level, level_count, 0, 1
+		}
+	};
+
+	cmd.pipelineBarrier(
+		src_stage,
+		dst_stage,
+		{},
+		0, nullptr,
+		0, nullptr,
+		1, &barrier);
+}
+
+static bool is_8bit_channel_format(vk::Format format)
+{
+	switch (format) {
+	case vk::Format::eR8Unorm:
+	case vk::Format::eR8Uint:
+	case vk::Format::eR8Srgb:
+	case vk::Format::eR8G8Unorm:
+	case vk::Format::eR8G8Uint:
+	case vk::Format::eR8G8Srgb:
+	case vk::Format::eR8G8B8Unorm:
+	case vk::Format::eR8G8B8Srgb:
+	case vk::Format::eR8G8B8A8Unorm:
+	case vk::Format::eR8G8B8A8Uint:
+	case vk::Format::eR8G8B8A8Srgb:
+	case vk::Format::eB8G8R8A8Unorm:
+	case vk::Format::eB8G8R8A8Srgb:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// A rectangle of one mip level, in texels of that level
+struct MipRegion
+{
+	uint32_t x, y, width, height;
+};
+
+// 2x2 box filter. On a level of odd size the last destination column (row) also takes
+// the last source column (row), a 3 texel box, so no source texel is dropped. `src` and
+// `dst` hold only their region, tightly packed, `src_extent` is the size of the level.
+static void box_downsample(const uint8_t* src, const MipRegion& src_region, uvec2 src_extent, uint8_t* dst, const MipRegion& dst_region, size_t channels)
+{
+	const uvec2 dst_extent = uvec2(std::max(src_extent.x / 2, 1u), std::max(src_extent.y / 2, 1u));
+
+	for (uint32_t y = dst_region.y; y < dst_region.y + dst_region.height; y++) {
+		const uint32_t y_begin = y * 2 - src_region.y;
+		const uint32_t y_end   = (y == dst_extent.y - 1 ? src_extent.y : y * 2 + 2) - src_region.y;
+
+		for (uint32_t x = dst_region.x; x < dst_region.x + dst_region.width; x++) {
+			const uint32_t x_begin = x * 2 - src_region.x;
+			const uint32_t x_end   = (x == dst_extent.x - 1 ? src_extent.x : x * 2 + 2) - src_region.x;
+			const uint32_t count   = (x_end - x_begin) * (y_end - y_begin);
+
+			for (size_t c = 0; c < channels; c++) {
+				uint32_t sum = 0;
+
+				for (uint32_t sy = y_begin; sy < y_end; sy++)
+					for (uint32_t sx = x_begin; sx < x_end; sx++)
+						sum += src[(static_cast<size_t>(sy) * src_region.width + sx) * channels + c];
+
+				const size_t index = (static_cast<size_t>(y - dst_region.y) * dst_region.width + (x - dst_region.x)) * channels + c;
+				dst[index] = static_cast<uint8_t>((sum + count / 2) / count);
+			}
+		}
+	}
+}
+
+// Copies the tightly packed `src` rectangle into `dst`, which holds `dst_region`
+static void copy_region(const uint8_t* src, const MipRegion& src_region, uint8_t* dst, const MipRegion& dst_region, size_t channels)
+{
+	for (uint32_t y = 0; y < src_region.height; y++) {
+		const size_t dst_offset = (static_cast<size_t>(src_region.y - dst_region.y + y) * dst_region.width + (src_region.x - dst_region.x)) * channels;
+		std::memcpy(dst + dst_offset, src + static_cast<size_t>(y) * src_region.width * channels, static_cast<size_t>(src_region.width) * channels);
+	}
+}
+
 VKDL_BEGIN
 
 Texture::Texture(const TextureInfo& info) :
 	info(info),
 	image(nullptr),
 	image_view(nullptr),
-	memory(nullptr),
+	allocation(),
 	sampler(nullptr),
 	desc_set(nullptr),
+	layout(vk::ImageLayout::eUndefined),
 	allocated_size(0),
 	staging_buffer(vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible)
 {
@@ -191,9 +312,9 @@ Texture::Texture(const TextureInfo& info) :
 	auto& device = ctx.device;
 
 	image      = device.createImage(info.image_info);
-	memory     = allocateMemory(image, allocated_size);
+	allocation = allocateMemory(image, allocated_size);
 	image_view = create_image_view(info.image_info, image);
-	sampler    = device.createSampler(info.sampler_info);
+	sampler    = ctx.sampler_cache->acquire(info.sampler_info);
 	desc_set   = createDescriptorSet(sampler, image_view);
 }
 
@@ -201,9 +322,10 @@ Texture::Texture() :
 	info(),
 	image(nullptr),
 	image_view(nullptr),
-	memory(nullptr),
+	allocation(),
 	sampler(nullptr),
 	desc_set(nullptr),
+	layout(vk::ImageLayout::eUndefined),
 	allocated_size(0),
 	staging_buffer(vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible)
 {
@@ -213,12 +335,14 @@ Texture::Texture(Texture&& rhs) :
 	info(std::exchange(rhs.info, {})),
 	image(std::exchange(rhs.image, nullptr)),
 	image_view(std::exchange(rhs.image_view, nullptr)),
-	memory(std::exchange(rhs.memory, nullptr)),
+	allocation(std::exchange(rhs.allocation, {})),
 	sampler(std::exchange(rhs.sampler, nullptr)),
 	desc_set(std::exchange(rhs.desc_set, nullptr)),
+	layout(std::exchange(rhs.layout, vk::ImageLayout::eUndefined)),
 	staging_buffer(std::move(rhs.staging_buffer)),
 	allocated_size(std::exchange(rhs.allocated_size, 0))
 {
+	adoptAllocation();
 }
 
 Texture::~Texture()
@@ -233,12 +357,15 @@ Texture& Texture::operator=(Texture&& rhs)
 	info            = std::exchange(rhs.info, {});
 	image           = std::exchange(rhs.image, nullptr);
 	image_view      = std::exchange(rhs.image_view, nullptr);
-	memory          = std::exchange(rhs.memory, nullptr);
+	allocation      = std::exchange(rhs.allocation, {});
 	sampler         = std::exchange(rhs.sampler, nullptr);
 	desc_set        = std::exchange(rhs.desc_set, nullptr);
+	layout          = std::exchange(rhs.layout, vk::ImageLayout::eUndefined);
 	allocated_size  = std::exchange(rhs.allocated_size, 0);
 	staging_buffer  = std::move(rhs.staging_buffer);
 
+	adoptAllocation();
+
 	return *this;
 }
 
@@ -247,44 +374,296 @@ const vk::DescriptorSet& Texture::getDescriptorSet() const
 	return desc_set;
 }
 
+void Texture::bind(vk::CommandBuffer cmd, vk::PipelineLayout pipeline_layout, uint32_t set) const
+{
+	if (desc_set) {
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, set, 1, &desc_set, 0, nullptr);
+		return;
+	}
+
+	VKDL_CHECK_MSG(info.push_descriptor, "Texture has no descriptor set");
+
+	auto image_info = descriptorImageInfo();
+
+	vk::WriteDescriptorSet write_desc_set = {};
+	write_desc_set.dstBinding      = 0;
+	write_desc_set.dstArrayElement = 0;
+	write_desc_set.descriptorCount = 1;
+	write_desc_set.descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+	write_desc_set.pImageInfo      = &image_info;
+
+	Context::get().pushDescriptorSet(cmd, vk::PipelineBindPoint::eGraphics, pipeline_layout, set, 1, &write_desc_set);
+}
+
 void Texture::update(void* pixels)
 {
 	update(pixels, ivec2(0, 0), extent());
 }
 
-void Texture::update(void* pixels, const ivec2& offset, const uvec2& size)
+void Texture::update(void* pixels, const ivec2& offset, const uvec2& size, uint32_t mip_level)
 {
+	VKDL_CHECK(mip_level < mipLevels());
+	VKDL_PROFILE_ZONE("Texture::update");
+
 	auto& ctx = Context::get();
-	auto  device = ctx.device;
 	auto  transfer_size = size.x * size.y * format_size_in_byte(info.image_info.format);
 
+	VKDL_PROFILE_COUNT(UploadBytes, transfer_size);
+
 	staging_buffer.resize(transfer_size);
 	memcpy(staging_buffer.map(), pixels, transfer_size);
 	staging_buffer.flush();
 
 	auto cmd = ctx.beginSingleTimeCommmand();
 
+	update(cmd, staging_buffer.getBuffer(), 0, offset, size, mip_level);
+
+	ctx.endSingleTimeCommmand(cmd);
+
+	if (info.generate_mips && mip_level == 0 && mipLevels() > 1 && !supportsBlitMips())
+		generateMipsOnCPU(offset, size, pixels);
+}
+
+void Texture::update(vk::CommandBuffer cmd, vk::Buffer buffer, vk::DeviceSize buffer_offset, const ivec2& offset, const uvec2& size, uint32_t mip_level)
+{
+	VKDL_CHECK(mip_level < mipLevels());
+
+	auto& ctx = Context::get();
+
+	// Previous contents only need to survive a partial update, or when other
+	// mip levels hold data that is not regenerated from this one
+	const bool whole_level = offset == ivec2(0, 0) && size == extent(mip_level);
+	const bool discard     = whole_level && (mipLevels() == 1 || (info.generate_mips && mip_level == 0));
+
 	ctx.transitionImageLayout(
 		cmd,
 		image,
 		info.image_info.format,
-		vk::ImageLayout::eUndefined,
+		discard ? vk::ImageLayout::eUndefined : layout,
 		vk::ImageLayout::eTransferDstOptimal);
 
 	vk::BufferImageCopy image_copy = {};
-	image_copy.bufferOffset      = 0;
+	image_copy.bufferOffset      = buffer_offset;
 	image_copy.bufferRowLength   = 0;
 	image_copy.bufferImageHeight = 0;
-	image_copy.imageSubresource  = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, info.image_info.mipLevels - 1, 0, 1 };
+	image_copy.imageSubresource  = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mip_level, 0, 1 };
 	image_copy.imageOffset       = vk::Offset3D{ offset.x, offset.y, 0 };
 	image_copy.imageExtent       = vk::Extent3D{ size.x, size.y, 1 };
 
 	cmd.copyBufferToImage(
-		staging_buffer.getBuffer(),
+		buffer,
+		image,
+		vk::ImageLayout::eTransferDstOptimal,
+		1, &image_copy);
+
+	ctx.transitionImageLayout(
+		cmd,
+		image,
+		info.image_info.format,
+		vk::ImageLayout::eTransferDstOptimal,
+		vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	if (info.generate_mips && mip_level == 0 && mipLevels() > 1 && supportsBlitMips())
+		generateMips(cmd);
+}
+
+void Texture::update(vk::CommandBuffer cmd, vk::Buffer buffer, const vk::BufferImageCopy* regions, uint32_t region_count)
+{
+	auto& ctx = Context::get();
+
+	ctx.transitionImageLayout(
+		cmd,
 		image,
+		info.image_info.format,
+		layout,
+		vk::ImageLayout::eTransferDstOptimal);
+
+	cmd.copyBufferToImage(
+		buffer,
+		image,
+		vk::ImageLayout::eTransferDstOptimal,
+		region_count, regions);
+
+	ctx.transitionImageLayout(
+		cmd,
+		image,
+		info.image_info.format,
 		vk::ImageLayout::eTransferDstOptimal,
+		vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+}
+
+void Texture::generateMips()
+{
+	VKDL_CHECK(!is_null());
+
+	if (mipLevels() == 1) return;
+
+	if (!supportsBlitMips()) {
+		generateMipsOnCPU(ivec2(0, 0), extent());
+		return;
+	}
+
+	auto& ctx = Context::get();
+
+	auto cmd = ctx.beginSingleTimeCommmand();
+	generateMips(cmd);
+	ctx.endSingleTimeCommmand(cmd);
+}
+
+void Texture::generateMips(vk::CommandBuffer cmd)
+{
+	VKDL_CHECK(!is_null());
+	VKDL_CHECK_MSG(supportsBlitMips(), "Texture format does not support linear blits");
+
+	const auto levels = mipLevels();
+
+	if (levels == 1) return;
+
+	const auto old_stage = layout == vk::ImageLayout::eUndefined ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eFragmentShader;
+	const auto old_access = layout == vk::ImageLayout::eUndefined ? vk::AccessFlags() : vk::AccessFlags(vk::AccessFlagBits::eShaderRead);
+
+	// Level 0 becomes the first blit source, the rest is overwritten
+	mip_barrier(cmd, image, 0, 1,
+		layout, vk::ImageLayout::eTransferSrcOptimal,
+		old_access, vk::AccessFlagBits::eTransferRead,
+		old_stage, vk::PipelineStageFlagBits::eTransfer);
+
+	mip_barrier(cmd, image, 1, levels - 1,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		old_access, vk::AccessFlagBits::eTransferWrite,
+		old_stage, vk::PipelineStageFlagBits::eTransfer);
+
+	for (uint32_t level = 1; level < levels; level++) {
+		const auto src_extent = extent(level - 1);
+		const auto dst_extent = extent(level);
+
+		vk::ImageBlit blit = {};
+		blit.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - 1, 0, 1 };
+		blit.srcOffsets[1]  = vk::Offset3D{ static_cast<int32_t>(src_extent.x), static_cast<int32_t>(src_extent.y), 1 };
+		blit.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+		blit.dstOffsets[1]  = vk::Offset3D{ static_cast<int32_t>(dst_extent.x), static_cast<int32_t>(dst_extent.y), 1 };
+
+		cmd.blitImage(
+			image, vk::ImageLayout::eTransferSrcOptimal,
+			image, vk::ImageLayout::eTransferDstOptimal,
+			1, &blit,
+			vk::Filter::eLinear);
+
+		// The level just written is the source of the next one
+		mip_barrier(cmd, image, level, 1,
+			vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer);
+	}
+
+	mip_barrier(cmd, image, 0, levels,
+		vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+		vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+
+	layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+}
+
+std::shared_future<void> Texture::updateAsync(const void* pixels)
+{
+	return updateAsync(pixels, ivec2(0, 0), extent());
+}
+
+std::shared_future<void> Texture::updateAsync(const void* pixels, const ivec2& offset, const uvec2& size)
+{
+	return Context::get().upload_service->uploadTexture(*this, pixels, offset, size);
+}
+
+void Texture::readback(void* pixels) const
+{
+	readback(pixels, ivec2(0, 0), extent());
+}
+
+void Texture::readback(void* pixels, const ivec2& offset, const uvec2& size) const
+{
+	auto& ctx = Context::get();
+
+	const size_t transfer_size = size == extent()
+		? size_in_bytes()
+		: static_cast<size_t>(size.x) * size.y * format_size_in_byte(info.image_info.format);
+
+	Buffer<uint8_t> buffer(
+		transfer_size,
+		vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	auto cmd = ctx.beginSingleTimeCommmand();
+
+	ctx.transitionImageLayout(
+		cmd,
+		image,
+		info.image_info.format,
+		layout,
+		vk::ImageLayout::eTransferSrcOptimal);
+
+	vk::BufferImageCopy image_copy = {};
+	image_copy.bufferOffset      = 0;
+	image_copy.bufferRowLength   = 0;
+	image_copy.bufferImageHeight = 0;
+	image_copy.imageSubresource  = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+	image_copy.imageOffset       = vk::Offset3D{ offset.x, offset.y, 0 };
+	image_copy.imageExtent       = vk::Extent3D{ size.x, size.y, 1 };
+
+	cmd.copyImageToBuffer(
+		image,
+		vk::ImageLayout::eTransferSrcOptimal,
+		buffer.getBuffer(),
 		1, &image_copy);
 
+	ctx.transitionImageLayout(
+		cmd,
+		image,
+		info.image_info.format,
+		vk::ImageLayout::eTransferSrcOptimal,
+		vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	ctx.endSingleTimeCommmand(cmd);
+
+	layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	memcpy(pixels, buffer.map(), transfer_size);
+	buffer.unmap();
+}
+
+void Texture::copy(const Texture& src, const vk::ImageCopy* regions, uint32_t region_count)
+{
+	VKDL_CHECK(!is_null() && !src.is_null());
+	VKDL_CHECK(format() == src.format());
+
+	auto& ctx = Context::get();
+
+	auto cmd = ctx.beginSingleTimeCommmand();
+
+	ctx.transitionImageLayout(
+		cmd,
+		src.image,
+		src.info.image_info.format,
+		src.layout,
+		vk::ImageLayout::eTransferSrcOptimal);
+
+	ctx.transitionImageLayout(
+		cmd,
+		image,
+		info.image_info.format,
+		layout,
+		vk::ImageLayout::eTransferDstOptimal);
+
+	cmd.copyImage(
+		src.image,
+		vk::ImageLayout::eTransferSrcOptimal,
+		image,
+		vk::ImageLayout::eTransferDstOptimal,
+		region_count, regions);
+
 	ctx.transitionImageLayout(
 		cmd,
 		image,
@@ -292,7 +671,17 @@ void Texture::update(void* pixels, const ivec2& offset, const uvec2& size)
 		vk::ImageLayout::eTransferDstOptimal,
 		vk::ImageLayout::eShaderReadOnlyOptimal);
 
+	ctx.transitionImageLayout(
+		cmd,
+		src.image,
+		src.info.image_info.format,
+		vk::ImageLayout::eTransferSrcOptimal,
+		vk::ImageLayout::eShaderReadOnlyOptimal);
+
 	ctx.endSingleTimeCommmand(cmd);
+
+	layout     = vk::ImageLayout::eShaderReadOnlyOptimal;
+	src.layout = vk::ImageLayout::eShaderReadOnlyOptimal;
 }
 
 void Texture::resize(uint32_t width, uint32_t height)
@@ -310,8 +699,11 @@ void Texture::resize(uint32_t width, uint32_t height)
 	info.image_info.extent.width  = width;
 	info.image_info.extent.height = height;
 
+	if (info.generate_mips)
+		info.image_info.mipLevels = mip_level_count(width, height);
+
 	auto new_image      = device.createImage(info.image_info);
-	auto new_memory     = allocateMemory(new_image, allocated_size);
+	auto new_allocation = allocateMemory(new_image, allocated_size);
 
 	auto cmd = ctx.beginSingleTimeCommmand();
 
@@ -319,7 +711,7 @@ void Texture::resize(uint32_t width, uint32_t height)
 		cmd,
 		image,
 		info.image_info.format,
-		vk::ImageLayout::eUndefined,
+		layout,
 		vk::ImageLayout::eTransferSrcOptimal);
 
 	ctx.transitionImageLayout(
@@ -330,11 +722,11 @@ void Texture::resize(uint32_t width, uint32_t height)
 		vk::ImageLayout::eTransferDstOptimal);
 
 	vk::ImageCopy image_copy = {};
-	image_copy.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, info.image_info.mipLevels - 1, 0, 1 };
+	image_copy.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
 	image_copy.srcOffset      = vk::Offset3D{};
-	image_copy.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, info.image_info.mipLevels - 1, 0, 1 };
+	image_copy.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
 	image_copy.dstOffset      = vk::Offset3D{};
-	image_copy.extent         = prev_extent;
+	image_copy.extent         = vk::Extent3D{ std::min(prev_extent.width, width), std::min(prev_extent.height, height), 1 };
 
 	cmd.copyImage(
 		image,
@@ -352,26 +744,32 @@ void Texture::resize(uint32_t width, uint32_t height)
 
 	ctx.endSingleTimeCommmand(cmd);
 
-	device.destroy(std::exchange(image, new_image));
-	device.destroy(std::exchange(image_view, create_image_view(info.image_info, new_image)));
-	device.destroy(std::exchange(sampler, device.createSampler(info.sampler_info)));
-	device.free(std::exchange(memory, new_memory));
-	device.free(ctx.descriptor_pool, 1, &desc_set);
-	desc_set = createDescriptorSet(sampler, image_view);
+	retireImage();
+
+	image      = new_image;
+	image_view = create_image_view(info.image_info, new_image);
+	allocation = new_allocation;
+
+	if (!info.push_descriptor)
+		desc_set = createDescriptorSet(sampler, image_view);
+
+	layout   = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	if (info.generate_mips)
+		generateMips();
 }
 
 void Texture::clear()
 {
-	auto& ctx    = Context::get();
-	auto  device = ctx.device;
+	// Textures that never allocated can live and die without a Context
+	if (!image) return;
 
-	device.free(ctx.descriptor_pool, 1, &desc_set);
-	device.free(std::exchange(memory, nullptr));
-	device.destroy(std::exchange(image, nullptr));
-	device.destroy(std::exchange(image_view, nullptr));
-	device.destroy(std::exchange(sampler, nullptr));
-	
-	desc_set       = nullptr;
+	retireImage();
+
+	// The cache destroys the last user's sampler once the frames in flight completed
+	Context::get().sampler_cache->release(std::exchange(sampler, nullptr));
+
+	layout         = vk::ImageLayout::eUndefined;
 	allocated_size = 0;
 }
 
@@ -390,11 +788,26 @@ uvec2 Texture::extent() const
 	return uvec2(info.image_info.extent.width, info.image_info.extent.height);
 }
 
+uvec2 Texture::extent(uint32_t mip_level) const
+{
+	return uvec2(
+		std::max(info.image_info.extent.width >> mip_level, 1u),
+		std::max(info.image_info.extent.height >> mip_level, 1u));
+}
+
+uint32_t Texture::mipLevels() const
+{
+	return info.image_info.mipLevels;
+}
+
 size_t Texture::size_in_bytes() const
 {
 	auto width  = info.image_info.extent.width;
 	auto height = info.image_info.extent.height;
 
+	if (VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(info.image_info.format) != 0)
+		return VKDL_PRIV_NAMESPACE_NAME::compressedSizeInBytes(info.image_info.format, width, height);
+
 	return width * height * format_size_in_byte(info.image_info.format);
 }
 
@@ -418,29 +831,329 @@ void Texture::swap(Texture& rhs)
 	std::swap(info, rhs.info);
 	std::swap(image, rhs.image);
 	std::swap(image_view, rhs.image_view);
-	std::swap(memory, rhs.memory);
+	std::swap(allocation, rhs.allocation);
 	std::swap(sampler, rhs.sampler);
 	std::swap(desc_set, rhs.desc_set);
+	std::swap(layout, rhs.layout);
 	std::swap(allocated_size, rhs.allocated_size);
 	staging_buffer.swap(rhs.staging_buffer);
+
+	adoptAllocation();
+	rhs.adoptAllocation();
 }
 
-vk::DeviceMemory Texture::allocateMemory(vk::Image image, vk::DeviceSize& size) const
+bool Texture::relocate(const MemoryAllocation& from, const MemoryAllocation& to)
 {
+	if (!image || allocation.memory != from.memory || allocation.offset != from.offset)
+		return false;
+
 	auto& ctx    = Context::get();
-	auto& device = ctx.device;
+	auto  device = ctx.device;
+
+	auto new_image = device.createImage(info.image_info);
+	device.bindImageMemory(new_image, to.memory, to.offset);
+
+	// Textures without contents have nothing to copy
+	if (layout != vk::ImageLayout::eUndefined) {
+		const uint32_t levels = mipLevels();
+
+		auto cmd = ctx.beginSingleTimeCommmand();
+
+		mip_barrier(cmd, image, 0, levels,
+			layout, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer);
+
+		mip_barrier(cmd, new_image, 0, levels,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			{}, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer);
+
+		std::vector<vk::ImageCopy> copies(levels);
+		for (uint32_t level = 0; level < levels; level++) {
+			const auto level_extent = extent(level);
+
+			copies[level].srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+			copies[level].dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+			copies[level].extent         = vk::Extent3D{ level_extent.x, level_extent.y, 1 };
+		}
+
+		cmd.copyImage(
+			image,
+			vk::ImageLayout::eTransferSrcOptimal,
+			new_image,
+			vk::ImageLayout::eTransferDstOptimal,
+			levels, copies.data());
+
+		mip_barrier(cmd, new_image, 0, levels,
+			vk::ImageLayout::eTransferDstOptimal, layout,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands);
+
+		ctx.endSingleTimeCommmand(cmd);
+	}
+
+	// Frames in flight may still sample the old image through its view and descriptor set
+	ctx.retire([device, old_image = image, old_view = image_view, set_layout = info.desc_set_layout, old_set = desc_set]() {
+		Context::get().descriptor_allocator->free(set_layout, old_set);
+		device.destroy(old_view);
+		device.destroy(old_image);
+	});
+
+	image      = new_image;
+	image_view = create_image_view(info.image_info, new_image);
+	allocation = to;
+	desc_set   = createDescriptorSet(sampler, image_view);
+
+	return true;
+}
+
+bool Texture::supportsBlitMips() const
+{
+	const auto features = Context::get().physical_device.getFormatProperties(format()).optimalTilingFeatures;
+	const auto required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+	return (features & required) == required;
+}
+
+void Texture::generateMipsOnCPU(const ivec2& offset, const uvec2& size, const void* pixels)
+{
+	VKDL_CHECK_MSG(is_8bit_channel_format(format()), "Texture format supports neither blits nor CPU mip generation");
+
+	auto& ctx = Context::get();
+
+	const auto channels = format_size_in_byte(format());
+	const auto levels   = mipLevels();
+	const auto base     = extent();
+
+	if (levels == 1) return;
+
+	// Texels each level rebuilds, half of the level above rounded outwards
+	std::vector<MipRegion> regions(levels);
+	regions[0] = { static_cast<uint32_t>(offset.x), static_cast<uint32_t>(offset.y), size.x, size.y };
+
+	for (uint32_t level = 1; level < levels; level++) {
+		const auto& src = regions[level - 1];
+		const auto  dst = extent(level);
+
+		// The last column (row) of an odd level folds into the last texel below it
+		regions[level].x      = std::min(src.x / 2, dst.x - 1);
+		regions[level].y      = std::min(src.y / 2, dst.y - 1);
+		regions[level].width  = std::min((src.x + src.width + 1) / 2, dst.x) - regions[level].x;
+		regions[level].height = std::min((src.y + src.height + 1) / 2, dst.y) - regions[level].y;
+	}
+
+	// Texels the filter reads for them, a row and column more on each side (two where
+	// an odd edge folds), which keep their current content and are read back
+	std::vector<MipRegion> sources(levels - 1);
+
+	for (uint32_t level = 0; level + 1 < levels; level++) {
+		const auto& dst        = regions[level + 1];
+		const auto  dst_extent = extent(level + 1);
+		const auto  src_extent = extent(level);
+
+		sources[level].x      = dst.x * 2;
+		sources[level].y      = dst.y * 2;
+		sources[level].width  = (dst.x + dst.width == dst_extent.x ? src_extent.x : (dst.x + dst.width) * 2) - sources[level].x;
+		sources[level].height = (dst.y + dst.height == dst_extent.y ? src_extent.y : (dst.y + dst.height) * 2) - sources[level].y;
+	}
+
+	const auto covers = [](const MipRegion& lhs, const MipRegion& rhs) {
+		return lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width && lhs.height == rhs.height;
+	};
+
+	// One readback for every source level that needs texels from the GPU, level 0
+	// also when the caller has no pixels
+	std::vector<std::vector<uint8_t>> source_pixels(levels - 1);
+	std::vector<vk::BufferImageCopy>  readbacks;
+	std::vector<uint32_t>             readback_levels;
+	vk::DeviceSize                    readback_size = 0;
+
+	for (uint32_t level = 0; level + 1 < levels; level++) {
+		if (covers(sources[level], regions[level]) && (level != 0 || pixels))
+			continue;
+
+		const auto& region = sources[level];
+
+		vk::BufferImageCopy image_copy = {};
+		image_copy.bufferOffset     = readback_size;
+		image_copy.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+		image_copy.imageOffset      = vk::Offset3D{ static_cast<int32_t>(region.x), static_cast<int32_t>(region.y), 0 };
+		image_copy.imageExtent      = vk::Extent3D{ region.width, region.height, 1 };
+
+		readbacks.push_back(image_copy);
+		readback_levels.push_back(level);
+		readback_size += static_cast<vk::DeviceSize>(region.width) * region.height * channels;
+	}
+
+	if (!readbacks.empty()) {
+		Buffer<uint8_t> buffer(
+			static_cast<size_t>(readback_size),
+			vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+		auto cmd = ctx.beginSingleTimeCommmand();
+
+		mip_barrier(cmd, image, 0, 1,
+			layout, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer);
+
+		mip_barrier(cmd, image, 1, levels - 1,
+			vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eTransfer);
+
+		cmd.copyImageToBuffer(
+			image,
+			vk::ImageLayout::eTransferSrcOptimal,
+			buffer.getBuffer(),
+			static_cast<uint32_t>(readbacks.size()), readbacks.data());
+
+		mip_barrier(cmd, image, 0, levels,
+			vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+
+		ctx.endSingleTimeCommmand(cmd);
+
+		layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		const uint8_t* mapped = buffer.map();
+
+		for (size_t i = 0; i < readbacks.size(); i++) {
+			const auto level = readback_levels[i];
+			const auto bytes = static_cast<size_t>(sources[level].width) * sources[level].height * channels;
+
+			source_pixels[level].assign(mapped + readbacks[i].bufferOffset, mapped + readbacks[i].bufferOffset + bytes);
+		}
+
+		buffer.unmap();
+	}
+
+	// Level 0 is read from the caller's pixels when they cover the source as is
+	if (pixels && !source_pixels[0].empty())
+		copy_region(static_cast<const uint8_t*>(pixels), regions[0], source_pixels[0].data(), sources[0], channels);
+
+	// Every level after the first, packed back to back
+	std::vector<vk::DeviceSize> offsets(levels, 0);
+	vk::DeviceSize              total_size = 0;
+
+	for (uint32_t level = 1; level < levels; level++) {
+		offsets[level] = total_size;
+		total_size    += static_cast<vk::DeviceSize>(regions[level].width) * regions[level].height * channels;
+	}
+
+	staging_buffer.resize(static_cast<size_t>(total_size));
+	auto* mapped = staging_buffer.map();
+
+	const uint8_t* src = source_pixels[0].empty() ? static_cast<const uint8_t*>(pixels) : source_pixels[0].data();
+
+	for (uint32_t level = 1; level < levels; level++) {
+		auto* dst = mapped + offsets[level];
+
+		box_downsample(src, sources[level - 1], extent(level - 1), dst, regions[level], channels);
+
+		if (level + 1 == levels) break;
+
+		// The next level reads the new texels, and around them the ones read back
+		if (source_pixels[level].empty()) {
+			src = dst;
+		} else {
+			copy_region(dst, regions[level], source_pixels[level].data(), sources[level], channels);
+			src = source_pixels[level].data();
+		}
+	}
+
+	staging_buffer.flush();
+
+	std::vector<vk::BufferImageCopy> copies;
+
+	for (uint32_t level = 1; level < levels; level++) {
+		const auto& region = regions[level];
+
+		vk::BufferImageCopy image_copy = {};
+		image_copy.bufferOffset     = offsets[level];
+		image_copy.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+		image_copy.imageOffset      = vk::Offset3D{ static_cast<int32_t>(region.x), static_cast<int32_t>(region.y), 0 };
+		image_copy.imageExtent      = vk::Extent3D{ region.width, region.height, 1 };
+
+		copies.push_back(image_copy);
+	}
+
+	// A partial rebuild keeps the rest of the levels
+	const bool whole = regions[0].width == base.x && regions[0].height == base.y;
+
+	auto cmd = ctx.beginSingleTimeCommmand();
+
+	mip_barrier(cmd, image, 1, levels - 1,
+		whole ? vk::ImageLayout::eUndefined : vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferDstOptimal,
+		vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eTransferWrite,
+		vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eTransfer);
 
-	auto req = device.getImageMemoryRequirements(image);
+	cmd.copyBufferToImage(
+		staging_buffer.getBuffer(),
+		image,
+		vk::ImageLayout::eTransferDstOptimal,
+		static_cast<uint32_t>(copies.size()), copies.data());
 
-	vk::MemoryAllocateInfo image_info = {};
-	image_info.allocationSize  = size = req.size;
-	image_info.memoryTypeIndex = ctx.findMemoryType(req.memoryTypeBits, info.memory_props);
+	mip_barrier(cmd, image, 1, levels - 1,
+		vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+		vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
 
-	auto memory = device.allocateMemory(image_info);
+	ctx.endSingleTimeCommmand(cmd);
+}
+
+bool Texture::canGenerateMips() const
+{
+	return supportsBlitMips() || is_8bit_channel_format(format());
+}
+
+MemoryAllocation Texture::allocateMemory(vk::Image image, vk::DeviceSize& size)
+{
+	auto& ctx = Context::get();
+
+	auto allocation = ctx.memory_allocator->allocate(
+		image,
+		info.memory_props,
+		MemoryCategory::Texture,
+		info.image_info.tiling == vk::ImageTiling::eLinear,
+		this);
+
+	size = allocation.size;
+
+	return allocation;
+}
+
+// The allocator hands `this` to defragment(), which changes when the texture moves
+void Texture::adoptAllocation()
+{
+	if (allocation.block)
+		Context::get().memory_allocator->setOwner(allocation, this);
+}
 
-	device.bindImageMemory(image, memory, 0);
+// Frames in flight may still sample the image, it is released with its view, memory and
+// descriptor set once they completed
+void Texture::retireImage()
+{
+	auto& ctx = Context::get();
 
-	return memory;
+	// Without an owner the range is never moved by defragment() meanwhile
+	ctx.memory_allocator->setOwner(allocation, nullptr);
+
+	ctx.retire([device = ctx.device, old_image = image, old_view = image_view, old_allocation = allocation,
+		set_layout = info.desc_set_layout, old_set = desc_set]() mutable {
+		Context::get().descriptor_allocator->free(set_layout, old_set);
+		device.destroy(old_view);
+		device.destroy(old_image);
+		Context::get().memory_allocator->free(old_allocation);
+	});
+
+	image      = nullptr;
+	image_view = nullptr;
+	allocation = {};
+	desc_set   = nullptr;
 }
 
 vk::DescriptorSet Texture::createDescriptorSet(vk::Sampler sampler, vk::ImageView image_view) const
@@ -448,12 +1161,9 @@ vk::DescriptorSet Texture::createDescriptorSet(vk::Sampler sampler, vk::ImageVie
 	auto& ctx    = Context::get();
 	auto& device = ctx.device;
 
-	vk::DescriptorSetAllocateInfo desc_set_info = {};
-	desc_set_info.descriptorPool     = ctx.descriptor_pool;
-	desc_set_info.descriptorSetCount = 1;
-	desc_set_info.pSetLayouts        = &info.desc_set_layout;
+	if (info.push_descriptor) return nullptr;
 
-	auto desc_set = device.allocateDescriptorSets(desc_set_info).front();
+	vk::DescriptorSet desc_set = ctx.descriptor_allocator->allocate(info.desc_set_layout);
 
 	vk::DescriptorImageInfo desc_image_info = {};
 	desc_image_info.sampler     = sampler;
@@ -473,6 +1183,15 @@ vk::DescriptorSet Texture::createDescriptorSet(vk::Sampler sampler, vk::ImageVie
 	return desc_set;
 }
 
+vk::DescriptorImageInfo Texture::descriptorImageInfo() const
+{
+	vk::DescriptorImageInfo desc_image_info = {};
+	desc_image_info.sampler     = sampler;
+	desc_image_info.imageView   = image_view;
+	desc_image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	return desc_image_info;
+}
+
 TextureCreator::TextureCreator() :
 	info()
 {
@@ -507,7 +1226,9 @@ TextureCreator::TextureCreator() :
 	info.sampler_info.borderColor             = vk::BorderColor::eFloatTransparentBlack;
 	info.sampler_info.unnormalizedCoordinates = false;
 
-	info.memory_props = vk::MemoryPropertyFlagBits::eDeviceLocal;
+	info.memory_props    = vk::MemoryPropertyFlagBits::eDeviceLocal;
+	info.generate_mips   = false;
+	info.push_descriptor = false;
 }
 
 TextureCreator& TextureCreator::setImageFormat(vk::Format format)
@@ -536,6 +1257,12 @@ TextureCreator& TextureCreator::setImageMipLevels(uint32_t mip_levels)
 	return *this;
 }
 
+TextureCreator& TextureCreator::setGenerateMips(bool value)
+{
+	info.generate_mips = value;
+	return *this;
+}
+
 TextureCreator& TextureCreator::setImageSamples(vk::SampleCountFlagBits samples)
 {
 	info.image_info.samples = samples;
@@ -631,15 +1358,31 @@ TextureCreator& TextureCreator::setSamplerUnnormalizedCoordinates(bool value)
 	return *this;
 }
 
-TextureCreator& TextureCreator::setDescriptorSetLayout(vk::DescriptorSetLayout layout)
+TextureCreator& TextureCreator::setDescriptorSetLayout(vk::DescriptorSetLayout layout, vk::DescriptorSetLayoutCreateFlags flags)
+{
+	info.desc_set_layout = layout;
+	info.push_descriptor = static_cast<bool>(flags & vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+	return *this;
+}
+
+TextureCreator& TextureCreator::setDescriptorSetLayout(const DescriptorSetLayout& layout)
 {
 	info.desc_set_layout = layout;
+	info.push_descriptor = layout.isPushDescriptor();
 	return *this;
 }
 
 Texture TextureCreator::create() const
 {
-	return Texture(info);
+	if (!info.generate_mips)
+		return Texture(info);
+
+	// The full chain down to 1x1, blits read and write the image itself
+	auto mip_info = info;
+	mip_info.image_info.mipLevels = mip_level_count(info.image_info.extent.width, info.image_info.extent.height);
+	mip_info.image_info.usage    |= vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+
+	return Texture(mip_info);
 }
 
 VKDL_END
\ No newline at end of file
@@ -0,0 +1,607 @@
+#include "../include/vkdl/graphics/texture_container.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/util/file_io.h"
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+size_t format_size_in_byte(vk::Format format);
+
+static const uint8_t ktx2_identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+#define KTX2_HEADER_SIZE      80
+#define KTX2_LEVEL_INDEX_SIZE 24
+#define DDS_HEADER_SIZE       128
+#define DDS_DX10_HEADER_SIZE  20
+#define LEVEL_ALIGNMENT       16
+
+#define DDSD_MIPMAPCOUNT      0x20000
+#define DDPF_FOURCC           0x4
+#define DDPF_RGB              0x40
+#define DDSCAPS2_CUBEMAP      0x200
+#define DDSCAPS2_VOLUME       0x200000
+
+template <class T>
+static T read_value(const uint8_t* data)
+{
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+template <class T>
+static void write_value(std::vector<uint8_t>& output, size_t offset, T value)
+{
+	std::memcpy(output.data() + offset, &value, sizeof(T));
+}
+
+static constexpr uint32_t make_fourcc(char a, char b, char c, char d)
+{
+	return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+static size_t level_size_in_bytes(vk::Format format, uint32_t width, uint32_t height)
+{
+	if (VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(format) != 0)
+		return VKDL_PRIV_NAMESPACE_NAME::compressedSizeInBytes(format, width, height);
+
+	return static_cast<size_t>(width) * height * format_size_in_byte(format);
+}
+
+// Widest mip chain an image of this size can have, longer chains in a file are corrupt
+static uint32_t max_mip_levels(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+
+	for (auto size = std::max(width, height); size > 1; size >>= 1)
+		levels++;
+
+	return levels;
+}
+
+// Formats createTexture can upload as they are, or decode. Anything else (ETC2, ASTC,
+// packed or depth formats) is rejected when the file is opened.
+static bool is_supported_format(vk::Format format)
+{
+	if (VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(format) != 0)
+		return true;
+
+	switch (format) {
+	case vk::Format::eR8Unorm:
+	case vk::Format::eR8G8Unorm:
+	case vk::Format::eR8G8B8A8Unorm:
+	case vk::Format::eR8G8B8A8Srgb:
+	case vk::Format::eB8G8R8A8Unorm:
+	case vk::Format::eB8G8R8A8Srgb:
+	case vk::Format::eR16Sfloat:
+	case vk::Format::eR16G16B16A16Sfloat:
+	case vk::Format::eR32Sfloat:
+	case vk::Format::eR32G32B32A32Sfloat:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static size_t align_up(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+static bool is_srgb(vk::Format format)
+{
+	switch (format) {
+	case vk::Format::eBc1RgbSrgbBlock:
+	case vk::Format::eBc1RgbaSrgbBlock:
+	case vk::Format::eBc2SrgbBlock:
+	case vk::Format::eBc3SrgbBlock:
+	case vk::Format::eR8G8B8A8Srgb:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static vk::Format dxgi_to_vk_format(uint32_t dxgi_format)
+{
+	switch (dxgi_format) {
+	case 28: return vk::Format::eR8G8B8A8Unorm;
+	case 29: return vk::Format::eR8G8B8A8Srgb;
+	case 87: return vk::Format::eB8G8R8A8Unorm;
+	case 91: return vk::Format::eB8G8R8A8Srgb;
+	case 71: return vk::Format::eBc1RgbaUnormBlock;
+	case 72: return vk::Format::eBc1RgbaSrgbBlock;
+	case 74: return vk::Format::eBc2UnormBlock;
+	case 75: return vk::Format::eBc2SrgbBlock;
+	case 77: return vk::Format::eBc3UnormBlock;
+	case 78: return vk::Format::eBc3SrgbBlock;
+	case 80: return vk::Format::eBc4UnormBlock;
+	case 81: return vk::Format::eBc4SnormBlock;
+	case 83: return vk::Format::eBc5UnormBlock;
+	case 84: return vk::Format::eBc5SnormBlock;
+	case 95: return vk::Format::eBc6HUfloatBlock;
+	case 96: return vk::Format::eBc6HSfloatBlock;
+	case 98: return vk::Format::eBc7UnormBlock;
+	case 99: return vk::Format::eBc7SrgbBlock;
+	default: return vk::Format::eUndefined;
+	}
+}
+
+static vk::Format fourcc_to_vk_format(uint32_t fourcc)
+{
+	switch (fourcc) {
+	case make_fourcc('D', 'X', 'T', '1'): return vk::Format::eBc1RgbaUnormBlock;
+	case make_fourcc('D', 'X', 'T', '3'): return vk::Format::eBc2UnormBlock;
+	case make_fourcc('D', 'X', 'T', '5'): return vk::Format::eBc3UnormBlock;
+	case make_fourcc('A', 'T', 'I', '1'): return vk::Format::eBc4UnormBlock;
+	case make_fourcc('B', 'C', '4', 'U'): return vk::Format::eBc4UnormBlock;
+	case make_fourcc('A', 'T', 'I', '2'): return vk::Format::eBc5UnormBlock;
+	case make_fourcc('B', 'C', '5', 'U'): return vk::Format::eBc5UnormBlock;
+	default: return vk::Format::eUndefined;
+	}
+}
+
+// Box filtered half size RGBA8 image. On an odd size the last column (row) also
+// takes the last source column (row), so no texel is dropped.
+static std::vector<uint8_t> downsample_rgba(const std::vector<uint8_t>& src, uint32_t src_w, uint32_t src_h, uint32_t dst_w, uint32_t dst_h)
+{
+	std::vector<uint8_t> dst(static_cast<size_t>(dst_w) * dst_h * 4);
+
+	for (uint32_t y = 0; y < dst_h; y++) {
+		const uint32_t y_begin = std::min(y * 2, src_h - 1);
+		const uint32_t y_end   = y == dst_h - 1 ? src_h : y * 2 + 2;
+
+		for (uint32_t x = 0; x < dst_w; x++) {
+			const uint32_t x_begin = std::min(x * 2, src_w - 1);
+			const uint32_t x_end   = x == dst_w - 1 ? src_w : x * 2 + 2;
+			const uint32_t count   = (x_end - x_begin) * (y_end - y_begin);
+
+			for (size_t c = 0; c < 4; c++) {
+				uint32_t sum = 0;
+
+				for (uint32_t sy = y_begin; sy < y_end; sy++)
+					for (uint32_t sx = x_begin; sx < x_end; sx++)
+						sum += src[(static_cast<size_t>(sy) * src_w + sx) * 4 + c];
+
+				dst[(static_cast<size_t>(y) * dst_w + x) * 4 + c] = static_cast<uint8_t>((sum + count / 2) / count);
+			}
+		}
+	}
+
+	return dst;
+}
+
+// KTX2 requires a Khronos basic data format descriptor, see the Khronos Data Format Specification
+static std::vector<uint8_t> build_dfd(vk::Format format)
+{
+	struct Sample
+	{
+		uint16_t bit_offset;
+		uint8_t  bit_length;
+		uint8_t  channel;
+		uint32_t upper;
+	};
+
+	const bool srgb = is_srgb(format);
+
+	uint8_t             color_model = 1; // KHR_DF_MODEL_RGBSDA
+	uint8_t             block_dim   = 0;
+	uint8_t             bytes_plane = 4;
+	std::vector<Sample> samples;
+
+	switch (format) {
+	case vk::Format::eBc1RgbUnormBlock:
+	case vk::Format::eBc1RgbSrgbBlock:
+		color_model = 128; // KHR_DF_MODEL_BC1A
+		block_dim   = 3;
+		bytes_plane = 8;
+		samples     = { { 0, 63, 0, 0xffffffff } };
+		break;
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+		color_model = 130; // KHR_DF_MODEL_BC3
+		block_dim   = 3;
+		bytes_plane = 16;
+		samples     = { { 0, 63, 15, 0xffffffff }, { 64, 63, 0, 0xffffffff } };
+		break;
+	default:
+		samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, 15 | (srgb ? 0x10 : 0), 255 } };
+		break;
+	}
+
+	const uint32_t block_size = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+	std::vector<uint8_t> dfd(4 + block_size, 0);
+
+	write_value<uint32_t>(dfd, 0, static_cast<uint32_t>(dfd.size()));
+	write_value<uint32_t>(dfd, 4, 0);                              // vendor id, descriptor type
+	write_value<uint32_t>(dfd, 8, 2 | (block_size << 16));         // version 1.3, block size
+	dfd[12] = color_model;
+	dfd[13] = 1;                                                   // BT.709 primaries
+	dfd[14] = srgb ? 2 : 1;                                        // sRGB or linear transfer
+	dfd[15] = 0;                                                   // straight alpha
+	dfd[16] = dfd[17] = block_dim;
+	dfd[20] = bytes_plane;
+
+	for (size_t i = 0; i < samples.size(); i++) {
+		const size_t offset = 28 + 16 * i;
+
+		write_value<uint16_t>(dfd, offset, samples[i].bit_offset);
+		dfd[offset + 2] = samples[i].bit_length;
+		dfd[offset + 3] = samples[i].channel;
+		write_value<uint32_t>(dfd, offset + 8, 0);
+		write_value<uint32_t>(dfd, offset + 12, samples[i].upper);
+	}
+
+	return dfd;
+}
+
+VKDL_BEGIN
+
+TextureContainer::TextureContainer() :
+	file(),
+	fmt(vk::Format::eUndefined),
+	levels(),
+	generate_mips(false)
+{
+}
+
+TextureContainer::TextureContainer(const char* path) :
+	TextureContainer()
+{
+	if (!loadFromFile(path))
+		VKDL_ERROR("Failed to load texture container");
+}
+
+VKDL_NODISCARD bool TextureContainer::loadFromFile(const char* path)
+{
+	close();
+
+	if (!file.open(path))
+		return false;
+
+	if (parseKTX2() || parseDDS())
+		return true;
+
+	close();
+	return false;
+}
+
+void TextureContainer::close()
+{
+	file.close();
+	fmt = vk::Format::eUndefined;
+	levels.clear();
+	generate_mips = false;
+}
+
+VKDL_NODISCARD Texture TextureContainer::createTexture(TextureCreator creator) const
+{
+	VKDL_CHECK(!empty());
+
+	auto& ctx = Context::get();
+
+	const auto features = ctx.physical_device.getFormatProperties(fmt).optimalTilingFeatures;
+	const bool decode   = !(features & vk::FormatFeatureFlagBits::eSampledImage);
+
+	if (decode)
+		VKDL_CHECK_MSG(VKDL_PRIV_NAMESPACE_NAME::canDecodeBlocks(fmt), "Texture format is not supported by the device");
+
+	const auto texture_format = !decode ? fmt : is_srgb(fmt) ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+
+	// Every level goes into one staging buffer and one copy command
+	std::vector<vk::BufferImageCopy> regions;
+	size_t                           staging_size = 0;
+
+	for (uint32_t level = 0; level < mipLevels(); level++) {
+		const auto& src = levels[level];
+
+		vk::BufferImageCopy region = {};
+		region.bufferOffset     = staging_size;
+		region.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 };
+		region.imageExtent      = vk::Extent3D{ src.width, src.height, 1 };
+
+		regions.push_back(region);
+
+		const size_t size = decode ? static_cast<size_t>(src.width) * src.height * 4 : src.size;
+		staging_size = align_up(staging_size + size, LEVEL_ALIGNMENT);
+	}
+
+	Buffer<uint8_t> staging(
+		staging_size,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	auto* mapped = staging.map();
+
+	for (uint32_t level = 0; level < mipLevels(); level++) {
+		const auto& src = levels[level];
+		auto*       dst = mapped + regions[level].bufferOffset;
+
+		if (decode)
+			VKDL_PRIV_NAMESPACE_NAME::decodeBlocks(fmt, src.data, src.width, src.height, dst);
+		else
+			std::memcpy(dst, src.data, src.size);
+	}
+
+	auto texture = creator
+		.setImageFormat(texture_format)
+		.setImageExtent(levels.front().width, levels.front().height)
+		.setImageMipLevels(mipLevels())
+		.setImageUsage(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst)
+		.setGenerateMips(generate_mips)
+		.create();
+
+	auto cmd = ctx.beginSingleTimeCommmand();
+	texture.update(cmd, staging.getBuffer(), regions.data(), static_cast<uint32_t>(regions.size()));
+	ctx.endSingleTimeCommmand(cmd);
+
+	staging.unmap();
+
+	if (generate_mips)
+		texture.generateMips();
+
+	return texture;
+}
+
+VKDL_NODISCARD vk::Format TextureContainer::format() const
+{
+	return fmt;
+}
+
+VKDL_NODISCARD uvec2 TextureContainer::extent() const
+{
+	return empty() ? uvec2(0, 0) : uvec2(levels.front().width, levels.front().height);
+}
+
+VKDL_NODISCARD uint32_t TextureContainer::mipLevels() const
+{
+	return static_cast<uint32_t>(levels.size());
+}
+
+VKDL_NODISCARD bool TextureContainer::generatesMips() const
+{
+	return generate_mips;
+}
+
+VKDL_NODISCARD const TextureContainer::Level& TextureContainer::getLevel(uint32_t mip_level) const
+{
+	VKDL_CHECK(mip_level < levels.size());
+	return levels[mip_level];
+}
+
+VKDL_NODISCARD bool TextureContainer::isCompressed() const
+{
+	return VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(fmt) != 0;
+}
+
+VKDL_NODISCARD bool TextureContainer::empty() const
+{
+	return levels.empty();
+}
+
+bool TextureContainer::bake(const ColorImage& image, const char* path, const TextureBakeOptions& options)
+{
+	VKDL_CHECK(!image.empty());
+
+	vk::Format format = {};
+
+	switch (options.format) {
+	case TextureBakeFormat::RGBA8: format = options.srgb ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm; break;
+	case TextureBakeFormat::BC1:   format = options.srgb ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc1RgbUnormBlock; break;
+	case TextureBakeFormat::BC3:   format = options.srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock; break;
+	}
+
+	uint32_t width  = image.width();
+	uint32_t height = image.height();
+
+	const auto* pixels = reinterpret_cast<const uint8_t*>(image.data());
+
+	std::vector<uint8_t>              rgba(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	std::vector<std::vector<uint8_t>> encoded;
+
+	while (true) {
+		std::vector<uint8_t> level(level_size_in_bytes(format, width, height));
+
+		switch (options.format) {
+		case TextureBakeFormat::RGBA8: level = rgba; break;
+		case TextureBakeFormat::BC1:   VKDL_PRIV_NAMESPACE_NAME::encodeBC1(rgba.data(), width, height, level.data()); break;
+		case TextureBakeFormat::BC3:   VKDL_PRIV_NAMESPACE_NAME::encodeBC3(rgba.data(), width, height, level.data()); break;
+		}
+
+		encoded.push_back(std::move(level));
+
+		if (!options.generate_mips || (width == 1 && height == 1))
+			break;
+
+		const uint32_t next_width  = std::max(width / 2, 1u);
+		const uint32_t next_height = std::max(height / 2, 1u);
+
+		rgba   = downsample_rgba(rgba, width, height, next_width, next_height);
+		width  = next_width;
+		height = next_height;
+	}
+
+	const auto   dfd         = build_dfd(format);
+	const size_t level_count = encoded.size();
+	const size_t dfd_offset  = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE * level_count;
+
+	// Level data is stored smallest first
+	std::vector<size_t> offsets(level_count);
+	size_t              file_size = dfd_offset + dfd.size();
+
+	for (size_t level = level_count; level-- > 0;) {
+		file_size       = align_up(file_size, LEVEL_ALIGNMENT);
+		offsets[level]  = file_size;
+		file_size      += encoded[level].size();
+	}
+
+	std::vector<uint8_t> output(file_size, 0);
+
+	std::memcpy(output.data(), ktx2_identifier, sizeof(ktx2_identifier));
+	write_value<uint32_t>(output, 12, static_cast<uint32_t>(format));
+	write_value<uint32_t>(output, 16, 1);                                       // typeSize
+	write_value<uint32_t>(output, 20, image.width());
+	write_value<uint32_t>(output, 24, image.height());
+	write_value<uint32_t>(output, 28, 0);                                       // pixelDepth
+	write_value<uint32_t>(output, 32, 0);                                       // layerCount
+	write_value<uint32_t>(output, 36, 1);                                       // faceCount
+	write_value<uint32_t>(output, 40, static_cast<uint32_t>(level_count));
+	write_value<uint32_t>(output, 44, 0);                                       // supercompressionScheme
+	write_value<uint32_t>(output, 48, static_cast<uint32_t>(dfd_offset));
+	write_value<uint32_t>(output, 52, static_cast<uint32_t>(dfd.size()));
+
+	for (size_t level = 0; level < level_count; level++) {
+		const size_t index = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE * level;
+
+		write_value<uint64_t>(output, index, offsets[level]);
+		write_value<uint64_t>(output, index + 8, encoded[level].size());
+		write_value<uint64_t>(output, index + 16, encoded[level].size());
+
+		std::memcpy(output.data() + offsets[level], encoded[level].data(), encoded[level].size());
+	}
+
+	std::memcpy(output.data() + dfd_offset, dfd.data(), dfd.size());
+
+	// A killed baker never leaves a truncated file
+	return writeFile(path, output.data(), output.size());
+}
+
+bool TextureContainer::parseKTX2()
+{
+	const uint8_t* data = file.data();
+	const size_t   size = file.size();
+
+	if (size < KTX2_HEADER_SIZE || std::memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) != 0)
+		return false;
+
+	const auto vk_format        = read_value<uint32_t>(data + 12);
+	const auto width            = read_value<uint32_t>(data + 20);
+	const auto height           = read_value<uint32_t>(data + 24);
+	const auto depth            = read_value<uint32_t>(data + 28);
+	const auto layer_count      = read_value<uint32_t>(data + 32);
+	const auto face_count       = read_value<uint32_t>(data + 36);
+	const auto file_levels      = read_value<uint32_t>(data + 40);
+	const auto supercompression = read_value<uint32_t>(data + 44);
+
+	// Basis Universal payloads (VK_FORMAT_UNDEFINED) and supercompression need a transcoder
+	if (vk_format == 0 || supercompression != 0) return false;
+	if (!is_supported_format(static_cast<vk::Format>(vk_format))) return false;
+	if (width == 0 || height == 0 || depth > 1 || layer_count > 1 || face_count != 1) return false;
+	if (file_levels > max_mip_levels(width, height)) return false;
+
+	// A level count of 0 stores level 0 only and asks the loader to build the chain,
+	// which the spec only allows for uncompressed formats
+	const bool     generate    = file_levels == 0;
+	const uint32_t level_count = std::max(file_levels, 1u);
+
+	if (generate && VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(static_cast<vk::Format>(vk_format)) != 0) return false;
+	if (KTX2_HEADER_SIZE + static_cast<size_t>(level_count) * KTX2_LEVEL_INDEX_SIZE > size) return false;
+
+	fmt           = static_cast<vk::Format>(vk_format);
+	generate_mips = generate;
+
+	for (uint32_t level = 0; level < level_count; level++) {
+		const uint8_t* index = data + KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE * level;
+
+		const auto offset = read_value<uint64_t>(index);
+		const auto length = read_value<uint64_t>(index + 8);
+
+		Level info = {};
+		info.width  = std::max(width >> level, 1u);
+		info.height = std::max(height >> level, 1u);
+		info.size   = level_size_in_bytes(fmt, info.width, info.height);
+		info.data   = data + offset;
+
+		if (offset > size || length > size - offset || length < info.size) {
+			levels.clear();
+			fmt           = vk::Format::eUndefined;
+			generate_mips = false;
+			return false;
+		}
+
+		levels.push_back(info);
+	}
+
+	return true;
+}
+
+bool TextureContainer::parseDDS()
+{
+	const uint8_t* data = file.data();
+	const size_t   size = file.size();
+
+	if (size < DDS_HEADER_SIZE || read_value<uint32_t>(data) != make_fourcc('D', 'D', 'S', ' '))
+		return false;
+
+	const auto flags     = read_value<uint32_t>(data + 8);
+	const auto height    = read_value<uint32_t>(data + 12);
+	const auto width     = read_value<uint32_t>(data + 16);
+	const auto mip_count = read_value<uint32_t>(data + 28);
+	const auto pf_flags  = read_value<uint32_t>(data + 80);
+	const auto fourcc    = read_value<uint32_t>(data + 84);
+	const auto bit_count = read_value<uint32_t>(data + 88);
+	const auto r_mask    = read_value<uint32_t>(data + 92);
+	const auto g_mask    = read_value<uint32_t>(data + 96);
+	const auto b_mask    = read_value<uint32_t>(data + 100);
+	const auto a_mask    = read_value<uint32_t>(data + 104);
+	const auto caps2     = read_value<uint32_t>(data + 112);
+
+	if (width == 0 || height == 0 || (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)))
+		return false;
+
+	size_t offset = DDS_HEADER_SIZE;
+
+	if ((pf_flags & DDPF_FOURCC) && fourcc == make_fourcc('D', 'X', '1', '0')) {
+		if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) return false;
+
+		const auto dxgi_format = read_value<uint32_t>(data + offset);
+		const auto dimension   = read_value<uint32_t>(data + offset + 4);
+		const auto array_size  = read_value<uint32_t>(data + offset + 12);
+
+		if (dimension != 3 || array_size > 1) return false; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+
+		fmt     = dxgi_to_vk_format(dxgi_format);
+		offset += DDS_DX10_HEADER_SIZE;
+	} else if (pf_flags & DDPF_FOURCC) {
+		fmt = fourcc_to_vk_format(fourcc);
+	} else if ((pf_flags & DDPF_RGB) && bit_count == 32 && g_mask == 0x0000ff00 && a_mask == 0xff000000) {
+		if (r_mask == 0x000000ff && b_mask == 0x00ff0000)
+			fmt = vk::Format::eR8G8B8A8Unorm;
+		else if (r_mask == 0x00ff0000 && b_mask == 0x000000ff)
+			fmt = vk::Format::eB8G8R8A8Unorm;
+	}
+
+	if (fmt == vk::Format::eUndefined) return false;
+
+	const uint32_t level_count = (flags & DDSD_MIPMAPCOUNT) ? std::max(mip_count, 1u) : 1;
+
+	if (level_count > max_mip_levels(width, height)) {
+		fmt = vk::Format::eUndefined;
+		return false;
+	}
+
+	// DDS stores the levels back to back, largest first
+	for (uint32_t level = 0; level < level_count; level++) {
+		Level info = {};
+		info.width  = std::max(width >> level, 1u);
+		info.height = std::max(height >> level, 1u);
+		info.size   = level_size_in_bytes(fmt, info.width, info.height);
+		info.data   = data + offset;
+
+		if (info.size > size - offset) {
+			levels.clear();
+			fmt = vk::Format::eUndefined;
+			return false;
+		}
+
+		levels.push_back(info);
+		offset += info.size;
+	}
+
+	return true;
+}
+
+VKDL_END
\ No newline at end of file
@@ -1,24 +1,27 @@
 #include "../include/vkdl/graphics/texture_view.h"
 
 #include "../include/vkdl/core/builtin_objects.h"
+#include "../include/vkdl/core/cpu_profiler.h"
 
 VKDL_BEGIN
 
 TextureView::TextureView() :
 	Offset(),
 	Size(),
-	FilledColor(Colors::White)
+	FilledColor(Colors::White),
+	render_pass(registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID)),
+	pipeline(registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE2_UUID))
 {
-	registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE2_UUID);
 }
 
 TextureView::TextureView(const Texture& texture, const vec2& offset, const vec2& size) :
 	TexturePtr(&texture),
 	Offset(offset),
 	Size(size),
-	FilledColor(Colors::White)
+	FilledColor(Colors::White),
+	render_pass(registerBuiltinRenderpass(VKDL_BUILTIN_RENDERPASS0_UUID)),
+	pipeline(registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE2_UUID))
 {
-	registerBuiltinPipeline(VKDL_BUILTIN_PIPELINE2_UUID);
 }
 
 bool TextureView::empty() const
@@ -34,18 +37,13 @@ void TextureView::draw(RenderTarget& target, RenderStates& states, const RenderO
 	auto cmd     = target.getCommandBuffer();
 	auto fb_size = target.getFrameBufferSize();
 
-	auto& pipeline_layout = ctx.getPipeline(VKDL_BUILTIN_PIPELINE2_UUID).getPipelineLayout();
+	auto& pipeline_layout = ctx.getPipeline(pipeline).getPipelineLayout();
 	auto& texture         = *TexturePtr;
 
-	states.updateRenderPassUUID(VKDL_BUILTIN_RENDERPASS0_UUID);
-	states.updatePipelineUUID(VKDL_BUILTIN_PIPELINE2_UUID);
+	states.updateRenderPass(render_pass);
+	states.updatePipeline(pipeline);
 
-	cmd.bindDescriptorSets(
-		vk::PipelineBindPoint::eGraphics,
-		pipeline_layout,
-		0,
-		1, &texture.getDescriptorSet(),
-		0, nullptr);
+	texture.bind(cmd, pipeline_layout);
 
 	struct {
 		Transform2D transform;
@@ -80,6 +78,9 @@ void TextureView::draw(RenderTarget& target, RenderStates& states, const RenderO
 	states.bind(target, options);
 
 	cmd.draw(6, 1, 0, 0);
+
+	VKDL_PROFILE_COUNT(DrawCalls, 1);
+	VKDL_PROFILE_COUNT(Vertices, 6);
 }
 
 VKDL_END
\ No newline at end of file
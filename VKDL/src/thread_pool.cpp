@@ -0,0 +1,93 @@
+#include "../include/vkdl/util/thread_pool.h"
+
+#include <algorithm>
+
+VKDL_BEGIN
+
+ThreadPool::ThreadPool(size_t thread_count) :
+	workers(),
+	tasks(),
+	mutex(),
+	condition(),
+	stopping(false)
+{
+	if (thread_count == 0)
+		thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (size_t i = 0; i < thread_count; i++)
+		workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	condition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+VKDL_NODISCARD size_t ThreadPool::threadCount() const
+{
+	return workers.size();
+}
+
+VKDL_NODISCARD ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+
+	condition.notify_one();
+}
+
+// Runs the oldest queued task, false when there is none
+bool ThreadPool::runPending()
+{
+	std::function<void()> task;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (tasks.empty()) return false;
+
+		task = std::move(tasks.front());
+		tasks.pop_front();
+	}
+
+	task();
+
+	return true;
+}
+
+void ThreadPool::run()
+{
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+			if (tasks.empty()) return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+VKDL_END
\ No newline at end of file
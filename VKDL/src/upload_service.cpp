@@ -0,0 +1,580 @@
+#include "../include/vkdl/core/upload_service.h"
+
+#include "../include/vkdl/core/context.h"
+#include "../include/vkdl/core/cpu_profiler.h"
+#include "../include/vkdl/graphics/texture.h"
+#include "block_compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#define STAGING_ALIGNMENT 16
+
+static vk::DeviceSize align_up(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+VKDL_BEGIN
+
+UploadService::UploadService(vk::DeviceSize ring_size) :
+	graphics_family(Context::get().getQueueFamilyIndex(QueueType::Graphics)),
+	transfer_family(Context::get().getQueueFamilyIndex(QueueType::Transfer)),
+	graphics_pool(nullptr),
+	transfer_pool(nullptr),
+	ring(),
+	ring_head(0),
+	ring_used(0),
+	pending_consumed(0)
+{
+	auto& device = Context::get().device;
+
+	graphics_pool = device.createCommandPool({ vk::CommandPoolCreateFlagBits::eTransient, graphics_family });
+
+	if (hasDedicatedTransferQueue())
+		transfer_pool = device.createCommandPool({ vk::CommandPoolCreateFlagBits::eTransient, transfer_family });
+
+	ring = createStaging(align_up(ring_size, STAGING_ALIGNMENT));
+}
+
+UploadService::~UploadService()
+{
+	auto& device = Context::get().device;
+
+	wait();
+
+	destroyStaging(ring);
+
+	device.destroy(graphics_pool);
+	device.destroy(transfer_pool);
+}
+
+std::shared_future<void> UploadService::uploadTexture(Texture& texture, const void* pixels, const ivec2& offset, const uvec2& size)
+{
+	VKDL_CHECK(!texture.is_null());
+	VKDL_CHECK_MSG(!texture.info.generate_mips || texture.mipLevels() == 1 || texture.canGenerateMips(),
+		"Texture format supports neither blits nor CPU mip generation");
+
+	const auto format = texture.info.image_info.format;
+
+	Job job = {};
+	job.texture = &texture;
+	job.offset  = offset;
+	job.size    = size;
+
+	// Compressed formats are copied in whole blocks
+	if (VKDL_PRIV_NAMESPACE_NAME::blockSizeInBytes(format) != 0) {
+		job.src_size = VKDL_PRIV_NAMESPACE_NAME::compressedSizeInBytes(format, size.x, size.y);
+	} else {
+		const auto extent     = texture.extent();
+		const auto texel_size = texture.size_in_bytes() / (static_cast<size_t>(extent.x) * extent.y);
+
+		job.src_size = static_cast<vk::DeviceSize>(size.x) * size.y * texel_size;
+	}
+
+	return enqueue(job, pixels);
+}
+
+std::shared_future<void> UploadService::uploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size_in_bytes)
+{
+	Job job = {};
+	job.dst_buffer = buffer;
+	job.dst_offset = offset;
+	job.src_size   = size_in_bytes;
+
+	return enqueue(job, data);
+}
+
+VKDL_NODISCARD UploadService::Staging UploadService::allocateStaging(vk::DeviceSize size) const
+{
+	return createStaging(size);
+}
+
+void UploadService::releaseStaging(Staging& staging) const
+{
+	destroyStaging(staging);
+}
+
+std::shared_future<void> UploadService::uploadTexture(Texture& texture, Staging&& staging, const ivec2& offset, const uvec2& size, std::function<void()> on_complete)
+{
+	VKDL_CHECK(!texture.is_null() && staging.buffer);
+	VKDL_CHECK_MSG(!texture.info.generate_mips || texture.mipLevels() == 1 || texture.canGenerateMips(),
+		"Texture format supports neither blits nor CPU mip generation");
+
+	Job job = {};
+	job.texture     = &texture;
+	job.offset      = offset;
+	job.size        = size;
+	job.src_buffer  = staging.buffer;
+	job.src_offset  = 0;
+	job.src_size    = staging.size;
+	job.promise     = std::make_shared<std::promise<void>>();
+	job.on_complete = std::move(on_complete);
+
+	std::shared_future<void> future = job.promise->get_future().share();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	pending_dedicated.push_back(std::exchange(staging, {}));
+	pending.push_back(std::move(job));
+
+	return future;
+}
+
+void UploadService::flush()
+{
+	VKDL_PROFILE_ZONE("UploadService::flush");
+
+	collect(false);
+
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+
+	std::vector<Job> jobs;
+	Batch            batch = {};
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (pending.empty()) return;
+
+		jobs.swap(pending);
+		batch.dedicated.swap(pending_dedicated);
+		batch.ring_consumed = std::exchange(pending_consumed, 0);
+	}
+
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	// Group the uploads per texture so each one is transitioned once per batch
+	std::vector<Texture*>                                 textures;
+	std::unordered_map<Texture*, std::vector<const Job*>> texture_jobs;
+	std::vector<const Job*>                               buffer_jobs;
+
+	for (auto& job : jobs) {
+		if (job.texture) {
+			auto& list = texture_jobs[job.texture];
+			if (list.empty()) textures.push_back(job.texture);
+			list.push_back(&job);
+		} else {
+			buffer_jobs.push_back(&job);
+		}
+
+		batch.promises.push_back(job.promise);
+
+		VKDL_PROFILE_COUNT(UploadBytes, job.src_size);
+
+		if (job.on_complete)
+			batch.callbacks.push_back(std::move(job.on_complete));
+	}
+
+	batch.graphics_cmd = device.allocateCommandBuffers({ graphics_pool, vk::CommandBufferLevel::ePrimary, 1 }).front();
+	batch.graphics_cmd.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+	for (auto* texture : textures) {
+		// Only textures without contents can move to the transfer queue, anything
+		// else would need a release from the graphics queue first
+		const bool use_transfer_queue = hasDedicatedTransferQueue() && texture->layout == vk::ImageLayout::eUndefined;
+
+		if (use_transfer_queue && !batch.transfer_cmd) {
+			batch.transfer_cmd = device.allocateCommandBuffers({ transfer_pool, vk::CommandBufferLevel::ePrimary, 1 }).front();
+			batch.transfer_cmd.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		}
+
+		recordTextureJobs(batch, *texture, texture_jobs[texture], use_transfer_queue);
+	}
+
+	if (!buffer_jobs.empty())
+		recordBufferJobs(batch, buffer_jobs);
+
+	batch.graphics_cmd.end();
+	batch.fence = device.createFence({});
+
+	vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eAllCommands;
+
+	if (batch.transfer_cmd) {
+		batch.transfer_cmd.end();
+		batch.semaphore = device.createSemaphore({});
+
+		vk::SubmitInfo transfer_submit = {
+			0, nullptr,
+			nullptr,
+			1, &batch.transfer_cmd,
+			1, &batch.semaphore
+		};
+
+		ctx.submit(QueueType::Transfer, 1, &transfer_submit);
+	}
+
+	vk::SubmitInfo graphics_submit = {
+		batch.semaphore ? 1u : 0u, &batch.semaphore,
+		&wait_stage,
+		1, &batch.graphics_cmd
+	};
+
+	ctx.submit(QueueType::Graphics, 1, &graphics_submit, batch.fence);
+
+	in_flight.push_back(std::move(batch));
+}
+
+void UploadService::wait()
+{
+	flush();
+	collect(true);
+}
+
+VKDL_NODISCARD bool UploadService::hasDedicatedTransferQueue() const
+{
+	return Context::get().hasDedicatedQueue(QueueType::Transfer);
+}
+
+VKDL_NODISCARD size_t UploadService::pendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending.size();
+}
+
+std::shared_future<void> UploadService::enqueue(Job& job, const void* data)
+{
+	job.promise = std::make_shared<std::promise<void>>();
+
+	std::shared_future<void> future = job.promise->get_future().share();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	vk::DeviceSize offset = 0;
+	if (allocateRing(align_up(job.src_size, STAGING_ALIGNMENT), offset)) {
+		job.src_buffer = ring.buffer;
+		job.src_offset = offset;
+		std::memcpy(ring.mapped + offset, data, job.src_size);
+	} else {
+		// Bigger than what the ring has left, the upload gets its own staging buffer
+		auto staging = createStaging(job.src_size);
+		std::memcpy(staging.mapped, data, job.src_size);
+
+		job.src_buffer = staging.buffer;
+		job.src_offset = 0;
+		pending_dedicated.push_back(staging);
+	}
+
+	pending.push_back(std::move(job));
+
+	return future;
+}
+
+bool UploadService::allocateRing(vk::DeviceSize size, vk::DeviceSize& offset)
+{
+	const vk::DeviceSize capacity = ring.size;
+
+	if (size > capacity - ring_used) return false;
+
+	if (ring_used == 0) ring_head = 0;
+
+	const vk::DeviceSize tail = (ring_head + capacity - ring_used) % capacity;
+
+	if (ring_head >= tail) {
+		if (capacity - ring_head >= size) {
+			offset = ring_head;
+		} else if (size <= tail) {
+			// Skip the end of the ring and wrap around
+			const vk::DeviceSize skipped = capacity - ring_head;
+			ring_used        += skipped;
+			pending_consumed += skipped;
+			offset = 0;
+		} else {
+			return false;
+		}
+	} else {
+		if (tail - ring_head < size) return false;
+		offset = ring_head;
+	}
+
+	ring_head         = offset + size;
+	ring_used        += size;
+	pending_consumed += size;
+
+	return true;
+}
+
+void UploadService::collect(bool wait_all)
+{
+	auto& device = Context::get().device;
+
+	std::vector<Batch> done;
+
+	{
+		std::lock_guard<std::mutex> submit_lock(submit_mutex);
+
+		while (!in_flight.empty()) {
+			auto& batch = in_flight.front();
+
+			if (wait_all)
+				VK_CHECK(device.waitForFences(1, &batch.fence, true, UINT64_MAX));
+			else if (device.getFenceStatus(batch.fence) != vk::Result::eSuccess)
+				break;
+
+			// Before the staging memory goes away, the pixels are read from it
+			for (const auto& mips : batch.cpu_mips)
+				mips.texture->generateMipsOnCPU(mips.offset, mips.size, mips.pixels);
+
+			for (auto& staging : batch.dedicated)
+				destroyStaging(staging);
+
+			device.freeCommandBuffers(graphics_pool, 1, &batch.graphics_cmd);
+			if (batch.transfer_cmd)
+				device.freeCommandBuffers(transfer_pool, 1, &batch.transfer_cmd);
+
+			device.destroy(batch.semaphore);
+			device.destroy(batch.fence);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				ring_used -= batch.ring_consumed;
+			}
+
+			done.push_back(std::move(batch));
+			in_flight.pop_front();
+		}
+	}
+
+	// Outside the lock, callbacks may upload or flush again
+	for (auto& batch : done) {
+		for (auto& callback : batch.callbacks)
+			callback();
+
+		for (auto& promise : batch.promises)
+			promise->set_value();
+	}
+}
+
+UploadService::Staging UploadService::createStaging(vk::DeviceSize size) const
+{
+	auto& ctx    = Context::get();
+	auto& device = ctx.device;
+
+	const std::array<uint32_t, 2> families = { graphics_family, transfer_family };
+
+	vk::BufferCreateInfo buffer_info = {};
+	buffer_info.size  = size;
+	buffer_info.usage = vk::BufferUsageFlagBits::eTransferSrc;
+
+	// Read by both queue families without ownership transfers
+	if (hasDedicatedTransferQueue()) {
+		buffer_info.sharingMode           = vk::SharingMode::eConcurrent;
+		buffer_info.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+		buffer_info.pQueueFamilyIndices   = families.data();
+	} else {
+		buffer_info.sharingMode = vk::SharingMode::eExclusive;
+	}
+
+	Staging staging = {};
+	staging.buffer = device.createBuffer(buffer_info);
+	staging.size   = size;
+
+	auto req = device.getBufferMemoryRequirements(staging.buffer);
+
+	vk::MemoryAllocateInfo alloc_info = {};
+	alloc_info.allocationSize  = req.size;
+	alloc_info.memoryTypeIndex = ctx.findMemoryType(req.memoryTypeBits,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	staging.memory = device.allocateMemory(alloc_info);
+	device.bindBufferMemory(staging.buffer, staging.memory, 0);
+
+	staging.mapped = static_cast<uint8_t*>(device.mapMemory(staging.memory, 0, VK_WHOLE_SIZE));
+
+	return staging;
+}
+
+void UploadService::destroyStaging(Staging& staging) const
+{
+	auto& device = Context::get().device;
+
+	if (staging.mapped)
+		device.unmapMemory(staging.memory);
+
+	device.destroy(std::exchange(staging.buffer, nullptr));
+	device.free(std::exchange(staging.memory, nullptr));
+
+	staging.mapped = nullptr;
+	staging.size   = 0;
+}
+
+void UploadService::recordTextureJobs(Batch& batch, Texture& texture, const std::vector<const Job*>& jobs, bool use_transfer_queue)
+{
+	auto cmd = use_transfer_queue ? batch.transfer_cmd : batch.graphics_cmd;
+
+	const auto old_layout = texture.layout;
+
+	const vk::ImageSubresourceRange range = {
+		vk::ImageAspectFlagBits::eColor,
+		0, VK_REMAINING_MIP_LEVELS,
+		0, 1
+	};
+
+	vk::ImageMemoryBarrier to_transfer = {};
+	to_transfer.srcAccessMask       = old_layout == vk::ImageLayout::eUndefined ? vk::AccessFlags() : vk::AccessFlagBits::eShaderRead;
+	to_transfer.dstAccessMask       = vk::AccessFlagBits::eTransferWrite;
+	to_transfer.oldLayout           = old_layout;
+	to_transfer.newLayout           = vk::ImageLayout::eTransferDstOptimal;
+	to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_transfer.image               = texture.image;
+	to_transfer.subresourceRange    = range;
+
+	cmd.pipelineBarrier(
+		old_layout == vk::ImageLayout::eUndefined ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eFragmentShader,
+		vk::PipelineStageFlagBits::eTransfer,
+		{},
+		0, nullptr,
+		0, nullptr,
+		1, &to_transfer);
+
+	for (const auto* job : jobs) {
+		vk::BufferImageCopy image_copy = {};
+		image_copy.bufferOffset      = job->src_offset;
+		image_copy.bufferRowLength   = 0;
+		image_copy.bufferImageHeight = 0;
+		image_copy.imageSubresource  = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		image_copy.imageOffset       = vk::Offset3D{ job->offset.x, job->offset.y, 0 };
+		image_copy.imageExtent       = vk::Extent3D{ job->size.x, job->size.y, 1 };
+
+		cmd.copyBufferToImage(
+			job->src_buffer,
+			texture.image,
+			vk::ImageLayout::eTransferDstOptimal,
+			1, &image_copy);
+	}
+
+	vk::ImageMemoryBarrier to_shader = {};
+	to_shader.srcAccessMask       = vk::AccessFlagBits::eTransferWrite;
+	to_shader.dstAccessMask       = vk::AccessFlagBits::eShaderRead;
+	to_shader.oldLayout           = vk::ImageLayout::eTransferDstOptimal;
+	to_shader.newLayout           = vk::ImageLayout::eShaderReadOnlyOptimal;
+	to_shader.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_shader.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_shader.image               = texture.image;
+	to_shader.subresourceRange    = range;
+
+	if (use_transfer_queue) {
+		// Release on the transfer queue, then acquire with the same barrier
+		// on the graphics queue once the batch semaphore is signaled
+		to_shader.srcQueueFamilyIndex = transfer_family;
+		to_shader.dstQueueFamilyIndex = graphics_family;
+
+		auto release = to_shader;
+		release.dstAccessMask = {};
+
+		cmd.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eBottomOfPipe,
+			{},
+			0, nullptr,
+			0, nullptr,
+			1, &release);
+
+		auto acquire = to_shader;
+		acquire.srcAccessMask = {};
+
+		batch.graphics_cmd.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTopOfPipe,
+			vk::PipelineStageFlagBits::eFragmentShader,
+			{},
+			0, nullptr,
+			0, nullptr,
+			1, &acquire);
+	} else {
+		cmd.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eFragmentShader,
+			{},
+			0, nullptr,
+			0, nullptr,
+			1, &to_shader);
+	}
+
+	texture.layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	if (!texture.info.generate_mips || texture.mipLevels() == 1)
+		return;
+
+	// Blits need a graphics capable queue, after the acquire in the transfer path
+	if (texture.supportsBlitMips()) {
+		texture.generateMips(batch.graphics_cmd);
+		return;
+	}
+
+	// Otherwise collect() filters the staged pixels once the batch completed. Several
+	// uploads into the texture are merged, their union is then read back
+	CpuMips mips = {};
+	mips.texture = &texture;
+	mips.offset  = jobs.front()->offset;
+	mips.size    = jobs.front()->size;
+
+	if (jobs.size() == 1) {
+		const auto* job = jobs.front();
+
+		if (job->src_buffer == ring.buffer) {
+			mips.pixels = ring.mapped + job->src_offset;
+		} else {
+			for (const auto& staging : batch.dedicated)
+				if (staging.buffer == job->src_buffer)
+					mips.pixels = staging.mapped + job->src_offset;
+		}
+	} else {
+		ivec2 lo = mips.offset;
+		ivec2 hi = mips.offset + ivec2(mips.size);
+
+		for (const auto* job : jobs) {
+			lo.x = std::min(lo.x, job->offset.x);
+			lo.y = std::min(lo.y, job->offset.y);
+			hi.x = std::max(hi.x, job->offset.x + static_cast<int32_t>(job->size.x));
+			hi.y = std::max(hi.y, job->offset.y + static_cast<int32_t>(job->size.y));
+		}
+
+		mips.offset = lo;
+		mips.size   = uvec2(hi - lo);
+	}
+
+	batch.cpu_mips.push_back(mips);
+}
+
+void UploadService::recordBufferJobs(Batch& batch, const std::vector<const Job*>& jobs)
+{
+	auto cmd = batch.graphics_cmd;
+
+	// Buffers may still be read by frames in flight
+	cmd.pipelineBarrier(
+		vk::PipelineStageFlagBits::eAllCommands,
+		vk::PipelineStageFlagBits::eTransfer,
+		{},
+		0, nullptr,
+		0, nullptr,
+		0, nullptr);
+
+	for (const auto* job : jobs) {
+		vk::BufferCopy region = {};
+		region.srcOffset = job->src_offset;
+		region.dstOffset = job->dst_offset;
+		region.size      = job->src_size;
+
+		cmd.copyBuffer(job->src_buffer, job->dst_buffer, 1, &region);
+	}
+
+	vk::MemoryBarrier barrier = {
+		vk::AccessFlagBits::eTransferWrite,
+		vk::AccessFlagBits::eMemoryRead
+	};
+
+	cmd.pipelineBarrier(
+		vk::PipelineStageFlagBits::eTransfer,
+		vk::PipelineStageFlagBits::eAllCommands,
+		{},
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+}
+
+VKDL_END
\ No newline at end of file